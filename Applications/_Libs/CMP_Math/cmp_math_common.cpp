@@ -22,116 +22,12 @@
 //=====================================================================
 
 #include "cmp_math_common.h"
+#include "cmp_math_cpuid.h"
 #include "cmp_math_vec4.h"
 
 #ifndef ASPM_GPU
 
-//---------------------------------------------
-// CPU: Computes square root of  a float value
-//---------------------------------------------
-float cpu_sqrtf(float * pIn)
-{
-    //printf("native : ");
-    return sqrtf(*pIn);
-}
-
-#ifndef _LINUX
-//---------------------------------------------
-// SSE: Computes square root of  a float value
-//---------------------------------------------
-float sse_sqrtf(  float *pIn )
-{
-    //printf("sse    : ");
-    __m128 val = _mm_load1_ps(pIn);
-    val = _mm_sqrt_ss(val);
-    return val.m128_f32[0];
-}
-#endif
-
-//-------------------------------------------------
-// CPU: Computes 1 / (square root of a float value)
-//-------------------------------------------------
-float cpu_rsqf(float *f)
-{
-    float sf = cmp_sqrtf(f);
-    if (sf != 0)
-        return 1 / cmp_sqrtf(f);
-    else
-        return 0.0f;
-}
-
-#ifndef _LINUX
-//-------------------------------------------------
-// SSE: Computes 1 / (square root of a float value)
-//-------------------------------------------------
-float sse_rsqf(float *v)
-{
-    __m128 val = _mm_load1_ps(v);
-    val = _mm_rsqrt_ss(val);
-    float frsq = val.m128_f32[0];
-    return (0.5f * frsq) * (3.0f - (*v  * frsq) * frsq);
-};
-#endif
-
-//---------------------------------------------
-// CPU: Computes min of two float values
-//---------------------------------------------
-float cpu_minf(float l1, float r1)
-{
-    return (l1 < r1 ? l1 : r1);
-}
-
-#ifndef _LINUX
-float sse_minf( float a, float b )
-{
-    // Branchless SSE min.
-    _mm_store_ss( &a, _mm_min_ss(_mm_set_ss(a),_mm_set_ss(b)) );
-    return a;
-}
-#endif
-
-//---------------------------------------------
-// CPU: Computes max of two float values
-//---------------------------------------------
-float cpu_maxf(float l1, float r1)
-{
-    return (l1 > r1 ? l1 : r1);
-}
-
-#ifndef _LINUX
-float sse_maxf( float a, float b )
-{
-    // Branchless SSE max.
-    _mm_store_ss( &a, _mm_max_ss(_mm_set_ss(a),_mm_set_ss(b)) );
-    return a;
-}
-#endif
-
-//================================================
-// Clamp the value in the range [minval .. maxval]
-//================================================
-float cpu_clampf(float value, float minval, float maxval)
-{
-    if (value < minval)
-    {
-        return(minval);
-    }
-    else if (value > maxval)
-    {
-        return(maxval);
-    }
-    return value;
-}
-
-#ifndef _LINUX
-float sse_clampf( float val, float minval, float maxval )
-{
-    _mm_store_ss( &val, _mm_min_ss( _mm_max_ss(_mm_set_ss(val),_mm_set_ss(minval)), _mm_set_ss(maxval) ) );
-    return val;
-}
-#endif
-
-void cpu_averageRGB(unsigned char *src_rgba_block)
+void cmp_averageRGB(unsigned char *src_rgba_block)
 {
     float medianR = 0.0f, medianG = 0.0f, medianB = 0.0f;
 
@@ -164,7 +60,7 @@ void cpu_averageRGB(unsigned char *src_rgba_block)
 }
 
 
-float cpu_lerp2(CMP_Vec4uc C1, CMP_Vec4uc CA, CMP_Vec4uc CB, CMP_Vec4uc C2, CMP_MATH_BYTE *encode1, CMP_MATH_BYTE *encode2)
+float cmp_lerp2(CMP_Vec4uc C1, CMP_Vec4uc CA, CMP_Vec4uc CB, CMP_Vec4uc C2, CMP_MATH_BYTE *encode1, CMP_MATH_BYTE *encode2)
 {
     // Initial Setup
     CMP_Vec4uc P[4];
@@ -205,169 +101,6 @@ float cpu_lerp2(CMP_Vec4uc C1, CMP_Vec4uc CA, CMP_Vec4uc CB, CMP_Vec4uc C2, CMP_
     return float(min1+min2);
 }
 
-#ifndef _LINUX
-float sse_lerp2(CMP_Vec4uc C1, CMP_Vec4uc CA, CMP_Vec4uc CB, CMP_Vec4uc C2, CMP_MATH_BYTE *encode1, CMP_MATH_BYTE *encode2)
-{
-    // Initial Setup
-    __m128 iC1, iC2, iCA, iCB; //Load auchars into _m128
-    __m128 iP[4];
-    __m128 idiff1, idiff2;
-    float min = 511.0f;
-    __m128 imin1    = _mm_set_ps1(min);
-    __m128 imin2    = _mm_set_ps1(min);
-    __m128 absMask  = _mm_set_ps1(-0.0);
-    __m128 zero     = _mm_set_ps1(0.0);
-
-    //Aplha channels have been disabled
-    iC1 = _mm_set_ps(0, C1.z, C1.y, C1.x);
-    iC2 = _mm_set_ps(0, C2.z, C2.y, C2.x);
-    iCA = _mm_set_ps(0, CA.z, CA.y, CA.x);
-    iCB = _mm_set_ps(0, CB.z, CB.y, CB.x);
-
-    //Direction Vector
-    __m128 iD;
-    iD = _mm_sub_ps(iC2, iC1);
-
-    float gradA[4] = { 0.0f, 0.3f, 0.7f, 1.0f };
-
-    for (int i = 0; i < 4; i++)
-    {
-        __m128 currentGradA = _mm_set_ps1(gradA[i]);
-        iP[i] = _mm_add_ps(_mm_mul_ps(currentGradA, iD), iC1);
-
-        //Calculate SAD (Sum of Absolute Difference)
-        __m128 iSub1 = _mm_sub_ps(iCA, iP[i]);
-        __m128 iSub2 = _mm_sub_ps(iCB, iP[i]);        
-        __m128 iAbs1 = _mm_andnot_ps(absMask, iSub1); // Computes the absolute value
-        __m128 iAbs2 = _mm_andnot_ps(absMask, iSub2);
-        idiff1 = _mm_hadd_ps(iAbs1, zero);
-        idiff1 = _mm_hadd_ps(idiff1, zero);        
-        idiff2 = _mm_hadd_ps(iAbs2, zero);
-        idiff2 = _mm_hadd_ps(idiff2, zero);
-
-        if (_mm_comilt_ss(idiff1, imin1))
-        {
-            *encode1 = (CMP_MATH_BYTE)i;
-            imin1 = idiff1;
-        }
-
-        if (_mm_comilt_ss(idiff2, imin2))
-        {
-            *encode2 = (CMP_MATH_BYTE)i;
-            imin2 = idiff2;
-        }
-    }
-    // Convert __m128 back to floats
-    float result1[4];
-    float result2[4];
-    _mm_storeu_ps (result1, imin1);
-    _mm_storeu_ps (result2, imin2);
-    return (result1[0] + result2[0]);
-}
-
-float fma_lerp2(CMP_Vec4uc C1, CMP_Vec4uc CA, CMP_Vec4uc CB, CMP_Vec4uc C2, CMP_MATH_BYTE *encode1, CMP_MATH_BYTE *encode2)
-{
-    // Initial Setup
-    __m128 iC1, iC2, iCA, iCB; //Load auchars into _m128
-    __m128 iP[4];
-    __m128 idiff1, idiff2;
-    float min = 511.0f;
-    __m128 imin1    = _mm_set_ps1(min);
-    __m128 imin2    = _mm_set_ps1(min);
-    __m128 absMask  = _mm_set_ps1(-0.0);
-    __m128 zero      = _mm_set_ps1(0.0);
-
-    //Aplha channels have been disabled
-    iC1 = _mm_set_ps(0, C1.z, C1.y, C1.x);
-    iC2 = _mm_set_ps(0, C2.z, C2.y, C2.x);
-    iCA = _mm_set_ps(0, CA.z, CA.y, CA.x);
-    iCB = _mm_set_ps(0, CB.z, CB.y, CB.x);
-
-    //Direction Vector
-    __m128 iD;
-    iD = _mm_sub_ps(iC2, iC1);
-
-    float gradA[4] = { 0.0f, 0.3f, 0.7f, 1.0f };
-
-    for (int i = 0; i < 4; i++)
-    {
-        __m128 currentGradA = _mm_set_ps1(gradA[i]);
-        iP[i] = _mm_fmadd_ps(currentGradA, iD, iC1); 
-
-        //Calculate SAD (Sum of Absolute Difference)
-        __m128 iSub1 = _mm_sub_ps(iCA, iP[i]);
-        __m128 iSub2 = _mm_sub_ps(iCB, iP[i]);
-        __m128 iAbs1 = _mm_andnot_ps(absMask, iSub1); // Computes the absolute value
-        __m128 iAbs2 = _mm_andnot_ps(absMask, iSub2);
-        idiff1 = _mm_hadd_ps(iAbs1, zero);
-        idiff1 = _mm_hadd_ps(idiff1, zero);
-        idiff2 = _mm_hadd_ps(iAbs2, zero);
-        idiff2 = _mm_hadd_ps(idiff2, zero);
-
-        if (_mm_comilt_ss(idiff1, imin1))
-        {
-            *encode1 = (CMP_MATH_BYTE)i;
-            imin1 = idiff1;
-        }
-
-        if (_mm_comilt_ss(idiff2, imin2))
-        {
-            *encode2 = (CMP_MATH_BYTE)i;
-            imin2 = idiff2;
-        }
-    }
-
-    // Convert __m128 back to floats
-    float result1[4];
-    float result2[4];
-    _mm_storeu_ps (result1, imin1);
-    _mm_storeu_ps (result2, imin2);
-    return (result1[0] + result2[0]);
-}
-
-void cmp_set_fma3_features()
-{
-    //printf("FMA3 has been enabled.");
-    cmp_lerp2 = fma_lerp2;
-}
-#endif
-
-
-void cmp_set_cpu_features()
-{
-    // features list in Alphabetical order
-    cmp_clampf   = cpu_clampf;
-    cmp_lerp2    = cpu_lerp2;
-    cmp_maxf     = cpu_maxf;
-    cmp_minf     = cpu_minf;
-    cmp_rsqf     = cpu_rsqf;
-    cmp_sqrtf    = cpu_sqrtf;
-}
-
-#ifndef _LINUX
-void cmp_set_sse2_features()
-{
-    cmp_clampf   = sse_clampf;
-    cmp_lerp2    = sse_lerp2;
-    cmp_maxf     = sse_maxf;
-    cmp_minf     = sse_minf;
-    cmp_rsqf     = sse_rsqf;
-    cmp_sqrtf    = sse_sqrtf;
-}
-#endif
-
-//---------------------------------
-// User Interface to the CMP_MATH
-//---------------------------------
-float(*cmp_sqrtf   ) (float *)                                   = cpu_sqrtf;
-float(*cmp_rsqf    ) (float *)                                   = cpu_rsqf;
-float(*cmp_minf    ) (float l1, float r1)                        = cpu_minf;
-float(*cmp_maxf    ) (float l1, float r1)                        = cpu_maxf;
-float(*cmp_clampf  ) (float value, float minval, float maxval)   = cpu_clampf;
-float (*cmp_lerp2) (CMP_Vec4uc C1, CMP_Vec4uc CA, CMP_Vec4uc CB, CMP_Vec4uc C2, CMP_MATH_BYTE *encode1, CMP_MATH_BYTE *encode2) = cpu_lerp2;
-void  (*cmp_averageRGB)(unsigned char *src_rgba_block) = cpu_averageRGB;
-//}
-
 #else
 // OpenCL interfaces
 float cmp_sqrtf (float *)                                {};
@@ -29,58 +29,61 @@
 
 #ifndef ASPM_GPU
 
+#include <math.h>
+
 #ifdef _WIN32
 #define CMP_Align(x)  __declspec(align(x))
 #else
 #define CMP_Align(x)  __attribute(aligned(x))
 #endif
 
-#define CMP_MATH_USE_AUTO   0
-#define CMP_MATH_USE_CPU    1
-#define CMP_MATH_USE_HPC    2
-#define CMP_MATH_USE_GPU    4
-
 typedef unsigned char CMP_MATH_BYTE;
 typedef unsigned int  CMP_MATH_DWORD;
 
-#ifndef _LINUX
-extern void cmp_set_fma3_features();
-extern void cmp_set_sse2_features();
-#endif
-
-extern void cmp_set_cpu_features();
-
-//==================================
-// internal interfaces
-//==================================
-extern float cpu_clampf(float value, float minval, float maxval);
-extern float cpu_lerp2(CMP_Vec4uc C1, CMP_Vec4uc CA, CMP_Vec4uc CB, CMP_Vec4uc C2, CMP_MATH_BYTE *encode1, CMP_MATH_BYTE *encode2);
-extern float cpu_maxf(float l1, float r1);
-extern float cpu_minf(float l1, float r1);
-extern float cpu_rsqf(float *f);
-extern float cpu_sqrtf(float * pIn);
-
-
-#ifndef _LINUX
-extern float sse_clampf(float value, float minval, float maxval);
-extern float sse_lerp2(CMP_Vec4uc C1, CMP_Vec4uc CA, CMP_Vec4uc CB, CMP_Vec4uc C2, CMP_MATH_BYTE *encode1, CMP_MATH_BYTE *encode2);
-extern float sse_maxf(float l1, float r1);
-extern float sse_minf(float l1, float r1);
-extern float sse_rsqf(float *v);
-extern float sse_sqrtf(  float *pIn );
-#endif
-
 //==================================
 // User interfaces
+//
+// The scalar helpers are inline so they compile into the calling kernel, an instruction
+// set is chosen once per kernel (see the CompressBlocksBCn and BC7 dispatch in CMP_Core)
+// rather than once per operation.
 //==================================
-void cmp_autodected_cpufeatures(CMP_MATH_BYTE set);
-
-extern float(*cmp_clampf )(float value, float minval, float maxval);
-extern float(*cmp_lerp2  )(CMP_Vec4uc C1, CMP_Vec4uc CA, CMP_Vec4uc CB, CMP_Vec4uc C2, CMP_MATH_BYTE *encode1, CMP_MATH_BYTE *encode2);
-extern float(*cmp_maxf   )(float l1, float r1);
-extern float(*cmp_minf   )(float l1, float r1);
-extern float(*cmp_rsqf   )(float *);
-extern float(*cmp_sqrtf  )(float *);
+static inline float cmp_sqrtf(float *pIn)
+{
+    return sqrtf(*pIn);
+}
+
+// 1 / square root, 0 for 0
+static inline float cmp_rsqf(float *f)
+{
+    float sf = sqrtf(*f);
+    if (sf != 0)
+        return 1 / sf;
+    else
+        return 0.0f;
+}
+
+static inline float cmp_minf(float l1, float r1)
+{
+    return (l1 < r1 ? l1 : r1);
+}
+
+static inline float cmp_maxf(float l1, float r1)
+{
+    return (l1 > r1 ? l1 : r1);
+}
+
+// Clamp the value in the range [minval .. maxval]
+static inline float cmp_clampf(float value, float minval, float maxval)
+{
+    if (value < minval)
+        return minval;
+    else if (value > maxval)
+        return maxval;
+    return value;
+}
+
+extern float cmp_lerp2(CMP_Vec4uc C1, CMP_Vec4uc CA, CMP_Vec4uc CB, CMP_Vec4uc C2, CMP_MATH_BYTE *encode1, CMP_MATH_BYTE *encode2);
+extern void  cmp_averageRGB(unsigned char *src_rgba_block);
 
 #endif
 
@@ -27,14 +27,40 @@
 
 #ifndef ASPM_GPU
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CMP_CPUID_X86
+#ifdef _WIN32
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
 void cmp_cpuid(int cpuInfo[4], int function_id)
 {
     // subfunction_id = 0
-    #ifdef _WIN32
+#if !defined(CMP_CPUID_X86)
+    cpuInfo[0] = cpuInfo[1] = cpuInfo[2] = cpuInfo[3] = 0;
+    (void)function_id;
+#elif defined(_WIN32)
     __cpuidex(cpuInfo, function_id, 0);
 #else
-    // To Do
-    //__cpuid_count(0, function_id, cpuInfo[0], cpuInfo[1], cpuInfo[2], cpuInfo[3]);
+    __cpuid_count(function_id, 0, cpuInfo[0], cpuInfo[1], cpuInfo[2], cpuInfo[3]);
+#endif
+}
+
+// Register state saved by the OS on a context switch, the AVX units can only
+// be used when it saves the YMM (and for AVX-512 the ZMM and opmask) registers
+static unsigned long long cmp_xgetbv()
+{
+#if !defined(CMP_CPUID_X86)
+    return 0;
+#elif defined(_WIN32)
+    return _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
 #endif
 }
 
@@ -43,14 +69,17 @@ cmp_cpufeatures cmp_get_cpufeatures()
     unsigned int maxInfoType;
     cmp_cpufeatures cpu;
     int cpuInfo[4], i;
+    bool bOSAVX    = false;
+    bool bOSAVX512 = false;
 
     // Clear the feature list
     for (i = 0; i<SSP_SSE_COUNT; ++i)
     {
         cpu.feature[i] = 0;
     }
+    cpu.x64 = false;
 
-#ifndef _LINUX
+#ifdef CMP_CPUID_X86
     cmp_cpuid(cpuInfo,0);
     int nIds = cpuInfo[0];
 
@@ -62,7 +91,14 @@ cmp_cpufeatures cmp_get_cpufeatures()
         cpu.feature[SSP_SSE4_1] = (cpuInfo[2] & CMP_CPU_SSE41);
         cpu.feature[SSP_SSE4_2] = (cpuInfo[2] & CMP_CPU_SSE42);
         // (cpuInfo[2] & CMP_CPU_AES   );
-        // (cpuInfo[2] & CMP_CPU_AVX   );
+
+        if (cpuInfo[2] & CMP_CPU_OSXSAVE)
+        {
+            unsigned long long xcr0 = cmp_xgetbv();
+            bOSAVX    = (xcr0 & 0x06) == 0x06;
+            bOSAVX512 = (xcr0 & 0xE6) == 0xE6;
+        }
+        cpu.feature[SSP_AVX] = bOSAVX ? (cpuInfo[2] & CMP_CPU_AVX) : 0;
 
         // also check for fma4 features
         cpu.feature[SSP_FMA3] = (cpuInfo[2] & CMP_CPU_FMA3);
@@ -73,27 +109,26 @@ cmp_cpufeatures cmp_get_cpufeatures()
         // (cpuInfo[3] & CMP_CPU_MMX   );
     }
 
-    //if (nIds >= 0x00000007)
-    //{
-    //    cpuid(cpuInfo,0x00000007);
-    //    (cpuInfo[1] & CMP_CPU_AVX2       );
-    //    (cpuInfo[1] & CMP_CPU_BMI1       );
-    //    (cpuInfo[1] & CMP_CPU_BMI2       );
-    //    (cpuInfo[1] & CMP_CPU_ADX        );
-    //    (cpuInfo[1] & CMP_CPU_MPX        );
-    //    (cpuInfo[1] & CMP_CPU_SHA        );
-    //    (cpuInfo[1] & CMP_CPU_AVX512_F   );
-    //    (cpuInfo[1] & CMP_CPU_AVX512_CD  );
-    //    (cpuInfo[1] & CMP_CPU_AVX512_PF  );
-    //    (cpuInfo[1] & CMP_CPU_AVX512_ER  );
-    //    (cpuInfo[1] & CMP_CPU_AVX512_VL  );
-    //    (cpuInfo[1] & CMP_CPU_AVX512_BW  );
-    //    (cpuInfo[1] & CMP_CPU_AVX512_DQ  );
-    //    (cpuInfo[1] & CMP_CPU_AVX512_IFMA);
-    //    (cpuInfo[2] & CMP_CPU_AVX512_VBMI);
-    //    (cpuInfo[2] & CMP_CPU_PREFETCHWT1);
-    //
-    //}
+    if (nIds >= 0x00000007)
+    {
+        cmp_cpuid(cpuInfo,0x00000007);
+        cpu.feature[SSP_AVX2]      = bOSAVX    ? (cpuInfo[1] & CMP_CPU_AVX2)      : 0;
+        cpu.feature[SSP_AVX512_F]  = bOSAVX512 ? (cpuInfo[1] & CMP_CPU_AVX512_F)  : 0;
+        cpu.feature[SSP_AVX512_BW] = bOSAVX512 ? (cpuInfo[1] & CMP_CPU_AVX512_BW) : 0;
+        //    (cpuInfo[1] & CMP_CPU_BMI1       );
+        //    (cpuInfo[1] & CMP_CPU_BMI2       );
+        //    (cpuInfo[1] & CMP_CPU_ADX        );
+        //    (cpuInfo[1] & CMP_CPU_MPX        );
+        //    (cpuInfo[1] & CMP_CPU_SHA        );
+        //    (cpuInfo[1] & CMP_CPU_AVX512_CD  );
+        //    (cpuInfo[1] & CMP_CPU_AVX512_PF  );
+        //    (cpuInfo[1] & CMP_CPU_AVX512_ER  );
+        //    (cpuInfo[1] & CMP_CPU_AVX512_VL  );
+        //    (cpuInfo[1] & CMP_CPU_AVX512_DQ  );
+        //    (cpuInfo[1] & CMP_CPU_AVX512_IFMA);
+        //    (cpuInfo[2] & CMP_CPU_AVX512_VBMI);
+        //    (cpuInfo[2] & CMP_CPU_PREFETCHWT1);
+    }
 
     cmp_cpuid(cpuInfo,0x80000000);
     maxInfoType = cpuInfo[0];
@@ -112,47 +147,6 @@ cmp_cpufeatures cmp_get_cpufeatures()
     return cpu;
 }
 
-void cmp_autodected_cpufeatures(CMP_MATH_BYTE set)
-{
-    // Determine which features are available
-    cmp_cpufeatures cpu = cmp_get_cpufeatures();
-
-    // Default: features always set to CPU 
-    cmp_set_cpu_features();
-
-    // User requested to use only CPU
-    if ((set & CMP_MATH_USE_CPU) > 0) return;
-
-
-#ifndef _LINUX
-    // Auto detect CPU features to enable
-    for (int i = 0; i<SSP_SSE_COUNT; i++)
-    {
-        if (cpu.feature[i] > 0)
-        {
-            switch (i)
-            {
-                // Enable SSE features
-                case SSP_SSE2:
-                case SSP_SSE:
-                {
-                    if ((set == CMP_MATH_USE_AUTO) || (set == CMP_MATH_USE_HPC))
-                        cmp_set_sse2_features();
-                    break;
-                }
-                case SSP_FMA3:
-                {
-                    if ((set == CMP_MATH_USE_AUTO) || (set == CMP_MATH_USE_HPC))
-                        cmp_set_fma3_features();
-                    break;
-                }
-            }
-        }
-    }
-#endif
-
-}
-
 //}
 
 #else
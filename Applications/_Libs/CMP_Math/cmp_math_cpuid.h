@@ -40,6 +40,7 @@
 #define CMP_CPU_AES          ((int)1 << 25)
 #define CMP_CPU_AVX          ((int)1 << 28)
 #define CMP_CPU_FMA3         ((int)1 << 12)
+#define CMP_CPU_OSXSAVE      ((int)1 << 27)
 #define CMP_CPU_RDRAND       ((int)1 << 30)
 #define CMP_CPU_AVX2         ((int)1 <<  5)
 #define CMP_CPU_BMI1         ((int)1 <<  3)
@@ -77,6 +78,10 @@ typedef enum
     SSP_SSE4_2,
     SSP_SSE5,
     SSP_FMA3,
+    SSP_AVX,
+    SSP_AVX2,
+    SSP_AVX512_F,
+    SSP_AVX512_BW,
     SSP_SSE_COUNT
 }cmp_cpu_feature;
 
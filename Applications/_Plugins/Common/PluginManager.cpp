@@ -33,6 +33,12 @@
 #include "PluginInterface.h"
 #include "PluginManager.h"
 
+#include <mutex>
+
+// Plugins are registered and their libraries loaded on first use, serialize that
+// for callers such as the command line file pipeline that load and save on threads
+static std::mutex g_GetPluginMutex;
+
 static bool CMP_FileExists(const std::string& abs_filename)
 {
     bool ret = false;
@@ -478,6 +484,8 @@ char * PluginManager::getPluginType(int index)
 
 void *PluginManager::GetPlugin(char *type, const char *name)
 {
+    std::lock_guard<std::mutex> lock(g_GetPluginMutex);
+
     if (!m_pluginlistset)
     {
         getPluginList(DEFAULT_PLUGINLIST_DIR);
@@ -524,6 +532,8 @@ bool PluginManager::RemovePlugin(char *type, char *name)
 
 void *PluginManager::GetPlugin(char *uuid)
 {
+    std::lock_guard<std::mutex> lock(g_GetPluginMutex);
+
     if (!m_pluginlistset)
     {
         getPluginList(DEFAULT_PLUGINLIST_DIR);
@@ -45,6 +45,11 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 #ifdef USE_MESH_CLI
 #include <gltf/tiny_gltf2.h>
 #include <gltf/GltfCommon.h>
@@ -2266,6 +2271,365 @@ void PrintInfoStr(const char* InfoStr )
     PrintInfo(InfoStr);
 }
 
+//======================================================
+// Determine if MIP mapping is required
+// if so generate the MIP levels for the source file
+//=======================================================
+void GenerateSourceMipLevels(MipSet* pMipSetIn)
+{
+    if (((g_CmdPrams.MipsLevel > 1) && (pMipSetIn->m_nMipLevels == 1)) && (!g_CmdPrams.use_noMipMaps))
+    {
+        int nMinSize;
+        // Precheck user setting against image size
+        CMP_INT nHeight     = pMipSetIn->m_nHeight;
+        CMP_INT nWidth      = pMipSetIn->m_nWidth;
+        CMP_INT maxLevel    = 1; // count from top level
+        CMP_INT MipsLevel   = g_CmdPrams.MipsLevel;
+        while (MipsLevel > 0) {
+            maxLevel++;
+            nWidth  = CMP_MAX(nWidth >> 1, 1);
+            nHeight = CMP_MAX(nHeight >> 1, 1);
+            if ((nWidth <= 1) || (nHeight <= 1))
+                break;
+            MipsLevel--;
+        }
+
+        // User has two option to specify MIP levels
+        if (g_CmdPrams.nMinSize > 0) {
+            nMinSize = g_CmdPrams.nMinSize;
+        }
+        else
+        {
+            if (maxLevel < g_CmdPrams.MipsLevel)
+                PrintInfo("Warning miplevels %d is larger then required, value is autoset to use %d\n", g_CmdPrams.MipsLevel,maxLevel);
+            nMinSize = CMP_CalcMinMipSize(pMipSetIn->m_nHeight, pMipSetIn->m_nWidth, g_CmdPrams.MipsLevel);
+        }
+
+        CMP_GenerateMIPLevels((CMP_MipSet *)pMipSetIn, nMinSize);
+    }
+}
+
+// Number of source images loaded ahead of the encoder when a folder of files is processed
+#define PIPELINE_LOAD_AHEAD  2
+
+//
+// PrintInfo output of the pipeline threads is not printed by those threads.
+// While a pipeline runs PrintStatusLine is replaced by PipelinePrintStatusLine,
+// which keeps the lines of a pipeline thread with the image it is working on.
+// The main thread prints them when it takes that image, so the console and
+// the print callback are only ever used by the main thread.
+//
+static thread_local std::vector<std::string>* g_pPipelineInfo = NULL;
+static void (*g_PipelinePrintStatusLine)(char*) = NULL;
+
+static void PipelinePrintStatusLine(char* InfoStr)
+{
+    if (g_pPipelineInfo)
+        g_pPipelineInfo->push_back(InfoStr);
+    else if (g_PipelinePrintStatusLine)
+        g_PipelinePrintStatusLine(InfoStr);
+}
+
+static void PrintPipelineInfo(std::vector<std::string>& Info)
+{
+    for (auto& InfoStr : Info)
+        PrintInfo("%s", InfoStr.c_str());
+    Info.clear();
+}
+
+//
+// Installs PipelinePrintStatusLine for the lifetime of the pipelines, it must
+// be declared before them so their threads are joined before it is removed.
+// The compute library may have been given it as its PrintLine hook, that is
+// put back to the previous print as well.
+//
+class CPipelinePrint
+{
+public:
+    CPipelinePrint() : m_bInstalled(false), m_pPrevious(NULL)
+    {
+    }
+
+    ~CPipelinePrint()
+    {
+        if (m_bInstalled)
+        {
+            if (g_CMIPS && (g_CMIPS->PrintLine == &PipelinePrintStatusLine))
+                g_CMIPS->PrintLine = m_pPrevious;
+            PrintStatusLine           = m_pPrevious;
+            g_PipelinePrintStatusLine = NULL;
+        }
+    }
+
+    void Install()
+    {
+        if (PrintStatusLine == NULL)
+            PrintStatusLine = &LocalPrintF;
+        m_pPrevious               = PrintStatusLine;
+        g_PipelinePrintStatusLine = PrintStatusLine;
+        PrintStatusLine           = &PipelinePrintStatusLine;
+        m_bInstalled              = true;
+    }
+
+private:
+    bool m_bInstalled;
+    void (*m_pPrevious)(char*);
+};
+
+//
+// Load stage of the file pipeline: a thread loads the next source images,
+// swizzles them and generates their MIP levels while the current image is
+// encoded. At most PIPELINE_LOAD_AHEAD images are held, so a slow encoder
+// stops the loader rather than filling memory.
+//
+class CSourcePipeline
+{
+public:
+    CSourcePipeline() : m_bStop(false)
+    {
+    }
+
+    ~CSourcePipeline()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_bStop = true;
+        }
+        m_Changed.notify_all();
+        if (m_Thread.joinable())
+            m_Thread.join();
+
+        for (auto& source : m_Sources)
+        {
+            if (source.mipSet.m_pMipLevelTable)
+                g_CMIPS->FreeMipSet(&source.mipSet);
+        }
+    }
+
+    void Start(const std::vector<std::string>& files)
+    {
+        m_Files  = files;
+        m_Thread = std::thread(&CSourcePipeline::LoadProc, this);
+    }
+
+    // Hands over the image loaded for SourceFile and prints what the loader
+    // reported for it. Returns false if the loader does not have it, the
+    // caller then loads the file itself.
+    bool Take(const std::string& SourceFile, MipSet& mipSet, int& loadResult, bool& prepared)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Changed.wait(lock, [this] { return !m_Sources.empty() || m_Files.empty(); });
+        if (m_Sources.empty() || (m_Sources.front().SourceFile != SourceFile))
+            return false;
+
+        Source source = m_Sources.front();
+        m_Sources.pop_front();
+        m_Changed.notify_all();
+        lock.unlock();
+
+        PrintPipelineInfo(source.Info);
+        mipSet     = source.mipSet;
+        loadResult = source.loadResult;
+        prepared   = source.prepared;
+        return true;
+    }
+
+private:
+    struct Source
+    {
+        std::string              SourceFile;
+        MipSet                   mipSet;
+        int                      loadResult;
+        bool                     prepared;    // Swizzled and MIP mapped
+        std::vector<std::string> Info;        // PrintInfo output of the load
+    };
+
+    void LoadProc()
+    {
+        for (;;)
+        {
+            std::string SourceFile;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Changed.wait(lock, [this] { return m_bStop || (m_Sources.size() < PIPELINE_LOAD_AHEAD); });
+                if (m_bStop || m_Files.empty())
+                    return;
+                SourceFile = m_Files.front();
+            }
+
+            // Models are processed by ProcessCMDLine without an image load
+            if (fileIsModel(SourceFile))
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Files.erase(m_Files.begin());
+                m_Changed.notify_all();
+                continue;
+            }
+
+            Source source;
+            source.SourceFile = SourceFile;
+            source.prepared   = false;
+            memset(&source.mipSet, 0, sizeof(MipSet));
+            g_pPipelineInfo = &source.Info;
+
+            if (g_CmdPrams.noswizzle)
+                source.mipSet.m_swizzle = false;
+            if (g_CmdPrams.doswizzle)
+                source.mipSet.m_swizzle = true;
+
+            source.loadResult = AMDLoadMIPSTextureImage(SourceFile.c_str(), &source.mipSet, g_CmdPrams.use_OCV, &g_pluginManager);
+
+            // Only images that need no format fix up are prepared ahead, the rest are left to ProcessCMDLine
+            if ((source.loadResult == 0) && (g_CmdPrams.CompressOptions.SourceFormat == CMP_FORMAT_Unknown) &&
+                (source.mipSet.m_format != CMP_FORMAT_Unknown) && !CompressedFormat(source.mipSet.m_format))
+            {
+                if (source.mipSet.m_swizzle)
+                    SwizzleMipMap(&source.mipSet);
+                GenerateSourceMipLevels(&source.mipSet);
+                source.prepared = true;
+            }
+            g_pPipelineInfo = NULL;
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Files.erase(m_Files.begin());
+            m_Sources.push_back(source);
+            m_Changed.notify_all();
+        }
+    }
+
+    std::vector<std::string> m_Files;      // Files still to be loaded, in processing order
+    std::deque<Source>       m_Sources;    // Loaded images waiting for the encoder
+    bool                     m_bStop;
+    std::mutex               m_Mutex;
+    std::condition_variable  m_Changed;
+    std::thread              m_Thread;
+};
+
+//
+// Write stage of the file pipeline: a compressed image is saved by a thread
+// while the next image is encoded. Save() waits for the write of the image
+// before it, so a failed write is known before the next encode starts and
+// processing stops there, as it does on the serial path.
+//
+class CDestPipeline
+{
+public:
+    CDestPipeline() : m_bStop(false), m_bFailed(false)
+    {
+    }
+
+    ~CDestPipeline()
+    {
+        Finish();
+    }
+
+    void Start()
+    {
+        m_Thread = std::thread(&CDestPipeline::SaveProc, this);
+    }
+
+    // Queues mipSet to be written and takes ownership of its mip levels, they
+    // are freed once written. Waits for the previous write and prints what
+    // the writer reported, returns false if it failed and processing must stop.
+    bool Save(const std::string& DestFile, MipSet& mipSet, const CMP_CompressOptions& options)
+    {
+        Dest dest;
+        dest.DestFile = DestFile;
+        dest.mipSet   = mipSet;
+        dest.options  = options;
+        mipSet.m_pMipLevelTable = NULL;
+
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Dests.push_back(dest);
+            m_Changed.notify_all();
+            m_Changed.wait(lock, [this] { return m_Dests.size() <= 1; });
+        }
+        return Report();
+    }
+
+    // Prints what the writer reported since the last call, returns false if
+    // a write has failed and processing must stop
+    bool Report()
+    {
+        std::vector<std::string> Info;
+        bool                     Failed;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            Info.swap(m_Info);
+            Failed = m_bFailed;
+        }
+        PrintPipelineInfo(Info);
+        return !Failed;
+    }
+
+    // Waits for all the images to be written, returns false if a write failed
+    bool Finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_bStop = true;
+        }
+        m_Changed.notify_all();
+        if (m_Thread.joinable())
+            m_Thread.join();
+        return Report();
+    }
+
+private:
+    struct Dest
+    {
+        std::string         DestFile;
+        MipSet              mipSet;
+        CMP_CompressOptions options;
+    };
+
+    void SaveProc()
+    {
+        std::vector<std::string> Info;
+        g_pPipelineInfo = &Info;
+
+        for (;;)
+        {
+            Dest dest;
+            bool Failed;
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Changed.wait(lock, [this] { return m_bStop || !m_Dests.empty(); });
+                if (m_Dests.empty())
+                    break;
+                dest   = m_Dests.front();
+                Failed = m_bFailed;
+            }
+
+            if (!Failed && (AMDSaveMIPSTextureImage(dest.DestFile.c_str(), &dest.mipSet, g_CmdPrams.use_OCV_out, dest.options) != 0))
+            {
+                PrintInfo("Error: saving image %s failed, write permission denied or format is unsupported for the file extension.\n",
+                          dest.DestFile.c_str());
+                Failed = true;
+            }
+            g_CMIPS->FreeMipSet(&dest.mipSet);
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Info.insert(m_Info.end(), Info.begin(), Info.end());
+            Info.clear();
+            m_bFailed = Failed;
+            m_Dests.pop_front();
+            m_Changed.notify_all();
+        }
+
+        g_pPipelineInfo = NULL;
+    }
+
+    std::deque<Dest>         m_Dests;    // Images waiting to be written, the front one is being written
+    std::vector<std::string> m_Info;     // PrintInfo output of the writes, not printed yet
+    bool                     m_bStop;
+    bool                     m_bFailed;
+    std::mutex               m_Mutex;
+    std::condition_variable  m_Changed;
+    std::thread              m_Thread;
+};
+
 
 int ProcessCMDLine(CMP_Feedback_Proc pFeedbackProc, MipSet* p_userMipSetIn)
 {
@@ -2331,6 +2695,22 @@ int ProcessCMDLine(CMP_Feedback_Proc pFeedbackProc, MipSet* p_userMipSetIn)
     // Fix to output view to look the same as v3.1 print info for calls to CMP_ConvertMipTexture
     g_CmdPrams.CompressOptions.m_PrintInfoStr = PrintInfoStr;
 
+    // When a folder is processed the next images are loaded, and the compressed images
+    // written, while the current image is encoded
+    CPipelinePrint  PipelinePrint;
+    CSourcePipeline SourcePipeline;
+    CDestPipeline   DestPipeline;
+    bool UsePipeline = (p_userMipSetIn == NULL) && (g_CmdPrams.SourceFileList.size() > 0) && !g_CmdPrams.analysis && !g_CmdPrams.diffImage &&
+                       !g_CmdPrams.imageprops;
+    if (UsePipeline)
+    {
+        PipelinePrint.Install();
+        std::vector<std::string> PipelineFiles(1, g_CmdPrams.SourceFile);
+        PipelineFiles.insert(PipelineFiles.end(), g_CmdPrams.SourceFileList.begin(), g_CmdPrams.SourceFileList.end());
+        SourcePipeline.Start(PipelineFiles);
+        DestPipeline.Start();
+    }
+
     do
     {
 
@@ -2377,6 +2757,7 @@ int ProcessCMDLine(CMP_Feedback_Proc pFeedbackProc, MipSet* p_userMipSetIn)
         // ---------
         CMP_FORMAT srcFormat;
         memset(&g_MipSetIn, 0, sizeof(MipSet));
+        bool SourcePrepared = false;
 
         //===========================
         // Set the destination format
@@ -2498,7 +2879,11 @@ int ProcessCMDLine(CMP_Feedback_Proc pFeedbackProc, MipSet* p_userMipSetIn)
             //---------------------------------------
             // Set user specification for Block sizes
             //----------------------------------------
-            if (AMDLoadMIPSTextureImage(g_CmdPrams.SourceFile.c_str(), &g_MipSetIn, g_CmdPrams.use_OCV, &g_pluginManager) != 0)
+            int LoadResult;
+            if (!(UsePipeline && SourcePipeline.Take(g_CmdPrams.SourceFile, g_MipSetIn, LoadResult, SourcePrepared)))
+                LoadResult = AMDLoadMIPSTextureImage(g_CmdPrams.SourceFile.c_str(), &g_MipSetIn, g_CmdPrams.use_OCV, &g_pluginManager);
+
+            if (LoadResult != 0)
             {
                 cleanup(Delete_gMipSetIn, SwizzledMipSetIn);
                 PrintInfo("Error: loading source image\n");
@@ -2630,7 +3015,7 @@ int ProcessCMDLine(CMP_Feedback_Proc pFeedbackProc, MipSet* p_userMipSetIn)
         }
         else
         {
-            if (g_MipSetIn.m_swizzle)
+            if (g_MipSetIn.m_swizzle && !SourcePrepared)
                 SwizzleMipMap(&g_MipSetIn);
         }
 
@@ -2638,36 +3023,8 @@ int ProcessCMDLine(CMP_Feedback_Proc pFeedbackProc, MipSet* p_userMipSetIn)
         // Determine if MIP mapping is required
         // if so generate the MIP levels for the source file
         //=======================================================
-        if (((g_CmdPrams.MipsLevel > 1) && (g_MipSetIn.m_nMipLevels == 1)) && (!g_CmdPrams.use_noMipMaps))
-        {
-            int nMinSize;
-            // Precheck user setting against image size
-            CMP_INT nHeight     = g_MipSetIn.m_nHeight;
-            CMP_INT nWidth      = g_MipSetIn.m_nWidth;
-            CMP_INT maxLevel    = 1; // count from top level
-            CMP_INT MipsLevel   = g_CmdPrams.MipsLevel;
-            while (MipsLevel > 0) {
-                maxLevel++;
-                nWidth  = CMP_MAX(nWidth >> 1, 1);
-                nHeight = CMP_MAX(nHeight >> 1, 1);
-                if ((nWidth <= 1) || (nHeight <= 1))
-                    break;
-                MipsLevel--;
-            }
-
-            // User has two option to specify MIP levels
-            if (g_CmdPrams.nMinSize > 0) {
-                nMinSize = g_CmdPrams.nMinSize;
-            }
-            else
-            {
-                if (maxLevel < g_CmdPrams.MipsLevel)
-                    PrintInfo("Warning miplevels %d is larger then required, value is autoset to use %d\n", g_CmdPrams.MipsLevel,maxLevel);
-                nMinSize = CMP_CalcMinMipSize(g_MipSetIn.m_nHeight, g_MipSetIn.m_nWidth, g_CmdPrams.MipsLevel);
-            }
-
-            CMP_GenerateMIPLevels((CMP_MipSet *)&g_MipSetIn, nMinSize);
-        }
+        if (!SourcePrepared)
+            GenerateSourceMipLevels(&g_MipSetIn);
 
         // --------------------------------
         // Setup Compressed Mip Set
@@ -2779,7 +3136,17 @@ int ProcessCMDLine(CMP_Feedback_Proc pFeedbackProc, MipSet* p_userMipSetIn)
 #ifdef USE_WITH_COMMANDLINE_TOOL
             PrintInfo("\n");
 #endif
-            if (AMDSaveMIPSTextureImage(g_CmdPrams.DestFile.c_str(), &g_MipSetCmp, g_CmdPrams.use_OCV_out, g_CmdPrams.CompressOptions) != 0)
+            // The file is only read back for a decompress or -log, otherwise it is written while the next image is encoded
+            if (UsePipeline && !g_CmdPrams.doDecompress && !g_CmdPrams.logresults)
+            {
+                // A failed write of the previous image stops processing, as it does on the serial path
+                if (!DestPipeline.Save(g_CmdPrams.DestFile, g_MipSetCmp, g_CmdPrams.CompressOptions))
+                {
+                    cleanup(Delete_gMipSetIn, SwizzledMipSetIn);
+                    return -1;
+                }
+            }
+            else if (AMDSaveMIPSTextureImage(g_CmdPrams.DestFile.c_str(), &g_MipSetCmp, g_CmdPrams.use_OCV_out, g_CmdPrams.CompressOptions) != 0)
             {
                 PrintInfo("Error: saving image failed, write permission denied or format is unsupported for the file extension.\n");
                 cleanup(Delete_gMipSetIn, SwizzledMipSetIn);
@@ -3323,6 +3690,9 @@ int ProcessCMDLine(CMP_Feedback_Proc pFeedbackProc, MipSet* p_userMipSetIn)
 
     } while (MoreSourceFiles);
 
+    if (UsePipeline && !DestPipeline.Finish())
+        processResult = -1;
+
     if (g_CmdPrams.logresults)
     {
         if (Plugin_Analysis)
@@ -246,7 +246,8 @@ void ASTCBlockDecoder::DecompressBlock( BYTE BlockWidth,
                                         BYTE BlockHeight,
                                         BYTE bitness,
                                         float   out[][4],
-                                        BYTE    in[ASTC_COMPRESSED_BLOCK_SIZE])
+                                        BYTE    in[ASTC_COMPRESSED_BLOCK_SIZE],
+                                        const ASTC_Encoder::ASTC_Encode* ASTCEncode)
 {
     // Results Buffer
     astc_codec_image_cpu *img = allocate_image_cpu(bitness, BlockWidth, BlockHeight, 1, 0);
@@ -256,7 +257,7 @@ void ASTCBlockDecoder::DecompressBlock( BYTE BlockWidth,
     physical_compressed_block_cpu pcb = *(physical_compressed_block_cpu *) bp;
     symbolic_compressed_block_cpu scb;
     
-    physical_to_symbolic_cpu(BlockWidth, BlockHeight, 1, pcb, &scb);
+    physical_to_symbolic_cpu(BlockWidth, BlockHeight, 1, pcb, &scb, ASTCEncode);
 
 
     swizzlepattern_cpu swz_decode = { 0, 1, 2, 3 };
@@ -266,11 +267,11 @@ void ASTCBlockDecoder::DecompressBlock( BYTE BlockWidth,
     // decompress_symbolic_block((astc_decode_mode)decode_mode1, BlockWidth, BlockHeight, 1, 0, 0, 0, (symbolic_compressed_block*)&scb, (imageblock_cpu *)&pb);
 
     ASTC_Encoder::astc_decode_mode decode_mode = ASTC_Encoder::DECODE_HDR;
-    decompress_symbolic_block_cpu(decode_mode, BlockWidth, BlockHeight, 1, 0, 0, 0, &scb, &pb);
+    decompress_symbolic_block_cpu(decode_mode, BlockWidth, BlockHeight, 1, 0, 0, 0, &scb, &pb, ASTCEncode);
 
 
 
-    write_imageblock_cpu(img, &pb, BlockWidth, BlockHeight, 1, 0, 0, 0, swz_decode);
+    write_imageblock_cpu(img, &pb, BlockWidth, BlockHeight, 1, 0, 0, 0, swz_decode, ASTCEncode);
 
     // copy results to our output buffer
     int x, y, z;
@@ -26,6 +26,7 @@
 #define _ASTC_DECODE_H_
 
 #include "ASTC/ASTC_Definitions.h"
+#include "ASTC/ASTC_Encode_Kernel.h"
 
 class ASTCBlockDecoder
 {
@@ -40,7 +41,8 @@ public:
                          BYTE BlockHeight,
                          BYTE bitness,
                          float  out[][4],
-                         BYTE   in[ASTC_COMPRESSED_BLOCK_SIZE]);
+                         BYTE   in[ASTC_COMPRESSED_BLOCK_SIZE],
+                         const ASTC_Encoder::ASTC_Encode* ASTCEncode);
 
 private:
     
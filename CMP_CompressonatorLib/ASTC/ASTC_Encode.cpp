@@ -28,6 +28,7 @@
 #include <assert.h>
 #include <float.h>
 #include <math.h>
+#include <string.h>
 #include "ASTC_Encode.h"
 #include "ASTC_Definitions.h"
 #include "softfloat.h"
@@ -47,6 +48,52 @@ int realign_weights(astc_decode_mode decode_mode, int xdim, int ydim, int zdim,
 #define SAFE_DELETE(x) if(x) { delete x; x = NULL;}
 #define SAFE_DELETE_ARR(x) if (x) { delete[] x; x = NULL;}
 
+// Returns true and the colour if every texel of the block, with the same edge clamping
+// as fetch_imageblock_cpu, is the same
+static bool GetSolidColour(
+    const astc_codec_image_cpu *img,
+    int xdim, int ydim, int zdim,
+    int xpos, int ypos, int zpos,
+    uint8_t colour[4])
+{
+    int xsize = img->xsize + 2 * img->padding;
+    int ysize = img->ysize + 2 * img->padding;
+    int zsize = (img->zsize == 1) ? 1 : img->zsize + 2 * img->padding;
+
+    xpos += img->padding;
+    ypos += img->padding;
+    if (img->zsize > 1)
+        zpos += img->padding;
+
+    // Clamped range of the texels the block covers
+    int xFirst = (xpos < 0) ? 0 : ((xpos < xsize) ? xpos : xsize - 1);
+    int yFirst = (ypos < 0) ? 0 : ((ypos < ysize) ? ypos : ysize - 1);
+    int zFirst = (zpos < 0) ? 0 : ((zpos < zsize) ? zpos : zsize - 1);
+    int xLast  = (xpos + xdim <= xsize) ? xpos + xdim - 1 : xsize - 1;
+    int yLast  = (ypos + ydim <= ysize) ? ypos + ydim - 1 : ysize - 1;
+    int zLast  = (zpos + zdim <= zsize) ? zpos + zdim - 1 : zsize - 1;
+
+    uint32_t first;
+    memcpy(&first, &img->imagedata8[zFirst][yFirst][4 * xFirst], 4);
+    for (int zi = zFirst; zi <= zLast; zi++)
+    {
+        for (int yi = yFirst; yi <= yLast; yi++)
+        {
+            const uint8_t *row = img->imagedata8[zi][yi];
+            for (int xi = xFirst; xi <= xLast; xi++)
+            {
+                uint32_t texel;
+                memcpy(&texel, &row[4 * xi], 4);
+                if (texel != first)
+                    return false;
+            }
+        }
+    }
+
+    memcpy(colour, &first, 4);
+    return true;
+}
+
 double ASTCBlockEncoder::CompressBlock_kernel(
     ASTC_Encoder::astc_codec_image *input_image,
     uint8_t *bp,
@@ -62,6 +109,25 @@ double ASTCBlockEncoder::CompressBlock_kernel(
     //ASTC_Encoder::CGU_UINT pixelcount = ASTCEncode->m_ydim * ASTCEncode->m_xdim;
     //ASTC_Encoder::fetch_imageblock(input_image, &pb, pixelcount, ASTCEncode);
 
+    // Blocks of one colour are written as the same UNORM16 constant colour block
+    // compress_symbolic_block makes for them, without fetching the block
+    uint8_t colour[4];
+    const astc_codec_image_cpu *image = (const astc_codec_image_cpu *)input_image;
+    if (!ASTCEncode->m_rgb_force_use_of_hdr && image->imagedata8 &&
+        GetSolidColour(image, ASTCEncode->m_xdim, ASTCEncode->m_ydim, ASTCEncode->m_zdim, x, y, z, colour))
+    {
+        scb.error_block     = 0;
+        scb.block_mode      = -2;
+        scb.partition_count = 0;
+        for (int i = 0; i < 4; i++)
+            scb.constant_color[i] = (int)floor((colour[i] / 255.0f) * 65535.0f + 0.5f);
+
+        *(ASTC_Encoder::physical_compressed_block *)bp = ASTC_Encoder::symbolic_to_physical(&scb, ASTCEncode);
+        m_blockClassCounts[CMP_BLOCK_SOLID]++;
+        return 0.0;
+    }
+    m_blockClassCounts[CMP_BLOCK_COMPLEX]++;
+
     fetch_imageblock_cpu(
         (const astc_codec_image_cpu *)input_image,
         (imageblock_cpu *) &m_pb,
@@ -70,7 +136,8 @@ double ASTCBlockEncoder::CompressBlock_kernel(
         ASTCEncode->m_zdim, 
         x, 
         y, 
-        z
+        z,
+        ASTCEncode
         );
 
 
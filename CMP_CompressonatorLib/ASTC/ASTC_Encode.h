@@ -28,6 +28,7 @@
 #include <float.h>
 #include "ASTC_Definitions.h"
 #include "ASTC_Encode_Kernel.h"
+#include "CMP_BlockClass.h"
 
 class ASTCBlockEncoder
 {
@@ -35,11 +36,14 @@ public:
 
     ASTCBlockEncoder()
     {
+        for (int i = 0; i < CMP_BLOCK_CLASSES; i++)
+            m_blockClassCounts[i] = 0;
     };
 
 
     ~ASTCBlockEncoder()
     {
+        CMP_AddBlockClassCounts(CMP_FORMAT_ASTC, m_blockClassCounts);
     };
 
     // This routine compresses a block and returns the RMS error
@@ -56,6 +60,10 @@ private:
     imageblock                  m_pb;
     symbolic_compressed_block   m_scb;
     physical_compressed_block   m_pcb;
+
+    // Number of blocks that went through each of the block class paths, only solid
+    // blocks have a fast path
+    CMP_DWORD                   m_blockClassCounts[CMP_BLOCK_CLASSES];
 };
 
 #endif
@@ -21,6 +21,10 @@
 
 #include "ASTC_Encode_Kernel.h"
 
+#ifndef __OPENCL_VERSION__
+#include <memory>
+#endif
+
 namespace ASTC_Encoder
 {
 
@@ -10491,10 +10495,30 @@ float compress_symbolic_block(
       endpoints_and_weights eix1[MAX_DECIMATION_MODES];
       endpoints_and_weights eix2[MAX_DECIMATION_MODES];
 
+#ifndef __OPENCL_VERSION__
+      // The CPU encoder runs many blocks at once against the same ASTC_Encode,
+      // each thread needs its own weight scratch arrays
+      struct weight_scratch
+      {
+          float   decimated_weights[2 * MAX_DECIMATION_MODES * MAX_WEIGHTS_PER_BLOCK];
+          uint8_t u8_quantized_decimated_quantized_weights[2 * MAX_WEIGHT_MODES * MAX_WEIGHTS_PER_BLOCK];
+          float   decimated_quantized_weights[2 * MAX_DECIMATION_MODES * MAX_WEIGHTS_PER_BLOCK];
+          float   flt_quantized_decimated_quantized_weights[2 * MAX_WEIGHT_MODES * MAX_WEIGHTS_PER_BLOCK];
+      };
+      static thread_local std::unique_ptr<weight_scratch> scratch;
+      if (!scratch)
+          scratch.reset(new weight_scratch);
+
+      float   *decimated_weights                           = scratch->decimated_weights;
+      uint8_t *u8_quantized_decimated_quantized_weights    = scratch->u8_quantized_decimated_quantized_weights;
+      float   *decimated_quantized_weights                 = scratch->decimated_quantized_weights;
+      float   *flt_quantized_decimated_quantized_weights   = scratch->flt_quantized_decimated_quantized_weights;
+#else
       __global2 float   *decimated_weights                           = ASTCEncode->decimated_weights;
       __global2 uint8_t *u8_quantized_decimated_quantized_weights    = ASTCEncode->u8_quantized_decimated_quantized_weights;
       __global2 float   *decimated_quantized_weights                 = ASTCEncode->decimated_quantized_weights;
       __global2 float   *flt_quantized_decimated_quantized_weights   = ASTCEncode->flt_quantized_decimated_quantized_weights;
+#endif
 
       if (blk->red_min == blk->red_max && blk->green_min == blk->green_max && blk->blue_min == blk->blue_max && blk->alpha_min == blk->alpha_max)
       {
@@ -18,11 +18,24 @@
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <memory>
 
 #include "ASTC_Host.h"
 #include "ASTC_Encode_Kernel.h"
 #include "Compressonator.h"
 
+// Random texel picks of the block size descriptors. Each descriptor starts from the same seed
+// so the tables of a block size are the same however many times and in whatever order the
+// descriptors are built, rand() would also be changed by every other caller in the process.
+static inline int texel_pick_rand(unsigned int& seed)
+{
+    seed = seed * 214013 + 2531011;
+    return (int)((seed >> 16) & 0x7FFF);
+}
+
 
 //================================= ASTC CPU HOST CODE  ===========================================
 
@@ -532,9 +545,10 @@ void construct_block_size_descriptor_3d_host(int xdim, int ydim, int zdim, block
         for (i = 0; i < xdim * ydim * zdim; i++)
             arr[i] = 0;
         int arr_elements_set = 0;
+        unsigned int seed = 1;
         while (arr_elements_set < 64)
         {
-            int idx = rand() % (xdim * ydim * zdim);
+            int idx = texel_pick_rand(seed) % (xdim * ydim * zdim);
             if (arr[idx] == 0)
             {
                 arr_elements_set++;
@@ -997,9 +1011,10 @@ void construct_block_size_descriptor_2d_host(int xdim, int ydim, block_size_desc
         for (i = 0; i < xdim * ydim; i++)
             arr[i] = 0;
         int arr_elements_set = 0;
+        unsigned int seed = 1;
         while (arr_elements_set < 64)
         {
-            int idx = rand() % (xdim * ydim);
+            int idx = texel_pick_rand(seed) % (xdim * ydim);
             if (arr[idx] == 0)
             {
                 arr_elements_set++;
@@ -1972,20 +1987,58 @@ void InitializeASTCSettingsForSetBlockSize(__global ASTC_Encode *ASTCEncode)
     expand_block_artifact_suppression_host(ASTCEncode->m_xdim, ASTCEncode->m_ydim, ASTCEncode->m_zdim, &ASTCEncode->m_ewp);
 }
 
-bool init_ASTC(__global ASTC_Encode *ASTCEncode)
-{
-    prepare_angular_tables(ASTCEncode);
-    build_quantization_mode_table(ASTCEncode);
-    InitializeASTCSettingsForSetBlockSize(ASTCEncode);
-    set_block_size_descriptor(ASTCEncode->m_xdim, ASTCEncode->m_ydim, ASTCEncode->m_zdim, ASTCEncode);
+// Tables of the block size last asked for, they only depend on the block size and are never
+// modified once built, codecs copy them into their own ASTC_Encode
+static std::mutex                           tables_mutex;
+static std::shared_ptr<const ASTC_Encode>   tables_last;
 
+std::shared_ptr<const ASTC_Encode> get_ASTC_tables(unsigned int xdim, unsigned int ydim, unsigned int zdim)
+{
+    std::lock_guard<std::mutex> lock(tables_mutex);
+
+    if (tables_last &&
+        (tables_last->m_xdim == xdim) &&
+        (tables_last->m_ydim == ydim) &&
+        (tables_last->m_zdim == zdim))
+        return tables_last;
+
+    std::shared_ptr<ASTC_Encode> tables(new ASTC_Encode());
+    tables->m_xdim = xdim;
+    tables->m_ydim = ydim;
+    tables->m_zdim = zdim;
 #ifdef ASTC_ENABLE_3D_SUPPORT
-    ASTCEncode->m_texels_per_block = ASTCEncode->m_xdim * ASTCEncode->m_ydim * ASTCEncode->m_zdim;
+    tables->m_texels_per_block = xdim * ydim * zdim;
 #else
-    ASTCEncode->m_texels_per_block = ASTCEncode->m_xdim * ASTCEncode->m_ydim;
+    tables->m_texels_per_block = xdim * ydim;
 #endif
-    ASTCEncode->m_ptindex = ASTCEncode->m_xdim + 16 * ASTCEncode->m_ydim + 256 * ASTCEncode->m_zdim;
-    generate_partition_tables(ASTCEncode->m_xdim, ASTCEncode->m_ydim, ASTCEncode->m_zdim, ASTCEncode);
+    tables->m_ptindex = xdim + 16 * ydim + 256 * zdim;
+
+    prepare_angular_tables(tables.get());
+    build_quantization_mode_table(tables.get());
+    set_block_size_descriptor(xdim, ydim, zdim, tables.get());
+    generate_partition_tables(xdim, ydim, zdim, tables.get());
+
+    tables_last = tables;
+    return tables_last;
+}
+
+bool init_ASTC(__global ASTC_Encode *ASTCEncode)
+{
+    std::shared_ptr<const ASTC_Encode> tables = get_ASTC_tables(ASTCEncode->m_xdim, ASTCEncode->m_ydim, ASTCEncode->m_zdim);
+
+    memcpy(ASTCEncode->quantization_mode_table, tables->quantization_mode_table, sizeof(tables->quantization_mode_table));
+    memcpy(ASTCEncode->sin_table, tables->sin_table, sizeof(tables->sin_table));
+    memcpy(ASTCEncode->cos_table, tables->cos_table, sizeof(tables->cos_table));
+    memcpy(ASTCEncode->stepsizes, tables->stepsizes, sizeof(tables->stepsizes));
+    memcpy(ASTCEncode->stepsizes_sqr, tables->stepsizes_sqr, sizeof(tables->stepsizes_sqr));
+    memcpy(ASTCEncode->max_angular_steps_needed_for_quant_level, tables->max_angular_steps_needed_for_quant_level,
+           sizeof(tables->max_angular_steps_needed_for_quant_level));
+    ASTCEncode->bsd = tables->bsd;
+    memcpy(ASTCEncode->partition_tables, tables->partition_tables, sizeof(tables->partition_tables));
+    ASTCEncode->m_texels_per_block = tables->m_texels_per_block;
+    ASTCEncode->m_ptindex          = tables->m_ptindex;
+
+    InitializeASTCSettingsForSetBlockSize(ASTCEncode);
     return true;
 }
 
@@ -1994,8 +2047,6 @@ bool init_ASTC(__global ASTC_Encode *ASTCEncode)
 //=====================================================================================================================================
 // CPU Based Decoder code
 
-extern ASTC_Encoder::ASTC_Encode g_ASTCEncode;
-
 void initialize_decimation_table_2d_cpu(
     // dimensions of the block
     int xdim, int ydim,
@@ -2224,9 +2275,10 @@ void construct_block_size_descriptor_2d_cpu(int xdim, int ydim, block_size_descr
         for (i = 0; i < xdim * ydim; i++)
             arr[i] = 0;
         int arr_elements_set = 0;
+        unsigned int seed = 1;
         while (arr_elements_set < 64)
         {
-            int idx = rand() % (xdim * ydim);
+            int idx = texel_pick_rand(seed) % (xdim * ydim);
             if (arr[idx] == 0)
             {
                 arr_elements_set++;
@@ -2371,9 +2423,10 @@ void construct_block_size_descriptor_3d(int xdim, int ydim, int zdim, block_size
         for (i = 0; i < xdim * ydim * zdim; i++)
             arr[i] = 0;
         int arr_elements_set = 0;
+        unsigned int seed = 1;
         while (arr_elements_set < 64)
         {
-            int idx = rand() % (xdim * ydim * zdim);
+            int idx = texel_pick_rand(seed) % (xdim * ydim * zdim);
             if (arr[idx] == 0)
             {
                 arr_elements_set++;
@@ -2393,29 +2446,37 @@ void construct_block_size_descriptor_3d(int xdim, int ydim, int zdim, block_size
 }
 #endif
 
-static block_size_descriptor_cpu *bsd_pointers[4096];
+static std::atomic<block_size_descriptor_cpu *> bsd_pointers[4096];
+static std::mutex                               bsd_mutex;
 
 // function to obtain a block size descriptor. If the descriptor does not exist,
-// it is created as needed. Should not be called from within multithreaded code.
+// it is created as needed. Descriptors are never changed once published, so
+// decoders on other threads can use them without a lock.
 block_size_descriptor_cpu *get_block_size_descriptor_cpu(int xdim, int ydim, int zdim)
 {
     int bsd_index = xdim + (ydim << 4) + (zdim << 8);
-    if (bsd_pointers[bsd_index] == NULL)
+    block_size_descriptor_cpu *bsd = bsd_pointers[bsd_index].load(std::memory_order_acquire);
+    if (bsd == NULL)
     {
-        block_size_descriptor_cpu *bsd = new block_size_descriptor_cpu;
+        std::lock_guard<std::mutex> lock(bsd_mutex);
+        bsd = bsd_pointers[bsd_index].load(std::memory_order_relaxed);
+        if (bsd == NULL)
+        {
+            bsd = new block_size_descriptor_cpu;
 #ifdef ASTC_ENABLE_3D_SUPPORT
-        if (zdim > 1)
-            construct_block_size_descriptor_3d(xdim, ydim, zdim, bsd);
-        else
+            if (zdim > 1)
+                construct_block_size_descriptor_3d(xdim, ydim, zdim, bsd);
+            else
 #endif
-            construct_block_size_descriptor_2d_cpu(xdim, ydim, bsd);
+                construct_block_size_descriptor_2d_cpu(xdim, ydim, bsd);
 
-        bsd_pointers[bsd_index] = bsd;
+            bsd_pointers[bsd_index].store(bsd, std::memory_order_release);
+        }
     }
-    return bsd_pointers[bsd_index];
+    return bsd;
 }
 
-void physical_to_symbolic_cpu(int xdim, int ydim, int zdim, physical_compressed_block_cpu pb, symbolic_compressed_block_cpu * res)
+void physical_to_symbolic_cpu(int xdim, int ydim, int zdim, physical_compressed_block_cpu pb, symbolic_compressed_block_cpu * res, const ASTC_Encoder::ASTC_Encode *ASTCEncode)
 {
     uint8_t bswapped[16];
     int i, j;
@@ -2594,7 +2655,7 @@ void physical_to_symbolic_cpu(int xdim, int ydim, int zdim, physical_compressed_
     if (color_bits < 0)
         color_bits = 0;
 
-    int color_quantization_level = g_ASTCEncode.quantization_mode_table[color_integer_count >> 1][color_bits];
+    int color_quantization_level = ASTCEncode->quantization_mode_table[color_integer_count >> 1][color_bits];
     res->color_quantization_level = color_quantization_level;
     if (color_quantization_level < 4)
         res->error_block = 1;
@@ -2791,7 +2852,8 @@ void fetch_imageblock_cpu(
                             // block dimensions
     int xdim, int ydim, int zdim,
     // position in texture.
-    int xpos, int ypos, int zpos
+    int xpos, int ypos, int zpos,
+    const ASTC_Encoder::ASTC_Encode *ASTCEncode
 )
 {
     float *fptr = pb->orig_data;
@@ -2917,8 +2979,8 @@ void fetch_imageblock_cpu(
     // impose the choice on every pixel when encoding.
     for (i = 0; i < pixelcount; i++)
     {
-        pb->rgb_lns[i]      = (uint8_t)g_ASTCEncode.m_rgb_force_use_of_hdr;
-        pb->alpha_lns[i]    = (uint8_t)g_ASTCEncode.m_alpha_force_use_of_hdr;
+        pb->rgb_lns[i]      = (uint8_t)ASTCEncode->m_rgb_force_use_of_hdr;
+        pb->alpha_lns[i]    = (uint8_t)ASTCEncode->m_alpha_force_use_of_hdr;
         pb->nan_texel[i]    = 0;
     }
 
@@ -3037,7 +3099,8 @@ void initialize_image_cpu(astc_codec_image_cpu * img)
 
 void write_imageblock_cpu(astc_codec_image_cpu * img, const imageblock_cpu * pb,
     int xdim, int ydim, int zdim,
-    int xpos, int ypos, int zpos, swizzlepattern_cpu swz)
+    int xpos, int ypos, int zpos, swizzlepattern_cpu swz,
+    const ASTC_Encoder::ASTC_Encode *ASTCEncode)
 {
     const float *fptr = pb->orig_data;
     const uint8_t *nptr = pb->nan_texel;
@@ -3077,7 +3140,7 @@ void write_imageblock_cpu(astc_codec_image_cpu * img, const imageblock_cpu * pb,
                         {
 #ifdef USE_PERFORMM_SRGB_TRANSFORM
                             // apply swizzle
-                            if (g_ASTCEncode.m_perform_srgb_transform)
+                            if (ASTCEncode->m_perform_srgb_transform)
                             {
                                 float r = fptr[0];
                                 float g = fptr[1];
@@ -3177,7 +3240,7 @@ void write_imageblock_cpu(astc_codec_image_cpu * img, const imageblock_cpu * pb,
                         {
 #ifdef USE_PERFORMM_SRGB_TRANSFORM
                             // apply swizzle
-                            if (g_ASTCEncode.m_perform_srgb_transform)
+                            if (ASTCEncode->m_perform_srgb_transform)
                             {
                                 float r = fptr[0];
                                 float g = fptr[1];
@@ -3444,7 +3507,7 @@ void imageblock_initialize_orig_from_work_cpu(imageblock_cpu * pb, int pixelcoun
     imageblock_initialize_deriv_from_work_and_orig_cpu(pb, pixelcount);
 }
 
-void unpack_color_endpoints_cpu(ASTC_Encoder::astc_decode_mode decode_mode, int format, int quantization_level,  int *input, int *rgb_hdr, int *alpha_hdr, int *nan_endpoint, ASTC_Encoder::ushort4 * output0, ASTC_Encoder::ushort4 * output1)
+void unpack_color_endpoints_cpu(ASTC_Encoder::astc_decode_mode decode_mode, int format, int quantization_level,  int *input, int *rgb_hdr, int *alpha_hdr, int *nan_endpoint, ASTC_Encoder::ushort4 * output0, ASTC_Encoder::ushort4 * output1, const ASTC_Encoder::ASTC_Encode *ASTCEncode)
 {
     *nan_endpoint = 0;
 
@@ -3554,7 +3617,7 @@ void unpack_color_endpoints_cpu(ASTC_Encoder::astc_decode_mode decode_mode, int
 
     if (*alpha_hdr == -1)
     {
-        if (g_ASTCEncode.m_alpha_force_use_of_hdr)
+        if (ASTCEncode->m_alpha_force_use_of_hdr)
         {
             output0->w = 0x7800;
             output1->w = 0x7800;
@@ -3706,7 +3769,8 @@ void decompress_symbolic_block_cpu(ASTC_Encoder::astc_decode_mode decode_mode,
 							   int xdim, int ydim, int zdim,   // dimensions of block
 							   int xpos, int ypos, int zpos,   // position of block
 							   symbolic_compressed_block_cpu * scb, 
-                               imageblock_cpu * blk)
+                               imageblock_cpu * blk,
+                               const ASTC_Encoder::ASTC_Encode *ASTCEncode)
 {
 	blk->xpos = xpos;
 	blk->ypos = ypos;
@@ -3850,7 +3914,8 @@ void decompress_symbolic_block_cpu(ASTC_Encoder::astc_decode_mode decode_mode,
             &(alpha_hdr_endpoint[i]), 
             &(nan_endpoint[i]), 
             &(color_endpoint0[i]), 
-            &(color_endpoint1[i]));
+            &(color_endpoint1[i]),
+            ASTCEncode);
 
 	// first unquantize the weights
 	int uq_plane1_weights[MAX_WEIGHTS_PER_BLOCK];
@@ -3891,7 +3956,7 @@ void decompress_symbolic_block_cpu(ASTC_Encoder::astc_decode_mode decode_mode,
 	// each texel.
 	for (i = 0; i < texels_per_block; i++)
 	{
-        ASTC_Encoder::uint8_t partition = g_ASTCEncode.partition_tables[partition_count][scb->partition_index].partition_of_texel[i];
+        ASTC_Encoder::uint8_t partition = ASTCEncode->partition_tables[partition_count][scb->partition_index].partition_of_texel[i];
  
         ASTC_Encoder::ushort4 color = lerp_color_int(decode_mode,
 									   color_endpoint0[partition],
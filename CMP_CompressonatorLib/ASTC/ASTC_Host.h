@@ -37,6 +37,7 @@
 #include <math.h>       /* floor */
 #include <algorithm>    // std::max
 #include <cstdint>
+#include <memory>
 
 
 namespace ASTC_Encoder
@@ -4758,6 +4759,7 @@ namespace ASTC_Encoder
     };
 
     bool init_ASTC(__global ASTC_Encode *ASTCEncode);
+    std::shared_ptr<const ASTC_Encode> get_ASTC_tables(unsigned int xdim, unsigned int ydim, unsigned int zdim);
     void InitializeASTCSettingsForSetBlockSize(__global ASTC_Encode *ASTCEncode);
 
     extern float sf16_to_float(CGU_SHORT p);
@@ -4914,18 +4916,20 @@ namespace ASTC_Encoder
     
     void imageblock_initialize_orig_from_work_cpu(imageblock_cpu * pb, int pixelcount);
     void imageblock_initialize_work_from_orig_cpu(imageblock_cpu * pb, int pixelcount);
-    void physical_to_symbolic_cpu(int xdim, int ydim, int zdim, physical_compressed_block_cpu pb, symbolic_compressed_block_cpu * res);
+    void physical_to_symbolic_cpu(int xdim, int ydim, int zdim, physical_compressed_block_cpu pb, symbolic_compressed_block_cpu * res, const ASTC_Encoder::ASTC_Encode *ASTCEncode);
 
     void update_imageblock_flags_cpu(imageblock_cpu * pb, int xdim, int ydim, int zdim);
 
     void decompress_symbolic_block_cpu(ASTC_Encoder::astc_decode_mode decode_mode,
         int xdim, int ydim, int zdim,   // dimensions of block
         int xpos, int ypos, int zpos,   // position of block
-        symbolic_compressed_block_cpu * scb, imageblock_cpu * blk);
+        symbolic_compressed_block_cpu * scb, imageblock_cpu * blk,
+        const ASTC_Encoder::ASTC_Encode *ASTCEncode);
 
     void write_imageblock_cpu(astc_codec_image_cpu * img, const imageblock_cpu * pb,
         int xdim, int ydim, int zdim,
-        int xpos, int ypos, int zpos, swizzlepattern_cpu swz);
+        int xpos, int ypos, int zpos, swizzlepattern_cpu swz,
+        const ASTC_Encoder::ASTC_Encode *ASTCEncode);
 
     void destroy_image_cpu(astc_codec_image_cpu * img);
 
@@ -4937,7 +4941,8 @@ namespace ASTC_Encoder
                                 // block dimensions
         int xdim, int ydim, int zdim,
         // position in texture.
-        int xpos, int ypos, int zpos
+        int xpos, int ypos, int zpos,
+        const ASTC_Encoder::ASTC_Encode *ASTCEncode
     );
 
 #ifdef __OPENCL_VERSION__
@@ -25,10 +25,13 @@
 #include "ASTC/ASTC_Definitions.h"
 #include "ASTC/ASTC_Encode.h"
 #include "ASTC/ASTC_Decode.h"
+#include "ASTC/ASTC_Host.h"
 #include "Compressonator.h"
 
+#include <atomic>
 
-extern CMP_BOOL g_LibraryInitialized;
+
+extern std::atomic<bool> g_LibraryInitialized;
 static ASTCBlockDecoder  g_Decoder;
 
 // Need to remove these calls 
@@ -64,7 +67,9 @@ extern "C" BC_ERROR CMP_DecodeASTCBlock( CMP_BYTE BlockWidth,
         return BC_ERROR_INVALID_PARAMETERS;
     }
 
-    g_Decoder.DecompressBlock(BlockWidth, BlockHeight, Bitness, out, in);
+    // Tables for the block size, built here if no codec has used it last
+    std::shared_ptr<const ASTC_Encoder::ASTC_Encode> tables = ASTC_Encoder::get_ASTC_tables(BlockWidth, BlockHeight, 1);
+    g_Decoder.DecompressBlock(BlockWidth, BlockHeight, Bitness, out, in, tables.get());
     return BC_ERROR_NONE;
 }
 
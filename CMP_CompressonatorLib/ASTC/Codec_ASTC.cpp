@@ -42,6 +42,7 @@
 
 #include <chrono>
 #include <cstring>
+#include <vector>
 
 #ifdef ASTC_COMPDEBUGGER
 #include "CompClient.h"
@@ -54,28 +55,6 @@ extern    CompViewerClient g_CompClient;
 // Gets the total numver of active processor cores on the running host system
 extern CMP_INT CMP_GetNumberOfProcessors();
 
-struct ASTCEncodeThreadParam
-{
-    ASTCBlockEncoder   *encoder;
-
-    // Encoder params
-    astc_codec_image *input_image;
-    uint8_t *bp;
-    int xdim;
-    int ydim;
-    int zdim;
-    int x;
-    int y;
-    int z;
-    astc_decode_mode decode_mode;
-    const error_weighting_params * ewp;
-
-    volatile CMP_BOOL      run;
-    volatile CMP_BOOL      exit;
-};
-
-static ASTCEncodeThreadParam *g_EncodeParameterStorage = NULL;
-
 //////////////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////////////
@@ -85,12 +64,13 @@ CCodec_ASTC::CCodec_ASTC() : CCodec_DXTC(CT_ASTC)
     m_LibraryInitialized    = false;
     m_AbortRequested        = false;
     m_NumThreads            = 0;
-    m_NumEncodingThreads    = 0; // new auto setting to use max processors * 2 threads
-    m_EncodingThreadHandle  = NULL;
+    m_NumEncodingThreads    = 0; // 0 = use all the thread pool workers
+    m_Use_MultiThreading    = true;
     m_xdim                  = 4;
     m_ydim                  = 4;
     m_zdim                  = 1;
     m_decoder               = NULL;
+    m_ASTCEncode            = NULL;
     m_Quality               = 0.05;
 }
 
@@ -99,63 +79,7 @@ CCodec_ASTC::~CCodec_ASTC()
 {
     if (m_LibraryInitialized)
     {
-
-        if (m_Use_MultiThreading)
-        {
-            // Tell all the live threads that they can exit when they have finished any current work
-            for (int i = 0; i < m_LiveThreads; i++)
-            {
-                // If a thread is in the running state then we need to wait for it to finish
-                // any queued work from the producer before we can tell it to exit.
-                //
-                // If we don't wait then there is a race condition here where we have
-                // told the thread to run but it hasn't yet been scheduled - if we set
-                // the exit flag before it runs then its block will not be processed.
-#pragma warning(push)
-#pragma warning(disable:4127) //warning C4127: conditional expression is constant
-                while (1)
-                {
-                    if (g_EncodeParameterStorage[i].run != TRUE)
-                    {
-                        break;
-                    }
-                }
-#pragma warning(pop)
-                // Signal to the thread that it can exit
-                g_EncodeParameterStorage[i].exit = TRUE;
-            }
-
-            // Now wait for all threads to have exited
-            if (m_LiveThreads > 0)
-            {
-                for ( CMP_DWORD dwThread = 0; dwThread < m_LiveThreads; dwThread++ )
-                {
-                    std::thread& curThread = m_EncodingThreadHandle[dwThread];
-
-                    curThread.join();
-                }
-            }
-
-            for (unsigned int i = 0; i < m_LiveThreads; i++)
-            {
-                std::thread& curThread = m_EncodingThreadHandle[i];
-
-                curThread = std::thread();
-            }
-
-            delete[] m_EncodingThreadHandle;
-        } // MultiThreading
-
-        m_EncodingThreadHandle = NULL;
-
-        if (g_EncodeParameterStorage)
-        {
-            delete[] g_EncodeParameterStorage;
-            g_EncodeParameterStorage = NULL;
-        }
-
-
-        for (int i = 0; i < m_NumEncodingThreads; i++)
+        for (int i = 0; i < CMP_MAX_POOL_SLOTS; i++)
         {
             if (m_encoder[i])
             {
@@ -171,6 +95,12 @@ CCodec_ASTC::~CCodec_ASTC()
             m_decoder = NULL;
         }
 
+        if (m_ASTCEncode)
+        {
+            delete m_ASTCEncode;
+            m_ASTCEncode = NULL;
+        }
+
         m_LibraryInitialized = false;
     }
 }
@@ -334,160 +264,47 @@ bool CCodec_ASTC::SetParameter(const CMP_CHAR* pszParamName, CODECFLOAT fValue)
 }
 
 
-//
-// Thread procedure for encoding a block
-//
-// The thread stays alive, and expects blocks to be pushed to it by a producer
-// process that signals it when new work is available. When the producer is finished
-// it should set the exit flag in the parameters to allow the tread to quit
-//
-
 #include "ASTC_Host.h"
-ASTC_Encoder::ASTC_Encode  g_ASTCEncode;
 
 
-unsigned int ASTCThreadProcEncode(void* param)
+CodecError CCodec_ASTC::InitializeASTCLibrary()
 {
-    ASTCEncodeThreadParam *tp = (ASTCEncodeThreadParam*)param;
-
-    while (tp->exit == FALSE)
+    if (!m_LibraryInitialized)
     {
-        if (tp->run == TRUE)
+        // Each codec has its own settings and copy of the block size tables
+        m_ASTCEncode = new ASTC_Encoder::ASTC_Encode();
+        if (!m_ASTCEncode)
         {
-            g_ASTCEncode.m_xdim = tp->xdim;
-            g_ASTCEncode.m_ydim = tp->ydim;
-            g_ASTCEncode.m_zdim = tp->zdim;
-
-            tp->encoder->CompressBlock_kernel(
-                (ASTC_Encoder::astc_codec_image *)tp->input_image,
-                tp->bp,
-                tp->x,
-                tp->y,
-                tp->z,
-                &g_ASTCEncode);
-
-            tp->run = FALSE;
+            return CE_Unknown;
         }
 
-        using namespace std::chrono_literals;
-
-        std::this_thread::sleep_for( 0ms );
-    }
-
-    return 0;
-}
-
-
-CodecError CCodec_ASTC::InitializeASTCLibrary()
-{
-    if (!m_LibraryInitialized)
-    {
-        g_ASTCEncode.m_decode_mode              = ASTC_Encoder::DECODE_HDR;
-        g_ASTCEncode.m_rgb_force_use_of_hdr     = 0;
-        g_ASTCEncode.m_alpha_force_use_of_hdr   = 0;
-        g_ASTCEncode.m_perform_srgb_transform   = 0;
-        g_ASTCEncode.m_Quality                  = (float)m_Quality;
-        g_ASTCEncode.m_target_bitrate           = m_target_bitrate;
-        g_ASTCEncode.m_xdim = m_xdim;
-        g_ASTCEncode.m_ydim = m_ydim;
-        g_ASTCEncode.m_zdim = m_zdim;
-        ASTC_Encoder::init_ASTC(&g_ASTCEncode);
+        m_ASTCEncode->m_decode_mode              = ASTC_Encoder::DECODE_HDR;
+        m_ASTCEncode->m_rgb_force_use_of_hdr     = 0;
+        m_ASTCEncode->m_alpha_force_use_of_hdr   = 0;
+        m_ASTCEncode->m_perform_srgb_transform   = 0;
+        m_ASTCEncode->m_Quality                  = (float)m_Quality;
+        m_ASTCEncode->m_target_bitrate           = m_target_bitrate;
+        m_ASTCEncode->m_xdim = m_xdim;
+        m_ASTCEncode->m_ydim = m_ydim;
+        m_ASTCEncode->m_zdim = m_zdim;
+        ASTC_Encoder::init_ASTC(m_ASTCEncode);
 
         //====================== Threads
-        for (CMP_DWORD i = 0; i < MAX_ASTC_THREADS; i++)
+        for (CMP_DWORD i = 0; i < CMP_MAX_POOL_SLOTS; i++)
         {
             m_encoder[i] = NULL;
         }
 
-        // Create threaded encoder instances
-        m_LiveThreads = 0;
-        m_LastThread = 0;
+        // Block rows are encoded by the library thread pool, m_NumThreads limits
+        // how many of its workers this codec may use at once (0 = all of them)
         m_NumEncodingThreads = min(m_NumThreads, (decltype(m_NumThreads))MAX_ASTC_THREADS);
-        if (m_NumEncodingThreads == 0)
-        {
-            m_NumEncodingThreads = CMP_GetNumberOfProcessors();
-            if (m_NumEncodingThreads <= 2)
-                m_NumEncodingThreads = 8; // fallback to a default!
-            if (m_NumEncodingThreads > 128)
-                m_NumEncodingThreads = 128;
-        }
         m_Use_MultiThreading = (m_NumEncodingThreads != 1);
 
-        g_EncodeParameterStorage = new ASTCEncodeThreadParam[m_NumEncodingThreads];
-        if (!g_EncodeParameterStorage)
-        {
-            return CE_Unknown;
-        }
-
-        m_EncodingThreadHandle = new std::thread[m_NumEncodingThreads];
-        if (!m_EncodingThreadHandle)
-        {
-            delete[] g_EncodeParameterStorage;
-            g_EncodeParameterStorage = NULL;
-
-            return CE_Unknown;
-        }
-
-        CMP_INT   i;
-
-        for (i = 0; i < m_NumEncodingThreads; i++)
-        {
-            // Create single encoder instance
-            m_encoder[i] = new ASTCBlockEncoder();
-
-
-            // Cleanup if problem!
-            if (!m_encoder[i])
-            {
-
-                delete[] g_EncodeParameterStorage;
-                g_EncodeParameterStorage = NULL;
-
-                delete[] m_EncodingThreadHandle;
-                m_EncodingThreadHandle = NULL;
-
-                for (CMP_INT j = 0; j<i; j++)
-                {
-                    delete m_encoder[j];
-                    m_encoder[j] = NULL;
-                }
-
-                return CE_Unknown;
-            }
-
-#ifdef USE_DBGTRACE
-            //DbgTrace(("Encoder[%d]:ModeMask %X, Quality %f", i, m_ModeMask, m_Quality));
-#endif
-
-        }
-
-        // Create the encoding threads
-        for (i = 0; i<m_NumEncodingThreads; i++)
-        {
-            // Initialize thread parameters.
-            g_EncodeParameterStorage[i].encoder = m_encoder[i];
-            // Inform the thread that at the moment it doesn't have any work to do
-            // but that it should wait for some and not exit
-            g_EncodeParameterStorage[i].run = FALSE;
-            g_EncodeParameterStorage[i].exit = FALSE;
-
-            m_EncodingThreadHandle[i] = std::thread(
-                ASTCThreadProcEncode,
-                (void*)&g_EncodeParameterStorage[i]
-            );
-            m_LiveThreads++;
-        }
-
         // Create single decoder instance
         m_decoder = new ASTCBlockDecoder();
 
         if (!m_decoder)
         {
-            for (CMP_INT j = 0; j<m_NumEncodingThreads; j++)
-            {
-                delete m_encoder[j];
-                m_encoder[j] = NULL;
-            }
             return CE_Unknown;
         }
 
@@ -496,101 +313,34 @@ CodecError CCodec_ASTC::InitializeASTCLibrary()
     return CE_OK;
 }
 
+// Returns the encoder owned by the calling thread's pool slot
+ASTCBlockEncoder* CCodec_ASTC::GetEncoder()
+{
+    CMP_INT slot = CMP_ThreadPool::GetWorkerSlot();
+    if (m_encoder[slot] == NULL)
+        m_encoder[slot] = new ASTCBlockEncoder();
+    return m_encoder[slot];
+}
+
 CodecError CCodec_ASTC::EncodeASTCBlock(
     astc_codec_image *input_image,
     uint8_t *bp,
-    int xdim,
-    int ydim,
-    int zdim,
     int x,
     int y,
     int z)
 {
-    if (m_Use_MultiThreading)
-    {
-        CMP_WORD   threadIndex;
-
-        // Loop and look for an available thread
-        CMP_BOOL found = FALSE;
-        threadIndex = m_LastThread;
-        while (found == FALSE)
-        {
-
-            if (g_EncodeParameterStorage == NULL)
-                return CE_Unknown;
-
-            if (g_EncodeParameterStorage[threadIndex].run == FALSE)
-            {
-                found = TRUE;
-                break;
-            }
-
-            // Increment and wrap the thread index
-            threadIndex++;
-            if (threadIndex == m_LiveThreads)
-            {
-                threadIndex = 0;
-            }
-        }
-
-        m_LastThread = threadIndex;
-
-        g_EncodeParameterStorage[threadIndex].input_image = input_image;
-        g_EncodeParameterStorage[threadIndex].bp = bp;
-        g_EncodeParameterStorage[threadIndex].xdim = xdim;
-        g_EncodeParameterStorage[threadIndex].ydim = ydim;
-        g_EncodeParameterStorage[threadIndex].zdim = zdim;
-        g_EncodeParameterStorage[threadIndex].x = x;
-        g_EncodeParameterStorage[threadIndex].y = y;
-        g_EncodeParameterStorage[threadIndex].z = z;
-        // Tell the thread to start working
-        g_EncodeParameterStorage[threadIndex].run = TRUE;
-    }
-    else
-    {
-        g_ASTCEncode.m_xdim = xdim;
-        g_ASTCEncode.m_ydim = ydim;
-        g_ASTCEncode.m_zdim = zdim;
-
-        m_encoder[0]->CompressBlock_kernel(
-            (ASTC_Encoder::astc_codec_image *)input_image, 
-            bp, 
-            x,
-            y,
-            z,
-            &g_ASTCEncode);
-    }
-    return CE_OK;
-}
-
-
-CodecError CCodec_ASTC::FinishASTCEncoding(void)
-{
-    if (!m_LibraryInitialized)
-    {
+    ASTCBlockEncoder* encoder = GetEncoder();
+    if (!encoder)
         return CE_Unknown;
-    }
-
-    if (!g_EncodeParameterStorage)
-    {
-        return CE_Unknown;
-    }
 
-    if (m_Use_MultiThreading)
-    {
-        // Wait for all the live threads to finish any current work
-        for (CMP_DWORD i = 0; i < m_LiveThreads; i++)
-        {
-            // If a thread is in the running state then we need to wait for it to finish
-            // its work from the producer
-            while (g_EncodeParameterStorage[i].run == TRUE)
-            {
-                using namespace std::chrono;
+    encoder->CompressBlock_kernel(
+        (ASTC_Encoder::astc_codec_image *)input_image,
+        bp,
+        x,
+        y,
+        z,
+        m_ASTCEncode);
 
-                std::this_thread::sleep_for( 1ms );
-            }
-        }
-    }
     return CE_OK;
 }
 
@@ -693,32 +443,22 @@ CodecError CCodec_ASTC::Compress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut
     // Loop through the original input image and setup compression threads for each 
     // block to encode  we will load the buffer to pass to ASTC code as 8 bit 4x4 blocks
     // the fill in source image. ASTC code will then use the adaptive sizes for process on the input
-    BYTE *pData = bufferIn.GetData();
-    int ii = 0;
-    for (int y = 0; y < ysize; y++) {
-        for (int x = 0; x < xsize; x++) {
-            input_image->imagedata8[0][y][4*x      ] = pData[ii];      // Red
-            ii++;
-            input_image->imagedata8[0][y][4 * x + 1] = pData[ii];      // Green
-            ii++;
-            input_image->imagedata8[0][y][4 * x + 2] = pData[ii];      // Blue
-            ii++;
-            input_image->imagedata8[0][y][4 * x + 3] = pData[ii];      // Alpha
-            ii++;
+    // The source is read a row of 4x4 blocks at a time so its pitch is honoured and views convert in place
+    CMP_DWORD dwRowBlocks = (xsize + 3) / 4;
+    std::vector<CMP_BYTE> srcRow(dwRowBlocks * BLOCK_SIZE_4X4X4);
+    for (int y = 0; y < ysize; y += 4) {
+        bufferIn.ReadBlockRowRGBA(0, y, dwRowBlocks, srcRow.data());
+        for (int j = 0; j < 4 && (y + j) < ysize; j++) {
+            for (int x = 0; x < xsize; x++) {
+                const CMP_BYTE* pPixel = &srcRow[((x / 4) * BLOCK_SIZE_4X4X4) + (j * 16) + ((x % 4) * 4)];
+                input_image->imagedata8[0][y + j][4 * x    ] = pPixel[0];      // Red
+                input_image->imagedata8[0][y + j][4 * x + 1] = pPixel[1];      // Green
+                input_image->imagedata8[0][y + j][4 * x + 2] = pPixel[2];      // Blue
+                input_image->imagedata8[0][y + j][4 * x + 3] = pPixel[3];      // Alpha
+            }
         }
     }
 
-    m_NumEncodingThreads = min(m_NumThreads, (decltype(m_NumThreads))MAX_ASTC_THREADS);
-    if (m_NumEncodingThreads == 0)
-    {
-        m_NumEncodingThreads = CMP_GetNumberOfProcessors();
-        if (m_NumEncodingThreads <= 2)
-            m_NumEncodingThreads = 8; // fallback to a default!
-            if (m_NumEncodingThreads > 128)
-                m_NumEncodingThreads = 128;
-
-    }
-
 // Common ARM and AMD Code
     CodecError result = CE_OK;
     int xdim = m_xdim;
@@ -734,36 +474,68 @@ CodecError CCodec_ASTC::Compress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut
     float TotalBlocks = (float) (yblocks * xblocks);
     int processingBlock = 0;
 
-    for (z = 0; z < zblocks; z++)
+    if (m_Use_MultiThreading)
     {
-        for (y = 0; y < yblocks; y++)
+        const CMP_DWORD dwNumBlocks  = xblocks * yblocks * zblocks;
+        const CMP_DWORD dwNumBatches = (dwNumBlocks + ASTC_BLOCKS_PER_BATCH - 1) / ASTC_BLOCKS_PER_BATCH;
+
+        bool bCompleted = CMP_ProcessBatches<ASTCBlockBatch>(dwNumBatches, m_NumEncodingThreads,
+            [&](ASTCBlockBatch& batch, CMP_DWORD dwBatch)
+            {
+                CMP_DWORD dwBlock = dwBatch * ASTC_BLOCKS_PER_BATCH;
+                batch.dwNumBlocks = min(dwNumBlocks - dwBlock, (CMP_DWORD)ASTC_BLOCKS_PER_BATCH);
+                for (CMP_DWORD i = 0; i < batch.dwNumBlocks; i++, dwBlock++)
+                {
+                    batch.x[i]   = (dwBlock % xblocks) * xdim;
+                    batch.y[i]   = ((dwBlock / xblocks) % yblocks) * ydim;
+                    batch.z[i]   = (dwBlock / (xblocks * yblocks)) * zdim;
+                    batch.out[i] = bufferOutput + dwBlock * 16;
+                }
+            },
+            [&](ASTCBlockBatch& batch)
+            {
+                for (CMP_DWORD i = 0; (i < batch.dwNumBlocks) && !IsCanceled(); i++)
+                    EncodeASTCBlock((astc_codec_image *)input_image, batch.out[i], batch.x[i], batch.y[i], batch.z[i]);
+            },
+            [&](float fProgress) { return pFeedbackProc ? pFeedbackProc(fProgress, pUser1, pUser2) : false; },
+            [&]() { return IsCanceled(); });
+
+        if (!bCompleted)
+            result = CE_Aborted;
+    }
+    else
+    {
+        for (z = 0; z < zblocks; z++)
         {
-            for (x = 0; x < xblocks; x++)
+            for (y = 0; y < yblocks; y++)
             {
-                int offset = ((z * yblocks + y) * xblocks + x) * 16;
-                uint8_t *bp = bufferOutput + offset;
-                EncodeASTCBlock((astc_codec_image *)input_image, bp, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim);
-                processingBlock++;
-            }
+                for (x = 0; x < xblocks; x++)
+                {
+                    int offset = ((z * yblocks + y) * xblocks + x) * 16;
+                    uint8_t *bp = bufferOutput + offset;
+                    EncodeASTCBlock((astc_codec_image *)input_image, bp, x * xdim, y * ydim, z * zdim);
+                    processingBlock++;
+                }
 
-            if (pFeedbackProc)
-            {
-                float fProgress = 100.f * ((float)(processingBlock) / TotalBlocks);
-                if (pFeedbackProc(fProgress, pUser1, pUser2))
+                if (IsCanceled())
                 {
                     result = CE_Aborted;
                     break;
                 }
-            }
 
+                if (pFeedbackProc)
+                {
+                    float fProgress = 100.f * ((float)(processingBlock) / TotalBlocks);
+                    if (pFeedbackProc(fProgress, pUser1, pUser2))
+                    {
+                        result = CE_Aborted;
+                        break;
+                    }
+                }
+            }
         }
     }
 
-    CodecError EncodeResult = FinishASTCEncoding();
-
-    if (result != CE_Aborted)
-        result = EncodeResult;
-
     destroy_image_cpu(input_image);
 
 #ifdef ASTC_COMPDEBUGGER
@@ -833,7 +605,7 @@ CodecError CCodec_ASTC::Decompress(CCodecBuffer& bufferIn, CCodecBuffer& bufferO
             bufferIn.ReadBlock(cmpColX*4, cmpRowY*4, CompData.compressedBlock, 4);
 
             // Encode to the appropriate location in the compressed image
-            m_decoder->DecompressBlock(Block_Width, Block_Height, bitness, DecData.decodedBlock,CompData.in);
+            m_decoder->DecompressBlock(Block_Width, Block_Height, bitness, DecData.decodedBlock,CompData.in, m_ASTCEncode);
             
             // Now that we have a decoded block lets copy that data over to the target image buffer
             CMP_DWORD outCol = cmpColX*Block_Width;
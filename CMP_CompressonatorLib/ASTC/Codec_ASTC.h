@@ -30,9 +30,22 @@
 #include "ASTC_Decode.h"
 #include "ASTC_Library.h"
 #include "ASTC_Definitions.h"
+#include "CMP_BlockQueue.h"
 
 #include <thread>
 
+// Number of blocks handed to a pool worker at a time
+#define ASTC_BLOCKS_PER_BATCH   16
+
+struct ASTCBlockBatch
+{
+    CMP_DWORD   dwNumBlocks;
+    int         x[ASTC_BLOCKS_PER_BATCH];
+    int         y[ASTC_BLOCKS_PER_BATCH];
+    int         z[ASTC_BLOCKS_PER_BATCH];
+    uint8_t*    out[ASTC_BLOCKS_PER_BATCH];
+};
+
 class CCodec_ASTC : public CCodec_DXTC
 {
 public:
@@ -58,27 +71,27 @@ private:
     CMP_INT     m_NumEncodingThreads;
     bool        m_AbortRequested;
 
-    int m_xdim, m_ydim, m_zdim;        // Is now implamented and set by user ( defined in g_ASTCEncode )
-    float m_target_bitrate;            // defined in g_ASTCEncode 
+    int m_xdim, m_ydim, m_zdim;        // Is now implamented and set by user ( defined in m_ASTCEncode )
+    float m_target_bitrate;            // defined in m_ASTCEncode 
+
+    // Settings and block size tables shared by this codec's encoders and decoder
+    ASTC_Encoder::ASTC_Encode* m_ASTCEncode;
 
                                        // ASTC Encoders and decoders: for encoding use the interfaces below
+    // Encoders are created on demand, one for each thread pool slot that uses them
     ASTCBlockDecoder*    m_decoder;
-    ASTCBlockEncoder*    m_encoder[MAX_ASTC_THREADS];
+    ASTCBlockEncoder*    m_encoder[CMP_MAX_POOL_SLOTS];
 
     // Encoder interfaces
-    std::thread         *m_EncodingThreadHandle;
+    ASTCBlockEncoder*    GetEncoder();
 
     CodecError      EncodeASTCBlock(
         astc_codec_image *input_image,
         uint8_t *bp,
-        int xdim,
-        int ydim,
-        int zdim,
         int x,
         int y,
         int z);
 
-    CodecError      FinishASTCEncoding();
     CodecError      InitializeASTCLibrary();
 
     // Encoder interfaces
@@ -88,8 +101,6 @@ private:
 
     // Internal status 
     CMP_BOOL    m_Use_MultiThreading;
-    CMP_WORD    m_LiveThreads;
-    CMP_WORD    m_LastThread;
 
     // Speed and Quality
     double  m_Quality;
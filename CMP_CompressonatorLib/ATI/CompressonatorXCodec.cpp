@@ -230,11 +230,18 @@ inline void BldRmp(CODECFLOAT _Rmp[NUM_CHANNELS][MAX_POINTS], CODECFLOAT _InpRmp
 
 /*------------------------------------------------------------------------------------------------
 Compute cumulative error for the current cluster
+The clustering kernels below are instantiated with and without channel weighting (and alpha)
+so those choices are compile time constants inside the per-colour loops
 ------------------------------------------------------------------------------------------------*/
-static CODECFLOAT ClstrErr(CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CODECFLOAT _Rpt[MAX_BLOCK], 
-                           CODECFLOAT _Rmp[NUM_CHANNELS][MAX_POINTS], int _NmbClrs, int _blcktp, 
-                           bool _ConstRamp, CODECFLOAT* _pfWeights)
+template<bool bWeighted>
+static CODECFLOAT ClstrErrT(CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CODECFLOAT _Rpt[MAX_BLOCK], 
+                            CODECFLOAT _Rmp[NUM_CHANNELS][MAX_POINTS], int _NmbClrs, int _blcktp, 
+                            bool _ConstRamp, CODECFLOAT* _pfWeights)
 {
+    const CODECFLOAT fWeightRed = bWeighted ? _pfWeights[0] : 1.f;
+    const CODECFLOAT fWeightGreen = bWeighted ? _pfWeights[1] : 1.f;
+    const CODECFLOAT fWeightBlue = bWeighted ? _pfWeights[2] : 1.f;
+
     CODECFLOAT fError = 0.f;
     int rmp_l = (_ConstRamp) ? 1 : _blcktp;
 
@@ -244,28 +251,16 @@ static CODECFLOAT ClstrErr(CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CODECFLOAT
     {
         CODECFLOAT fShortest = 99999999999.f;
 
-        if(_pfWeights)
-            for(int r=0; r < rmp_l; r++)
-            {
-                // calculate the distance for each component
-                CODECFLOAT fDistance =    (_Blk[i][RC] - _Rmp[RC][r]) * (_Blk[i][RC] - _Rmp[RC][r]) * _pfWeights[0] + 
-                                        (_Blk[i][GC] - _Rmp[GC][r]) * (_Blk[i][GC] - _Rmp[GC][r]) * _pfWeights[1] + 
-                                        (_Blk[i][BC] - _Rmp[BC][r]) * (_Blk[i][BC] - _Rmp[BC][r]) * _pfWeights[2];
-
-                if(fDistance < fShortest)
-                    fShortest = fDistance;
-            }
-        else
-            for(int r=0; r < rmp_l; r++)
-            {
-                // calculate the distance for each component
-                CODECFLOAT fDistance =    (_Blk[i][RC] - _Rmp[RC][r]) * (_Blk[i][RC] - _Rmp[RC][r]) + 
-                                        (_Blk[i][GC] - _Rmp[GC][r]) * (_Blk[i][GC] - _Rmp[GC][r]) + 
-                                        (_Blk[i][BC] - _Rmp[BC][r]) * (_Blk[i][BC] - _Rmp[BC][r]);
+        for(int r=0; r < rmp_l; r++)
+        {
+            // calculate the distance for each component
+            CODECFLOAT fDistance =    (_Blk[i][RC] - _Rmp[RC][r]) * (_Blk[i][RC] - _Rmp[RC][r]) * fWeightRed + 
+                                    (_Blk[i][GC] - _Rmp[GC][r]) * (_Blk[i][GC] - _Rmp[GC][r]) * fWeightGreen + 
+                                    (_Blk[i][BC] - _Rmp[BC][r]) * (_Blk[i][BC] - _Rmp[BC][r]) * fWeightBlue;
 
-                if(fDistance < fShortest)
-                    fShortest = fDistance;
-            }
+            if(fDistance < fShortest)
+                fShortest = fDistance;
+        }
 
         // accumulate the error
         fError += fShortest * _Rpt[i];
@@ -274,11 +269,28 @@ static CODECFLOAT ClstrErr(CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CODECFLOAT
     return fError;
 }
 
+#ifdef USE_SSE
+static CODECFLOAT ClstrErr(CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CODECFLOAT _Rpt[MAX_BLOCK], 
+                           CODECFLOAT _Rmp[NUM_CHANNELS][MAX_POINTS], int _NmbClrs, int _blcktp, 
+                           bool _ConstRamp, CODECFLOAT* _pfWeights)
+{
+    if(_pfWeights)
+        return ClstrErrT<true>(_Blk, _Rpt, _Rmp, _NmbClrs, _blcktp, _ConstRamp, _pfWeights);
+    else
+        return ClstrErrT<false>(_Blk, _Rpt, _Rmp, _NmbClrs, _blcktp, _ConstRamp, _pfWeights);
+}
+#endif // USE_SSE
+
 // Compute error and find DXTC indexes for the current cluster
-static CODECFLOAT ClstrIntnl(CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CMP_BYTE* _Indxs, 
-                             CODECFLOAT _Rmp[NUM_CHANNELS][MAX_POINTS], int dwBlockSize, CMP_BYTE dwNumPoints, 
-                             bool _ConstRamp, CODECFLOAT* _pfWeights, bool _bUseAlpha)
+template<bool bWeighted, bool bUseAlpha>
+static CODECFLOAT ClstrIntnlT(CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CMP_BYTE* _Indxs, 
+                              CODECFLOAT _Rmp[NUM_CHANNELS][MAX_POINTS], int dwBlockSize, CMP_BYTE dwNumPoints, 
+                              bool _ConstRamp, CODECFLOAT* _pfWeights)
 {
+    const CODECFLOAT fWeightRed = bWeighted ? _pfWeights[0] : 1.f;
+    const CODECFLOAT fWeightGreen = bWeighted ? _pfWeights[1] : 1.f;
+    const CODECFLOAT fWeightBlue = bWeighted ? _pfWeights[2] : 1.f;
+
     CODECFLOAT Err = 0.f;
     CMP_BYTE rmp_l = (_ConstRamp) ? 1 : dwNumPoints;
 
@@ -286,40 +298,25 @@ static CODECFLOAT ClstrIntnl(CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CMP_BYTE*
     // to the closest cluster and compute the cumulative error
     for(int i=0; i< dwBlockSize; i++)
     {
-        if(_bUseAlpha && *((DWORD*) &_Blk[i][AC]) == 0)
+        if(bUseAlpha && *((DWORD*) &_Blk[i][AC]) == 0)
             _Indxs[i] = dwNumPoints;
         else
         {
             CODECFLOAT shortest = 99999999999.f;
             CMP_BYTE shortestIndex = 0;
-            if(_pfWeights)
-                for(CMP_BYTE r=0; r < rmp_l; r++)
-                {
-                    // calculate the distance for each component
-                    CODECFLOAT distance =    (_Blk[i][RC] - _Rmp[RC][r]) * (_Blk[i][RC] - _Rmp[RC][r]) * _pfWeights[0] + 
-                                            (_Blk[i][GC] - _Rmp[GC][r]) * (_Blk[i][GC] - _Rmp[GC][r]) * _pfWeights[1] + 
-                                            (_Blk[i][BC] - _Rmp[BC][r]) * (_Blk[i][BC] - _Rmp[BC][r]) * _pfWeights[2];
+            for(CMP_BYTE r=0; r < rmp_l; r++)
+            {
+                // calculate the distance for each component
+                CODECFLOAT distance =    (_Blk[i][RC] - _Rmp[RC][r]) * (_Blk[i][RC] - _Rmp[RC][r]) * fWeightRed + 
+                                        (_Blk[i][GC] - _Rmp[GC][r]) * (_Blk[i][GC] - _Rmp[GC][r]) * fWeightGreen + 
+                                        (_Blk[i][BC] - _Rmp[BC][r]) * (_Blk[i][BC] - _Rmp[BC][r]) * fWeightBlue;
 
-                    if(distance < shortest)
-                    {
-                        shortest = distance;
-                        shortestIndex = r;
-                    }
-                }
-            else
-                for(CMP_BYTE r=0; r < rmp_l; r++)
+                if(distance < shortest)
                 {
-                    // calculate the distance for each component
-                    CODECFLOAT distance =    (_Blk[i][RC] - _Rmp[RC][r]) * (_Blk[i][RC] - _Rmp[RC][r]) + 
-                                            (_Blk[i][GC] - _Rmp[GC][r]) * (_Blk[i][GC] - _Rmp[GC][r]) + 
-                                            (_Blk[i][BC] - _Rmp[BC][r]) * (_Blk[i][BC] - _Rmp[BC][r]);
-
-                    if(distance < shortest)
-                    {
-                        shortest = distance;
-                        shortestIndex = r;
-                    }
+                    shortest = distance;
+                    shortestIndex = r;
                 }
+            }
 
             Err += shortest;
 
@@ -336,6 +333,26 @@ static CODECFLOAT ClstrIntnl(CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CMP_BYTE*
     return Err;
 }
 
+static CODECFLOAT ClstrIntnl(CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CMP_BYTE* _Indxs, 
+                             CODECFLOAT _Rmp[NUM_CHANNELS][MAX_POINTS], int dwBlockSize, CMP_BYTE dwNumPoints, 
+                             bool _ConstRamp, CODECFLOAT* _pfWeights, bool _bUseAlpha)
+{
+    if(_pfWeights)
+    {
+        if(_bUseAlpha)
+            return ClstrIntnlT<true, true>(_Blk, _Indxs, _Rmp, dwBlockSize, dwNumPoints, _ConstRamp, _pfWeights);
+        else
+            return ClstrIntnlT<true, false>(_Blk, _Indxs, _Rmp, dwBlockSize, dwNumPoints, _ConstRamp, _pfWeights);
+    }
+    else
+    {
+        if(_bUseAlpha)
+            return ClstrIntnlT<false, true>(_Blk, _Indxs, _Rmp, dwBlockSize, dwNumPoints, _ConstRamp, _pfWeights);
+        else
+            return ClstrIntnlT<false, false>(_Blk, _Indxs, _Rmp, dwBlockSize, dwNumPoints, _ConstRamp, _pfWeights);
+    }
+}
+
 /*------------------------------------------------------------------------------------------------
 // input ramp is on the coarse grid
 ------------------------------------------------------------------------------------------------*/
@@ -452,17 +469,13 @@ static CODECFLOAT Refine3DSSE2(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINT
                               CMP_BYTE nRedBits, CMP_BYTE nGreenBits, CMP_BYTE nBlueBits, CMP_BYTE nRefineSteps);
 #endif //USE_SSE
 
-static CODECFLOAT Refine(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
-                             CODECFLOAT _InpRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
-                             CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CODECFLOAT _Rpt[MAX_BLOCK], 
-                             int _NmrClrs, CMP_BYTE dwNumPoints, CODECFLOAT* _pfWeights, 
-                             CMP_BYTE nRedBits, CMP_BYTE nGreenBits, CMP_BYTE nBlueBits, CMP_BYTE nRefineSteps);
-
-static CODECFLOAT Refine3D(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
-                          CODECFLOAT _InpRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
-                          CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CODECFLOAT _Rpt[MAX_BLOCK], 
-                          int _NmrClrs, CMP_BYTE dwNumPoints, CODECFLOAT* _pfWeights, 
-                          CMP_BYTE nRedBits, CMP_BYTE nGreenBits, CMP_BYTE nBlueBits, CMP_BYTE nRefineSteps);
+// Refine kernels are instantiated for each ramp size and with or without channel weighting,
+// CompressRGBBlockX picks one of them per block through SelectRefine
+typedef CODECFLOAT (*RefineProc)(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
+                                 CODECFLOAT _InpRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
+                                 CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CODECFLOAT _Rpt[MAX_BLOCK], 
+                                 int _NmrClrs, CODECFLOAT* _pfWeights, 
+                                 CMP_BYTE nRedBits, CMP_BYTE nGreenBits, CMP_BYTE nBlueBits, CMP_BYTE nRefineSteps);
 
 #ifdef USE_SSE
 /*------------------------------------------------------------------------------------------------
@@ -698,10 +711,11 @@ This C version. For more performance, please, take SSE2 route.
 
 static const CODECFLOAT sMvF[] = { 0.f, -1.f, 1.f, -2.f, 2.f, -3.f, 3.f, -4.f, 4.f, -5.f, 5.f, -6.f, 6.f, -7.f, 7.f, -8.f, 8.f};
 
-CODECFLOAT Refine(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
+template<CMP_BYTE dwNumPoints, bool bWeighted>
+static CODECFLOAT Refine(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
                 CODECFLOAT _InpRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
                 CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CODECFLOAT _Rpt[MAX_BLOCK], 
-                int _NmrClrs, CMP_BYTE dwNumPoints, CODECFLOAT* _pfWeights, 
+                int _NmrClrs, CODECFLOAT* _pfWeights, 
                 CMP_BYTE nRedBits, CMP_BYTE nGreenBits, CMP_BYTE nBlueBits, CMP_BYTE nRefineSteps)
 {
     ALIGN_16 CODECFLOAT Rmp[NUM_CHANNELS][MAX_POINTS];
@@ -711,9 +725,9 @@ CODECFLOAT Refine(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
         for(int j = 0; j < 3; j++)
            Blk[i][j] = _Blk[i][j];
 
-    CODECFLOAT fWeightRed = _pfWeights ? _pfWeights[0] : 1.f;
-    CODECFLOAT fWeightGreen = _pfWeights ? _pfWeights[1] : 1.f;
-    CODECFLOAT fWeightBlue = _pfWeights ? _pfWeights[2] : 1.f;
+    const CODECFLOAT fWeightRed = bWeighted ? _pfWeights[0] : 1.f;
+    const CODECFLOAT fWeightGreen = bWeighted ? _pfWeights[1] : 1.f;
+    const CODECFLOAT fWeightBlue = bWeighted ? _pfWeights[2] : 1.f;
 
     // here is our grid
     CODECFLOAT Fctrs[3]; 
@@ -737,7 +751,7 @@ CODECFLOAT Refine(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
     BldRmp(Rmp, WkRmpPts, dwNumPoints); 
 
     // clusterize for the current ramp
-    CODECFLOAT bestE = ClstrErr(Blk, _Rpt, Rmp, _NmrClrs, dwNumPoints, Eq, _pfWeights);
+    CODECFLOAT bestE = ClstrErrT<bWeighted>(Blk, _Rpt, Rmp, _NmrClrs, dwNumPoints, Eq, _pfWeights);
     if(bestE == 0.f || !nRefineSteps)    // if exact, we've done
         return bestE;
 
@@ -924,10 +938,11 @@ CODECFLOAT Refine(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
     return bestE;
 }
 
-CODECFLOAT Refine3D(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
+template<CMP_BYTE dwNumPoints, bool bWeighted>
+static CODECFLOAT Refine3D(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
                   CODECFLOAT _InpRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
                   CODECFLOAT _Blk[MAX_BLOCK][NUM_CHANNELS], CODECFLOAT _Rpt[MAX_BLOCK], 
-                  int _NmrClrs, CMP_BYTE dwNumPoints, CODECFLOAT* _pfWeights, 
+                  int _NmrClrs, CODECFLOAT* _pfWeights, 
                   CMP_BYTE nRedBits, CMP_BYTE nGreenBits, CMP_BYTE nBlueBits, CMP_BYTE nRefineSteps)
 {
     ALIGN_16 CODECFLOAT Rmp[NUM_CHANNELS][MAX_POINTS];
@@ -937,9 +952,9 @@ CODECFLOAT Refine3D(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
         for(int j = 0; j < 3; j++)
             Blk[i][j] = _Blk[i][j];
 
-    CODECFLOAT fWeightRed = _pfWeights ? _pfWeights[0] : 1.f;
-    CODECFLOAT fWeightGreen = _pfWeights ? _pfWeights[1] : 1.f;
-    CODECFLOAT fWeightBlue = _pfWeights ? _pfWeights[2] : 1.f;
+    const CODECFLOAT fWeightRed = bWeighted ? _pfWeights[0] : 1.f;
+    const CODECFLOAT fWeightGreen = bWeighted ? _pfWeights[1] : 1.f;
+    const CODECFLOAT fWeightBlue = bWeighted ? _pfWeights[2] : 1.f;
 
     // here is our grid
     CODECFLOAT Fctrs[3]; 
@@ -963,7 +978,7 @@ CODECFLOAT Refine3D(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
     BldRmp(Rmp, WkRmpPts, dwNumPoints); 
 
     // clusterize for the current ramp
-    CODECFLOAT bestE = ClstrErr(Blk, _Rpt, Rmp, _NmrClrs, dwNumPoints, Eq, _pfWeights);
+    CODECFLOAT bestE = ClstrErrT<bWeighted>(Blk, _Rpt, Rmp, _NmrClrs, dwNumPoints, Eq, _pfWeights);
     if(bestE == 0.f || !nRefineSteps)    // if exact, we've done
         return bestE;
 
@@ -1050,6 +1065,27 @@ CODECFLOAT Refine3D(CODECFLOAT _OutRmpPnts[NUM_CHANNELS][NUM_ENDPOINTS],
     return bestE;
 }
 
+// DXTC colour blocks only use 3 or 4 point ramps
+static RefineProc SelectRefine(bool b3DRefinement, CMP_BYTE dwNumPoints, bool bWeighted)
+{
+    assert(dwNumPoints == 3 || dwNumPoints == 4);
+
+    if(b3DRefinement)
+    {
+        if(dwNumPoints == 3)
+            return bWeighted ? Refine3D<3, true> : Refine3D<3, false>;
+        else
+            return bWeighted ? Refine3D<4, true> : Refine3D<4, false>;
+    }
+    else
+    {
+        if(dwNumPoints == 3)
+            return bWeighted ? Refine<3, true> : Refine<3, false>;
+        else
+            return bWeighted ? Refine<4, true> : Refine<4, false>;
+    }
+}
+
 #ifdef USE_SSE
 /*---------------------------------------------------------------------------------------------------------
 this is SSE2 version. for more explanation, please, go to C version.
@@ -2189,10 +2225,8 @@ static void CompressRGBBlockX(CODECFLOAT _RsltRmpPnts[NUM_CHANNELS][NUM_ENDPOINT
 
 //    This not a small procedure squeezes and stretches the ramp along each axis (R,G,B) separately while other 2 are fixed.
 //    It does it only over coarse grid - 565 that is. It tries to squeeze more precision for the real world ramp.
-    if(b3DRefinement)
-        Refine3D(_RsltRmpPnts, inpRmpEndPts, _BlkIn, _Rpt, _UniqClrs, dwNumPoints, _pfWeights, nRedBits, nGreenBits, nBlueBits, nRefinementSteps);
-    else
-        Refine(_RsltRmpPnts, inpRmpEndPts, _BlkIn, _Rpt, _UniqClrs, dwNumPoints, _pfWeights, nRedBits, nGreenBits, nBlueBits, nRefinementSteps);
+    RefineProc pRefine = SelectRefine(b3DRefinement, dwNumPoints, _pfWeights != NULL);
+    pRefine(_RsltRmpPnts, inpRmpEndPts, _BlkIn, _Rpt, _UniqClrs, _pfWeights, nRedBits, nGreenBits, nBlueBits, nRefinementSteps);
 }
 
 /*--------------------------------------------------------------------------------------------------------
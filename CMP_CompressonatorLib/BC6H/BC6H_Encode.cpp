@@ -347,11 +347,14 @@ void SaveDataBlock(AMD_BC6H_Format bc6h_format, BYTE out[BC6H_COMPRESSED_BLOCK_S
             header.setvalue(15, 10, bc6h_format.gw);            // 16:   gw[9:0]
             header.setvalue(25, 10, bc6h_format.bw);            // 16:   bw[9:0]
             header.setvalue(35, 4, bc6h_format.rx);            //  4:   rx[3:0]
-            header.setvalue(39, 6, bc6h_format.rw, 10);         //       rw[15:10]
+            for (int i = 0; i < 6; i++)
+                header.setvalue(39 + i, 1, bc6h_format.rw, 15 - i); //   rw[10:15] (MSB first)
             header.setvalue(45, 4, bc6h_format.gx);            //  4:   gx[3:0]
-            header.setvalue(49, 6, bc6h_format.gw, 10);         //       gw[15:10]
+            for (int i = 0; i < 6; i++)
+                header.setvalue(49 + i, 1, bc6h_format.gw, 15 - i); //   gw[10:15] (MSB first)
             header.setvalue(55, 4, bc6h_format.bx);            //  4:   bx[3:0]
-            header.setvalue(59, 6, bc6h_format.bw, 10);         //       bw[15:10]
+            for (int i = 0; i < 6; i++)
+                header.setvalue(59 + i, 1, bc6h_format.bw, 15 - i); //   bw[10:15] (MSB first)
             break;
         default: // Need to indicate error!
             return;
@@ -870,7 +873,8 @@ void ReIndexShapef(AMD_BC6H_Format &BC6H_data, int shape_indices[BC6H_MAX_SUBSET
 
 float    BC6HBlockEncoder::FindBestPattern(AMD_BC6H_Format &BC6H_data,
                           bool TwoRegionShapes,
-                          int shape_pattern)
+                          int shape_pattern,
+                          float quality)
 {
     // Index bit size for the patterns been used.
     // All two zone shapes have 3 bits per color, max index value < 8
@@ -914,7 +918,7 @@ float    BC6HBlockEncoder::FindBestPattern(AMD_BC6H_Format &BC6H_data,
             direction,                          // direction vector of the ramp (check normalization)
             &step,                              // step size (check normalization)
             3,                                  // number of channels (always 3 = RGB for BC6H)
-            m_quality                           // Quality set number of retry to get good end points
+            quality                             // Quality set number of retry to get good end points
                                                 // Max retries = MAX_TRY = 4000 when Quality is 1.0
                                                 // Min = 0 and default with quality 0.05 is 200 times
             );
@@ -1486,6 +1490,46 @@ float Testdin[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG] =
 };
 #endif
 
+// How far (squared, in half float steps) from their principal axis the pixels of a block may be
+// for it to count as a gradient, and the quality below which such blocks skip the two region shapes
+#define BC6H_LINE_TOLERANCE     4.0f
+#define BC6H_CLASSIFY_QUALITY   0.7f
+
+// Quality of the quick fit that ranks the shapes for the coarse to fine search, 20 quantizer retries
+#define BC6H_COARSE_QUALITY     0.005f
+
+bool BC6HBlockEncoder::EncodeSolidBlock(AMD_BC6H_Format &BC6H_data, BYTE out[COMPRESSED_BLOCK_SIZE])
+{
+    int endpoint[3];
+
+    // Mode 14 has 16 bit endpoints, which unquantize to themselves. Pick the smallest endpoint
+    // that the final scale by 31/64 (31/32 signed) takes back to the half value, all the
+    // indices are 0 and the deltas to the second endpoint are 0.
+    for (int ch = 0; ch < 3; ch++)
+    {
+        int h = (int)BC6H_data.din[0][ch];
+        if ((h > 0x7BFF) || (h < -0x7BFF))
+            return false;
+
+        if (m_isSigned)
+            endpoint[ch] = (h < 0) ? -((-h * 32 + 30) / 31) : (h * 32 + 30) / 31;
+        else
+            endpoint[ch] = (h * 64 + 30) / 31;
+    }
+
+    BC6H_data.m_mode = 14;
+    BC6H_data.rw = endpoint[0];
+    BC6H_data.gw = endpoint[1];
+    BC6H_data.bw = endpoint[2];
+    BC6H_data.rx = 0;
+    BC6H_data.gx = 0;
+    BC6H_data.bx = 0;
+    memset(BC6H_data.indices16, 0, sizeof(BC6H_data.indices16));
+
+    SaveDataBlock(BC6H_data, out);
+    return true;
+}
+
 float BC6HBlockEncoder::CompressBlock(float in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG], BYTE out[COMPRESSED_BLOCK_SIZE])
 {
     /* Reserved feature:
@@ -1578,6 +1622,31 @@ float BC6HBlockEncoder::CompressBlock(float in[MAX_SUBSET_SIZE][MAX_DIMENSION_BI
     }
 #endif
 
+    // Blocks of one colour are written directly. Below high quality, blocks of two colours
+    // or with their colours along a line are only fitted with the one region modes.
+    float fPixels[BC6H_MAX_SUBSET_SIZE][4];
+    for (int i = 0; i < BC6H_MAX_SUBSET_SIZE; i++)
+    {
+        fPixels[i][0] = BC6H_data.din[i][0];
+        fPixels[i][1] = BC6H_data.din[i][1];
+        fPixels[i][2] = BC6H_data.din[i][2];
+        fPixels[i][3] = 0.0f;
+    }
+
+    CMP_BlockClass blockClass = CMP_ClassifyBlock(fPixels, BC6H_LINE_TOLERANCE);
+    if (blockClass == CMP_BLOCK_SOLID)
+    {
+        if (EncodeSolidBlock(BC6H_data, out))
+        {
+            m_blockClassCounts[CMP_BLOCK_SOLID]++;
+            return 0.0f;
+        }
+        blockClass = CMP_BLOCK_COMPLEX;
+    }
+    else if ((blockClass != CMP_BLOCK_COMPLEX) && (m_quality >= BC6H_CLASSIFY_QUALITY))
+        blockClass = CMP_BLOCK_COMPLEX;
+    m_blockClassCounts[blockClass]++;
+
     if (m_useMonoShapePatterns)
     {
         /*
@@ -1585,27 +1654,54 @@ float BC6HBlockEncoder::CompressBlock(float in[MAX_SUBSET_SIZE][MAX_DIMENSION_BI
         */
     }
 
-    // run through no partition first
-    error = FindBestPattern(BC6H_data, false, 0);
-    if (error < bestError)
+    // Run through no partition first (shape -1), then all two regions shapes to find the best pattern
+    int shapes[MAX_BC6H_PARTITIONS + 1];
+    int numShapes = (blockClass == CMP_BLOCK_COMPLEX) ? MAX_BC6H_PARTITIONS : 0;
+    int numTries  = numShapes + 1;
+    for (int i = 0; i < numTries; i++)
+        shapes[i] = i - 1;
+
+    // Coarse to fine: rank the shapes with a quick fit and only fit the best ones at full quality
+    bool searchShapes = (m_modeCandidates > 0) && (numShapes > 0);
+    if (searchShapes)
     {
-        bestError = error;
-        bestShape = -1;
-        memcpy(BC6H_data.cur_best_shape_indices, BC6H_data.shape_indices, sizeof(BC6H_data.shape_indices));
-        memcpy(BC6H_data.cur_best_partition, BC6H_data.partition, sizeof(BC6H_data.partition));
-        memcpy(BC6H_data.cur_best_fEndPoints, BC6H_data.fEndPoints, sizeof(BC6H_data.fEndPoints));
-        memcpy(BC6H_data.cur_best_entryCount, BC6H_data.entryCount, sizeof(BC6H_data.entryCount));
-        BC6H_data.d_shape_index = bestShape;
+        float quickError[MAX_BC6H_PARTITIONS + 1];
+        float coarseQuality = min(m_quality, BC6H_COARSE_QUALITY);
+        for (int i = 0; i < numTries; i++)
+            quickError[i] = FindBestPattern(BC6H_data, shapes[i] >= 0, max(shapes[i], 0), coarseQuality);
+
+        // Stable insertion sort, shapes of equal error keep their default order
+        for (int i = 1; i < numTries; i++)
+        {
+            int   shape = shapes[i];
+            float quick = quickError[i];
+            int   n     = i;
+            while ((n > 0) && (quick < quickError[n - 1]))
+            {
+                shapes[n]     = shapes[n - 1];
+                quickError[n] = quickError[n - 1];
+                n--;
+            }
+            shapes[n]     = shape;
+            quickError[n] = quick;
+        }
+
+        m_searchCounts[CMP_SEARCH_BLOCKS]++;
+        m_searchCounts[CMP_SEARCH_CANDIDATES] += numTries;
+        numTries = min(numTries, (int)m_modeCandidates);
+        m_searchCounts[CMP_SEARCH_REFINED] += numTries;
     }
 
-    // now run through all two regions shapes to find the best pattern
-    for (int shape = 0; shape < MAX_BC6H_PARTITIONS; shape++)
+    int bestTry = 0;
+    for (int i = 0; i < numTries; i++)
     {
-        error = FindBestPattern(BC6H_data, true, shape);
+        int shape = shapes[i];
+        error = FindBestPattern(BC6H_data, shape >= 0, max(shape, 0), m_quality);
         if (error < bestError)
         {
             bestError = error;
             bestShape = shape;
+            bestTry   = i;
 
             memcpy(BC6H_data.cur_best_shape_indices, BC6H_data.shape_indices, sizeof(BC6H_data.shape_indices));
             memcpy(BC6H_data.cur_best_partition, BC6H_data.partition, sizeof(BC6H_data.partition));
@@ -1617,6 +1713,8 @@ float BC6HBlockEncoder::CompressBlock(float in[MAX_SUBSET_SIZE][MAX_DIMENSION_BI
         {
             if (bestShape != -1)
             {
+                // Ranked shapes can leave a one region fit behind
+                BC6H_data.region        = 2;
                 BC6H_data.d_shape_index = bestShape;
                 memcpy(BC6H_data.shape_indices, BC6H_data.cur_best_shape_indices, sizeof(BC6H_data.shape_indices));
                 memcpy(BC6H_data.partition, BC6H_data.cur_best_partition, sizeof(BC6H_data.partition));
@@ -1626,6 +1724,20 @@ float BC6HBlockEncoder::CompressBlock(float in[MAX_SUBSET_SIZE][MAX_DIMENSION_BI
         }
     }
 
+    if (searchShapes)
+        CMP_CountSearchRank(m_searchCounts, bestTry);
+
+    // The shapes leave their own data behind, go back to the one region fit if none of them beat it
+    if (bestShape == -1)
+    {
+        BC6H_data.region        = 1;
+        BC6H_data.d_shape_index = 0;
+        memcpy(BC6H_data.shape_indices, BC6H_data.cur_best_shape_indices, sizeof(BC6H_data.shape_indices));
+        memcpy(BC6H_data.partition, BC6H_data.cur_best_partition, sizeof(BC6H_data.partition));
+        memcpy(BC6H_data.fEndPoints, BC6H_data.cur_best_fEndPoints, sizeof(BC6H_data.fEndPoints));
+        memcpy(BC6H_data.entryCount, BC6H_data.cur_best_entryCount, sizeof(BC6H_data.entryCount));
+    }
+
     // Optimize the result for encoding
     bestError = EncodePattern(BC6H_data, bestError);
 
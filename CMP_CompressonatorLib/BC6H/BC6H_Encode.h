@@ -27,6 +27,7 @@
 
 #include "Compressonator.h"
 #include "BC6H_Definitions.h"
+#include "CMP_BlockClass.h"
 
 #include <float.h>
 
@@ -52,7 +53,7 @@ class BC6HBlockEncoder
 {
 public:
 
-    BC6HBlockEncoder(CMP_BC6H_BLOCK_PARAMETERS user_options)
+    BC6HBlockEncoder(CMP_BC6H_BLOCK_PARAMETERS user_options, CMP_DWORD modeCandidates = 0)
     {
         m_quality                 = user_options.fQuality;
         m_useMonoShapePatterns    = user_options.bUsePatternRec;
@@ -61,9 +62,19 @@ public:
         m_Exposure                = user_options.fExposure;
         m_bAverageEndPoint        = true;
         m_DiffLevel               = 0.01f;
+        m_modeCandidates          = modeCandidates;
+
+        for (int i = 0; i < CMP_BLOCK_CLASSES; i++)
+            m_blockClassCounts[i] = 0;
+        for (int i = 0; i < CMP_SEARCH_COUNTS; i++)
+            m_searchCounts[i] = 0;
     };
      
-    ~BC6HBlockEncoder(){};
+    ~BC6HBlockEncoder()
+    {
+        CMP_AddBlockClassCounts(m_isSigned ? CMP_FORMAT_BC6H_SF : CMP_FORMAT_BC6H, m_blockClassCounts);
+        CMP_AddModeSearchCounts(m_isSigned ? CMP_FORMAT_BC6H_SF : CMP_FORMAT_BC6H, m_searchCounts);
+    };
 
     float   CompressBlock(float in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],BYTE   out[COMPRESSED_BLOCK_SIZE]);
     void    clampF16Max(float EndPoints[MAX_SUBSETS][MAX_END_POINTS][MAX_DIMENSION_BIG]);
@@ -83,14 +94,19 @@ private:
     int BC6HBlockEncoder::FindPattern();
     */
 
+    // quality sets the number of quantizer retries, m_quality for the final fit
     float    FindBestPattern(AMD_BC6H_Format &BC6H_data,
                               bool    TwoRegionShapes, 
-                              int    shape_pattern);
+                              int    shape_pattern,
+                              float  quality);
 
 
     float    EncodePattern(AMD_BC6H_Format &BC6H_data,
         float  error);
 
+    // Writes a block whose din values are all the same as mode 14, returns false if they are out of range
+    bool    EncodeSolidBlock(AMD_BC6H_Format &BC6H_data, BYTE out[COMPRESSED_BLOCK_SIZE]);
+
     void    SaveCompressedBlockData(AMD_BC6H_Format &BC6H_data, 
                                     int oEndPoints[MAX_SUBSETS][MAX_END_POINTS][MAX_DIMENSION_BIG],
                                     int iIndices[3][MAX_SUBSET_SIZE], 
@@ -121,6 +137,13 @@ private:
     float  m_Exposure;
     bool    m_bAverageEndPoint;         // Enables Averaging Endpoints for low bits modes
     float   m_DiffLevel;                // Threashhold for Channel diferance to set Averages value of channels on Endpoints
+    DWORD   m_modeCandidates;           // Shapes fitted at full quality after a quick fit ranks them, 0 fits every shape
+
+    // Number of blocks that went through each of the block class paths
+    DWORD   m_blockClassCounts[CMP_BLOCK_CLASSES];
+
+    // Counters of the coarse to fine shape search
+    DWORD   m_searchCounts[CMP_SEARCH_COUNTS];
 };
 
 #endif
@@ -27,8 +27,10 @@
 #include "BC6H_Decode.h"
 #include "Compressonator.h"
 
+#include <atomic>
 
-extern bool    g_LibraryInitialized;
+
+extern std::atomic<bool> g_LibraryInitialized;
 
 static BC6HBlockDecoder  g_Decoder;
 
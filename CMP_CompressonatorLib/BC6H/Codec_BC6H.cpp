@@ -33,8 +33,10 @@
 #include "BC6H_Library.h"
 #include "BC6H_Definitions.h"
 #include "HDR_Encode.h"
+#include "CMP_CancelToken.h"
 
 #include <chrono>
+#include <vector>
 
 using namespace HDR_Encode;
 
@@ -49,34 +51,6 @@ extern CompViewerClient g_CompClient;
 // Gets the total numver of active processor cores on the running host system
 extern CMP_INT CMP_GetNumberOfProcessors();
 
-//
-// Thread procedure for encoding a block
-//
-// The thread stays alive, and expects blocks to be pushed to it by a producer
-// process that signals it when new work is available. When the producer is finished
-// it should set the exit flag in the parameters to allow the tread to quit
-//
-
-unsigned int BC6HThreadProcEncode(void* param)
-{
-    BC6HEncodeThreadParam* tp = (BC6HEncodeThreadParam*)param;
-
-    while (tp->exit == FALSE)
-    {
-        if (tp->run == TRUE)
-        {
-            tp->encoder->CompressBlock(tp->in, tp->out);
-            tp->run = FALSE;
-        }
-
-        using namespace std::chrono;
-
-        std::this_thread::sleep_for(0ms);
-    }
-
-    return 0;
-}
-
 int g_block = 0;  // Keep track of current encoder block!
 
 //////////////////////////////////////////////////////////////////////////////
@@ -96,13 +70,11 @@ CCodec_BC6H::CCodec_BC6H(CodecType codecType) : CCodec_DXTC(codecType)
     else
         m_bIsSigned = true;
     m_UsePatternRec = false;
+    m_ModeSearchCandidates = 0;
 
     // Internal setting
     m_LibraryInitialized   = false;
-    m_NumEncodingThreads   = 0; // new auto setting to use max processors * 2 threads
-    m_EncodingThreadHandle = NULL;
-    m_LiveThreads          = 0;
-    m_LastThread           = 0;
+    m_NumEncodingThreads   = 0; // 0 = use all the thread pool workers
     m_CodecType            = codecType;
 }
 
@@ -119,6 +91,10 @@ bool CCodec_BC6H::SetParameter(const CMP_CHAR* pszParamName, CMP_CHAR* sValue)
     {
         m_UsePatternRec = (bool)(std::stoi(sValue) > 0);
     }
+    else if (strcmp(pszParamName, "ModeSearchCandidates") == 0)
+    {
+        m_ModeSearchCandidates = max(0, std::stoi(sValue));
+    }
     else if (strcmp(pszParamName, "NumThreads") == 0)
     {
         m_NumThreads         = (CMP_BYTE)std::stoi(sValue);
@@ -149,6 +125,8 @@ bool CCodec_BC6H::SetParameter(const CMP_CHAR* pszParamName, CMP_DWORD dwValue)
         m_ModeMask = (CMP_BYTE)dwValue & 0xFF;
     else if (strcmp(pszParamName, "PatternRec") == 0)
         m_UsePatternRec = (bool)(dwValue > 0);
+    else if (strcmp(pszParamName, "ModeSearchCandidates") == 0)
+        m_ModeSearchCandidates = dwValue;
     else if (strcmp(pszParamName, "NumThreads") == 0)
     {
         m_NumThreads         = (CMP_BYTE)dwValue;
@@ -175,75 +153,10 @@ CCodec_BC6H::~CCodec_BC6H()
 {
     if (m_LibraryInitialized)
     {
-        if (m_Use_MultiThreading)
-        {
-            // Tell all the live threads that they can exit when they have finished any current work
-            for (int i = 0; i < m_LiveThreads; i++)
-            {
-                // If a thread is in the running state then we need to wait for it to finish
-                // any queued work from the producer before we can tell it to exit.
-                //
-                // If we don't wait then there is a race condition here where we have
-                // told the thread to run but it hasn't yet been scheduled - if we set
-                // the exit flag before it runs then its block will not be processed.
-#pragma warning(push)
-#pragma warning(disable : 4127)  //warning C4127: conditional expression is constant
-                while (1)
-                {
-                    if (m_EncodeParameterStorage == NULL)
-                        break;
-                    if (m_EncodeParameterStorage[i].run != TRUE)
-                    {
-                        break;
-                    }
-                }
-#pragma warning(pop)
-                // Signal to the thread that it can exit
-                m_EncodeParameterStorage[i].exit = TRUE;
-            }
-
-            // Now wait for all threads to have exited
-            if (m_LiveThreads > 0)
-            {
-                for (DWORD dwThread = 0; dwThread < m_LiveThreads; dwThread++)
-                {
-                    std::thread& curThread = m_EncodingThreadHandle[dwThread];
-
-                    curThread.join();
-                }
-            }
-
-            for (unsigned int i = 0; i < m_LiveThreads; i++)
-            {
-                std::thread& curThread = m_EncodingThreadHandle[i];
-
-                curThread = std::thread();
-            }
-
-            delete[] m_EncodingThreadHandle;
-
-        }  // MultiThreading
-        else
+        for (int i = 0; i < CMP_MAX_POOL_SLOTS; i++)
         {
-            // detach thread and delete
-            std::thread& curThread = m_EncodingThreadHandle[0];
-            curThread.detach();
-            delete[] m_EncodingThreadHandle;
-        }
-
-        m_EncodingThreadHandle = NULL;
-
-        if (m_EncodeParameterStorage)
-            delete[] m_EncodeParameterStorage;
-        m_EncodeParameterStorage = NULL;
-
-        for (int i = 0; i < m_NumEncodingThreads; i++)
-        {
-            if (m_encoder[i])
-            {
-                delete m_encoder[i];
-                m_encoder[i] = NULL;
-            }
+            SAFE_DELETE(m_encoder[i]);
+            SAFE_DELETE(m_fastEncoder[i]);
         }
 
         if (m_decoder)
@@ -260,105 +173,21 @@ CodecError CCodec_BC6H::CInitializeBC6HLibrary()
 {
     if (!m_LibraryInitialized)
     {
-        for (DWORD i = 0; i < BC6H_MAX_THREADS; i++)
+        for (DWORD i = 0; i < CMP_MAX_POOL_SLOTS; i++)
         {
-            m_encoder[i] = NULL;
+            m_encoder[i]     = NULL;
+            m_fastEncoder[i] = NULL;
         }
 
-        // Create threaded encoder instances
-        m_LiveThreads        = 0;
-        m_LastThread         = 0;
+        // Block rows are encoded by the library thread pool, m_NumThreads limits
+        // how many of its workers this codec may use at once (0 = all of them)
         m_NumEncodingThreads = min(m_NumThreads, BC6H_MAX_THREADS);
-        if (m_NumEncodingThreads == 0)
-        {
-            m_NumEncodingThreads = CMP_GetNumberOfProcessors();
-            if (m_NumEncodingThreads <= 2)
-                m_NumEncodingThreads = 8; // fallback to a default!
-            if (m_NumEncodingThreads > 128)
-                m_NumEncodingThreads = 128;
-
-        }
         m_Use_MultiThreading = (m_NumEncodingThreads != 1);
 
-        m_EncodeParameterStorage = new BC6HEncodeThreadParam[m_NumEncodingThreads];
-        if (!m_EncodeParameterStorage)
-        {
-            return CE_Unknown;
-        }
-
-        for (int i = 0; i < m_NumEncodingThreads; i++)
-            m_EncodeParameterStorage[i].run = false;
-
-
-        m_EncodingThreadHandle = new std::thread[m_NumEncodingThreads];
-        if (!m_EncodingThreadHandle)
-        {
-            delete[] m_EncodeParameterStorage;
-            m_EncodeParameterStorage = NULL;
-
-            return CE_Unknown;
-        }
-
-        for (int i = 0; i < m_NumEncodingThreads; i++)
-        {
-            // Create single encoder instance
-            CMP_BC6H_BLOCK_PARAMETERS user_options;
-
-            user_options.bIsSigned      = m_bIsSigned;
-            user_options.fQuality       = m_Quality;
-            user_options.dwMask         = m_ModeMask;
-            user_options.fExposure      = m_Exposure;
-            user_options.bUsePatternRec = m_UsePatternRec;
-
-            m_encoder[i] = new BC6HBlockEncoder(user_options);
-
-            // Cleanup if problem!
-            if (!m_encoder[i])
-            {
-                if (m_EncodeParameterStorage)
-                    delete[] m_EncodeParameterStorage;
-                m_EncodeParameterStorage = NULL;
-
-                delete[] m_EncodingThreadHandle;
-                m_EncodingThreadHandle = NULL;
-
-                for (int j = 0; j < i; j++)
-                {
-                    delete m_encoder[j];
-                    m_encoder[j] = NULL;
-                }
-
-                return CE_Unknown;
-            }
-
-#ifdef USE_DBGTRACE
-            DbgTrace(("Encoder[%d]:ModeMask %X, Quality %f\n", i, m_ModeMask, m_Quality));
-#endif
-        }
-
-        // Create the encoding threads
-        for (CMP_INT i = 0; i < m_NumEncodingThreads; i++)
-        {
-            // Initialize thread parameters.
-            m_EncodeParameterStorage[i].encoder = m_encoder[i];
-            // Inform the thread that at the moment it doesn't have any work to do
-            // but that it should wait for some and not exit
-            m_EncodeParameterStorage[i].run  = FALSE;
-            m_EncodeParameterStorage[i].exit = FALSE;
-
-            m_EncodingThreadHandle[i] = std::thread(BC6HThreadProcEncode, (void*)&m_EncodeParameterStorage[i]);
-            m_LiveThreads++;
-        }
-
         // Create single decoder instance
         m_decoder = new BC6HBlockDecoder();
         if (!m_decoder)
         {
-            for (CMP_INT j = 0; j < m_NumEncodingThreads; j++)
-            {
-                delete m_encoder[j];
-                m_encoder[j] = NULL;
-            }
             return CE_Unknown;
         }
 
@@ -367,83 +196,67 @@ CodecError CCodec_BC6H::CInitializeBC6HLibrary()
     return CE_OK;
 }
 
-CodecError CCodec_BC6H::CEncodeBC6HBlock(float in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG], BYTE* out)
+// Returns the encoder owned by the calling thread's pool slot
+BC6HBlockEncoder* CCodec_BC6H::GetEncoder()
 {
-    if (m_Use_MultiThreading)
-    {
-        CMP_WORD threadIndex;
+    CMP_INT slot     = CMP_ThreadPool::GetWorkerSlot();
+    bool    bDegrade = (m_Quality > CMP_DEGRADED_QUALITY) && IsDegraded();
 
-        if ((!m_LibraryInitialized) || (!in) || (!out))
-        {
-            return CE_Unknown;
-        }
-
-        // Loop and look for an available thread
-        bool found  = FALSE;
-        threadIndex = m_LastThread;
-        while (found == FALSE)
-        {
-            if (m_EncodeParameterStorage[threadIndex].run == FALSE)
-            {
-                found = TRUE;
-                break;
-            }
-
-            // Increment and wrap the thread index
-            threadIndex++;
-            if (threadIndex == m_LiveThreads)
-            {
-                threadIndex = 0;
-            }
-        }
-
-        m_LastThread = threadIndex;
+    BC6HBlockEncoder*& encoder = bDegrade ? m_fastEncoder[slot] : m_encoder[slot];
+    if (encoder == NULL)
+    {
+        CMP_BC6H_BLOCK_PARAMETERS user_options;
 
-        // Copy the input data into the thread storage
-        memcpy(m_EncodeParameterStorage[threadIndex].in, in, MAX_SUBSET_SIZE * MAX_DIMENSION_BIG * sizeof(float));
+        user_options.bIsSigned      = m_bIsSigned;
+        user_options.fQuality       = bDegrade ? CMP_DEGRADED_QUALITY : m_Quality;
+        user_options.dwMask         = m_ModeMask;
+        user_options.fExposure      = m_Exposure;
+        user_options.bUsePatternRec = m_UsePatternRec;
 
-        // Set the output pointer for the thread to the provided location
-        m_EncodeParameterStorage[threadIndex].out = out;
+        encoder = new BC6HBlockEncoder(user_options, m_ModeSearchCandidates);
 
-        // Tell the thread to start working
-        m_EncodeParameterStorage[threadIndex].run = TRUE;
-    }
-    else
-    {
-        // Copy the input data into the thread storage
-        memcpy(m_EncodeParameterStorage[0].in, in, BC6H_MAX_SUBSET_SIZE * MAX_DIMENSION_BIG * sizeof(float));
-        // Set the output pointer for the thread to write
-        m_EncodeParameterStorage[0].out = out;
-        m_encoder[0]->CompressBlock(m_EncodeParameterStorage[0].in, m_EncodeParameterStorage[0].out);
+#ifdef USE_DBGTRACE
+        DbgTrace(("Encoder[%d]:ModeMask %X, Quality %f\n", slot, m_ModeMask, user_options.fQuality));
+#endif
     }
-    return CE_OK;
+    return encoder;
 }
 
-CodecError CCodec_BC6H::CFinishBC6HEncoding(void)
+CodecError CCodec_BC6H::CEncodeBC6HBlock(float in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG], BYTE* out)
 {
-    if (!m_LibraryInitialized)
+    if ((!m_LibraryInitialized) || (!in) || (!out))
     {
         return CE_Unknown;
     }
 
-    if (m_Use_MultiThreading)
-    {
-        // Wait for all the live threads to finish any current work
-        for (DWORD i = 0; i < m_LiveThreads; i++)
-        {
-            using namespace std::chrono;
+    BC6HBlockEncoder* encoder = GetEncoder();
+    if (!encoder)
+        return CE_Unknown;
 
-            // If a thread is in the running state then we need to wait for it to finish
-            // its work from the producer
-            while (m_EncodeParameterStorage[i].run == TRUE)
-            {
-                std::this_thread::sleep_for(1ms);
-            }
-        }
-    }
+    encoder->CompressBlock(in, out);
     return CE_OK;
 }
 
+// Reads nBlocks consecutive blocks starting at block index dwBlock, one row run at a time.
+// The encoder takes pixels in the same R, G, B, A float order the buffer returns them in.
+static void BC6HReadBlocks(CCodecBuffer& bufferIn, CMP_DWORD dwBlock, CMP_DWORD dwBlocksX, CMP_DWORD nBlocks, float blocksToEncode[][BLOCK_SIZE_4X4][CHANNEL_SIZE_ARGB])
+{
+    CMP_DWORD n;
+    for (CMP_DWORD i = 0; i < nBlocks; i += n, dwBlock += n)
+    {
+        CMP_DWORD x = dwBlock % dwBlocksX;
+        n = min(nBlocks - i, dwBlocksX - x);
+        bufferIn.ReadBlockRowRGBA(x * 4, (dwBlock / dwBlocksX) * 4, n, &blocksToEncode[i][0][0]);
+    }
+}
+
+// Encodes a batch of blocks queued by Compress(), called from the thread pool
+void CCodec_BC6H::CEncodeBC6HBatch(BC6HBlockBatch& batch)
+{
+    for (CMP_DWORD i = 0; (i < batch.dwNumBlocks) && !IsCanceled(); i++)
+        CEncodeBC6HBlock(batch.in[i], batch.out[i]);
+}
+
 #ifdef BC6H_DEBUG_TO_RESULTS_TXT
 FILE* g_fp   = NULL;
 int   g_mode = 0;
@@ -490,7 +303,9 @@ CodecError CCodec_BC6H::Compress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut
     DbgTrace(("   : Height %d Width %d Pitch %d isFloat %d", bufferOut.GetHeight(), bufferOut.GetWidth(), bufferOut.GetWidth(), bufferOut.IsFloat()));
 #endif
 
-    char row, col, srcIndex;
+#ifdef _BC6H_COMPDEBUGGER
+    char row;
+#endif
 
     CMP_BYTE* pOutBuffer;
     pOutBuffer = bufferOut.GetData();
@@ -504,40 +319,60 @@ CodecError CCodec_BC6H::Compress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut
     FILE* bc6file = fopen("Test.bc6", "wb");
 #endif
 
+#if !defined(BC6H_COMPDEBUGGER) && !defined(_BC6H_COMPDEBUGGER) && !defined(BC6H_DEBUG_TO_RESULTS_TXT) && !defined(_SAVE_AS_BC6)
+    if (m_Use_MultiThreading)
+    {
+        const CMP_DWORD dwNumBlocks  = dwBlocksX * dwBlocksY;
+        const CMP_DWORD dwNumBatches = (dwNumBlocks + BC6H_BLOCKS_PER_BATCH - 1) / BC6H_BLOCKS_PER_BATCH;
+
+        bool bCompleted = CMP_ProcessBatches<BC6HBlockBatch>(dwNumBatches, m_NumEncodingThreads,
+            [&](BC6HBlockBatch& batch, CMP_DWORD dwBatch)
+            {
+                CMP_DWORD dwBlock = dwBatch * BC6H_BLOCKS_PER_BATCH;
+                batch.dwNumBlocks = min(dwNumBlocks - dwBlock, (CMP_DWORD)BC6H_BLOCKS_PER_BATCH);
+                BC6HReadBlocks(bufferIn, dwBlock, dwBlocksX, batch.dwNumBlocks, batch.in);
+                for (CMP_DWORD i = 0; i < batch.dwNumBlocks; i++, dwBlock++)
+                    batch.out[i] = pOutBuffer + dwBlock * 16;
+            },
+            [&](BC6HBlockBatch& batch) { CEncodeBC6HBatch(batch); },
+            [&](float fProgress) { return pFeedbackProc ? pFeedbackProc(fProgress, pUser1, pUser2) : false; },
+            [&]() { return IsCanceled(); });
+
+        if (!bCompleted)
+            return CE_Aborted;
+
+        if (pFeedbackProc)
+            pFeedbackProc(100.f, pUser1, pUser2);
+
+        return CE_OK;
+    }
+#endif
+
     int lineAtPercent = (int)(dwBlocksY * 0.01F);
      if (lineAtPercent <= 0)  lineAtPercent = 1;
     float fBlockXY = (float)(dwBlocksX * dwBlocksY);
     float fProgress;
     float old_fProgress = FLT_MAX;
 
+    std::vector<float> srcRow(dwBlocksX * BLOCK_SIZE_4X4X4);
+
     for (CMP_DWORD j = 0; j < dwBlocksY; j++)
     {
+        if (IsCanceled())
+            return CE_Aborted;
+
+        bufferIn.ReadBlockRowRGBA(0, j * 4, dwBlocksX, &srcRow[0]);
+
         for (CMP_DWORD i = 0; i < dwBlocksX; i++)
         {
             float     blockToEncode[BLOCK_SIZE_4X4][CHANNEL_SIZE_ARGB];
-            CMP_FLOAT srcBlock[BLOCK_SIZE_4X4X4];
 
-            memset(srcBlock, 0, sizeof(srcBlock));
-            bufferIn.ReadBlockRGBA(i * 4, j * 4, 4, 4, srcBlock);
+            memcpy(blockToEncode, &srcRow[i * BLOCK_SIZE_4X4X4], sizeof(blockToEncode));
 
 #ifdef _BC6H_COMPDEBUGGER
-            g_CompClient.SendData(1, sizeof(srcBlock), srcBlock);
+            g_CompClient.SendData(1, sizeof(blockToEncode), blockToEncode);
 #endif
 
-            // Create the block for encoding
-            srcIndex = 0;
-            for (row = 0; row < BLOCK_SIZE_4; row++)
-            {
-                for (col = 0; col < BLOCK_SIZE_4; col++)
-                {
-                    blockToEncode[row * BLOCK_SIZE_4 + col][BC6H_COMP_RED]   = (float)srcBlock[srcIndex];
-                    blockToEncode[row * BLOCK_SIZE_4 + col][BC6H_COMP_GREEN] = (float)srcBlock[srcIndex + 1];
-                    blockToEncode[row * BLOCK_SIZE_4 + col][BC6H_COMP_BLUE]  = (float)srcBlock[srcIndex + 2];
-                    blockToEncode[row * BLOCK_SIZE_4 + col][BC6H_COMP_ALPHA] = (float)srcBlock[srcIndex + 3];
-                    srcIndex += 4;
-                }
-            }
-
             union BBLOCKS
             {
                 CMP_DWORD compressedBlock[4];
@@ -586,7 +421,6 @@ CodecError CCodec_BC6H::Compress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut
                             #ifdef _BC6H_COMPDEBUGGER
                             g_CompClient.disconnect();
                             #endif
-                            CFinishBC6HEncoding();
                             return CE_Aborted;
                         }
                     }
@@ -615,7 +449,7 @@ CodecError CCodec_BC6H::Compress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut
         pFeedbackProc(fProgress, pUser1, pUser2);
     }
 
-    return CFinishBC6HEncoding();
+    return CE_OK;
 }
 
 CodecError CCodec_BC6H::Decompress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut, Codec_Feedback_Proc pFeedbackProc, CMP_DWORD_PTR pUser1,
@@ -33,16 +33,18 @@
 #include "BC6H_Encode.h"
 #include "BC6H_Decode.h"
 #include "BC6H_Library.h"
+#include "CMP_BlockQueue.h"
 
 #include <thread>
 
-struct BC6HEncodeThreadParam
+// Number of blocks handed to a pool worker at a time
+#define BC6H_BLOCKS_PER_BATCH   16
+
+struct BC6HBlockBatch
 {
-    BC6HBlockEncoder    *encoder;
-    float               in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
-    CMP_BYTE             *out;
-    volatile CMP_BOOL    run;
-    volatile CMP_BOOL    exit;
+    CMP_DWORD   dwNumBlocks;
+    float       in[BC6H_BLOCKS_PER_BATCH][BC6H_BLOCK_PIXELS][MAX_DIMENSION_BIG];
+    CMP_BYTE*   out[BC6H_BLOCKS_PER_BATCH];
 };
 
 class CCodec_BC6H : public CCodec_DXTC  
@@ -63,32 +65,32 @@ public:
 
 
 private:
-    BC6HEncodeThreadParam *m_EncodeParameterStorage;
-
     // BC6H User configurable variables
     CMP_WORD        m_ModeMask;
     float           m_Quality;
     CMP_WORD        m_NumThreads;    
     bool            m_bIsSigned;
     bool            m_UsePatternRec;
+    CMP_DWORD       m_ModeSearchCandidates;
     float           m_Exposure;
 
     // BC6H Internal status 
     CMP_BOOL        m_LibraryInitialized;
     CMP_BOOL        m_Use_MultiThreading;
     CMP_INT         m_NumEncodingThreads;
-    CMP_WORD        m_LiveThreads;
-    CMP_WORD        m_LastThread;
 
     // BC6H Encoders and decoders: for encding use the interfaces below
-    std::thread*         m_EncodingThreadHandle;
-    BC6HBlockEncoder*    m_encoder[BC6H_MAX_THREADS];
+    // Encoders are created on demand, one for each thread pool slot that uses them,
+    // the fast encoders are used once the cancel token asks for degraded quality
+    BC6HBlockEncoder*    m_encoder[CMP_MAX_POOL_SLOTS];
+    BC6HBlockEncoder*    m_fastEncoder[CMP_MAX_POOL_SLOTS];
     BC6HBlockDecoder*    m_decoder;
 
     // Encoder interfaces
     CodecError    CInitializeBC6HLibrary();
+    BC6HBlockEncoder* GetEncoder();
     CodecError    CEncodeBC6HBlock(float  in[BC6H_BLOCK_PIXELS][MAX_DIMENSION_BIG],CMP_BYTE *out);
-    CodecError    CFinishBC6HEncoding(void);
+    void          CEncodeBC6HBatch(BC6HBlockBatch& batch);
 
     
 };
@@ -33,6 +33,7 @@
 #include "debug.h"
 
 #include <mutex>
+#include <limits>
 
 
 #ifdef    BC7_DEBUG_TO_RESULTS_TXT
@@ -63,81 +64,65 @@ static int trcnts[MAX_CLUSTERS][MAX_ENTRIES_QUANT_TRACE];
     TRACE       amd_trs[MAX_CLUSTERS][MAX_ENTRIES_QUANT_TRACE][MAX_TRACE];
 #endif
 
-static int g_Quant_init = 0;
 void traceBuilder (int numEntries, int numClusters,struct TRACE tr [], int code[], int *trcnt );
 
-std::mutex mtx;
+static std::once_flag g_Quant_once;
 
-void Quant_Init(void)
+static void Quant_Build(void)
 {
-    if (g_Quant_init > 0)
-    {
-        g_Quant_init++;
-        return;
-    }
-    if (amd_codes[0][0])  return;
-    
-    mtx.lock();
+#ifdef USE_TRACE_WITH_DYNAMIC_MEM
+    // Trace into scratch buffers of the largest size, then keep only the entries each table
+    // uses so the tables stay small enough to share between all encoder threads
+    int*   codes = new int[ MAX_TRACE ];
+    TRACE* trs   = new TRACE[ MAX_TRACE ];
+#endif
 
     for ( int numClusters = 0; numClusters < MAX_CLUSTERS; numClusters++ )
     {
         for ( int numEntries = 0; numEntries < MAX_ENTRIES_QUANT_TRACE; numEntries++ )
         {
             #ifdef USE_TRACE_WITH_DYNAMIC_MEM
-                amd_codes[ numClusters][ numEntries ]    = new int[ MAX_TRACE ];
-                amd_trs[ numClusters ][ numEntries ]    = new TRACE[ MAX_TRACE ];
-            
+                traceBuilder (  numEntries+1,  
+                                numClusters+1, 
+                                trs,
+                                codes,
+                                trcnts[numClusters]+(numEntries)); 
+
+                // The search reads the first entry even when the trace is empty
+                int count = max(trcnts[numClusters][numEntries], 1);
+                amd_codes[ numClusters][ numEntries ]    = new int[ count ];
+                amd_trs[ numClusters ][ numEntries ]    = new TRACE[ count ];
+
                 assert(amd_codes[ numClusters][ numEntries ]);
                 assert(amd_trs[ numClusters ][ numEntries ]);
-            #endif
 
-            traceBuilder (  numEntries+1,  
-                            numClusters+1, 
-                            amd_trs[numClusters][numEntries],
-                            amd_codes[numClusters][numEntries],
-                            trcnts[numClusters]+(numEntries)); 
+                memcpy(amd_codes[numClusters][numEntries], codes, count * sizeof(int));
+                memcpy(amd_trs[numClusters][numEntries], trs, count * sizeof(TRACE));
+            #else
+                traceBuilder (  numEntries+1,  
+                                numClusters+1, 
+                                amd_trs[numClusters][numEntries],
+                                amd_codes[numClusters][numEntries],
+                                trcnts[numClusters]+(numEntries)); 
+            #endif
         }
     }
 
-    g_Quant_init++;
+#ifdef USE_TRACE_WITH_DYNAMIC_MEM
+    delete[] codes;
+    delete[] trs;
+#endif
+}
 
-    mtx.unlock();
+void Quant_Init(void)
+{
+    // Built once for the process, codecs on different threads share the tables read only
+    std::call_once(g_Quant_once, Quant_Build);
 }
 
 void Quant_DeInit(void)
 {
-    g_Quant_init--;
-    if (g_Quant_init > 1)
-    {
-        return;
-    }
-    else
-    {
-        g_Quant_init = 0; // Reset in case user called Quant_DeInit too many times without matching Quant_Init
-        if (amd_codes[0][0] == nullptr)  return;
-
-#ifdef USE_TRACE_WITH_DYNAMIC_MEM
-
-        for (int i = 0; i < MAX_CLUSTERS; i++)
-        {
-            for (int j = 0; j < MAX_ENTRIES_QUANT_TRACE; j++)
-            {
-                if (amd_codes[i][j])
-                {
-                    delete[] amd_codes[i][j];
-                    amd_codes[i][j] = nullptr;
-                }
-                if (amd_trs[i][j])
-                {
-                    delete[] amd_trs[i][j];
-                    amd_trs[i][j] = nullptr;
-                }
-            }
-        }
-
-#endif
-    }
-
+    // The tables are kept until the process exits so the next codec does not rebuild them
 }
 
 //=========================================================================================
@@ -148,32 +133,106 @@ void sugar(void){
 #endif
 };
 
-// called many times Optimize this call!
-inline int a_compare( const void *arg1, const void *arg2 )
+//
+// Sorting networks for up to 8 and 16 entries, used for the pixels of a subset. Entries are
+// compared on (key, original position) so equal keys keep their order, the same result
+// as the stable sort used before, and shorter lists are padded with keys that sort last.
+//
+static const int sortNetwork8[][2] =
 {
-// #ifdef USE_DBGTRACE
-//     DbgTrace(());
-// #endif
-    if (((a* )arg1)->d-((a* )arg2)->d > 0 ) return 1;
-    if (((a* )arg1)->d-((a* )arg2)->d < 0 ) return -1;
-    return 0;
+    {0,2},{1,3},{4,6},{5,7},   {0,4},{1,5},{2,6},{3,7},   {0,1},{2,3},{4,5},{6,7},
+    {2,4},{3,5},   {1,4},{3,6},   {1,2},{3,4},{5,6}
 };
 
-//
-// We ignore the issue of ordering equal elements here, though it can affect results abit
-//
-void sortProjection(double projection[MAX_ENTRIES], int order[MAX_ENTRIES], int numEntries) 
+static const int sortNetwork16[][2] =
 {
+    {0,13},{1,12},{2,15},{3,14},{4,8},{5,6},{7,11},{9,10},
+    {0,5},{1,7},{2,9},{3,4},{6,13},{8,14},{10,15},{11,12},
+    {0,1},{2,3},{4,5},{6,8},{7,9},{10,11},{12,13},{14,15},
+    {0,2},{1,3},{4,10},{5,11},{6,7},{8,9},{12,14},{13,15},
+    {1,2},{3,12},{4,6},{5,7},{8,10},{9,11},{13,14},
+    {1,4},{2,6},{5,8},{7,10},{9,13},{11,14},
+    {2,4},{3,6},{9,12},{11,13},
+    {3,5},{6,8},{7,9},{10,12},
+    {3,4},{5,6},{7,8},{9,10},{11,12},
+    {6,7},{8,9}
+};
+
+template <typename T>
+static inline void sortExchange(T key[], int pos[], int i, int j)
+{
+    T   ki = key[i], kj = key[j];
+    int pi = pos[i], pj = pos[j];
+    bool swap = (kj < ki) || ((kj == ki) && (pj < pi));
+    key[i] = swap ? kj : ki;
+    key[j] = swap ? ki : kj;
+    pos[i] = swap ? pj : pi;
+    pos[j] = swap ? pi : pj;
+}
+
+template <typename T, int N>
+static inline void sortNetwork(T key[], int pos[], int numEntries, const int network[][2], int numExchanges)
+{
+    T   k[N];
+    int p[N];
     int i;
-    a what[MAX_ENTRIES+MAX_PARTITIONS_TABLE];
-         
-    for (i=0; i < numEntries;i++) 
-        what[what[i].i=i].d = projection[i];
 
-    qsort((void*)&what, numEntries, sizeof(a),a_compare);
+    for (i=0; i < numEntries;i++) {
+        k[i] = key[i];
+        p[i] = pos[i];
+    }
+    for (; i < N;i++) {
+        k[i] = std::numeric_limits<T>::max();
+        p[i] = i;
+    }
+
+    for (i=0; i < numExchanges;i++)
+        sortExchange(k, p, network[i][0], network[i][1]);
+
+    for (i=0; i < numEntries;i++) {
+        key[i] = k[i];
+        pos[i] = p[i];
+    }
+}
+
+// Sorts key[] ascending and moves pos[] with it, equal keys are left in their order
+template <typename T>
+static void sortEntries(T key[], int pos[], int numEntries)
+{
+    if (numEntries <= 8)
+        sortNetwork<T, 8>(key, pos, numEntries, sortNetwork8, sizeof(sortNetwork8) / sizeof(sortNetwork8[0]));
+    else
+    if (numEntries <= 16)
+        sortNetwork<T, 16>(key, pos, numEntries, sortNetwork16, sizeof(sortNetwork16) / sizeof(sortNetwork16[0]));
+    else
+    {
+        // Longer lists, such as the errors of all the partitions of a mode
+        for (int i=1; i < numEntries;i++) {
+            T   k = key[i];
+            int p = pos[i];
+            int j = i;
+            for (; j > 0 && k < key[j-1];j--) {
+                key[j] = key[j-1];
+                pos[j] = pos[j-1];
+            }
+            key[j] = k;
+            pos[j] = p;
+        }
+    }
+}
+
+template <typename T>
+void sortProjection(T projection[MAX_ENTRIES], int order[MAX_ENTRIES], int numEntries) 
+{
+    int i;
+    T   key[MAX_ENTRIES+MAX_PARTITIONS_TABLE];
+
+    for (i=0; i < numEntries;i++) {
+        key[i]   = projection[i];
+        order[i] = i;
+    }
 
-    for (i=0; i < numEntries;i++) 
-        order[i]=what[i].i;
+    sortEntries(key, order, numEntries);
 };
 
 void covariance(double data[][DIMENSION], int numEntries, double cov[DIMENSION][DIMENSION]) 
@@ -195,7 +254,8 @@ void covariance(double data[][DIMENSION], int numEntries, double cov[DIMENSION][
             cov[i][j] = cov[j][i];
 }
  
-void covariance_d(double data[][MAX_DIMENSION_BIG], int numEntries, double cov[MAX_DIMENSION_BIG][MAX_DIMENSION_BIG], int dimension)
+template <typename T>
+static void covariance_d(T data[][MAX_DIMENSION_BIG], int numEntries, T cov[MAX_DIMENSION_BIG][MAX_DIMENSION_BIG], int dimension)
 {
 #ifdef USE_DBGTRACE
     DbgTrace(());
@@ -239,7 +299,8 @@ void centerInPlace(double data[][DIMENSION], int numEntries, double mean[DIMENSI
         }
 }
 
-void centerInPlace_d(double data[][MAX_DIMENSION_BIG], int numEntries, double mean[MAX_DIMENSION_BIG], int dimension)
+template <typename T>
+static void centerInPlace_d(T data[][MAX_DIMENSION_BIG], int numEntries, T mean[MAX_DIMENSION_BIG], int dimension)
 {
 #ifdef USE_DBGTRACE
     DbgTrace(());
@@ -258,7 +319,7 @@ void centerInPlace_d(double data[][MAX_DIMENSION_BIG], int numEntries, double me
 
     for(i=0;i<dimension;i++)
     {
-        mean[i]/=(double) numEntries;
+        mean[i]/=(T) numEntries;
         for(k=0;k<numEntries;k++)
             data[k][i]-=mean[i];
     }
@@ -280,7 +341,8 @@ void project(double data[][DIMENSION], int numEntries, double vector[DIMENSION],
     }
 }
 
-void project_d(double data[][MAX_DIMENSION_BIG], int numEntries, double vector[MAX_DIMENSION_BIG], double projection[MAX_ENTRIES], int dimension)
+template <typename T>
+static void project_d(T data[][MAX_DIMENSION_BIG], int numEntries, T vector[MAX_DIMENSION_BIG], T projection[MAX_ENTRIES], int dimension)
 {
     // assume that vector is normalized already
     int i,k;
@@ -381,7 +443,8 @@ void eigenVector(double cov[DIMENSION][DIMENSION], double vector[DIMENSION])
         vector[i]/=t;
 }
 
-void eigenVector_d(double cov[MAX_DIMENSION_BIG][MAX_DIMENSION_BIG], double vector[MAX_DIMENSION_BIG], int dimension)
+template <typename T>
+static void eigenVector_d(T cov[MAX_DIMENSION_BIG][MAX_DIMENSION_BIG], T vector[MAX_DIMENSION_BIG], int dimension)
 {
 #ifdef USE_DBGTRACE
     DbgTrace(());
@@ -395,14 +458,14 @@ void eigenVector_d(double cov[MAX_DIMENSION_BIG][MAX_DIMENSION_BIG], double vect
 
 
     int i,j,k,l, m, n,p,q;
-    double c[2][MAX_DIMENSION_BIG][MAX_DIMENSION_BIG];
-    double maxDiag;
+    T c[2][MAX_DIMENSION_BIG][MAX_DIMENSION_BIG];
+    T maxDiag;
 
     for(i=0;i<dimension;i++)
         for(j=0;j<dimension;j++)
             c[0][i][j] =cov[i][j];
 
-    p = (int) floor(log( (DBL_MAX_EXP - EV_SLACK) / ceil (log((double)dimension)/log(2.)) )/log(2.)); 
+    p = (int) floor(log( (std::numeric_limits<T>::max_exponent - EV_SLACK) / ceil (log((double)dimension)/log(2.)) )/log(2.)); 
 
     assert(p>0);
 
@@ -433,7 +496,7 @@ void eigenVector_d(double cov[MAX_DIMENSION_BIG][MAX_DIMENSION_BIG], double vect
         for(m=0;m<p;m++) {
             for(i=0;i<dimension;i++)
                 for(j=0;j<dimension;j++) {
-                    double temp=0;
+                    T temp=0;
                     for(k=0;k<dimension;k++)
                     {
                         // Notes: 
@@ -454,7 +517,7 @@ void eigenVector_d(double cov[MAX_DIMENSION_BIG][MAX_DIMENSION_BIG], double vect
          k = c[l][i][i] > maxDiag ? i : k;
          maxDiag = c[l][i][i] > maxDiag ? c[l][i][i] : maxDiag;
     }
-    double t;
+    T t;
     t=0;
     for(i=0;i<dimension;i++)
     {
@@ -751,10 +814,11 @@ double totalError(double data[MAX_ENTRIES][DIMENSION],double data2[MAX_ENTRIES][
     return t;
 };
 
-double totalError_d(double data[MAX_ENTRIES][MAX_DIMENSION_BIG],double data2[MAX_ENTRIES][MAX_DIMENSION_BIG],int numEntries, int dimension)
+template <typename T>
+T totalError_d(T data[MAX_ENTRIES][MAX_DIMENSION_BIG],T data2[MAX_ENTRIES][MAX_DIMENSION_BIG],int numEntries, int dimension)
 {
     int i,j;
-    double t=0;
+    T t=0;
     for (i=0;i<numEntries;i++) 
        for (j=0;j<dimension;j++) 
            t+= (data[i][j]-data2[i][j])*(data[i][j]-data2[i][j]);
@@ -1149,7 +1213,8 @@ void quantTrace(double data[MAX_ENTRIES_QUANT_TRACE][DIMENSION],int numEntries,
     }
 }
 
-void quantTrace_d(double data[MAX_ENTRIES_QUANT_TRACE][MAX_DIMENSION_BIG],int numEntries, int numClusters, int index[MAX_ENTRIES_QUANT_TRACE],int dimension)
+template <typename T>
+static void quantTrace_d(T data[MAX_ENTRIES_QUANT_TRACE][MAX_DIMENSION_BIG],int numEntries, int numClusters, int index[MAX_ENTRIES_QUANT_TRACE],int dimension)
 {
 #ifdef USE_DBGTRACE
     DbgTrace(());
@@ -1158,11 +1223,11 @@ void quantTrace_d(double data[MAX_ENTRIES_QUANT_TRACE][MAX_DIMENSION_BIG],int nu
 
     int i,j,k;
          
-    double sdata[2*MAX_ENTRIES][MAX_DIMENSION_BIG];
+    T sdata[2*MAX_ENTRIES][MAX_DIMENSION_BIG];
 
-    double  dpAcc [MAX_DIMENSION_BIG];
+    T  dpAcc [MAX_DIMENSION_BIG];
 
-    double M =0;
+    T M =0;
 
     struct TRACE  *tr ;
     tr=amd_trs[numClusters-1][numEntries-1];
@@ -1187,24 +1252,24 @@ void quantTrace_d(double data[MAX_ENTRIES_QUANT_TRACE][MAX_DIMENSION_BIG],int nu
 #define UROLL_STEP_1(i) \
     dpAcc[0]+=sdata[tr[i].k][0];\
     {\
-        double c; \
-        c = (dpAcc[0]*dpAcc[0])*tr[i].d;\
+        T c; \
+        c = (dpAcc[0]*dpAcc[0])*(T)tr[i].d;\
         if (c > M) {k=i;M=c;};\
     };
 
 #define UROLL_STEP_2(i) \
     dpAcc[0]+=sdata[tr[i].k][0];\
     dpAcc[1]+=sdata[tr[i].k][1];\
-    { double c; \
-    c = (dpAcc[0]*dpAcc[0]+dpAcc[1]*dpAcc[1])*tr[i].d;\
+    { T c; \
+    c = (dpAcc[0]*dpAcc[0]+dpAcc[1]*dpAcc[1])*(T)tr[i].d;\
     if (c > M) {k=i;M=c;};};
 
 #define UROLL_STEP_3(i) \
     dpAcc[0]+=sdata[tr[i].k][0];\
     dpAcc[1]+=sdata[tr[i].k][1];\
     dpAcc[2]+=sdata[tr[i].k][2];\
-    { double c; \
-    c = (dpAcc[0]*dpAcc[0]+dpAcc[1]*dpAcc[1]+dpAcc[2]*dpAcc[2])*tr[i].d;\
+    { T c; \
+    c = (dpAcc[0]*dpAcc[0]+dpAcc[1]*dpAcc[1]+dpAcc[2]*dpAcc[2])*(T)tr[i].d;\
     if (c > M) {k=i;M=c;};};
 
 #define UROLL_STEP_4(i) \
@@ -1212,8 +1277,8 @@ void quantTrace_d(double data[MAX_ENTRIES_QUANT_TRACE][MAX_DIMENSION_BIG],int nu
     dpAcc[1]+=sdata[tr[i].k][1];\
     dpAcc[2]+=sdata[tr[i].k][2];\
     dpAcc[3]+=sdata[tr[i].k][3];\
-    { double c; \
-    c = (dpAcc[0]*dpAcc[0]+dpAcc[1]*dpAcc[1]+dpAcc[2]*dpAcc[2]+dpAcc[3]*dpAcc[3])*tr[i].d;\
+    { T c; \
+    c = (dpAcc[0]*dpAcc[0]+dpAcc[1]*dpAcc[1]+dpAcc[2]*dpAcc[2]+dpAcc[3]*dpAcc[3])*(T)tr[i].d;\
     if (c > M) {k=i;M=c;};};
 
 #undef UROLL_STEP
@@ -1289,7 +1354,8 @@ void quantTrace_d(double data[MAX_ENTRIES_QUANT_TRACE][MAX_DIMENSION_BIG],int nu
     }
 }
 
-void quant_AnD_Shell(double* v_, int k, int n, int *idx) { 
+template <typename T>
+static void quant_AnD_Shell(T* v_, int k, int n, int *idx) { 
 
     // input:
     //
@@ -1303,17 +1369,18 @@ void quant_AnD_Shell(double* v_, int k, int n, int *idx) {
     //
     #define MAX_BLOCK MAX_ENTRIES
     int i,j;
-    double v[MAX_BLOCK];
-    double z[MAX_BLOCK];
-    a d[MAX_BLOCK];
-    double l;
-    double mm;
-    double r=0;
+    T v[MAX_BLOCK];
+    T z[MAX_BLOCK];
+    T d[MAX_BLOCK];
+    int di[MAX_BLOCK];
+    T l;
+    T mm;
+    T r=0;
     int mi;
 
     assert((v_ != NULL) && (n>1) && (k>1));
 
-    double m, M, s, dm=0.;
+    T m, M, s, dm=0.;
     m=M=v_[0]; 
     
     for (i=1; i < n;i++) {
@@ -1333,29 +1400,29 @@ void quant_AnD_Shell(double* v_, int k, int n, int *idx) {
 
         idx[i]=(int)(z[i] = floor(v[i] +0.5 /* stabilizer*/ - m *s));
 
-        d[i].d = v[i]-z[i]- m *s;
-        d[i].i = i; 
-        dm+= d[i].d;
-        r += d[i].d*d[i].d;
+        d[i] = v[i]-z[i]- m *s;
+        di[i] = i; 
+        dm+= d[i];
+        r += d[i]*d[i];
     }
     if (n*r- dm*dm >= (double)(n-1)/4 /*slack*/ /2) { 
 
-        dm /= (double)n;
+        dm /= (T)n;
 
         for (i=0; i < n;i++) 
-            d[i].d -= dm;
+            d[i] -= dm;
 
-        qsort((void*)&d, n, sizeof(a),a_compare);
+        sortEntries(d, di, n);
 
     // got into fundamental simplex
     // move coordinate system origin to its center
         for (i=0; i < n;i++) 
-            d[i].d -= (2.*(double)i+1-(double)n)/2./(double)n;
+            d[i] -= (T)((2.*(double)i+1-(double)n)/2./(double)n);
 
         mm=l=0.;
         j=-1;
         for (i=0; i < n;i++) {
-            l+=d[i].d;
+            l+=d[i];
             if (l < mm) {
                 mm =l;
                 j=i;
@@ -1366,7 +1433,7 @@ void quant_AnD_Shell(double* v_, int k, int n, int *idx) {
         j = ++j % n;
 
         for (i=j; i < n;i++) 
-            idx[d[i].i]++;
+            idx[di[i]]++;
     }
 // get rid of an offset in idx
     mi=idx[0];
@@ -1523,11 +1590,12 @@ double optQuantTrace(
     return totalError(data,out,numEntries);
 }
 
-double optQuantTrace_d(
-    double data[MAX_ENTRIES][MAX_DIMENSION_BIG], 
+template <typename T>
+T optQuantTrace_d(
+    T data[MAX_ENTRIES][MAX_DIMENSION_BIG], 
     int numEntries, int numClusters, int index_[MAX_ENTRIES],
-    double out[MAX_ENTRIES][MAX_DIMENSION_BIG],
-    double direction [MAX_DIMENSION_BIG],double *step,
+    T out[MAX_ENTRIES][MAX_DIMENSION_BIG],
+    T direction [MAX_DIMENSION_BIG],T *step,
     int dimension
     )
 {
@@ -1537,12 +1605,12 @@ double optQuantTrace_d(
     int index[MAX_ENTRIES];
     int maxTry=MAX_TRY;
     int i,j,k;
-    double t,s;
-    double centered[MAX_ENTRIES][MAX_DIMENSION_BIG];
-    double ordered[MAX_ENTRIES][MAX_DIMENSION_BIG];
-    double mean[MAX_DIMENSION_BIG];
-    double cov[DIMENSION][MAX_DIMENSION_BIG];
-    double projected[MAX_ENTRIES];
+    T t,s;
+    T centered[MAX_ENTRIES][MAX_DIMENSION_BIG];
+    T ordered[MAX_ENTRIES][MAX_DIMENSION_BIG];
+    T mean[MAX_DIMENSION_BIG];
+    T cov[DIMENSION][MAX_DIMENSION_BIG];
+    T projected[MAX_ENTRIES];
     int order[MAX_ENTRIES];
 
     for (i=0;i<numEntries;i++) 
@@ -1614,7 +1682,7 @@ double optQuantTrace_d(
 
     s=t=0;
     
-    double q=0;
+    T q=0;
 
     for (k=0;k<numEntries;k++)
     { 
@@ -1631,9 +1699,9 @@ double optQuantTrace_d(
 
     }   
 
-    s /= (double) numEntries;
+    s /= (T) numEntries;
 
-    t = t - s * s * (double) numEntries;
+    t = t - s * s * (T) numEntries;
 
     assert(t !=0);   
 
@@ -2014,11 +2082,12 @@ double optQuantAnD(
     return totalError(data,out,numEntries);
 }
 
-double optQuantAnD_d(
-    double data[MAX_ENTRIES][MAX_DIMENSION_BIG], 
+template <typename T>
+T optQuantAnD_d(
+    T data[MAX_ENTRIES][MAX_DIMENSION_BIG], 
     int numEntries, int numClusters, int index[MAX_ENTRIES],
-    double out[MAX_ENTRIES][MAX_DIMENSION_BIG],
-    double direction [MAX_DIMENSION_BIG],double *step,
+    T out[MAX_ENTRIES][MAX_DIMENSION_BIG],
+    T direction [MAX_DIMENSION_BIG],T *step,
     int dimension
     )
 {
@@ -2031,15 +2100,15 @@ double optQuantAnD_d(
     int try_two=50;
 
     int i,j,k;
-    double t,s;
+    T t,s;
 
-    double centered[MAX_ENTRIES][MAX_DIMENSION_BIG];
+    T centered[MAX_ENTRIES][MAX_DIMENSION_BIG];
 
-    double mean[MAX_DIMENSION_BIG];
+    T mean[MAX_DIMENSION_BIG];
 
-    double cov[MAX_DIMENSION_BIG][MAX_DIMENSION_BIG];
+    T cov[MAX_DIMENSION_BIG][MAX_DIMENSION_BIG];
 
-    double projected[MAX_ENTRIES];
+    T projected[MAX_ENTRIES];
 
     int order_[MAX_ENTRIES];
 
@@ -2079,7 +2148,7 @@ double optQuantAnD_d(
         {
             do
             {
-                double q;
+                T q;
                 q=s=t=0;
                 
                 for (k=0;k<numEntries;k++)
@@ -2097,8 +2166,8 @@ double optQuantAnD_d(
 
                 }
 
-                s /= (double) numEntries;
-                t = t - s * s * (double) numEntries;
+                s /= (T) numEntries;
+                t = t - s * s * (T) numEntries;
                 assert(t !=0);
                 t = (t == 0 ? 0. : 1/t);
                 // We need to requantize 
@@ -2161,7 +2230,7 @@ double optQuantAnD_d(
 
     s=t=0;
     
-    double q=0;
+    T q=0;
 
     for (k=0;k<numEntries;k++)
     { 
@@ -2177,9 +2246,9 @@ double optQuantAnD_d(
         q+= direction[j]* direction[j];
     }
 
-    s /= (double) numEntries;
+    s /= (T) numEntries;
 
-    t = t - s * s * (double) numEntries;
+    t = t - s * s * (T) numEntries;
 
     assert(t !=0);   
 
@@ -2199,3 +2268,16 @@ double optQuantAnD_d(
     return totalError_d(data,out,numEntries, dimension);
 }
 
+// Instantiations for the double and the single precision BC7 encoders
+template void   sortProjection(double projection[MAX_ENTRIES], int order[MAX_ENTRIES], int numEntries);
+template void   sortProjection(float projection[MAX_ENTRIES], int order[MAX_ENTRIES], int numEntries);
+template double totalError_d(double data[MAX_ENTRIES][MAX_DIMENSION_BIG], double data2[MAX_ENTRIES][MAX_DIMENSION_BIG], int numEntries, int dimension);
+template float  totalError_d(float data[MAX_ENTRIES][MAX_DIMENSION_BIG], float data2[MAX_ENTRIES][MAX_DIMENSION_BIG], int numEntries, int dimension);
+template double optQuantTrace_d(double data[MAX_ENTRIES][MAX_DIMENSION_BIG], int numEntries, int numClusters, int index_[MAX_ENTRIES],
+                                double out[MAX_ENTRIES][MAX_DIMENSION_BIG], double direction[MAX_DIMENSION_BIG], double *step, int dimension);
+template float  optQuantTrace_d(float data[MAX_ENTRIES][MAX_DIMENSION_BIG], int numEntries, int numClusters, int index_[MAX_ENTRIES],
+                                float out[MAX_ENTRIES][MAX_DIMENSION_BIG], float direction[MAX_DIMENSION_BIG], float *step, int dimension);
+template double optQuantAnD_d(double data[MAX_ENTRIES][MAX_DIMENSION_BIG], int numEntries, int numClusters, int index[MAX_ENTRIES],
+                              double out[MAX_ENTRIES][MAX_DIMENSION_BIG], double direction[MAX_DIMENSION_BIG], double *step, int dimension);
+template float  optQuantAnD_d(float data[MAX_ENTRIES][MAX_DIMENSION_BIG], int numEntries, int numClusters, int index[MAX_ENTRIES],
+                              float out[MAX_ENTRIES][MAX_DIMENSION_BIG], float direction[MAX_DIMENSION_BIG], float *step, int dimension);
@@ -25,16 +25,14 @@
 
 #define _3DQUANT_H_INCLUDED
 
-typedef struct {
-    double d;
-    int i;
-} a;
+// The _d quantizers and sortProjection are templates on the floating point type. They are
+// instantiated for double, the reference BC7 encoder, and for float, the single precision one.
 
-void sortProjection(double projection[MAX_ENTRIES], int order[MAX_ENTRIES], int numEntries);
+template <typename T>
+void sortProjection(T projection[MAX_ENTRIES], int order[MAX_ENTRIES], int numEntries);
 void covariance(double data[][DIMENSION], int numEntries, double cov[DIMENSION][DIMENSION]); 
 void centerInPlace(double data[][DIMENSION], int numEntries, double mean[DIMENSION]);
 void project(double data[][DIMENSION], int numEntries, double vector[DIMENSION], double projection[MAX_ENTRIES]);
-void sortProjection(double projection[MAX_ENTRIES], int order[MAX_ENTRIES], int numEntries);
 void eigenVector(double cov[DIMENSION][DIMENSION], double vector[DIMENSION]);
 double partition2 (double data[][DIMENSION], int numEntries,int index[]);
 
@@ -46,7 +44,8 @@ double optQuantEven(
     ) ;
  
 double totalError(double data[MAX_ENTRIES][DIMENSION],double data2[MAX_ENTRIES][DIMENSION],int numEntries);
-double totalError_d(double data[MAX_ENTRIES][MAX_DIMENSION_BIG],double data2[MAX_ENTRIES][MAX_DIMENSION_BIG],int numEntries, int dimension);
+template <typename T>
+T totalError_d(T data[MAX_ENTRIES][MAX_DIMENSION_BIG],T data2[MAX_ENTRIES][MAX_DIMENSION_BIG],int numEntries, int dimension);
 
 /****************************************************/
 /****************************************************/
@@ -66,14 +65,15 @@ double optQuantTrace(
     double *step                            // step size (check normalization) 
     );
 
-double optQuantTrace_d(
-    double data[MAX_ENTRIES][MAX_DIMENSION_BIG],    // input data 
+template <typename T>
+T optQuantTrace_d(
+    T data[MAX_ENTRIES][MAX_DIMENSION_BIG],    // input data 
     int numEntries,                            // number of input points above (not clear about 1, better to avoid)  
     int numClusters,                        // number of clusters on the ramp, max 8 (not clear about 1, better to avoid)  
     int index[MAX_ENTRIES],                    // output index, if not all points of the ramp used, 0 may not be assigned
-    double out[MAX_ENTRIES][MAX_DIMENSION_BIG],        // resulting quantization
-    double direction [MAX_DIMENSION_BIG],            // direction vector of the ramp (check normalization) 
-    double *step,                            // step size (check normalization) 
+    T out[MAX_ENTRIES][MAX_DIMENSION_BIG],        // resulting quantization
+    T direction [MAX_DIMENSION_BIG],            // direction vector of the ramp (check normalization) 
+    T *step,                            // step size (check normalization) 
     int dimension);
 
 /****************************************************/
@@ -102,11 +102,12 @@ double optQuantAnD(
     );
 
 
-double optQuantAnD_d(
-    double data[MAX_ENTRIES][MAX_DIMENSION_BIG],  // 0-255
+template <typename T>
+T optQuantAnD_d(
+    T data[MAX_ENTRIES][MAX_DIMENSION_BIG],  // 0-255
     int numEntries, int numClusters, int index[MAX_ENTRIES],
-    double out[MAX_ENTRIES][MAX_DIMENSION_BIG],
-    double direction [MAX_DIMENSION_BIG],double *step,
+    T out[MAX_ENTRIES][MAX_DIMENSION_BIG],
+    T direction [MAX_DIMENSION_BIG],T *step,
     int dimension
     );
 
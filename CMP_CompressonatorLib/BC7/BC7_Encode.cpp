@@ -29,6 +29,8 @@
 #include <float.h>
 #include <stdio.h>
 #include <math.h>
+#include <limits.h>
+#include <limits>
 #include "Common.h"
 #include "BC7_Definitions.h"
 #include "BC7_Partitions.h"
@@ -57,6 +59,10 @@ double g_qFAST_THRESHOLD  = 0.5;
 // This limit is used for DualIndex Block and if fQuality is above this limit then Quantization shaking will always be performed
 // on all indexs
 double g_HIGHQULITY_THRESHOLD = 0.7;
+
+// The coarse to fine mode search stops once a block is within this error even when the quality
+// threshold is lower, the same default as the minimum threshold of SetErrorThresholdBC7 in CMP_Core
+double g_MODESEARCH_MIN_THRESHOLD = 5.0;
 //
 // For a given block mode this sets up the data needed by the compressor
 //
@@ -365,27 +371,9 @@ void BC7BlockEncoder::EncodeSingleIndexBlock(CMP_DWORD blockMode,
 //BYTE BlankBC7Block[16] = { 0x40, 0xC0, 0x1F, 0xF0, 0x07, 0xFC, 0x70, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
 
 
-double BC7BlockEncoder::CompressSingleIndexBlock(
-    double      in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
-    CMP_BYTE    out[COMPRESSED_BLOCK_SIZE],
-    CMP_DWORD   blockMode)
+// Number of partitions of a single index mode that are searched at the encoder quality
+CMP_DWORD BC7BlockEncoder::PartitionsToTry(CMP_DWORD blockMode)
 {
-#ifdef USE_DBGTRACE
-    DbgTrace(("<---------CompressSingleIndexBlock----------->"));
-#endif
-    CMP_DWORD   i, k, n;
-    CMP_DWORD   dimension;
-
-    // Figure out the effective dimension of this block mode
-    if(bti[blockMode].encodingType == NO_ALPHA)
-    {
-        dimension = 3;
-    }
-    else
-    {
-        dimension = 4;
-    }
-
     CMP_DWORD numPartitionModes = 1 << bti[blockMode].partitionBits;
     CMP_DWORD partitionsToTry = numPartitionModes;
 
@@ -395,179 +383,161 @@ double BC7BlockEncoder::CompressSingleIndexBlock(
         partitionsToTry = (CMP_DWORD)floor((double)(partitionsToTry * m_partitionSearchSize) + 0.5);
         partitionsToTry = min(numPartitionModes, max(1, partitionsToTry));
     }
+    return partitionsToTry;
+}
 
-    CMP_DWORD   blockPartition;
-    double      partition[MAX_SUBSETS][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
+//
+// Quantizes one partition of a single index mode set up by BlockSetup and returns the
+// quantizer error, the first and cheap estimate of how well the partition will encode.
+// The indices are stored for the shakers.
+//
+template <typename T>
+T BC7BlockEncoder::QuantizePartition(
+    T           in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+    CMP_DWORD   blockMode,
+    CMP_DWORD   blockPartition,
+    CMP_DWORD   dimension,
+    int         storedIndices[MAX_SUBSETS][MAX_SUBSET_SIZE])
+{
+    T      partition[MAX_SUBSETS][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
     CMP_DWORD   entryCount[MAX_SUBSETS];
     CMP_DWORD   subset;
 
+    Partition(blockPartition,
+              in,
+              partition,
+              entryCount,
+              blockMode,
+              dimension);
 
-#ifdef    BC7_DEBUG_TO_RESULTS_TXT
-    fprintf(fp,"\CompressSingleIndexBlock\n");
-    fprintf(fp,"blockMode = %d\n",blockMode);
-    fprintf(fp,"numPartitionModes = %d\n",numPartitionModes);
-    fprintf(fp,"partitionsToTry = %d\n",partitionsToTry);
-    fprintf(fp,"m_blockMaxRange =  %4.0f\n",m_blockMaxRange);
-    fprintf(fp,"m_quantizerRangeThreshold = %4.0f\n",m_quantizerRangeThreshold);
-    fprintf(fp,"m_clusters[0] = %d\n",m_clusters[0]);
-#endif
 
-#ifdef USE_DBGTRACE
-    DbgTrace(("blockMode [%d] numPartitionModes [%d] partitionsToTry [%2d]",
-        blockMode,
-        numPartitionModes,
-        partitionsToTry));
-    DbgTrace((" m_blockMaxRange [%2d] m_quantizerRangeThreshold [%4.0f] m_clusters[0] = %d",
-        m_blockMaxRange,
-        m_quantizerRangeThreshold,
-        m_clusters[0]));
-#endif
+    T  error = 0.;
+    T  outB[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
+    T  direction[MAX_DIMENSION_BIG];
+    T  step;
 
-    // Loop over the available partitions for the block mode and quantize them 
-    // to figure out the best candidates for further refinement
-    for(blockPartition = 0;
-        blockPartition < partitionsToTry;
-        blockPartition++)
+    for(subset=0; subset < bti[blockMode].subsetCount; subset++)
     {
-        Partition(blockPartition,
-                  in,
-                  partition,
-                  entryCount,
-                  blockMode,
-                  dimension);
-
-
-        double  error = 0.;
-        double  outB[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
-        double  direction[MAX_DIMENSION_BIG];
-        double  step;
+        int     indices[MAX_SUBSETS][MAX_SUBSET_SIZE];
 
-        for(subset=0; subset < bti[blockMode].subsetCount; subset++)
+        if(entryCount[subset])
         {
-            int     indices[MAX_SUBSETS][MAX_SUBSET_SIZE];
 
-            if(entryCount[subset])
+            if((m_clusters[0] > 8) ||
+               (m_blockMaxRange <= m_quantizerRangeThreshold))
             {
 
-                if((m_clusters[0] > 8) ||
-                   (m_blockMaxRange <= m_quantizerRangeThreshold))
-                {
-
 #ifdef    BC7_DEBUG_TO_RESULTS_TXT
-                    fprintf(fp,"\noptQuantAnD_d\n");
+                fprintf(fp,"\noptQuantAnD_d\n");
 #endif
-                    error += optQuantAnD_d(partition[subset],
-                                           entryCount[subset],
-                                           m_clusters[0],
-                                           indices[subset],
-                                           outB,
-                                           direction,
-                                           &step,
-                                           dimension);
+                error += optQuantAnD_d(partition[subset],
+                                       entryCount[subset],
+                                       m_clusters[0],
+                                       indices[subset],
+                                       outB,
+                                       direction,
+                                       &step,
+                                       dimension);
 
 #ifdef    BC7_DEBUG_TO_RESULTS_TXT
-                    if (blockPartition == 11)
-                    {
-                            fprintf(fp,"\n");
-                            for (int row=0; row<16; row++)
-                            {
-                                fprintf(fp,"partition[%2d] = %4.2f, %4.2f, %4.2f\n",row,partition[subset][row][0],partition[subset][row][1],partition[subset][row][2]);
-                            }
-                    
-                    
-                            fprintf(fp,"\n");
-                            for (int row=0; row<16; row++)
-                            {
-                                fprintf(fp,"indices[0][%2d] = %4.2f\n",row,indices[0][row]);
-                            }
-                    
-                            fprintf(fp,"\n");
-                            for (int row=0; row<16; row++)
-                            {
-                                fprintf(fp,"outB[%2d] = %4.2f, %4.2f, %4.2f\n",row,outB[row][0],outB[row][1],outB[row][2]);
-                            }
-                    
-                            fprintf(fp,"\n");
-                            fprintf(fp,"entryCount = %d\n",entryCount[subset]);
-                            fprintf(fp,"m_clusters[0] = %d\n",m_clusters[0]);
-                            fprintf(fp,"Direction = %4.2f, %4.2f, %4.2f\n",direction[0],direction[1],direction[2]);
-                            fprintf(fp,"step = %4.2f\n",step);
-                            fprintf(fp,"dimension = %4.2f\n",dimension);
-                            fprintf(fp,"error = %4.2f\n",error);
-                    }                
-#endif
-                }
-                else
+                if (blockPartition == 11)
                 {
+                        fprintf(fp,"\n");
+                        for (int row=0; row<16; row++)
+                        {
+                            fprintf(fp,"partition[%2d] = %4.2f, %4.2f, %4.2f\n",row,partition[subset][row][0],partition[subset][row][1],partition[subset][row][2]);
+                        }
+                
+                
+                        fprintf(fp,"\n");
+                        for (int row=0; row<16; row++)
+                        {
+                            fprintf(fp,"indices[0][%2d] = %4.2f\n",row,indices[0][row]);
+                        }
+                
+                        fprintf(fp,"\n");
+                        for (int row=0; row<16; row++)
+                        {
+                            fprintf(fp,"outB[%2d] = %4.2f, %4.2f, %4.2f\n",row,outB[row][0],outB[row][1],outB[row][2]);
+                        }
+                
+                        fprintf(fp,"\n");
+                        fprintf(fp,"entryCount = %d\n",entryCount[subset]);
+                        fprintf(fp,"m_clusters[0] = %d\n",m_clusters[0]);
+                        fprintf(fp,"Direction = %4.2f, %4.2f, %4.2f\n",direction[0],direction[1],direction[2]);
+                        fprintf(fp,"step = %4.2f\n",step);
+                        fprintf(fp,"dimension = %4.2f\n",dimension);
+                        fprintf(fp,"error = %4.2f\n",error);
+                }                
+#endif
+            }
+            else
+            {
 #ifdef    BC7_DEBUG_TO_RESULTS_TXT
-                    fprintf(fp,"\optQuantTrace_d\n");
+                fprintf(fp,"\optQuantTrace_d\n");
 #endif
-                  error += optQuantTrace_d(partition[subset],
-                                             entryCount[subset],
-                                             m_clusters[0],
-                                             indices[subset],
-                                             outB,
-                                             direction,
-                                             &step,
-                                             dimension);
+              error += optQuantTrace_d(partition[subset],
+                                         entryCount[subset],
+                                         m_clusters[0],
+                                         indices[subset],
+                                         outB,
+                                         direction,
+                                         &step,
+                                         dimension);
 
 #ifdef    BC7_DEBUG_TO_RESULTS_TXT
-                    if (blockPartition == 11)
-                    {
-                            fprintf(fp,"\n");
-                            for (int row=0; row<16; row++)
-                            {
-                                fprintf(fp,"partition[%2d] = %4.2f, %4.2f, %4.2f\n",row,partition[subset][row][0],partition[subset][row][1],partition[subset][row][2]);
-                            }
-                    
-                    
-                            fprintf(fp,"\n");
-                            for (int row=0; row<16; row++)
-                            {
-                                fprintf(fp,"indices[0][%2d] = %4.2f\n",row,indices[0][row]);
-                            }
-                    
-                            fprintf(fp,"\n");
-                            for (int row=0; row<16; row++)
-                            {
-                                fprintf(fp,"outB[%2d] = %4.2f, %4.2f, %4.2f\n",row,outB[row][0],outB[row][1],outB[row][2]);
-                            }
-                    
-                            fprintf(fp,"\n");
-                            fprintf(fp,"entryCount = %d\n",entryCount[subset]);
-                            fprintf(fp,"m_clusters[0] = %d\n",m_clusters[0]);
-                            fprintf(fp,"Direction = %4.2f, %4.2f, %4.2f\n",direction[0],direction[1],direction[2]);
-                            fprintf(fp,"step = %4.2f\n",step);
-                            fprintf(fp,"dimension = %4.2f\n",dimension);
-                            fprintf(fp,"error = %4.2f\n",error);
-                    }
-#endif
+                if (blockPartition == 11)
+                {
+                        fprintf(fp,"\n");
+                        for (int row=0; row<16; row++)
+                        {
+                            fprintf(fp,"partition[%2d] = %4.2f, %4.2f, %4.2f\n",row,partition[subset][row][0],partition[subset][row][1],partition[subset][row][2]);
+                        }
                 
+                
+                        fprintf(fp,"\n");
+                        for (int row=0; row<16; row++)
+                        {
+                            fprintf(fp,"indices[0][%2d] = %4.2f\n",row,indices[0][row]);
+                        }
+                
+                        fprintf(fp,"\n");
+                        for (int row=0; row<16; row++)
+                        {
+                            fprintf(fp,"outB[%2d] = %4.2f, %4.2f, %4.2f\n",row,outB[row][0],outB[row][1],outB[row][2]);
+                        }
+                
+                        fprintf(fp,"\n");
+                        fprintf(fp,"entryCount = %d\n",entryCount[subset]);
+                        fprintf(fp,"m_clusters[0] = %d\n",m_clusters[0]);
+                        fprintf(fp,"Direction = %4.2f, %4.2f, %4.2f\n",direction[0],direction[1],direction[2]);
+                        fprintf(fp,"step = %4.2f\n",step);
+                        fprintf(fp,"dimension = %4.2f\n",dimension);
+                        fprintf(fp,"error = %4.2f\n",error);
                 }
+#endif
+            
+            }
 
-                // Store off the indices for later
-                for(CMP_DWORD idx=0; idx < entryCount[subset]; idx++)
-                {
-                    m_storedIndices[blockPartition][subset][idx] = indices[subset][idx];
-                }
+            // Store off the indices for later
+            for(CMP_DWORD idx=0; idx < entryCount[subset]; idx++)
+            {
+                storedIndices[subset][idx] = indices[subset][idx];
             }
         }
-
-        m_storedError[blockPartition] = error;
     }
 
-    // Sort the results
-    sortProjection(m_storedError,
-                   m_sortedModes,
-                   partitionsToTry);
-
+    return error;
+}
 
-    // Run shaking (endpoint refinement) pass for partitions that gave the
-    // best set of errors from quantization
+// Sets up the shaker bits of a single index mode and returns the size of the shake cube
+CMP_DWORD BC7BlockEncoder::ShakeSetup(CMP_DWORD blockMode, CMP_DWORD dimension, int bits[4])
+{
+    CMP_DWORD   i;
 
     // ep_shaker will take its endpoint information from bits[0-2]
     // ep_shaker_2_d will take its information from bits[3]
-    int     bits[4] = {0,0,0,0};
+    bits[3] = 0;
 
     // ep_shaker_d needs bits specified individually per channel including parity
     bits[0] = m_componentBits[COMP_RED]   + (m_parityBits ? 1:0);
@@ -589,16 +559,6 @@ double BC7BlockEncoder::CompressSingleIndexBlock(
         bits[3] += 1;
     }
 
-    int     epo_code[MAX_SUBSETS][2][MAX_DIMENSION_BIG];
-    double  epo[2][MAX_DIMENSION_BIG];
-    double  outB[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
-
-    int     bestEndpoints[MAX_SUBSETS][2][MAX_DIMENSION_BIG];
-    int     bestIndices[MAX_SUBSETS][MAX_SUBSET_SIZE];
-    CMP_DWORD   bestEntryCount[MAX_SUBSETS];
-    CMP_DWORD   bestPartition = 0;
-    double  bestError = DBL_MAX;
-
     // Extensive shaking is most important when the ramp is short, and
     // when we have less indices. On a long ramp the quality of the
     // initial quantizing is relatively more important
@@ -611,9 +571,6 @@ double BC7BlockEncoder::CompressSingleIndexBlock(
     CMP_DWORD   shakeSize = 8 - (CMP_DWORD)floor(1.5 * bti[blockMode].indexBits[0]);
     shakeSize = max(2, min((CMP_DWORD)floor( shakeSize * m_quality + 0.5), 6));
 
-    // Shake attempts indicates how many partitions to try to shake
-    CMP_DWORD   numShakeAttempts = max(1, min((CMP_DWORD)floor(8 * m_quality + 0.5), partitionsToTry));
-
     // Set up all the parameters for the shakers
     // Must increase shake size if these block endpoints use parity
     if((m_parityBits == SAME_PAR) ||
@@ -621,160 +578,144 @@ double BC7BlockEncoder::CompressSingleIndexBlock(
     {
         shakeSize += 2;
     }
+    return shakeSize;
+}
 
-#ifdef USE_DBGTRACE
-    DbgTrace(("%2d numPartitionModes %2d SearchSize %3.3f shakeSize %2d numShakeAttempts %2d\n",
-     partitionsToTry,
-     numPartitionModes,
-     m_partitionSearchSize,
-     shakeSize,
-     numShakeAttempts));
-#endif
-
-    // Now do the endpoint shaking
-    for(i=0; i < numShakeAttempts; i++)
+//
+// Runs the endpoint shakers on one partition of a single index mode. The stored indices
+// from the quantizer are refined in place, the endpoints go to epo_code and the error
+// of the refined partition is returned.
+//
+template <typename T>
+T BC7BlockEncoder::ShakePartition(
+    T           in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+    CMP_DWORD   blockMode,
+    CMP_DWORD   blockPartition,
+    CMP_DWORD   dimension,
+    CMP_DWORD   shakeSize,
+    int         bits[4],
+    int         storedIndices[MAX_SUBSETS][MAX_SUBSET_SIZE],
+    int         epo_code[MAX_SUBSETS][2][MAX_DIMENSION_BIG],
+    CMP_DWORD   entryCount[MAX_SUBSETS])
+{
+    T      partition[MAX_SUBSETS][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
+    T      epo[2][MAX_DIMENSION_BIG];
+    T      outB[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
+    CMP_DWORD   subset, k;
+    T      error = 0;
+
+    Partition(blockPartition,
+              in,
+              partition,
+              entryCount,
+              blockMode,
+              dimension);
+
+    for(subset=0; subset < bti[blockMode].subsetCount; subset++)
     {
-        double error = 0;
-
-        blockPartition = m_sortedModes[i];
-
-        Partition(blockPartition,
-                  in,
-                  partition,
-                  entryCount,
-                  blockMode,
-                  dimension);
-
-        for(subset=0; subset < bti[blockMode].subsetCount; subset++)
+        if(entryCount[subset])
         {
-            if(entryCount[subset])
+            // If quality is set low or the dimension is not compatible with
+            // shaker_d then just run shaker_2_d
+            if((m_blockMaxRange > m_shakerRangeThreshold) ||
+               (dimension != 3))
             {
-                // If quality is set low or the dimension is not compatible with
-                // shaker_d then just run shaker_2_d
-                if((m_blockMaxRange > m_shakerRangeThreshold) ||
-                   (dimension != 3))
+                error += ep_shaker_2_d(partition[subset],
+                                      entryCount[subset],
+                                      storedIndices[subset],
+                                      outB,
+                                      epo_code[subset],
+                                      shakeSize,
+                                      m_clusters[0]-1,
+                                      bits[3],
+                                      dimension,
+                                      epo);
+            }
+            else
+            {
+                T  tempError[2];
+                int     tempIndices[MAX_SUBSET_SIZE];
+                int     temp_epo_code[2][MAX_DIMENSION_BIG];
+
+                // Step one - run ep_shaker and ep_shaker_2 in parallel, and get the error from each
+
+                for(k=0; k < entryCount[subset]; k++)
                 {
-                    error += ep_shaker_2_d(partition[subset],
-                                          entryCount[subset],
-                                          m_storedIndices[blockPartition][subset],
-                                          outB,
-                                          epo_code[subset],
-                                          shakeSize,
-                                          m_clusters[0]-1,
-                                          bits[3],
-                                          dimension,
-                                          epo);
+                    tempIndices[k] = storedIndices[subset][k];
                 }
-                else
-                {
-                    double  tempError[2];
-                    int     tempIndices[MAX_SUBSET_SIZE];
-                    int     temp_epo_code[2][MAX_DIMENSION_BIG];
-
-                    // Step one - run ep_shaker and ep_shaker_2 in parallel, and get the error from each
+                tempError[0] = ep_shaker_d(partition[subset],
+                                           entryCount[subset],
+                                           tempIndices,
+                                           outB,
+                                           temp_epo_code,
+                                           m_clusters[0]-1,
+                                           bits,
+                                           (CMP_qt)m_parityBits,
+                                           dimension);
 
-                    for(k=0; k < entryCount[subset]; k++)
-                    {
-                        tempIndices[k] = m_storedIndices[blockPartition][subset][k];
-                    }
-                    tempError[0] = ep_shaker_d(partition[subset],
-                                               entryCount[subset],
-                                               tempIndices,
-                                               outB,
-                                               temp_epo_code,
-                                               m_clusters[0]-1,
-                                               bits,
-                                               (CMP_qt)m_parityBits,
-                                               dimension);
+                tempError[1] = ep_shaker_2_d(partition[subset],
+                                             entryCount[subset],
+                                             storedIndices[subset],
+                                             outB,
+                                             epo_code[subset],
+                                             shakeSize,
+                                             m_clusters[0]-1,
+                                             bits[3],
+                                             dimension,
+                                             epo);
+
+                if(tempError[0] < tempError[1])
+                {
+                    // If ep_shaker did better than ep_shaker_2 then we need to reshake
+                    // the output from ep_shaker using ep_shaker_2 for further refinement
 
                     tempError[1] = ep_shaker_2_d(partition[subset],
                                                  entryCount[subset],
-                                                 m_storedIndices[blockPartition][subset],
+                                                 tempIndices,
                                                  outB,
-                                                 epo_code[subset],
+                                                 temp_epo_code,
                                                  shakeSize,
                                                  m_clusters[0]-1,
                                                  bits[3],
                                                  dimension,
                                                  epo);
 
-                    if(tempError[0] < tempError[1])
-                    {
-                        // If ep_shaker did better than ep_shaker_2 then we need to reshake
-                        // the output from ep_shaker using ep_shaker_2 for further refinement
-
-                        tempError[1] = ep_shaker_2_d(partition[subset],
-                                                     entryCount[subset],
-                                                     tempIndices,
-                                                     outB,
-                                                     temp_epo_code,
-                                                     shakeSize,
-                                                     m_clusters[0]-1,
-                                                     bits[3],
-                                                     dimension,
-                                                     epo);
-
-                        // Copy the results into the expected location
-                        for(k=0; k<entryCount[subset]; k++)
-                        {
-                            m_storedIndices[blockPartition][subset][k] = tempIndices[k];
-                        }
-
-                        for(k=0; k < MAX_DIMENSION_BIG; k++)
-                        {
-                            epo_code[subset][0][k] = temp_epo_code[0][k];
-                            epo_code[subset][1][k] = temp_epo_code[1][k];
-                        }
-                    }
-
-                    error += tempError[1];
-                }
-            }
-        }
-
-
-        if(error < bestError)
-        {
-            bestPartition = blockPartition;
-
-            for(subset=0; subset < bti[blockMode].subsetCount; subset++)
-            {
-                bestEntryCount[subset] = entryCount[subset];
-
-                if(entryCount[subset])
-                {
-                    for(k=0; k < dimension; k++)
+                    // Copy the results into the expected location
+                    for(k=0; k<entryCount[subset]; k++)
                     {
-                        bestEndpoints[subset][0][k] = epo_code[subset][0][k];
-                        bestEndpoints[subset][1][k] = epo_code[subset][1][k];
+                        storedIndices[subset][k] = tempIndices[k];
                     }
 
-                    for(n=0; n < entryCount[subset]; n++)
+                    for(k=0; k < MAX_DIMENSION_BIG; k++)
                     {
-                        bestIndices[subset][n] = m_storedIndices[blockPartition][subset][n];
+                        epo_code[subset][0][k] = temp_epo_code[0][k];
+                        epo_code[subset][1][k] = temp_epo_code[1][k];
                     }
                 }
-            }
-
-            bestError = error;
-        }
 
-        // Early out if we  found we can compress with error below the quality threshold
-        if (m_errorThreshold > 0)
-        {
-            if(bestError <= m_errorThreshold)
-            {
-                break;
+                error += tempError[1];
             }
         }
     }
 
-    // Now we have all the data needed to encode the block
-    // We need to pack the endpoints prior to encoding
+    return error;
+}
+
+// Packs the endpoints of a single index mode and writes the block
+void BC7BlockEncoder::EncodeSingleIndexResult(CMP_DWORD blockMode,
+    CMP_DWORD   blockPartition,
+    CMP_DWORD   dimension,
+    CMP_DWORD   entryCount[MAX_SUBSETS],
+    int         endpoints[MAX_SUBSETS][2][MAX_DIMENSION_BIG],
+    int         indices[MAX_SUBSETS][MAX_SUBSET_SIZE],
+    CMP_BYTE    out[COMPRESSED_BLOCK_SIZE])
+{
+    CMP_DWORD   subset, k;
+
     CMP_DWORD   packedEndpoints[3][2];
     for(subset=0; subset<bti[blockMode].subsetCount; subset++)
     {
-        if(bestEntryCount[subset])
+        if(entryCount[subset])
         {
             CMP_DWORD   rightAlignment = 0;
             packedEndpoints[subset][0] = 0;
@@ -783,12 +724,12 @@ double BC7BlockEncoder::CompressSingleIndexBlock(
             // Sort out parity bits
             if(m_parityBits != CART)
             {
-                packedEndpoints[subset][0] = bestEndpoints[subset][0][0] & 1;
-                packedEndpoints[subset][1] = bestEndpoints[subset][1][0] & 1;
+                packedEndpoints[subset][0] = endpoints[subset][0][0] & 1;
+                packedEndpoints[subset][1] = endpoints[subset][1][0] & 1;
                 for(k=0; k<MAX_DIMENSION_BIG; k++)
                 {
-                    bestEndpoints[subset][0][k] >>= 1;
-                    bestEndpoints[subset][1][k] >>= 1;
+                    endpoints[subset][0][k] >>= 1;
+                    endpoints[subset][1][k] >>= 1;
                 }
                 rightAlignment++;
             }
@@ -798,8 +739,8 @@ double BC7BlockEncoder::CompressSingleIndexBlock(
             {
                 if(m_componentBits[k])
                 {
-                    packedEndpoints[subset][0] |= bestEndpoints[subset][0][k] << rightAlignment;
-                    packedEndpoints[subset][1] |= bestEndpoints[subset][1][k] << rightAlignment;
+                    packedEndpoints[subset][0] |= endpoints[subset][0][k] << rightAlignment;
+                    packedEndpoints[subset][1] |= endpoints[subset][1][k] << rightAlignment;
                     rightAlignment += m_componentBits[k];
                 }
             }
@@ -808,76 +749,232 @@ double BC7BlockEncoder::CompressSingleIndexBlock(
 
     // Save the data to output
     EncodeSingleIndexBlock(blockMode,
-                bestPartition,
+                blockPartition,
                 packedEndpoints,
-                bestIndices,
+                indices,
                 out);
-    return bestError;
 }
 
-static CMP_DWORD   componentRotations[4][4] =
-{
-    {COMP_ALPHA, COMP_RED,   COMP_GREEN, COMP_BLUE},
-    {COMP_RED,   COMP_ALPHA, COMP_GREEN, COMP_BLUE},
-    {COMP_GREEN, COMP_RED,   COMP_ALPHA, COMP_BLUE},
-    {COMP_BLUE,  COMP_RED,   COMP_GREEN, COMP_ALPHA}
-};
-
-void BC7BlockEncoder::EncodeDualIndexBlock(CMP_DWORD blockMode,
-    CMP_DWORD indexSelection,
-    CMP_DWORD componentRotation,
-    int endpoint[2][2][MAX_DIMENSION_BIG],
-    int indices[2][MAX_SUBSET_SIZE],
-    CMP_BYTE   out[COMPRESSED_BLOCK_SIZE])
+template <typename T>
+T BC7BlockEncoder::CompressSingleIndexBlock(
+    T      in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+    CMP_BYTE    out[COMPRESSED_BLOCK_SIZE],
+    CMP_DWORD   blockMode)
 {
-
 #ifdef USE_DBGTRACE
-    DbgTrace(("-> WriteBit()"));
+    DbgTrace(("<---------CompressSingleIndexBlock----------->"));
 #endif
-    CMP_DWORD i,j,k;
-    int   bitPosition = 0;    // Position the pointer at the LSB
-    CMP_BYTE  *basePtr = out;
-    CMP_DWORD idxBits[2];
-    CMP_BOOL swapIndices;
+    CMP_DWORD   i, k, n;
+    CMP_DWORD   dimension;
 
-    // Generate Unary header for this mode
-    for(i=0;i<blockMode;i++)
+    // Figure out the effective dimension of this block mode
+    if(bti[blockMode].encodingType == NO_ALPHA)
     {
-        WriteBit(basePtr, bitPosition++, 0);
+        dimension = 3;
     }
-    WriteBit(basePtr, bitPosition++, 1);
-
-    // Write rotation bits
-    for(i=0; i<bti[blockMode].rotationBits; i++)
+    else
     {
-        WriteBit(basePtr, bitPosition++, (CMP_BYTE)((componentRotation>>i) & 0xff));
+        dimension = 4;
     }
 
-    // Write index selector bits
-    for(i=0;i<bti[blockMode].indexModeBits; i++)
-    {
-        WriteBit(basePtr, bitPosition++, (CMP_BYTE)(indexSelection ? 1: 0));
-    }
+    CMP_DWORD partitionsToTry = PartitionsToTry(blockMode);
 
-    if(indexSelection)
-    {
-        swapIndices = TRUE;
-        idxBits[0] = bti[blockMode].indexBits[1];
-        idxBits[1] = bti[blockMode].indexBits[0];
-    }
-    else
-    {
-        swapIndices = FALSE;
-        idxBits[0] = bti[blockMode].indexBits[0];
-        idxBits[1] = bti[blockMode].indexBits[1];
-    }
+    CMP_DWORD   blockPartition;
+    CMP_DWORD   entryCount[MAX_SUBSETS];
+    CMP_DWORD   subset;
 
-    bool   flipColours[2] = {false, false};
 
-    // Indicate if we need to fixup the indices
-    if(indices[0][0] & (1<<(idxBits[0]-1)))
-    {
-        flipColours[0] = true;
+#ifdef    BC7_DEBUG_TO_RESULTS_TXT
+    fprintf(fp,"\CompressSingleIndexBlock\n");
+    fprintf(fp,"blockMode = %d\n",blockMode);
+    fprintf(fp,"numPartitionModes = %d\n",(1 << bti[blockMode].partitionBits));
+    fprintf(fp,"partitionsToTry = %d\n",partitionsToTry);
+    fprintf(fp,"m_blockMaxRange =  %4.0f\n",m_blockMaxRange);
+    fprintf(fp,"m_quantizerRangeThreshold = %4.0f\n",m_quantizerRangeThreshold);
+    fprintf(fp,"m_clusters[0] = %d\n",m_clusters[0]);
+#endif
+
+#ifdef USE_DBGTRACE
+    DbgTrace(("blockMode [%d] numPartitionModes [%d] partitionsToTry [%2d]",
+        blockMode,
+        (1 << bti[blockMode].partitionBits),
+        partitionsToTry));
+    DbgTrace((" m_blockMaxRange [%2d] m_quantizerRangeThreshold [%4.0f] m_clusters[0] = %d",
+        m_blockMaxRange,
+        m_quantizerRangeThreshold,
+        m_clusters[0]));
+#endif
+
+    // Loop over the available partitions for the block mode and quantize them 
+    // to figure out the best candidates for further refinement
+    for(blockPartition = 0;
+        blockPartition < partitionsToTry;
+        blockPartition++)
+    {
+        m_storedError[blockPartition] = QuantizePartition(in,
+                                                          blockMode,
+                                                          blockPartition,
+                                                          dimension,
+                                                          m_storedIndices[blockPartition]);
+    }
+
+    // Sort the results
+    sortProjection(m_storedError,
+                   m_sortedModes,
+                   partitionsToTry);
+
+
+    // Run shaking (endpoint refinement) pass for partitions that gave the
+    // best set of errors from quantization
+    int     bits[4];
+    CMP_DWORD   shakeSize = ShakeSetup(blockMode, dimension, bits);
+
+    int     epo_code[MAX_SUBSETS][2][MAX_DIMENSION_BIG];
+
+    int     bestEndpoints[MAX_SUBSETS][2][MAX_DIMENSION_BIG];
+    int     bestIndices[MAX_SUBSETS][MAX_SUBSET_SIZE];
+    CMP_DWORD   bestEntryCount[MAX_SUBSETS];
+    CMP_DWORD   bestPartition = 0;
+    T  bestError = std::numeric_limits<T>::max();
+
+    // Shake attempts indicates how many partitions to try to shake
+    CMP_DWORD   numShakeAttempts = max(1, min((CMP_DWORD)floor(8 * m_quality + 0.5), partitionsToTry));
+
+#ifdef USE_DBGTRACE
+    DbgTrace(("%2d numPartitionModes %2d SearchSize %3.3f shakeSize %2d numShakeAttempts %2d\n",
+     partitionsToTry,
+     (1 << bti[blockMode].partitionBits),
+     m_partitionSearchSize,
+     shakeSize,
+     numShakeAttempts));
+#endif
+
+    // Now do the endpoint shaking
+    for(i=0; i < numShakeAttempts; i++)
+    {
+        blockPartition = m_sortedModes[i];
+
+        T error = ShakePartition(in,
+                                 blockMode,
+                                 blockPartition,
+                                 dimension,
+                                 shakeSize,
+                                 bits,
+                                 m_storedIndices[blockPartition],
+                                 epo_code,
+                                 entryCount);
+
+        if(error < bestError)
+        {
+            bestPartition = blockPartition;
+
+            for(subset=0; subset < bti[blockMode].subsetCount; subset++)
+            {
+                bestEntryCount[subset] = entryCount[subset];
+
+                if(entryCount[subset])
+                {
+                    for(k=0; k < dimension; k++)
+                    {
+                        bestEndpoints[subset][0][k] = epo_code[subset][0][k];
+                        bestEndpoints[subset][1][k] = epo_code[subset][1][k];
+                    }
+
+                    for(n=0; n < entryCount[subset]; n++)
+                    {
+                        bestIndices[subset][n] = m_storedIndices[blockPartition][subset][n];
+                    }
+                }
+            }
+
+            bestError = error;
+        }
+
+        // Early out if we  found we can compress with error below the quality threshold
+        if (m_errorThreshold > 0)
+        {
+            if(bestError <= m_errorThreshold)
+            {
+                break;
+            }
+        }
+    }
+
+    // Now we have all the data needed to encode the block
+    EncodeSingleIndexResult(blockMode,
+                            bestPartition,
+                            dimension,
+                            bestEntryCount,
+                            bestEndpoints,
+                            bestIndices,
+                            out);
+    return bestError;
+}
+
+
+static CMP_DWORD   componentRotations[4][4] =
+{
+    {COMP_ALPHA, COMP_RED,   COMP_GREEN, COMP_BLUE},
+    {COMP_RED,   COMP_ALPHA, COMP_GREEN, COMP_BLUE},
+    {COMP_GREEN, COMP_RED,   COMP_ALPHA, COMP_BLUE},
+    {COMP_BLUE,  COMP_RED,   COMP_GREEN, COMP_ALPHA}
+};
+
+void BC7BlockEncoder::EncodeDualIndexBlock(CMP_DWORD blockMode,
+    CMP_DWORD indexSelection,
+    CMP_DWORD componentRotation,
+    int endpoint[2][2][MAX_DIMENSION_BIG],
+    int indices[2][MAX_SUBSET_SIZE],
+    CMP_BYTE   out[COMPRESSED_BLOCK_SIZE])
+{
+
+#ifdef USE_DBGTRACE
+    DbgTrace(("-> WriteBit()"));
+#endif
+    CMP_DWORD i,j,k;
+    int   bitPosition = 0;    // Position the pointer at the LSB
+    CMP_BYTE  *basePtr = out;
+    CMP_DWORD idxBits[2];
+    CMP_BOOL swapIndices;
+
+    // Generate Unary header for this mode
+    for(i=0;i<blockMode;i++)
+    {
+        WriteBit(basePtr, bitPosition++, 0);
+    }
+    WriteBit(basePtr, bitPosition++, 1);
+
+    // Write rotation bits
+    for(i=0; i<bti[blockMode].rotationBits; i++)
+    {
+        WriteBit(basePtr, bitPosition++, (CMP_BYTE)((componentRotation>>i) & 0xff));
+    }
+
+    // Write index selector bits
+    for(i=0;i<bti[blockMode].indexModeBits; i++)
+    {
+        WriteBit(basePtr, bitPosition++, (CMP_BYTE)(indexSelection ? 1: 0));
+    }
+
+    if(indexSelection)
+    {
+        swapIndices = TRUE;
+        idxBits[0] = bti[blockMode].indexBits[1];
+        idxBits[1] = bti[blockMode].indexBits[0];
+    }
+    else
+    {
+        swapIndices = FALSE;
+        idxBits[0] = bti[blockMode].indexBits[0];
+        idxBits[1] = bti[blockMode].indexBits[1];
+    }
+
+    bool   flipColours[2] = {false, false};
+
+    // Indicate if we need to fixup the indices
+    if(indices[0][0] & (1<<(idxBits[0]-1)))
+    {
+        flipColours[0] = true;
     }
     if(indices[1][0] & (1<<(idxBits[1]-1)))
     {
@@ -979,373 +1076,756 @@ void BC7BlockEncoder::EncodeDualIndexBlock(CMP_DWORD blockMode,
         return;
     }
 
-#ifdef USE_DBGTRACE
-    DbgTrace(("OUTPUT [%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x]",
-        out[ 0],out[ 1],out[ 2],out[ 3],
-        out[ 4],out[ 5],out[ 6],out[ 7],
-        out[ 8],out[ 9],out[10],out[11],
-        out[12],out[13],out[14],out[15]));
-#endif
+#ifdef USE_DBGTRACE
+    DbgTrace(("OUTPUT [%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x,%2x]",
+        out[ 0],out[ 1],out[ 2],out[ 3],
+        out[ 4],out[ 5],out[ 6],out[ 7],
+        out[ 8],out[ 9],out[10],out[11],
+        out[12],out[13],out[14],out[15]));
+#endif
+
+}
+
+
+// Splits the block into the vector and the scalar block of a dual index mode rotation
+template <typename T>
+static void RotateDualIndexBlock(T in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+    CMP_DWORD   rotation,
+    T           cBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+    T           aBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG])
+{
+    CMP_DWORD   i;
+
+    for(i=0; i<MAX_SUBSET_SIZE; i++)
+    { 
+        cBlock[i][COMP_RED]   = in[i][componentRotations[rotation][1]];
+        cBlock[i][COMP_GREEN] = in[i][componentRotations[rotation][2]];
+        cBlock[i][COMP_BLUE]  = in[i][componentRotations[rotation][3]];
+
+        aBlock[i][COMP_RED]   = in[i][componentRotations[rotation][0]];
+        aBlock[i][COMP_GREEN] = in[i][componentRotations[rotation][0]];
+        aBlock[i][COMP_BLUE]  = in[i][componentRotations[rotation][0]];
+    }
+
+#ifdef    BC7_DEBUG_TO_RESULTS_TXT
+    fprintf(fp,"\ncBlock[16][3]\n");
+    for(i=0; i<MAX_SUBSET_SIZE; i++)
+    { 
+        fprintf(fp,"%4.0f, %4.0f, %4.0f\n",cBlock[i][COMP_RED],cBlock[i][COMP_GREEN],cBlock[i][COMP_BLUE]);
+    }
+    
+
+    fprintf(fp,"\naBlock[16][3]\n");
+    for(i=0; i<MAX_SUBSET_SIZE; i++)
+    { 
+        fprintf(fp,"%4.0f, %4.0f, %4.0f\n",aBlock[i][COMP_RED],aBlock[i][COMP_GREEN],aBlock[i][COMP_BLUE]);
+    }
+#endif
+}
+
+//
+// Quantizes the vector and scalar blocks of a dual index mode for one index selection and
+// returns the quantizer error, the cheap estimate before endpoint shaking
+//
+template <typename T>
+T BC7BlockEncoder::QuantizeDualIndex(T cBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+    T           aBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+    CMP_DWORD   blockMode,
+    CMP_DWORD   indexSelection,
+    int         indices[2][MAX_SUBSET_SIZE])
+{
+    T  outQ[2][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
+    T  direction[MAX_DIMENSION_BIG];
+    T  step;
+    T  quantizerError;
+
+    quantizerError = 0.;
+    
+#ifdef    BC7_DEBUG_TO_RESULTS_TXT
+    fprintf(fp,"\n-------------- Quantize the vector block ----------------\n");
+#endif
+    // Quantize the vector block
+    if(m_blockMaxRange <= m_quantizerRangeThreshold)
+    {
+
+#ifdef    BC7_DEBUG_TO_RESULTS_TXT
+        fprintf(fp,"\noptQuantAnD_d\n");
+        fprintf(fp,"IndexSelection = %d\n",indexSelection);
+        fprintf(fp,"NumClusters = %d\n",1 << bti[blockMode].indexBits[0 ^ indexSelection]);
+#endif
+        quantizerError = optQuantAnD_d(cBlock,
+                            MAX_SUBSET_SIZE,
+                            (1 << bti[blockMode].indexBits[0 ^ indexSelection]),
+                            indices[0],
+                            outQ[0],
+                            direction,
+                            &step,
+                            3);
+        
+#ifdef    BC7_DEBUG_TO_RESULTS_TXT
+        fprintf(fp,"\n");
+        for (int row=0; row<16; row++)
+        {
+            fprintf(fp,"indices[0][%2d] = %4.2f\n",row,indices[0][row]);
+        }
+        
+        fprintf(fp,"\n");
+        for (int row=0; row<16; row++)
+        {
+            fprintf(fp,"outQ[0][%2d] = %4.2f, %4.2f, %4.2f\n",row,outQ[0][row][0],outQ[0][row][1],outQ[0][row][2]);
+        }
+        
+        fprintf(fp,"\n");
+        fprintf(fp,"Direction = %4.2f, %4.2f, %4.2f\n",direction[0],direction[1],direction[2]);
+        fprintf(fp,"step = %4.2f\n",step);
+        fprintf(fp,"quantizerError = %4.2f\n",quantizerError);
+#endif
+    
+    }
+    else
+    {
+
+#ifdef    BC7_DEBUG_TO_RESULTS_TXT
+        fprintf(fp,"\noptQuantTrace_d\n");
+        fprintf(fp,"IndexSelection = %d\n",indexSelection);
+        fprintf(fp,"NumClusters = %d\n",1 << bti[blockMode].indexBits[0 ^ indexSelection]);
+#endif
+        quantizerError = optQuantTrace_d(cBlock,
+                            MAX_SUBSET_SIZE,
+                            (1 << bti[blockMode].indexBits[0 ^ indexSelection]),
+                            indices[0],
+                            outQ[0],
+                            direction,
+                            &step,
+                            3);
+
+#ifdef    BC7_DEBUG_TO_RESULTS_TXT
+        fprintf(fp,"\n");
+        for (int row=0; row<16; row++)
+        {
+            fprintf(fp,"indices[0][%2d] = %4.2f\n",row,indices[0][row]);
+        }
+        
+        fprintf(fp,"\n");
+        for (int row=0; row<16; row++)
+        {
+            fprintf(fp,"outQ[0][%2d] = %4.2f, %4.2f, %4.2f\n",row,outQ[0][row][0],outQ[0][row][1],outQ[0][row][2]);
+        }
+        
+        fprintf(fp,"\n");
+        fprintf(fp,"Direction = %4.2f, %4.2f, %4.2f\n",direction[0],direction[1],direction[2]);
+        fprintf(fp,"step = %4.2f\n",step);
+        fprintf(fp,"quantizerError = %4.2f\n",quantizerError);
+#endif
+
+    }
+
+    // Quantize the scalar block
+#ifdef    BC7_DEBUG_TO_RESULTS_TXT
+    fprintf(fp,"\nQuantize the scalar block\n");
+#endif
+    if(m_blockMaxRange <= m_quantizerRangeThreshold)
+    {
+
+#ifdef    BC7_DEBUG_TO_RESULTS_TXT
+        fprintf(fp,"\noptQuantAnD_d\n");
+        fprintf(fp,"IndexSelection = %d\n",indexSelection);
+        fprintf(fp,"NumClusters = %d\n",1 << bti[blockMode].indexBits[1 ^ indexSelection]);
+#endif
+        quantizerError += optQuantAnD_d(aBlock,
+                         MAX_SUBSET_SIZE,
+                         (1 << bti[blockMode].indexBits[1 ^ indexSelection]),
+                         indices[1],
+                         outQ[1],
+                         direction,
+                         &step,
+                         3) / 3.;
+
+#ifdef    BC7_DEBUG_TO_RESULTS_TXT
+        fprintf(fp,"\n");
+        for (int row=0; row<16; row++)
+        {
+            fprintf(fp,"indices[1][%2d] = %4.2f\n",row,indices[1][row]);
+        }
+        
+        fprintf(fp,"\n");
+        for (int row=0; row<16; row++)
+        {
+            fprintf(fp,"outQ[1][%2d] = %4.2f, %4.2f, %4.2f\n",row,outQ[1][row][0],outQ[1][row][1],outQ[1][row][2]);
+        }
+        
+        fprintf(fp,"\n");
+        fprintf(fp,"Direction = %4.2f, %4.2f, %4.2f\n",direction[0],direction[1],direction[2]);
+        fprintf(fp,"step = %4.2f\n",step);
+        fprintf(fp,"quantizerError = %4.2f\n",quantizerError);
+#endif
+    }
+    else
+    {
+#ifdef    BC7_DEBUG_TO_RESULTS_TXT
+        fprintf(fp,"\noptQuantTrace_d\n");
+        fprintf(fp,"IndexSelection = %d\n",indexSelection);
+        fprintf(fp,"NumClusters = %d\n",1 << bti[blockMode].indexBits[1 ^ indexSelection]);
+#endif
+        quantizerError += optQuantTrace_d(aBlock,
+                         MAX_SUBSET_SIZE,
+                         (1 << bti[blockMode].indexBits[1 ^ indexSelection]),
+                         indices[1],
+                         outQ[1],
+                         direction,
+                         &step,
+                         3) / 3.;
+
+#ifdef    BC7_DEBUG_TO_RESULTS_TXT
+        fprintf(fp,"\n");
+        for (int row=0; row<16; row++)
+        {
+            fprintf(fp,"indices[1][%2d] = %4.2f\n",row,indices[1][row]);
+        }
+        
+        fprintf(fp,"\n");
+        for (int row=0; row<16; row++)
+        {
+            fprintf(fp,"outQ[1][%2d] = %4.2f, %4.2f, %4.2f\n",row,outQ[1][row][0],outQ[1][row][1],outQ[1][row][2]);
+        }
+        
+        fprintf(fp,"\n");
+        fprintf(fp,"Direction = %4.2f, %4.2f, %4.2f\n",direction[0],direction[1],direction[2]);
+        fprintf(fp,"step = %4.2f\n",step);
+        fprintf(fp,"quantizerError = %4.2f\n",quantizerError);
+#endif
+
+    }
+
+    return quantizerError;
+}
+
+//
+// Runs the endpoint shakers on the vector and scalar blocks of a dual index mode, the
+// quantizer indices are refined in place and the endpoints go to epo_code
+//
+template <typename T>
+T BC7BlockEncoder::ShakeDualIndex(T cBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+    T           aBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+    CMP_DWORD   blockMode,
+    CMP_DWORD   indexSelection,
+    int         indices[2][MAX_SUBSET_SIZE],
+    int         epo_code[2][2][MAX_DIMENSION_BIG])
+{
+    T  outQ[2][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
+    T  overallError;
+
+    // Shake size gives the size of the shake cube
+    CMP_DWORD   shakeSize;
+
+    shakeSize = max(2, min( (CMP_DWORD)(6 * m_quality), 6));
+
+    int     bits[2][4];
+
+    // Specify number of bits for vector block
+    bits[0][COMP_RED] = m_componentBits[COMP_RED];
+    bits[0][COMP_GREEN] = m_componentBits[COMP_GREEN];
+    bits[0][COMP_BLUE] = m_componentBits[COMP_BLUE];
+    bits[0][3] = 2 * (m_componentBits[COMP_RED] + m_componentBits[COMP_GREEN] + m_componentBits[COMP_BLUE]);
+
+    // Specify number of bits for scalar block
+    bits[1][0] = m_componentBits[COMP_ALPHA];
+    bits[1][1] = m_componentBits[COMP_ALPHA];
+    bits[1][2] = m_componentBits[COMP_ALPHA];
+    bits[1][3] = 6 * m_componentBits[COMP_ALPHA];
+
+    overallError = 0;
+    T  epo[2][MAX_DIMENSION_BIG];
+
+    if(m_blockMaxRange > m_shakerRangeThreshold)
+    {
+        overallError += ep_shaker_2_d(cBlock,
+                                      MAX_SUBSET_SIZE,
+                                      indices[0],
+                                      outQ[0],
+                                      epo_code[0],
+                                      shakeSize,
+                                      (1 << bti[blockMode].indexBits[0 ^ indexSelection])-1,
+                                      bits[0][3],
+                                      3,
+                                      epo);
+    }
+    else
+    {
+        ep_shaker_d(cBlock,
+                    MAX_SUBSET_SIZE,
+                    indices[0],
+                    outQ[0],
+                    epo_code[0],
+                    (1 << bti[blockMode].indexBits[0 ^ indexSelection])-1,
+                    bits[0],
+                    (CMP_qt)0,
+                    3);
+
+         overallError += ep_shaker_2_d(cBlock,
+                                MAX_SUBSET_SIZE,
+                                indices[0],
+                                outQ[0],
+                                epo_code[0],
+                                shakeSize,
+                                (1 << bti[blockMode].indexBits[0 ^ indexSelection])-1,
+                                bits[0][3],
+                                3,
+                                epo);
+    }
+
+    if(m_blockMaxRange > m_shakerRangeThreshold)
+    {
+        overallError += ep_shaker_2_d(aBlock,
+                                      MAX_SUBSET_SIZE,
+                                      indices[1],
+                                      outQ[1],
+                                      epo_code[1],
+                                      shakeSize,
+                                      (1 << bti[blockMode].indexBits[1 ^ indexSelection])-1,
+                                      bits[1][3],
+                                      3,
+                                      epo) / 3.;
+    }
+    else
+    {
+        ep_shaker_d(aBlock,
+                    MAX_SUBSET_SIZE,
+                    indices[1],
+                    outQ[1],
+                    epo_code[1],
+                    (1 << bti[blockMode].indexBits[1 ^ indexSelection])-1,
+                    bits[1],
+                    (CMP_qt)0,
+                    3);
+
+        overallError += ep_shaker_2_d(aBlock,
+                            MAX_SUBSET_SIZE,
+                            indices[1],
+                            outQ[1],
+                            epo_code[1],
+                            shakeSize,
+                            (1 << bti[blockMode].indexBits[1 ^ indexSelection])-1,
+                            bits[1][3],
+                            3,
+                            epo) / 3.;
+    }
+
+    return overallError;
+}
+
+
+template <typename T>
+T BC7BlockEncoder::CompressDualIndexBlock(T in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+    CMP_BYTE   out[COMPRESSED_BLOCK_SIZE],
+    CMP_DWORD  blockMode)
+{
+#ifdef USE_DBGTRACE
+    DbgTrace(("<---------CompressDualIndexBlock----------->"));
+#endif
+    T  cBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
+    T  aBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
+
+    CMP_DWORD maxRotation = 1 << bti[blockMode].rotationBits;
+    CMP_DWORD rotation;
+
+    CMP_DWORD maxIndexSelection = 1 << bti[blockMode].indexModeBits;
+    CMP_DWORD indexSelection;
+
+    int        indices[2][MAX_SUBSET_SIZE];
+
+    T quantizerError;
+    T bestQuantizerError = std::numeric_limits<T>::max();
+    T overallError;
+    T bestOverallError   = std::numeric_limits<T>::max();
+
+#ifdef    BC7_DEBUG_TO_RESULTS_TXT
+    fprintf(fp,"\nCompressDualIndexBlock\n");
+    fprintf(fp,"blockMode = %d\n",blockMode);
+    fprintf(fp,"maxIndexSelection = %d\n",maxIndexSelection);
+    fprintf(fp,"maxRotation = %d\n",maxRotation);
+    fprintf(fp,"m_blockMaxRange =  %4.0f\n",m_blockMaxRange);
+    fprintf(fp,"m_quantizerRangeThreshold = %4.0f\n",m_quantizerRangeThreshold);
+#endif
+    
+    // Go through each possible rotation and selection of indices
+    for(rotation = 0; rotation < maxRotation; rotation++)  
+    { // A
+        RotateDualIndexBlock(in, rotation, cBlock, aBlock);
+
+        for(indexSelection = 0; indexSelection < maxIndexSelection; indexSelection++)
+        { // B
+            quantizerError = QuantizeDualIndex(cBlock, aBlock, blockMode, indexSelection, indices);
+
+            // If quality is high then run the full shaking for this config and
+            // store the result if it beats the best overall error
+            // Otherwise only run the shaking if the error is better than the best
+            // quantizer error
+            if((m_quality > g_HIGHQULITY_THRESHOLD) || (quantizerError <= bestQuantizerError))
+            {
+                int     epo_code[2][2][MAX_DIMENSION_BIG];
+                overallError = ShakeDualIndex(cBlock, aBlock, blockMode, indexSelection, indices, epo_code);
+
+                // If we beat the previous best then encode the block
+                if(overallError < bestOverallError)
+                {
+                    EncodeDualIndexBlock(blockMode,
+                                         indexSelection,
+                                         rotation,
+                                         epo_code,
+                                         indices,
+                                         out);
+
+                    bestOverallError = overallError;
+                }
+
+                if(quantizerError < bestQuantizerError)
+                {
+                    bestQuantizerError = quantizerError;
+                }
+
+            }
+        } // B
+    } // A
+    return bestOverallError;
+}
+
+
+//
+// Endpoints for blocks of one colour. Every pixel uses interpolation weight 21 (index 1 of
+// mode 5, index 5 of mode 6) and each table entry holds the 7 bit endpoint pair whose
+// interpolated value is closest to the 8 bit value. Mode 5 reaches every value exactly,
+// mode 6 has a table per pair of endpoint parity bits and misses either 0 or 255 in each.
+//
+
+#define SOLID_WEIGHT        21
+#define SOLID_MODE5_INDEX   1
+#define SOLID_MODE6_INDEX   5
+
+// Modes 4, 5 and 6, and how far (squared) from their principal axis the pixels of a block
+// may be for it to count as a gradient
+#define BC7_SINGLE_SUBSET_MODES ((1 << 4) | (1 << 5) | (1 << 6))
+#define BC7_LINE_TOLERANCE      1.0f
+
+struct BC7SolidEndpoints
+{
+    CMP_BYTE    lo;
+    CMP_BYTE    hi;
+    CMP_BYTE    error;
+};
+
+struct BC7SolidTables
+{
+    BC7SolidEndpoints   mode5[256];
+    BC7SolidEndpoints   mode6[4][256];      // [p0 | (p1 << 1)][value]
+
+    BC7SolidTables()
+    {
+        int     v, a, b, p;
+        for(v = 0; v < 256; v++)
+        {
+            mode5[v].error = 255;
+            for(p = 0; p < 4; p++)
+                mode6[p][v].error = 255;
+        }
+
+        for(a = 0; a < 128; a++)
+        {
+            for(b = 0; b < 128; b++)
+            {
+                // Mode 5 colour endpoints are 7 bits, widened by repeating the MSB
+                int A = (a << 1) | (a >> 6);
+                int B = (b << 1) | (b >> 6);
+                Insert(mode5, a, b, (A * (64 - SOLID_WEIGHT) + B * SOLID_WEIGHT + 32) >> 6);
+
+                // Mode 6 endpoints are 7 bits and a parity bit
+                for(p = 0; p < 4; p++)
+                {
+                    A = (a << 1) | (p & 1);
+                    B = (b << 1) | (p >> 1);
+                    Insert(mode6[p], a, b, (A * (64 - SOLID_WEIGHT) + B * SOLID_WEIGHT + 32) >> 6);
+                }
+            }
+        }
+
+        // Fill the values a table cannot reach with the nearest one it can
+        for(p = 0; p < 5; p++)
+        {
+            BC7SolidEndpoints* table = (p < 4) ? mode6[p] : mode5;
+            for(v = 0; v < 256; v++)
+            {
+                if(table[v].error == 0)
+                    continue;
+                for(int d = 1; d < 256; d++)
+                {
+                    if((v - d >= 0) && (table[v - d].error == 0))
+                    {
+                        table[v] = table[v - d];
+                        table[v].error = (CMP_BYTE)d;
+                        break;
+                    }
+                    if((v + d < 256) && (table[v + d].error == 0))
+                    {
+                        table[v] = table[v + d];
+                        table[v].error = (CMP_BYTE)d;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    static void Insert(BC7SolidEndpoints table[256], int a, int b, int v)
+    {
+        if(table[v].error != 0)
+        {
+            table[v].lo    = (CMP_BYTE)a;
+            table[v].hi    = (CMP_BYTE)b;
+            table[v].error = 0;
+        }
+    }
+};
 
+static const BC7SolidTables& GetSolidTables()
+{
+    static const BC7SolidTables tables;
+    return tables;
 }
 
+static double SolidError(double in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG], const int decoded[MAX_DIMENSION_BIG])
+{
+    double error = 0.0;
+    for(CMP_DWORD i = 0; i < MAX_SUBSET_SIZE; i++)
+    {
+        for(CMP_DWORD k = 0; k < MAX_DIMENSION_BIG; k++)
+        {
+            double d = in[i][k] - decoded[k];
+            error += d * d;
+        }
+    }
+    return error;
+}
 
-double BC7BlockEncoder::CompressDualIndexBlock(double in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+double BC7BlockEncoder::CompressSolidBlock(double in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
     CMP_BYTE   out[COMPRESSED_BLOCK_SIZE],
     CMP_DWORD  blockMode)
 {
-#ifdef USE_DBGTRACE
-    DbgTrace(("<---------CompressDualIndexBlock----------->"));
-#endif
-    CMP_DWORD   i;
-    double  cBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
-    double  aBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
-
-    CMP_DWORD maxRotation = 1 << bti[blockMode].rotationBits;
-    CMP_DWORD rotation;
+    const BC7SolidTables& tables = GetSolidTables();
+    CMP_DWORD   i, k;
+    int         value[MAX_DIMENSION_BIG];
+    int         decoded[MAX_DIMENSION_BIG];
 
-    CMP_DWORD maxIndexSelection = 1 << bti[blockMode].indexModeBits;
-    CMP_DWORD indexSelection;
+    for(k = 0; k < MAX_DIMENSION_BIG; k++)
+    {
+        double v = floor(in[0][k] + 0.5);
+        value[k] = (int)((v < 0.0) ? 0.0 : ((v > 255.0) ? 255.0 : v));
+    }
 
-    int        indices[2][MAX_SUBSET_SIZE];
-    double  outQ[2][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
-    double  direction[MAX_DIMENSION_BIG];
-    double  step;
+    if(blockMode == 5)
+    {
+        int     endpoint[2][2][MAX_DIMENSION_BIG];
+        int     indices[2][MAX_SUBSET_SIZE];
 
-    double quantizerError;
-    double bestQuantizerError = DBL_MAX;
-    double overallError;
-    double bestOverallError   = DBL_MAX;
+        for(k = 0; k < MAX_DIMENSION_BIG; k++)
+        {
+            if(k == COMP_ALPHA)
+                continue;
+            const BC7SolidEndpoints& ep = tables.mode5[value[k]];
+            endpoint[0][0][k] = ep.lo;
+            endpoint[0][1][k] = ep.hi;
+            decoded[k] = value[k];
+        }
+        endpoint[1][0][0] = value[COMP_ALPHA];
+        endpoint[1][1][0] = value[COMP_ALPHA];
+        decoded[COMP_ALPHA] = value[COMP_ALPHA];
 
-#ifdef    BC7_DEBUG_TO_RESULTS_TXT
-    fprintf(fp,"\nCompressDualIndexBlock\n");
-    fprintf(fp,"blockMode = %d\n",blockMode);
-    fprintf(fp,"maxIndexSelection = %d\n",maxIndexSelection);
-    fprintf(fp,"maxRotation = %d\n",maxRotation);
-    fprintf(fp,"m_blockMaxRange =  %4.0f\n",m_blockMaxRange);
-    fprintf(fp,"m_quantizerRangeThreshold = %4.0f\n",m_quantizerRangeThreshold);
-#endif
-    
-    // Go through each possible rotation and selection of indices
-    for(rotation = 0; rotation < maxRotation; rotation++)  
-    { // A
+        for(i = 0; i < MAX_SUBSET_SIZE; i++)
+        {
+            indices[0][i] = SOLID_MODE5_INDEX;
+            indices[1][i] = 0;
+        }
 
+        EncodeDualIndexBlock(5, 0, 0, endpoint, indices, out);
+        return SolidError(in, decoded);
+    }
 
-        for(i=0; i<MAX_SUBSET_SIZE; i++)
-        { 
-            cBlock[i][COMP_RED]   = in[i][componentRotations[rotation][1]];
-            cBlock[i][COMP_GREEN] = in[i][componentRotations[rotation][2]];
-            cBlock[i][COMP_BLUE]  = in[i][componentRotations[rotation][3]];
-
-            aBlock[i][COMP_RED]   = in[i][componentRotations[rotation][0]];
-            aBlock[i][COMP_GREEN] = in[i][componentRotations[rotation][0]];
-            aBlock[i][COMP_BLUE]  = in[i][componentRotations[rotation][0]];
+    // Mode 6: use the parity bits that miss the block's colour by the least
+    int     bestParity = 0;
+    int     bestError  = INT_MAX;
+    for(int p = 0; p < 4; p++)
+    {
+        int error = 0;
+        for(k = 0; k < MAX_DIMENSION_BIG; k++)
+            error += tables.mode6[p][value[k]].error * tables.mode6[p][value[k]].error;
+        if(error < bestError)
+        {
+            bestError  = error;
+            bestParity = p;
         }
+    }
 
-#ifdef    BC7_DEBUG_TO_RESULTS_TXT
-        fprintf(fp,"\ncBlock[16][3]\n");
-        for(i=0; i<MAX_SUBSET_SIZE; i++)
-        { 
-            fprintf(fp,"%4.0f, %4.0f, %4.0f\n",cBlock[i][COMP_RED],cBlock[i][COMP_GREEN],cBlock[i][COMP_BLUE]);
-        }
-        
+    CMP_DWORD   packedEndpoints[MAX_SUBSETS][2];
+    int         indices[MAX_SUBSETS][MAX_SUBSET_SIZE];
 
-        fprintf(fp,"\naBlock[16][3]\n");
-        for(i=0; i<MAX_SUBSET_SIZE; i++)
-        { 
-            fprintf(fp,"%4.0f, %4.0f, %4.0f\n",aBlock[i][COMP_RED],aBlock[i][COMP_GREEN],aBlock[i][COMP_BLUE]);
-        }
-#endif
+    packedEndpoints[0][0] = bestParity & 1;
+    packedEndpoints[0][1] = bestParity >> 1;
+    for(k = 0; k < MAX_DIMENSION_BIG; k++)
+    {
+        const BC7SolidEndpoints& ep = tables.mode6[bestParity][value[k]];
+        packedEndpoints[0][0] |= ep.lo << (1 + 7 * k);
+        packedEndpoints[0][1] |= ep.hi << (1 + 7 * k);
 
-        for(indexSelection = 0; indexSelection < maxIndexSelection; indexSelection++)
-        { // B
-            quantizerError = 0.;
-            
-#ifdef    BC7_DEBUG_TO_RESULTS_TXT
-            fprintf(fp,"\n-------------- Quantize the vector block ----------------\n");
-#endif
-            // Quantize the vector block
-            if(m_blockMaxRange <= m_quantizerRangeThreshold)
-            {
+        int A = (ep.lo << 1) | (bestParity & 1);
+        int B = (ep.hi << 1) | (bestParity >> 1);
+        decoded[k] = (A * (64 - SOLID_WEIGHT) + B * SOLID_WEIGHT + 32) >> 6;
+    }
+    for(i = 0; i < MAX_SUBSET_SIZE; i++)
+        indices[0][i] = SOLID_MODE6_INDEX;
 
-#ifdef    BC7_DEBUG_TO_RESULTS_TXT
-                fprintf(fp,"\noptQuantAnD_d\n");
-                fprintf(fp,"IndexSelection = %d\n",indexSelection);
-                fprintf(fp,"NumClusters = %d\n",1 << bti[blockMode].indexBits[0 ^ indexSelection]);
-#endif
-                quantizerError = optQuantAnD_d(cBlock,
-                                    MAX_SUBSET_SIZE,
-                                    (1 << bti[blockMode].indexBits[0 ^ indexSelection]),
-                                    indices[0],
-                                    outQ[0],
-                                    direction,
-                                    &step,
-                                    3);
-                
-#ifdef    BC7_DEBUG_TO_RESULTS_TXT
-                fprintf(fp,"\n");
-                for (int row=0; row<16; row++)
-                {
-                    fprintf(fp,"indices[0][%2d] = %4.2f\n",row,indices[0][row]);
-                }
-                
-                fprintf(fp,"\n");
-                for (int row=0; row<16; row++)
-                {
-                    fprintf(fp,"outQ[0][%2d] = %4.2f, %4.2f, %4.2f\n",row,outQ[0][row][0],outQ[0][row][1],outQ[0][row][2]);
-                }
-                
-                fprintf(fp,"\n");
-                fprintf(fp,"Direction = %4.2f, %4.2f, %4.2f\n",direction[0],direction[1],direction[2]);
-                fprintf(fp,"step = %4.2f\n",step);
-                fprintf(fp,"quantizerError = %4.2f\n",quantizerError);
-#endif
-            
-            }
-            else
-            {
+    BlockSetup(6);
+    EncodeSingleIndexBlock(6, 0, packedEndpoints, indices, out);
+    return SolidError(in, decoded);
+}
 
-#ifdef    BC7_DEBUG_TO_RESULTS_TXT
-                fprintf(fp,"\noptQuantTrace_d\n");
-                fprintf(fp,"IndexSelection = %d\n",indexSelection);
-                fprintf(fp,"NumClusters = %d\n",1 << bti[blockMode].indexBits[0 ^ indexSelection]);
-#endif
-                quantizerError = optQuantTrace_d(cBlock,
-                                    MAX_SUBSET_SIZE,
-                                    (1 << bti[blockMode].indexBits[0 ^ indexSelection]),
-                                    indices[0],
-                                    outQ[0],
-                                    direction,
-                                    &step,
-                                    3);
 
-#ifdef    BC7_DEBUG_TO_RESULTS_TXT
-                fprintf(fp,"\n");
-                for (int row=0; row<16; row++)
-                {
-                    fprintf(fp,"indices[0][%2d] = %4.2f\n",row,indices[0][row]);
-                }
-                
-                fprintf(fp,"\n");
-                for (int row=0; row<16; row++)
-                {
-                    fprintf(fp,"outQ[0][%2d] = %4.2f, %4.2f, %4.2f\n",row,outQ[0][row][0],outQ[0][row][1],outQ[0][row][2]);
-                }
-                
-                fprintf(fp,"\n");
-                fprintf(fp,"Direction = %4.2f, %4.2f, %4.2f\n",direction[0],direction[1],direction[2]);
-                fprintf(fp,"step = %4.2f\n",step);
-                fprintf(fp,"quantizerError = %4.2f\n",quantizerError);
-#endif
+//
+// Coarse to fine mode search. Every partition of the valid single index modes and every
+// rotation and index selection of the dual index modes is quantized, which is cheap next
+// to the endpoint shakers, and only the m_modeCandidates candidates with the lowest
+// quantizer error are shaken, best first, until the block is within the error threshold.
+//
+template <typename T>
+double BC7BlockEncoder::SearchModes(T in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+    CMP_DWORD   validModeMask,
+    CMP_BYTE    out[COMPRESSED_BLOCK_SIZE])
+{
+    CMP_DWORD   blockModeOrder[NUM_BLOCK_TYPES] = {6, 4, 3, 1, 0, 2, 7, 5};
+    CMP_DWORD   numCandidates = 0;
+    CMP_DWORD   i, n;
+    T           cBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
+    T           aBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
 
-            }
+    // Coarse pass: the quantizer error of each candidate
+    for(i=0; i < NUM_BLOCK_TYPES; i++)
+    {
+        CMP_DWORD blockMode = blockModeOrder[i];
+        if(!(validModeMask & (1 << blockMode)))
+            continue;
 
-            // Quantize the scalar block
-#ifdef    BC7_DEBUG_TO_RESULTS_TXT
-            fprintf(fp,"\nQuantize the scalar block\n");
-#endif
-            if(m_blockMaxRange <= m_quantizerRangeThreshold)
-            {
+        BlockSetup(blockMode);
 
-#ifdef    BC7_DEBUG_TO_RESULTS_TXT
-                fprintf(fp,"\noptQuantAnD_d\n");
-                fprintf(fp,"IndexSelection = %d\n",indexSelection);
-                fprintf(fp,"NumClusters = %d\n",1 << bti[blockMode].indexBits[1 ^ indexSelection]);
-#endif
-                quantizerError += optQuantAnD_d(aBlock,
-                                 MAX_SUBSET_SIZE,
-                                 (1 << bti[blockMode].indexBits[1 ^ indexSelection]),
-                                 indices[1],
-                                 outQ[1],
-                                 direction,
-                                 &step,
-                                 3) / 3.;
+        if(bti[blockMode].encodingType != SEPARATE_ALPHA)
+        {
+            CMP_DWORD dimension       = (bti[blockMode].encodingType == NO_ALPHA) ? 3 : 4;
+            CMP_DWORD partitionsToTry = PartitionsToTry(blockMode);
 
-#ifdef    BC7_DEBUG_TO_RESULTS_TXT
-                fprintf(fp,"\n");
-                for (int row=0; row<16; row++)
-                {
-                    fprintf(fp,"indices[1][%2d] = %4.2f\n",row,indices[1][row]);
-                }
-                
-                fprintf(fp,"\n");
-                for (int row=0; row<16; row++)
-                {
-                    fprintf(fp,"outQ[1][%2d] = %4.2f, %4.2f, %4.2f\n",row,outQ[1][row][0],outQ[1][row][1],outQ[1][row][2]);
-                }
-                
-                fprintf(fp,"\n");
-                fprintf(fp,"Direction = %4.2f, %4.2f, %4.2f\n",direction[0],direction[1],direction[2]);
-                fprintf(fp,"step = %4.2f\n",step);
-                fprintf(fp,"quantizerError = %4.2f\n",quantizerError);
-#endif
-            }
-            else
+            for(CMP_DWORD blockPartition = 0; blockPartition < partitionsToTry; blockPartition++)
             {
-#ifdef    BC7_DEBUG_TO_RESULTS_TXT
-                fprintf(fp,"\noptQuantTrace_d\n");
-                fprintf(fp,"IndexSelection = %d\n",indexSelection);
-                fprintf(fp,"NumClusters = %d\n",1 << bti[blockMode].indexBits[1 ^ indexSelection]);
-#endif
-                quantizerError += optQuantTrace_d(aBlock,
-                                 MAX_SUBSET_SIZE,
-                                 (1 << bti[blockMode].indexBits[1 ^ indexSelection]),
-                                 indices[1],
-                                 outQ[1],
-                                 direction,
-                                 &step,
-                                 3) / 3.;
+                BC7ModeCandidate& candidate = m_candidates[numCandidates];
+                candidate.blockMode = blockMode;
+                candidate.partition = blockPartition;
+                m_candidateError[numCandidates++] = QuantizePartition(in, blockMode, blockPartition, dimension, candidate.indices);
+            }
+        }
+        else
+        {
+            CMP_DWORD maxRotation       = 1 << bti[blockMode].rotationBits;
+            CMP_DWORD maxIndexSelection = 1 << bti[blockMode].indexModeBits;
 
-#ifdef    BC7_DEBUG_TO_RESULTS_TXT
-                fprintf(fp,"\n");
-                for (int row=0; row<16; row++)
-                {
-                    fprintf(fp,"indices[1][%2d] = %4.2f\n",row,indices[1][row]);
-                }
-                
-                fprintf(fp,"\n");
-                for (int row=0; row<16; row++)
+            for(CMP_DWORD rotation = 0; rotation < maxRotation; rotation++)
+            {
+                RotateDualIndexBlock(in, rotation, cBlock, aBlock);
+                for(CMP_DWORD indexSelection = 0; indexSelection < maxIndexSelection; indexSelection++)
                 {
-                    fprintf(fp,"outQ[1][%2d] = %4.2f, %4.2f, %4.2f\n",row,outQ[1][row][0],outQ[1][row][1],outQ[1][row][2]);
+                    BC7ModeCandidate& candidate = m_candidates[numCandidates];
+                    candidate.blockMode = blockMode;
+                    candidate.partition = (rotation << 1) | indexSelection;
+                    m_candidateError[numCandidates++] = QuantizeDualIndex(cBlock, aBlock, blockMode, indexSelection, candidate.indices);
                 }
-                
-                fprintf(fp,"\n");
-                fprintf(fp,"Direction = %4.2f, %4.2f, %4.2f\n",direction[0],direction[1],direction[2]);
-                fprintf(fp,"step = %4.2f\n",step);
-                fprintf(fp,"quantizerError = %4.2f\n",quantizerError);
-#endif
-
             }
+        }
+    }
 
-            // If quality is high then run the full shaking for this config and
-            // store the result if it beats the best overall error
-            // Otherwise only run the shaking if the error is better than the best
-            // quantizer error
-            if((m_quality > g_HIGHQULITY_THRESHOLD) || (quantizerError <= bestQuantizerError))
-            {
-                // Shake size gives the size of the shake cube
-                CMP_DWORD   shakeSize;
-
-                shakeSize = max(2, min( (CMP_DWORD)(6 * m_quality), 6));
+    // Keep the best ones in order, candidates with the same error stay in mode order
+    CMP_DWORD   numRefine = min(m_modeCandidates, numCandidates);
+    CMP_DWORD   numRanked = 0;
+    int         order[MAX_MODE_CANDIDATES];
 
-                int     bits[2][4];
+    for(i=0; i < numCandidates; i++)
+    {
+        if((numRanked == numRefine) && !(m_candidateError[i] < m_candidateError[order[numRanked-1]]))
+            continue;
 
-                // Specify number of bits for vector block
-                bits[0][COMP_RED] = m_componentBits[COMP_RED];
-                bits[0][COMP_GREEN] = m_componentBits[COMP_GREEN];
-                bits[0][COMP_BLUE] = m_componentBits[COMP_BLUE];
-                bits[0][3] = 2 * (m_componentBits[COMP_RED] + m_componentBits[COMP_GREEN] + m_componentBits[COMP_BLUE]);
+        n = (numRanked < numRefine) ? numRanked++ : numRanked - 1;
+        while((n > 0) && (m_candidateError[i] < m_candidateError[order[n-1]]))
+        {
+            order[n] = order[n-1];
+            n--;
+        }
+        order[n] = i;
+    }
 
-                // Specify number of bits for scalar block
-                bits[1][0] = m_componentBits[COMP_ALPHA];
-                bits[1][1] = m_componentBits[COMP_ALPHA];
-                bits[1][2] = m_componentBits[COMP_ALPHA];
-                bits[1][3] = 6 * m_componentBits[COMP_ALPHA];
+    // Fine pass: shake the best candidates until one is good enough
+    double      errorThreshold = max(m_errorThreshold, g_MODESEARCH_MIN_THRESHOLD);
+    double      bestError = DBL_MAX;
+    CMP_DWORD   bestRank = 0;
+    CMP_DWORD   numRefined = 0;
 
-                overallError = 0;
-                int     epo_code[2][2][MAX_DIMENSION_BIG];
-                double  epo[2][MAX_DIMENSION_BIG];
+    for(i=0; i < numRefine; i++)
+    {
+        BC7ModeCandidate& candidate = m_candidates[order[i]];
+        CMP_DWORD blockMode = candidate.blockMode;
+        double    error;
 
-                if(m_blockMaxRange > m_shakerRangeThreshold)
-                {
-                    overallError += ep_shaker_2_d(cBlock,
-                                                  MAX_SUBSET_SIZE,
-                                                  indices[0],
-                                                  outQ[0],
-                                                  epo_code[0],
-                                                  shakeSize,
-                                                  (1 << bti[blockMode].indexBits[0 ^ indexSelection])-1,
-                                                  bits[0][3],
-                                                  3,
-                                                  epo);
-                }
-                else
-                {
-                    ep_shaker_d(cBlock,
-                                MAX_SUBSET_SIZE,
-                                indices[0],
-                                outQ[0],
-                                epo_code[0],
-                                (1 << bti[blockMode].indexBits[0 ^ indexSelection])-1,
-                                bits[0],
-                                (CMP_qt)0,
-                                3);
-
-                     overallError += ep_shaker_2_d(cBlock,
-                                            MAX_SUBSET_SIZE,
-                                            indices[0],
-                                            outQ[0],
-                                            epo_code[0],
-                                            shakeSize,
-                                            (1 << bti[blockMode].indexBits[0 ^ indexSelection])-1,
-                                            bits[0][3],
-                                            3,
-                                            epo);
-                }
+        BlockSetup(blockMode);
+        numRefined++;
 
-                if(m_blockMaxRange > m_shakerRangeThreshold)
-                {
-                    overallError += ep_shaker_2_d(aBlock,
-                                                  MAX_SUBSET_SIZE,
-                                                  indices[1],
-                                                  outQ[1],
-                                                  epo_code[1],
-                                                  shakeSize,
-                                                  (1 << bti[blockMode].indexBits[1 ^ indexSelection])-1,
-                                                  bits[1][3],
-                                                  3,
-                                                  epo) / 3.;
-                }
-                else
-                {
-                    ep_shaker_d(aBlock,
-                                MAX_SUBSET_SIZE,
-                                indices[1],
-                                outQ[1],
-                                epo_code[1],
-                                (1 << bti[blockMode].indexBits[1 ^ indexSelection])-1,
-                                bits[1],
-                                (CMP_qt)0,
-                                3);
-
-                    overallError += ep_shaker_2_d(aBlock,
-                                        MAX_SUBSET_SIZE,
-                                        indices[1],
-                                        outQ[1],
-                                        epo_code[1],
-                                        shakeSize,
-                                        (1 << bti[blockMode].indexBits[1 ^ indexSelection])-1,
-                                        bits[1][3],
-                                        3,
-                                        epo) / 3.;
-                }
+        if(bti[blockMode].encodingType != SEPARATE_ALPHA)
+        {
+            CMP_DWORD   dimension = (bti[blockMode].encodingType == NO_ALPHA) ? 3 : 4;
+            int         bits[4];
+            CMP_DWORD   shakeSize = ShakeSetup(blockMode, dimension, bits);
+            int         epo_code[MAX_SUBSETS][2][MAX_DIMENSION_BIG];
+            CMP_DWORD   entryCount[MAX_SUBSETS];
+
+            error = ShakePartition(in, blockMode, candidate.partition, dimension, shakeSize, bits, candidate.indices, epo_code, entryCount);
+            if(error < bestError)
+                EncodeSingleIndexResult(blockMode, candidate.partition, dimension, entryCount, epo_code, candidate.indices, out);
+        }
+        else
+        {
+            CMP_DWORD   rotation       = candidate.partition >> 1;
+            CMP_DWORD   indexSelection = candidate.partition & 1;
+            int         epo_code[2][2][MAX_DIMENSION_BIG];
+
+            RotateDualIndexBlock(in, rotation, cBlock, aBlock);
+            error = ShakeDualIndex(cBlock, aBlock, blockMode, indexSelection, candidate.indices, epo_code);
+            if(error < bestError)
+                EncodeDualIndexBlock(blockMode, indexSelection, rotation, epo_code, candidate.indices, out);
+        }
 
-                // If we beat the previous best then encode the block
-                if(overallError < bestOverallError)
-                {
-                    EncodeDualIndexBlock(blockMode,
-                                         indexSelection,
-                                         rotation,
-                                         epo_code,
-                                         indices,
-                                         out);
+        if(error < bestError)
+        {
+            bestError = error;
+            bestRank  = i;
+        }
 
-                    bestOverallError = overallError;
-                }
+        if(bestError <= errorThreshold)
+        {
+            if(numRefined < numRefine)
+                m_searchCounts[CMP_SEARCH_EARLY_OUTS]++;
+            break;
+        }
+    }
 
-                if(quantizerError < bestQuantizerError)
-                {
-                    bestQuantizerError = quantizerError;
-                }
+    m_searchCounts[CMP_SEARCH_BLOCKS]++;
+    m_searchCounts[CMP_SEARCH_CANDIDATES] += numCandidates;
+    m_searchCounts[CMP_SEARCH_REFINED]    += numRefined;
+    CMP_CountSearchRank(m_searchCounts, bestRank);
 
-            }
-        } // B
-    } // A
-    return bestOverallError;
+    return bestError;
 }
 
-
-
 //
 // This routine compresses a block and returns the RMS error
 //
@@ -1489,6 +1969,38 @@ double BC7BlockEncoder::CompressBlock(double in[MAX_SUBSET_SIZE][MAX_DIMENSION_B
 
     assert(validModeMask != 0);
 
+    // Blocks of one colour are written straight from the solid colour tables when the
+    // result is within the error threshold. Below high quality, blocks of two colours
+    // or with their colours along a line only try the single subset modes.
+    CMP_BlockClass blockClass = CMP_BLOCK_COMPLEX;
+    if(m_blockMaxRange == 0.0)
+    {
+        CMP_DWORD solidMode = (validModeMask & (1 << 5)) ? 5 : ((validModeMask & (1 << 6)) ? 6 : 0);
+        if(solidMode)
+        {
+            double solidError = CompressSolidBlock(in, out, solidMode);
+            if(solidError <= max(m_errorThreshold, 0.0))
+            {
+                m_blockClassCounts[CMP_BLOCK_SOLID]++;
+                m_smallestError = min(m_smallestError, solidError);
+                m_largestError  = max(m_largestError, solidError);
+                return solidError;
+            }
+        }
+    }
+    else if((m_quality < g_HIGHQULITY_THRESHOLD) && (validModeMask & BC7_SINGLE_SUBSET_MODES))
+    {
+        float fPixels[MAX_SUBSET_SIZE][4];
+        for(i=0; i<MAX_SUBSET_SIZE; i++)
+            for(j=0; j<4; j++)
+                fPixels[i][j] = (float)in[i][j];
+
+        blockClass = CMP_ClassifyBlock(fPixels, BC7_LINE_TOLERANCE);
+        if(blockClass != CMP_BLOCK_COMPLEX)
+            validModeMask &= BC7_SINGLE_SUBSET_MODES;
+    }
+    m_blockClassCounts[blockClass]++;
+
 #ifdef USE_DBGTRACE
     DbgTrace(("validModeMask [%x]",validModeMask));
 #endif
@@ -1496,6 +2008,15 @@ double BC7BlockEncoder::CompressBlock(double in[MAX_SUBSET_SIZE][MAX_DIMENSION_B
 
     CMP_BYTE    temporaryOutputBlock[COMPRESSED_BLOCK_SIZE];
     double bestError = DBL_MAX;
+
+    // The single precision encoder works on a float copy of the block
+    float       inF[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
+    if(m_singlePrecision)
+    {
+        for(i=0; i<MAX_SUBSET_SIZE; i++)
+            for(j=0; j<MAX_DIMENSION_BIG; j++)
+                inF[i][j] = (float)in[i][j];
+    }
     double thisError;
     CMP_DWORD bestblockMode=99;
 
@@ -1512,59 +2033,76 @@ double BC7BlockEncoder::CompressBlock(double in[MAX_SUBSET_SIZE][MAX_DIMENSION_B
     //                76543210
     // validModeMask = 0b00100000;
 
-    for(CMP_DWORD j1=0; j1 < NUM_BLOCK_TYPES; j1++)
+    if(m_modeCandidates > 0)
     {
-        CMP_DWORD blockMode = blockModeOrder[j1];
-        CMP_DWORD Mode = 0x0001 << blockMode;
-
-        if(!(validModeMask & Mode))
+        if(m_singlePrecision)
+            bestError = SearchModes(inF, validModeMask, out);
+        else
+            bestError = SearchModes(in, validModeMask, out);
+        encodedBlock = TRUE;
+    }
+    else
+    {
+        for(CMP_DWORD j1=0; j1 < NUM_BLOCK_TYPES; j1++)
         {
-            continue;
-        }
+            CMP_DWORD blockMode = blockModeOrder[j1];
+            CMP_DWORD Mode = 0x0001 << blockMode;
 
-        // CPU:HPC #1
-        // Setup mode parameters for this block
-        BlockSetup(blockMode);
+            if(!(validModeMask & Mode))
+            {
+                continue;
+            }
+
+            // CPU:HPC #1
+            // Setup mode parameters for this block
+            BlockSetup(blockMode);
         
-        if(bti[blockMode].encodingType != SEPARATE_ALPHA)
-        {
+            if(bti[blockMode].encodingType != SEPARATE_ALPHA)
+            {
        
-            #ifdef    BC7_DEBUG_TO_RESULTS_TXT
-            fprintf(fp,"=================== CompressSingleIndexBlock ======================\n");
-            #endif
-            thisError = CompressSingleIndexBlock(in, temporaryOutputBlock, blockMode);
+                #ifdef    BC7_DEBUG_TO_RESULTS_TXT
+                fprintf(fp,"=================== CompressSingleIndexBlock ======================\n");
+                #endif
+                if(m_singlePrecision)
+                    thisError = CompressSingleIndexBlock(inF, temporaryOutputBlock, blockMode);
+                else
+                    thisError = CompressSingleIndexBlock(in, temporaryOutputBlock, blockMode);
 
-        }
-        else
-        {
+            }
+            else
+            {
             
-            #ifdef    BC7_DEBUG_TO_RESULTS_TXT
-            fprintf(fp,"==================  CompressDualIndexBlock =======================\n");
-            #endif
+                #ifdef    BC7_DEBUG_TO_RESULTS_TXT
+                fprintf(fp,"==================  CompressDualIndexBlock =======================\n");
+                #endif
        
-            thisError = CompressDualIndexBlock(in, temporaryOutputBlock, blockMode);
-        }
+                if(m_singlePrecision)
+                    thisError = CompressDualIndexBlock(inF, temporaryOutputBlock, blockMode);
+                else
+                    thisError = CompressDualIndexBlock(in, temporaryOutputBlock, blockMode);
+            }
 
-        // If this compression did better than all previous attempts then copy the result
-        // to the output block
-        if(thisError < bestError)
-        {
-            for(i=0; i < COMPRESSED_BLOCK_SIZE; i++)
+            // If this compression did better than all previous attempts then copy the result
+            // to the output block
+            if(thisError < bestError)
             {
-                out[i] = temporaryOutputBlock[i];
+                for(i=0; i < COMPRESSED_BLOCK_SIZE; i++)
+                {
+                    out[i] = temporaryOutputBlock[i];
+                }
+                bestError = thisError;
+                encodedBlock = TRUE;
+                bestblockMode = blockMode;
             }
-            bestError = thisError;
-            encodedBlock = TRUE;
-            bestblockMode = blockMode;
-        }
 
-        // If we have achieved an error lower than the requirement threshold then just exit now
-        // Early out if we  found we can compress with error below the quality threshold
-        if (m_errorThreshold > 0)
-        {
-            if(bestError <= m_errorThreshold)
+            // If we have achieved an error lower than the requirement threshold then just exit now
+            // Early out if we  found we can compress with error below the quality threshold
+            if (m_errorThreshold > 0)
             {
-                break;
+                if(bestError <= m_errorThreshold)
+                {
+                    break;
+                }
             }
         }
     }
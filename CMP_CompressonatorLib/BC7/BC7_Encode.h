@@ -26,6 +26,7 @@
 
 #include <float.h>
 #include "BC7_Definitions.h"
+#include "CMP_BlockClass.h"
 #include "debug.h"
 
 #include <mutex>
@@ -35,6 +36,20 @@
 extern double g_qFAST_THRESHOLD;
 extern double g_HIGHQULITY_THRESHOLD;
 
+// Error below which the coarse to fine mode search stops refining candidates at any quality
+extern double g_MODESEARCH_MIN_THRESHOLD;
+
+// Most (mode, partition) and (mode, rotation, index selection) candidates of a block
+#define MAX_MODE_CANDIDATES     (5 * MAX_PARTITIONS)
+
+// A candidate of the coarse to fine mode search with the indices from its quantizer estimate
+struct BC7ModeCandidate
+{
+    CMP_DWORD   blockMode;
+    CMP_DWORD   partition;          // Partition, or (rotation << 1) | indexSelection for modes 4 and 5
+    int         indices[MAX_SUBSETS][MAX_SUBSET_SIZE];
+};
+
 class BC7BlockEncoder
 {
 public:
@@ -44,7 +59,9 @@ public:
                     double quality,
         CMP_BOOL colourRestrict,
         CMP_BOOL alphaRestrict,
-                    double performance = 1.0
+                    double performance = 1.0,
+        CMP_BOOL singlePrecision = FALSE,
+        CMP_DWORD modeCandidates = 0
                     )
                     {
                         // Bug check : ModeMask must be > 0
@@ -60,6 +77,13 @@ public:
                         m_largestError       = 0.0;
                         m_colourRestrict     = colourRestrict;
                         m_alphaRestrict      = alphaRestrict;
+                        m_singlePrecision    = singlePrecision;
+                        m_modeCandidates     = modeCandidates;
+
+                        for (int i = 0; i < CMP_BLOCK_CLASSES; i++)
+                            m_blockClassCounts[i] = 0;
+                        for (int i = 0; i < CMP_SEARCH_COUNTS; i++)
+                            m_searchCounts[i] = 0;
                         
                         m_quantizerRangeThreshold  = 255 * m_performance;
 
@@ -102,6 +126,8 @@ public:
 
     ~BC7BlockEncoder()
     {
+                CMP_AddBlockClassCounts(CMP_FORMAT_BC7, m_blockClassCounts);
+                CMP_AddModeSearchCounts(CMP_FORMAT_BC7, m_searchCounts);
 #ifdef USE_DBGTRACE
                 DbgTrace(("Smallest Error %f", (float)m_smallestError));
                 DbgTrace(("Largest Error %f", (float)m_largestError));
@@ -113,10 +139,13 @@ public:
         CMP_BYTE   out[COMPRESSED_BLOCK_SIZE]);
 
 private:
-    double quant_single_point_d(
-        double data[MAX_ENTRIES][MAX_DIMENSION_BIG],
+    // The quantizers, shakers and block compressors are templates on the floating point
+    // type, double for the reference encoder and float for the single precision one
+    template <typename T>
+    T quant_single_point_d(
+        T data[MAX_ENTRIES][MAX_DIMENSION_BIG],
         int numEntries, int index[MAX_ENTRIES],
-        double out[MAX_ENTRIES][MAX_DIMENSION_BIG],
+        T out[MAX_ENTRIES][MAX_DIMENSION_BIG],
         int epo_1[2][MAX_DIMENSION_BIG],
         int Mi_,                // last cluster
         int bits[3],            // including parity
@@ -124,26 +153,28 @@ private:
         int dimension
     );
 
-    double ep_shaker_2_d(
-        double data[MAX_ENTRIES][MAX_DIMENSION_BIG],
+    template <typename T>
+    T ep_shaker_2_d(
+        T data[MAX_ENTRIES][MAX_DIMENSION_BIG],
         int numEntries,
         int index_[MAX_ENTRIES],
-        double out[MAX_ENTRIES][MAX_DIMENSION_BIG],
+        T out[MAX_ENTRIES][MAX_DIMENSION_BIG],
         int epo_code[2][MAX_DIMENSION_BIG],
         int size,
         int Mi_,             // last cluster
         int bits,            // total for all channels
                              // defined by total numbe of bits and dimensioin
         int dimension,
-        double epo[2][MAX_DIMENSION_BIG]
+        T epo[2][MAX_DIMENSION_BIG]
 
     );
 
-    double ep_shaker_d(
-        double data[MAX_ENTRIES][MAX_DIMENSION_BIG],
+    template <typename T>
+    T ep_shaker_d(
+        T data[MAX_ENTRIES][MAX_DIMENSION_BIG],
         int numEntries,
         int index_[MAX_ENTRIES],
-        double out[MAX_ENTRIES][MAX_DIMENSION_BIG],
+        T out[MAX_ENTRIES][MAX_DIMENSION_BIG],
         int epo_code[2][MAX_DIMENSION_BIG],
         int Mi_,                // last cluster
         int bits[3],            // including parity
@@ -159,10 +190,41 @@ private:
         CMP_BYTE  block[COMPRESSED_BLOCK_SIZE]);
 
     // This routine compresses a block to any of the single index modes
-    double CompressSingleIndexBlock(double in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+    template <typename T>
+    T CompressSingleIndexBlock(T in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
         CMP_BYTE   out[COMPRESSED_BLOCK_SIZE],
         CMP_DWORD  blockMode);
 
+    // Steps of CompressSingleIndexBlock, also used by the coarse to fine mode search
+    CMP_DWORD PartitionsToTry(CMP_DWORD blockMode);
+    CMP_DWORD ShakeSetup(CMP_DWORD blockMode, CMP_DWORD dimension, int bits[4]);
+
+    template <typename T>
+    T QuantizePartition(T in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+        CMP_DWORD  blockMode,
+        CMP_DWORD  blockPartition,
+        CMP_DWORD  dimension,
+        int        storedIndices[MAX_SUBSETS][MAX_SUBSET_SIZE]);
+
+    template <typename T>
+    T ShakePartition(T in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+        CMP_DWORD  blockMode,
+        CMP_DWORD  blockPartition,
+        CMP_DWORD  dimension,
+        CMP_DWORD  shakeSize,
+        int        bits[4],
+        int        storedIndices[MAX_SUBSETS][MAX_SUBSET_SIZE],
+        int        epo_code[MAX_SUBSETS][2][MAX_DIMENSION_BIG],
+        CMP_DWORD  entryCount[MAX_SUBSETS]);
+
+    void EncodeSingleIndexResult(CMP_DWORD blockMode,
+        CMP_DWORD  blockPartition,
+        CMP_DWORD  dimension,
+        CMP_DWORD  entryCount[MAX_SUBSETS],
+        int        endpoints[MAX_SUBSETS][2][MAX_DIMENSION_BIG],
+        int        indices[MAX_SUBSETS][MAX_SUBSET_SIZE],
+        CMP_BYTE   out[COMPRESSED_BLOCK_SIZE]);
+
     void EncodeDualIndexBlock(CMP_DWORD blockMode,
         CMP_DWORD indexSelection,
         CMP_DWORD componentRotation,
@@ -170,16 +232,49 @@ private:
                               int indices[2][MAX_SUBSET_SIZE],
         CMP_BYTE   out[COMPRESSED_BLOCK_SIZE]);
 
+    // Encodes a block of one colour with mode 5 or 6 and returns the error
+    double CompressSolidBlock(double in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+        CMP_BYTE   out[COMPRESSED_BLOCK_SIZE],
+        CMP_DWORD  blockMode);
+
     // This routine compresses a block to any of the dual index modes
-    double CompressDualIndexBlock(double in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+    template <typename T>
+    T CompressDualIndexBlock(T in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
         CMP_BYTE   out[COMPRESSED_BLOCK_SIZE],
         CMP_DWORD  blockMode);
 
+    // Steps of CompressDualIndexBlock, also used by the coarse to fine mode search
+    template <typename T>
+    T QuantizeDualIndex(T cBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+        T          aBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+        CMP_DWORD  blockMode,
+        CMP_DWORD  indexSelection,
+        int        indices[2][MAX_SUBSET_SIZE]);
+
+    template <typename T>
+    T ShakeDualIndex(T cBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+        T          aBlock[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+        CMP_DWORD  blockMode,
+        CMP_DWORD  indexSelection,
+        int        indices[2][MAX_SUBSET_SIZE],
+        int        epo_code[2][2][MAX_DIMENSION_BIG]);
+
+    // Ranks every (mode, partition) of the valid modes by its quantizer error, shakes the
+    // best m_modeCandidates of them and stops early on the error threshold
+    template <typename T>
+    double SearchModes(T in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+        CMP_DWORD  validModeMask,
+        CMP_BYTE   out[COMPRESSED_BLOCK_SIZE]);
+
     // Bulky temporary data used during compression of a block
     int     m_storedIndices[MAX_PARTITIONS][MAX_SUBSETS][MAX_SUBSET_SIZE];
     double  m_storedError[MAX_PARTITIONS];
     int     m_sortedModes[MAX_PARTITIONS];
 
+    // Candidates of the coarse to fine mode search
+    BC7ModeCandidate m_candidates[MAX_MODE_CANDIDATES];
+    double  m_candidateError[MAX_MODE_CANDIDATES];
+
     // This stores the min and max for the components of the block, and the ranges
     double  m_blockMin[MAX_DIMENSION_BIG];
     double  m_blockMax[MAX_DIMENSION_BIG];
@@ -200,6 +295,8 @@ private:
     CMP_BOOL   m_imageNeedsAlpha;
     CMP_BOOL   m_colourRestrict;
     CMP_BOOL   m_alphaRestrict;
+    CMP_BOOL   m_singlePrecision;   // Run the float instead of the double encoder
+    CMP_DWORD  m_modeCandidates;    // Candidates refined by the coarse to fine mode search, 0 tries every mode in turn
 
     // Data for compressing a particular block mode
     CMP_DWORD m_parityBits;
@@ -210,6 +307,12 @@ private:
     double m_smallestError;
     double m_largestError;
 
+    // Number of blocks that went through each of the block class paths
+    CMP_DWORD m_blockClassCounts[CMP_BLOCK_CLASSES];
+
+    // Counters of the coarse to fine mode search
+    CMP_DWORD m_searchCounts[CMP_SEARCH_COUNTS];
+
 };
 
 
@@ -30,8 +30,12 @@
 #include "Compressonator.h"
 #include "HDR_Encode.h"
 
+#include <atomic>
+#include <mutex>
 
-CMP_BOOL    g_LibraryInitialized = FALSE;
+
+std::atomic<bool>   g_LibraryInitialized(false);
+static std::mutex   g_LibraryMutex;
 static BC7BlockDecoder  g_Decoder;
 
 //
@@ -41,6 +45,7 @@ static BC7BlockDecoder  g_Decoder;
 //
 extern "C" BC_ERROR CMP_InitializeBCLibrary()
 {
+    std::lock_guard<std::mutex> lock(g_LibraryMutex);
     if(g_LibraryInitialized)
     {
         return BC_ERROR_LIBRARY_ALREADY_INITIALIZED;
@@ -49,7 +54,7 @@ extern "C" BC_ERROR CMP_InitializeBCLibrary()
     // One time initialisation for quantizer and shaker
     Quant_Init();
     init_ramps();
-    g_LibraryInitialized = TRUE;
+    g_LibraryInitialized = true;
     return BC_ERROR_NONE;
 }
 
@@ -149,12 +154,13 @@ extern "C" BC_ERROR CMP_DestroyBC7Encoder( BC7BlockEncoder* encoder )
 //
 extern "C" BC_ERROR CMP_ShutdownBCLibrary(void)
 {
+    std::lock_guard<std::mutex> lock(g_LibraryMutex);
     if(!g_LibraryInitialized)
     {
         return BC_ERROR_LIBRARY_NOT_INITIALIZED;
     }
     Quant_DeInit();
-    g_LibraryInitialized = FALSE;
+    g_LibraryInitialized = false;
 
     return BC_ERROR_NONE;
 }
@@ -1006,9 +1006,10 @@ CMP_DWORD  BC7_FIXUPINDICES[MAX_SUBSETS][MAX_PARTITIONS][3] =
 
 extern FILE *fp;
 
+template <typename T>
 void    Partition(CMP_DWORD partition,
-                  double in[][MAX_DIMENSION_BIG],
-                  double subsets[MAX_SUBSETS][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+                  T in[][MAX_DIMENSION_BIG],
+                  T subsets[MAX_SUBSETS][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
     CMP_DWORD count[MAX_SUBSETS],
     CMP_DWORD blockType,
                   int   dimension)
@@ -1067,4 +1068,7 @@ void    Partition(CMP_DWORD partition,
     }
 }
 
-
+template void Partition(CMP_DWORD partition, double in[][MAX_DIMENSION_BIG], double subsets[MAX_SUBSETS][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+                        CMP_DWORD count[MAX_SUBSETS], CMP_DWORD blockType, int dimension);
+template void Partition(CMP_DWORD partition, float in[][MAX_DIMENSION_BIG], float subsets[MAX_SUBSETS][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+                        CMP_DWORD count[MAX_SUBSETS], CMP_DWORD blockType, int dimension);
@@ -31,9 +31,11 @@ extern CMP_DWORD    BC7_PARTITIONS[MAX_SUBSETS][MAX_PARTITIONS][MAX_SUBSET_SIZE]
 extern CMP_DWORD    BC7_FIXUPINDICES[MAX_SUBSETS][MAX_PARTITIONS][3];
 
 
-extern void    Partition(CMP_DWORD partition,
-                  double in[][MAX_DIMENSION_BIG],
-                  double subsets[MAX_SUBSETS][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+// Instantiated for double and float blocks
+template <typename T>
+void    Partition(CMP_DWORD partition,
+                  T in[][MAX_DIMENSION_BIG],
+                  T subsets[MAX_SUBSETS][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
     CMP_DWORD count[MAX_SUBSETS],
     CMP_DWORD blockType,
                   int   dimension);
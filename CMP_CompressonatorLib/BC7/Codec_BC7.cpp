@@ -30,7 +30,9 @@
 #include "Common.h"
 #include "Codec_BC7.h"
 #include "BC7_Library.h"
+#include "CMP_CancelToken.h"
 #include <chrono>
+#include <vector>
 
 #ifdef BC7_COMPDEBUGGER
 #include "CompClient.h"
@@ -54,34 +56,6 @@ int bc7_total_MSE = 0;
 // Gets the total numver of active processor cores on the running host system
 extern CMP_INT CMP_GetNumberOfProcessors();
 
-//
-// Thread procedure for encoding a block
-//
-// The thread stays alive, and expects blocks to be pushed to it by a producer
-// process that signals it when new work is available. When the producer is finished
-// it should set the exit flag in the parameters to allow the tread to quit
-//
-
-unsigned int BC7ThreadProcEncode(void* param)
-{
-    BC7EncodeThreadParam *tp = (BC7EncodeThreadParam*)param;
-    
-    while(tp->exit == FALSE)
-    {
-        if(tp->run == TRUE)
-        {
-            tp->encoder->CompressBlock(tp->in, tp->out);
-            tp->run = FALSE;
-        }
-
-        using namespace std::chrono;
-
-        std::this_thread::sleep_for(0ms);
-    }
-    
-    return 0;
-}
-
 //////////////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////////////
@@ -96,13 +70,12 @@ CCodec_BC7::CCodec_BC7() : CCodec_DXTC(CT_BC7)
     m_Performance          = 1.00;
     m_ColourRestrict       = FALSE;
     m_AlphaRestrict        = FALSE;
+    m_SinglePrecision      = FALSE;
+    m_ModeSearchCandidates = 0;
     m_ImageNeedsAlpha      = TRUE;
 
     m_NumThreads           = 0;
     m_NumEncodingThreads   = m_NumThreads;
-    m_EncodingThreadHandle = NULL;
-    m_LiveThreads          = 0;
-    m_LastThread           = 0;
 
 }
 
@@ -123,6 +96,12 @@ bool CCodec_BC7::SetParameter(const CMP_CHAR* pszParamName, CMP_CHAR* sValue)
     if(strcmp(pszParamName, "AlphaRestrict") == 0)
         m_AlphaRestrict        = std::stoi(sValue) > 0?TRUE:FALSE;
     else
+    if(strcmp(pszParamName, "SinglePrecision") == 0)
+        m_SinglePrecision      = std::stoi(sValue) > 0?TRUE:FALSE;
+    else
+    if(strcmp(pszParamName, "ModeSearchCandidates") == 0)
+        m_ModeSearchCandidates = max(0, std::stoi(sValue));
+    else
     if(strcmp(pszParamName, "ImageNeedsAlpha") == 0)
         m_ImageNeedsAlpha     = std::stoi(sValue) > 0?TRUE:FALSE;
     else
@@ -167,6 +146,12 @@ bool CCodec_BC7::SetParameter(const CMP_CHAR* pszParamName, CMP_DWORD dwValue)
     if(strcmp(pszParamName, "AlphaRestrict") == 0)
         m_AlphaRestrict        =  (dwValue & 1)?TRUE:FALSE;
     else
+    if(strcmp(pszParamName, "SinglePrecision") == 0)
+        m_SinglePrecision      =  (dwValue & 1)?TRUE:FALSE;
+    else
+    if(strcmp(pszParamName, "ModeSearchCandidates") == 0)
+        m_ModeSearchCandidates = dwValue;
+    else
     if(strcmp(pszParamName, "ImageNeedsAlpha") == 0)
         m_ImageNeedsAlpha     = (dwValue & 1)?TRUE:FALSE;
     else
@@ -197,65 +182,10 @@ CCodec_BC7::~CCodec_BC7()
 {
     if (m_LibraryInitialized)
     {
-        if (m_Use_MultiThreading)
+        for(int i=0; i < CMP_MAX_POOL_SLOTS; i++)
         {
-            // Tell all the live threads that they can exit when they have finished any current work
-            for(int i=0; i < m_LiveThreads; i++)
-            {
-                // If a thread is in the running state then we need to wait for it to finish
-                // any queued work from the producer before we can tell it to exit.
-                //
-                // If we don't wait then there is a race condition here where we have
-                // told the thread to run but it hasn't yet been scheduled - if we set
-                // the exit flag before it runs then its block will not be processed.
-#pragma warning(push)
-#pragma warning(disable:4127) //warning C4127: conditional expression is constant
-                while(1)
-                {
-                    if(m_EncodeParameterStorage[i].run != TRUE)
-                    {
-                        break;
-                    }
-                }
-#pragma warning(pop)
-                // Signal to the thread that it can exit
-                m_EncodeParameterStorage[i].exit = TRUE;
-            }
-
-            // Now wait for all threads to have exited
-            if (m_LiveThreads > 0)
-            {
-                for (CMP_DWORD dwThread = 0; dwThread < m_LiveThreads; dwThread++)
-                {
-                    std::thread& curThread = m_EncodingThreadHandle[dwThread];
-
-                    curThread.join();
-                }
-            }
-
-            for (unsigned int i = 0; i < m_LiveThreads; i++)
-            {
-                std::thread& curThread = m_EncodingThreadHandle[i];
-            
-                curThread = std::thread();
-            }
-
-            delete[] m_EncodingThreadHandle;
-        } // MultiThreading
-
-        m_EncodingThreadHandle = NULL;
-
-        if (m_EncodeParameterStorage)
-            delete[] m_EncodeParameterStorage;
-        m_EncodeParameterStorage = NULL;
-
-        for(int i=0; i < m_NumEncodingThreads; i++)
-        {
-            if (m_encoder[i])
-            {
-                delete m_encoder[i];
-                m_encoder[i] = NULL;
-            }
+            SAFE_DELETE(m_encoder[i]);
+            SAFE_DELETE(m_fastEncoder[i]);
         }
 
         if (m_decoder)
@@ -282,106 +212,21 @@ CodecError CCodec_BC7::InitializeBC7Library()
         init_ramps();
 
 
-        for(CMP_DWORD i=0; i < MAX_BC7_THREADS; i++)
+        for(CMP_DWORD i=0; i < CMP_MAX_POOL_SLOTS; i++)
         {
-            m_encoder[i] = NULL;
+            m_encoder[i]     = NULL;
+            m_fastEncoder[i] = NULL;
         }
 
-        // Create threaded encoder instances
-        m_LiveThreads = 0;
-        m_LastThread  = 0;
-        //printf("BC7 CPU Num user threads = %d\n",m_NumEncodingThreads);
+        // Block rows are encoded by the library thread pool, m_NumThreads limits
+        // how many of its workers this codec may use at once (0 = all of them)
         m_NumEncodingThreads = min(m_NumThreads, MAX_BC7_THREADS);
-        if (m_NumEncodingThreads == 0)
-        {
-            m_NumEncodingThreads = CMP_GetNumberOfProcessors();
-            if (m_NumEncodingThreads <= 2)
-                m_NumEncodingThreads = 8; // fallback to a default!
-            if (m_NumEncodingThreads > 128)
-                m_NumEncodingThreads = 128;
-
-        }
         m_Use_MultiThreading = (m_NumEncodingThreads != 1);
 
-        m_EncodeParameterStorage = new BC7EncodeThreadParam[m_NumEncodingThreads];
-        if(!m_EncodeParameterStorage)
-        {
-            return CE_Unknown;
-        }
-
-        m_EncodingThreadHandle = new std::thread[m_NumEncodingThreads];
-        if(!m_EncodingThreadHandle)
-        {
-            delete[] m_EncodeParameterStorage;
-            m_EncodeParameterStorage = NULL;
-
-            return CE_Unknown;
-        }
-
-        CMP_INT   i;
-        //printf("BC7 CPU Num threads used = %d\n",m_NumEncodingThreads);
-        for(i=0; i < m_NumEncodingThreads; i++)
-        {
-            // Create single encoder instance
-            m_encoder[i] = new BC7BlockEncoder( m_ModeMask,
-                                                m_ImageNeedsAlpha,
-                                                m_Quality,
-                                                m_ColourRestrict,
-                                                m_AlphaRestrict,
-                                                m_Performance);
-
-            
-            // Cleanup if problem!
-            if(!m_encoder[i])
-            {
-
-                delete[] m_EncodeParameterStorage;
-                m_EncodeParameterStorage = NULL;
-
-                delete[] m_EncodingThreadHandle;
-                m_EncodingThreadHandle = NULL;
-
-                for(CMP_INT j=0; j<i; j++)
-                {
-                    delete m_encoder[j];
-                    m_encoder[j] = NULL;
-                }
-
-                return CE_Unknown;
-            }
-
-            #ifdef USE_DBGTRACE
-            DbgTrace(("Encoder[%d]:ModeMask %X, Quality %f",i,m_ModeMask,m_Quality));
-            #endif
-
-        }
-
-        // Create the encoding threads
-        for (i = 0; i<m_NumEncodingThreads; i++)
-        {
-            // Initialize thread parameters.
-            m_EncodeParameterStorage[i].encoder = m_encoder[i];
-            // Inform the thread that at the moment it doesn't have any work to do
-            // but that it should wait for some and not exit
-            m_EncodeParameterStorage[i].run = FALSE;
-            m_EncodeParameterStorage[i].exit = FALSE;
-
-            m_EncodingThreadHandle[i] = std::thread(
-                BC7ThreadProcEncode,
-                (void*)&m_EncodeParameterStorage[i]
-            );
-            m_LiveThreads++;
-        }
-
         // Create single decoder instance
         m_decoder = new BC7BlockDecoder();
         if(!m_decoder)
         {
-            for(CMP_INT j=0; j<m_NumEncodingThreads; j++)
-            {
-                delete m_encoder[j];
-                m_encoder[j] = NULL;
-            }
             return CE_Unknown;
         }
 
@@ -390,18 +235,36 @@ CodecError CCodec_BC7::InitializeBC7Library()
     return CE_OK;
 }
 
+// Returns the encoder owned by the calling thread's pool slot
+BC7BlockEncoder* CCodec_BC7::GetEncoder()
+{
+    CMP_INT slot     = CMP_ThreadPool::GetWorkerSlot();
+    bool    bDegrade = (m_Quality > CMP_DEGRADED_QUALITY) && IsDegraded();
+
+    BC7BlockEncoder*& encoder = bDegrade ? m_fastEncoder[slot] : m_encoder[slot];
+    if (encoder == NULL)
+    {
+        double quality = bDegrade ? CMP_DEGRADED_QUALITY : m_Quality;
+        if (m_SinglePrecision)
+            init_ramps_f();
+        encoder = new BC7BlockEncoder( m_ModeMask,
+                                       m_ImageNeedsAlpha,
+                                       quality,
+                                       m_ColourRestrict,
+                                       m_AlphaRestrict,
+                                       m_Performance,
+                                       m_SinglePrecision,
+                                       m_ModeSearchCandidates);
+        #ifdef USE_DBGTRACE
+        DbgTrace(("Encoder[%d]:ModeMask %X, Quality %f",slot,m_ModeMask,quality));
+        #endif
+    }
+    return encoder;
+}
 
 CodecError CCodec_BC7::EncodeBC7Block(double  in[BC7_BLOCK_PIXELS][MAX_DIMENSION_BIG],
     CMP_BYTE    *out)
 {
-#ifdef USE_SINGLETHREADING
-    m_Use_MultiThreading = false;
-#endif
-
-if (m_Use_MultiThreading)
-{
-    CMP_WORD   threadIndex;
-
     if((!m_LibraryInitialized) ||
         (!in) ||
         (!out))
@@ -409,83 +272,49 @@ if (m_Use_MultiThreading)
         return CE_Unknown;
     }
 
-    // Loop and look for an available thread
-    CMP_BOOL found = FALSE;
-    threadIndex = m_LastThread;
-    while (found == FALSE)
-    {
-
-        if (m_EncodeParameterStorage == NULL)
-            return CE_Unknown;
-
-        if(m_EncodeParameterStorage[threadIndex].run == FALSE)
-        {
-            found = TRUE;
-            break;
-        }
-
-        // Increment and wrap the thread index
-        threadIndex++;
-        if(threadIndex == m_LiveThreads)
-        {
-            threadIndex = 0;
-        }
-    }
-
-    m_LastThread = threadIndex;
-
-    // Copy the input data into the thread storage
-    std::memcpy(m_EncodeParameterStorage[threadIndex].in,
-           in,
-           MAX_SUBSET_SIZE * MAX_DIMENSION_BIG * sizeof(double));
-
-    // Set the output pointer for the thread to the provided location
-    m_EncodeParameterStorage[threadIndex].out = out;
+    BC7BlockEncoder* encoder = GetEncoder();
+    if (!encoder)
+        return CE_Unknown;
 
-    // Tell the thread to start working
-    m_EncodeParameterStorage[threadIndex].run = TRUE;
-}
-else 
-{
-    //printf("BC7 CPU Single Threaded\n");
-        // Copy the input data into the thread storage
-        std::memcpy(m_EncodeParameterStorage[0].in, in, MAX_SUBSET_SIZE * MAX_DIMENSION_BIG * sizeof(double));
-        // Set the output pointer for the thread to write
-        m_EncodeParameterStorage[0].out = out;
-        m_encoder[0]->CompressBlock(m_EncodeParameterStorage[0].in, m_EncodeParameterStorage[0].out);
-}
+    encoder->CompressBlock(in, out);
     return CE_OK;
 }
 
-CodecError CCodec_BC7::FinishBC7Encoding(void)
+// Reads nBlocks consecutive blocks starting at block index dwBlock, one row run at a time
+static void BC7ReadBlocks(CCodecBuffer& bufferIn, CMP_DWORD dwBlock, CMP_DWORD dwBlocksX, CMP_DWORD nBlocks, CMP_BYTE srcBlocks[])
 {
-    if(!m_LibraryInitialized)
+    CMP_DWORD n;
+    for(CMP_DWORD i = 0; i < nBlocks; i += n, dwBlock += n)
     {
-        return CE_Unknown;
-    }
-
-    if (!m_EncodeParameterStorage)
-    {
-        return CE_Unknown;
+        CMP_DWORD x = dwBlock % dwBlocksX;
+        n = min(nBlocks - i, dwBlocksX - x);
+        bufferIn.ReadBlockRowRGBA(x*4, (dwBlock / dwBlocksX)*4, n, &srcBlocks[i * BLOCK_SIZE_4X4X4]);
     }
+}
 
-if (m_Use_MultiThreading)
+static void BC7LoadBlock(const CMP_BYTE srcBlock[BLOCK_SIZE_4X4X4], double blockToEncode[BLOCK_SIZE_4X4][CHANNEL_SIZE_ARGB])
 {
-
-    // Wait for all the live threads to finish any current work
-    for (CMP_DWORD i = 0; i < m_LiveThreads; i++)
+    // Create the block for encoding
+    int srcIndex = 0;
+    for(int row=0; row < BLOCK_SIZE_4; row++)
     {
-        using namespace std::chrono;
-        
-        // If a thread is in the running state then we need to wait for it to finish
-        // its work from the producer
-        while (m_EncodeParameterStorage[i].run == TRUE)
+        for(int col=0; col < BLOCK_SIZE_4; col++)
         {
-            std::this_thread::sleep_for(1ms);
+            blockToEncode[row*BLOCK_SIZE_4+col][BC_COMP_RED]        = (double)srcBlock[srcIndex];
+            blockToEncode[row*BLOCK_SIZE_4+col][BC_COMP_GREEN]        = (double)srcBlock[srcIndex+1];
+            blockToEncode[row*BLOCK_SIZE_4+col][BC_COMP_BLUE]        = (double)srcBlock[srcIndex+2];
+            blockToEncode[row*BLOCK_SIZE_4+col][BC_COMP_ALPHA]        = (double)srcBlock[srcIndex+3];
+            srcIndex+=4;
         }
     }
 }
-return CE_OK;
+
+// Encodes a batch of blocks queued by Compress(), called from the thread pool
+void CCodec_BC7::EncodeBC7Batch(BC7BlockBatch& batch)
+{
+    // Poll per block, at high quality a whole batch is far longer than the cancel latency we want
+    for(CMP_DWORD i = 0; (i < batch.dwNumBlocks) && !IsCanceled(); i++)
+        EncodeBC7Block(batch.in[i], batch.out[i]);
 }
 
 
@@ -576,23 +405,55 @@ CodecError CCodec_BC7::Compress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut,
     DbgTrace(("   : Height %d Width %d Pitch %d isFloat %d",bufferOut.GetHeight(),bufferOut.GetWidth(),bufferOut.GetWidth(),bufferOut.IsFloat()));
     #endif
 
-    char            row,col,srcIndex;
-
     CMP_BYTE    *pOutBuffer;
     pOutBuffer    = bufferOut.GetData();
 
     CMP_BYTE*    pInBuffer;
     pInBuffer    =  bufferIn.GetData();
 
+#if !defined(BC7_COMPDEBUGGER) && !defined(USE_FILEIO) && !defined(USE_THREADED_CALLBACKS) && !defined(USE_SINGLETHREADING)
+    if (m_Use_MultiThreading)
+    {
+        const CMP_DWORD dwNumBlocks  = dwBlocksX * dwBlocksY;
+        const CMP_DWORD dwNumBatches = (dwNumBlocks + BC7_BLOCKS_PER_BATCH - 1) / BC7_BLOCKS_PER_BATCH;
+
+        bool bCompleted = CMP_ProcessBatches<BC7BlockBatch>(dwNumBatches, m_NumEncodingThreads,
+            [&](BC7BlockBatch& batch, CMP_DWORD dwBatch)
+            {
+                CMP_DWORD dwBlock = dwBatch * BC7_BLOCKS_PER_BATCH;
+                batch.dwNumBlocks = min(dwNumBlocks - dwBlock, (CMP_DWORD)BC7_BLOCKS_PER_BATCH);
+
+                CMP_BYTE srcBlocks[BC7_BLOCKS_PER_BATCH * BLOCK_SIZE_4X4X4];
+                BC7ReadBlocks(bufferIn, dwBlock, dwBlocksX, batch.dwNumBlocks, srcBlocks);
+                for(CMP_DWORD i = 0; i < batch.dwNumBlocks; i++, dwBlock++)
+                {
+                    BC7LoadBlock(&srcBlocks[i * BLOCK_SIZE_4X4X4], batch.in[i]);
+                    batch.out[i] = pOutBuffer + dwBlock * 16;
+                }
+            },
+            [&](BC7BlockBatch& batch) { EncodeBC7Batch(batch); },
+            [&](float fProgress) { return pFeedbackProc ? pFeedbackProc(fProgress, pUser1, pUser2) : false; },
+            [&]() { return IsCanceled(); });
+
+        return bCompleted ? CE_OK : CE_Aborted;
+    }
+#endif
+
 #ifdef USE_FILEIO
     bc7_File = fopen("bc7_report.txt", "w");
     bc7_blockcount = 0;
     bc7_total_MSE = 0;
 #endif
 
+    std::vector<CMP_BYTE> srcRow(dwBlocksX * BLOCK_SIZE_4X4X4);
+
     CMP_DWORD block = 0;
     for(CMP_DWORD j = 0; j < dwBlocksY; j++)
     {
+        if (IsCanceled())
+            return CE_Aborted;
+
+        bufferIn.ReadBlockRowRGBA(0, j*4, dwBlocksX, &srcRow[0]);
 
         for(CMP_DWORD i = 0; i < dwBlocksX; i++)
         {
@@ -607,31 +468,18 @@ CodecError CCodec_BC7::Compress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut,
 #endif
 
             double blockToEncode[BLOCK_SIZE_4X4][CHANNEL_SIZE_ARGB];
-            CMP_BYTE srcBlock[BLOCK_SIZE_4X4X4];
-
-            memset(srcBlock,0,sizeof(srcBlock));
-            bufferIn.ReadBlockRGBA(i*4, j*4, 4, 4, srcBlock);
 
             #ifdef BC7_COMPDEBUGGER
             if (CompClient.Connected())
             {
+                CMP_BYTE srcBlock[BLOCK_SIZE_4X4X4];
+                memset(srcBlock,0,sizeof(srcBlock));
+                bufferIn.ReadBlockRGBA(i*4, j*4, 4, 4, srcBlock);
                 CompClient.SendData(1, sizeof(srcBlock), srcBlock);
             }
             #endif
 
-            // Create the block for encoding
-            srcIndex = 0;
-            for(row=0; row < BLOCK_SIZE_4; row++)
-            {
-                for(col=0; col < BLOCK_SIZE_4; col++)
-                {
-                    blockToEncode[row*BLOCK_SIZE_4+col][BC_COMP_RED]        = (double)srcBlock[srcIndex];
-                    blockToEncode[row*BLOCK_SIZE_4+col][BC_COMP_GREEN]        = (double)srcBlock[srcIndex+1];
-                    blockToEncode[row*BLOCK_SIZE_4+col][BC_COMP_BLUE]        = (double)srcBlock[srcIndex+2];
-                    blockToEncode[row*BLOCK_SIZE_4+col][BC_COMP_ALPHA]        = (double)srcBlock[srcIndex+3];
-                    srcIndex+=4;
-                }
-            }
+            BC7LoadBlock(&srcRow[i * BLOCK_SIZE_4X4X4], blockToEncode);
 
            // printf("[i %3d, j%3d]\n",i,j);
             EncodeBC7Block(blockToEncode, pOutBuffer + block);
@@ -719,7 +567,6 @@ CodecError CCodec_BC7::Compress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut,
                 #ifdef BC7_COMPDEBUGGER
                     CompClient.disconnect();
                 #endif
-                FinishBC7Encoding();
                 return CE_Aborted;
             }
          }
@@ -737,7 +584,6 @@ CodecError CCodec_BC7::Compress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut,
                         #ifdef BC7_COMPDEBUGGER
                             CompClient.disconnect();
                         #endif
-                        FinishBC7Encoding();
                         return CE_Aborted;
                     }
                 }
@@ -766,14 +612,11 @@ CodecError CCodec_BC7::Compress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut,
     cmp_progress->detach();
     delete cmp_progress;
 #endif
-    // Close up remaining compression blocks
-    CodecError cError = FinishBC7Encoding();
-
     #ifdef USE_DBGTRACE
     DbgTrace(("###########-----------DONE -------------###########"));
     #endif
 
-    return cError;
+    return CE_OK;
 }
 
 
@@ -33,6 +33,7 @@
 #include "BC7_Encode.h"
 #include "BC7_Decode.h"
 #include "BC7_Library.h"
+#include "CMP_BlockQueue.h"
 #include <thread>
 
 // #define USE_THREADED_CALLBACKS  // This is experimental code to improve compression performance!
@@ -45,13 +46,14 @@ typedef struct
 #endif
 
 
-struct BC7EncodeThreadParam
+// Number of blocks handed to a pool worker at a time
+#define BC7_BLOCKS_PER_BATCH    16
+
+struct BC7BlockBatch
 {
-    BC7BlockEncoder    *encoder;
-    double    in[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
-    CMP_BYTE    *out;
-    volatile CMP_BOOL    run;
-    volatile CMP_BOOL    exit;
+    CMP_DWORD   dwNumBlocks;
+    double      in[BC7_BLOCKS_PER_BATCH][BC7_BLOCK_PIXELS][MAX_DIMENSION_BIG];
+    CMP_BYTE*   out[BC7_BLOCKS_PER_BATCH];
 };
 
 class CCodec_BC7 : public CCodec_DXTC  
@@ -72,14 +74,14 @@ public:
 
 
 private:
-    BC7EncodeThreadParam *m_EncodeParameterStorage;
-
     // BC7 User configurable variables
     CMP_DWORD   m_ModeMask;
     double  m_Quality;
     double  m_Performance;
     CMP_BOOL    m_ColourRestrict;
     CMP_BOOL    m_AlphaRestrict;
+    CMP_BOOL    m_SinglePrecision;
+    CMP_DWORD   m_ModeSearchCandidates;
     CMP_WORD    m_NumThreads;    
     CMP_BOOL    m_ImageNeedsAlpha;
 
@@ -88,18 +90,19 @@ private:
     CMP_BOOL     m_LibraryInitialized;
     CMP_BOOL     m_Use_MultiThreading;
     CMP_INT      m_NumEncodingThreads;
-    CMP_WORD     m_LiveThreads;
-    CMP_WORD     m_LastThread;
 
     // BC7 Encoders and decoders: for encding use the interfaces below
-    std::thread*        m_EncodingThreadHandle;
-    BC7BlockEncoder*    m_encoder[MAX_BC7_THREADS];
+    // Encoders are created on demand, one for each thread pool slot that uses them,
+    // the fast encoders are used once the cancel token asks for degraded quality
+    BC7BlockEncoder*    m_encoder[CMP_MAX_POOL_SLOTS];
+    BC7BlockEncoder*    m_fastEncoder[CMP_MAX_POOL_SLOTS];
     BC7BlockDecoder*    m_decoder;
 
     // Encoder interfaces
     CodecError    InitializeBC7Library();
+    BC7BlockEncoder* GetEncoder();
     CodecError    EncodeBC7Block(double  in[BC7_BLOCK_PIXELS][MAX_DIMENSION_BIG],CMP_BYTE *out);
-    CodecError    FinishBC7Encoding(void);
+    void          EncodeBC7Batch(BC7BlockBatch& batch);
 
     static void Run();
 
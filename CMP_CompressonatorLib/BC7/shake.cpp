@@ -25,6 +25,8 @@
 #include <assert.h>
 #include <math.h>
 #include <float.h>
+#include <mutex>
+#include <limits>
 
 #include "3dquant_constants.h"
 #include "3dquant_vpc.h"
@@ -226,6 +228,8 @@ static double ramp_err[LOG_CL_RANGE-LOG_CL_BASE][BIT_RANGE-BIT_BASE][256][256][2
 #endif
 
 static double ramp[LOG_CL_RANGE-LOG_CL_BASE][BIT_RANGE-BIT_BASE][256][256][16];
+// the same ramps for the single precision encoder, all values are integers
+static float  ramp_f[LOG_CL_RANGE-LOG_CL_BASE][BIT_RANGE-BIT_BASE][256][256][16];
 static double ep_d[BIT_RANGE-BIT_BASE][256];
 // inverted table
 // <log2 clusters >,  bits, value, par1, par2, <ep1>
@@ -240,11 +244,11 @@ int expand_ (int bits, int v) {
     return (  v << (8-bits) | v >> (2* bits - 8)); 
 }
 
-static bool ramp_init = false;
+static std::once_flag ramp_once;
+static std::once_flag ramp_f_once;
 
-void init_ramps (void) 
+static void build_ramps (void) 
 {
-    if (ramp_init) return;
 #ifdef USE_DBGTRACE
     DbgTrace(());
 #endif
@@ -328,8 +332,50 @@ void init_ramps (void)
                                     sp_err[CLT(clog1)][BTT(bits)][j][o1][o2][i]=k*k;
                                 }
                             }
+}
 
-    ramp_init = true;
+void init_ramps (void) 
+{
+    // Codecs on different threads may initialize at the same time, the first one builds
+    // the tables and the rest only read them
+    std::call_once(ramp_once, build_ramps);
+}
+
+static void build_ramps_f (void) 
+{
+    int clog1;
+    int bits;
+    int p1;
+    int p2;
+    int i;
+
+    for (clog1=LOG_CL_BASE;clog1<LOG_CL_RANGE;clog1++)
+        for (bits=BIT_BASE;bits<BIT_RANGE;bits++) 
+            for (p1=0;p1<(1<<bits);p1++)
+                for (p2=0;p2<(1<<bits);p2++)
+                    for (i=0; i<(1<<clog1);i++)
+                        ramp_f[CLT(clog1)][BTT(bits)][p1][p2][i] = (float) ramp[CLT(clog1)][BTT(bits)][p1][p2][i];
+}
+
+void init_ramps_f (void) 
+{
+    // ramp_f is large and only the single precision encoder reads it, so it is
+    // filled in the first time such an encoder is created
+    init_ramps();
+    std::call_once(ramp_f_once, build_ramps_f);
+}
+
+// ramp of the endpoint pair p1, p2 in the precision of the encoder
+template <typename T> static inline T* ramp_row(int clog, int bits, int p1, int p2);
+
+template <> inline double* ramp_row<double>(int clog, int bits, int p1, int p2)
+{
+    return ramp[CLT(clog)][BTT(bits)][p1][p2];
+}
+
+template <> inline float* ramp_row<float>(int clog, int bits, int p1, int p2)
+{
+    return ramp_f[CLT(clog)][BTT(bits)][p1][p2];
 }
 
 // finds "floor in the set" if exists, otherwise returns min
@@ -383,7 +429,8 @@ inline void mean_d (double d[][DIMENSION], double mean[DIMENSION], int n) {
         mean[j] /=(double) n;
 }
 
-inline void mean_d_d (double d[][MAX_DIMENSION_BIG], double mean[MAX_DIMENSION_BIG], int n, int dimension) {
+template <typename T>
+inline void mean_d_d (T d[][MAX_DIMENSION_BIG], T mean[MAX_DIMENSION_BIG], int n, int dimension) {
 #ifdef USE_DBGTRACE
     DbgTrace(());
 #endif
@@ -395,7 +442,7 @@ inline void mean_d_d (double d[][MAX_DIMENSION_BIG], double mean[MAX_DIMENSION_B
         for(j=0;j< dimension;j++)
             mean[j] +=d[i][j];
     for(j=0;j< dimension;j++)
-        mean[j] /=(double) n;
+        mean[j] /=(T) n;
 }
 
 inline int cluster_mean_d (double d[][DIMENSION],  double mean[][DIMENSION], int index[],int i_comp[],int i_cnt[], int n) {
@@ -427,7 +474,8 @@ inline int cluster_mean_d (double d[][DIMENSION],  double mean[][DIMENSION], int
     return k;
 }
 
-inline int cluster_mean_d_d (double d[][MAX_DIMENSION_BIG],  double mean[][MAX_DIMENSION_BIG], int index[],int i_comp[],int i_cnt[], int n, int dimension) {
+template <typename T>
+inline int cluster_mean_d_d (T d[][MAX_DIMENSION_BIG],  T mean[][MAX_DIMENSION_BIG], int index[],int i_comp[],int i_cnt[], int n, int dimension) {
     // unused index values are underfined
     int i,j,k;
     assert(n!=0);
@@ -449,7 +497,7 @@ inline int cluster_mean_d_d (double d[][MAX_DIMENSION_BIG],  double mean[][MAX_D
 
     for(i=0;i< k;i++)
         for(j=0;j< dimension;j++)
-            mean[i_comp[i]][j] /=(double) i_cnt[i_comp[i]];
+            mean[i_comp[i]][j] /=(T) i_cnt[i_comp[i]];
     return k;
 }
 
@@ -467,7 +515,8 @@ inline int all_same (double d[][DIMENSION],  int n) {
     return(same);
 }
 
-inline int all_same_d (double d[][MAX_DIMENSION_BIG],  int n, int dimension){
+template <typename T>
+inline int all_same_d (T d[][MAX_DIMENSION_BIG],  int n, int dimension){
     assert(n>0);
     int i,j;
     int same = 1;
@@ -526,11 +575,12 @@ void index_collapse_ (int index[], int numEntries)
 //
 //
 
-double BC7BlockEncoder::quant_single_point_d
+template <typename T>
+T BC7BlockEncoder::quant_single_point_d
 ( 
-    double data[MAX_ENTRIES][MAX_DIMENSION_BIG], 
+    T data[MAX_ENTRIES][MAX_DIMENSION_BIG], 
     int numEntries, int index[MAX_ENTRIES],
-    double out[MAX_ENTRIES][MAX_DIMENSION_BIG],
+    T out[MAX_ENTRIES][MAX_DIMENSION_BIG],
     int epo_1[2][MAX_DIMENSION_BIG],
     int Mi_,                // last cluster
     int bits[3],            // including parity
@@ -544,9 +594,9 @@ double BC7BlockEncoder::quant_single_point_d
 
     int i,j;
 
-    double err_0=DBL_MAX;
+    T err_0=std::numeric_limits<T>::max();
 
-    double err_1=DBL_MAX;
+    T err_1=std::numeric_limits<T>::max();
     int idx = 0;
     int idx_1 = 0;
 
@@ -591,16 +641,16 @@ double BC7BlockEncoder::quant_single_point_d
             
             int dr[MAX_DIMENSION_BIG];
             int dr_0[MAX_DIMENSION_BIG];
-            double tr;
+            T tr;
             
             for (i=0; i< (1<<clog2);i++)
             {
-                double t=0; 
+                T t=0; 
                 int t1o[MAX_DIMENSION_BIG],t2o[MAX_DIMENSION_BIG];
 
                 for (j=0;j<dimension;j++)
                 {
-                    double t_=DBL_MAX;
+                    T t_=std::numeric_limits<T>::max();
 
                     for (t1=o1[0][j];t1<o1[1][j];t1++)
                     {
@@ -625,7 +675,7 @@ double BC7BlockEncoder::quant_single_point_d
                                 dr[j]=(int)floor(data[0][j]+0.5);
 
                             tr = sp_err[CLT(clog2)][BTT(bits[j])][dr[j]][t1][t2][i] + 
-                                 2*sqrt(sp_err[CLT(clog2)][BTT(bits[j])][dr[j]][t1][t2][i]) * fabs((double)dr[j]-data[0][j])+
+                                 2*sqrt(sp_err[CLT(clog2)][BTT(bits[j])][dr[j]][t1][t2][i]) * fabs((T)dr[j]-data[0][j])+
                                  (dr[j]-data[0][j])* (dr[j]-data[0][j]);
 
                             if (tr < t_)
@@ -676,24 +726,25 @@ double BC7BlockEncoder::quant_single_point_d
         index[i]=idx_1;
         for (j=0;j<dimension;j++) 
         {
-           out[i][j]=ramp[CLT(clog2)][BTT(bits[j])][epo_1[0][j]][epo_1[1][j]][idx_1];
+           out[i][j]=ramp_row<T>(clog2, bits[j], epo_1[0][j], epo_1[1][j])[idx_1];
         }
     }
     return err_1 * numEntries;
 }
 
-double BC7BlockEncoder::ep_shaker_2_d(
-    double data[MAX_ENTRIES][MAX_DIMENSION_BIG], 
+template <typename T>
+T BC7BlockEncoder::ep_shaker_2_d(
+    T data[MAX_ENTRIES][MAX_DIMENSION_BIG], 
     int numEntries, 
     int index_[MAX_ENTRIES],
-    double out[MAX_ENTRIES][MAX_DIMENSION_BIG],
+    T out[MAX_ENTRIES][MAX_DIMENSION_BIG],
     int epo_code[2][MAX_DIMENSION_BIG],
     int size,
     int Mi_,             // last cluster
     int bits,            // total for all channels
      // defined by total numbe of bits and dimensioin
     int dimension,
-    double epo[2][MAX_DIMENSION_BIG]
+    T epo[2][MAX_DIMENSION_BIG]
 
     ) 
 {
@@ -723,7 +774,7 @@ double BC7BlockEncoder::ep_shaker_2_d(
 
     assert((1<<clog3)== Mi_+1);
 
-    double mean[MAX_DIMENSION_BIG];
+    T mean[MAX_DIMENSION_BIG];
     int index[MAX_ENTRIES];
     int Mi;
 
@@ -738,11 +789,11 @@ double BC7BlockEncoder::ep_shaker_2_d(
 
     int better;
     
-    double err_o = DBL_MAX;
+    T err_o = std::numeric_limits<T>::max();
 
     int epo_0[2][MAX_DIMENSION_BIG];
         
-    double outg[MAX_ENTRIES][MAX_DIMENSION_BIG];
+    T outg[MAX_ENTRIES][MAX_DIMENSION_BIG];
 
     // handled below automatically
     int alls= all_same_d(data, numEntries, dimension); 
@@ -756,7 +807,7 @@ double BC7BlockEncoder::ep_shaker_2_d(
         int p, q;
         int p0=-1,q0=-1;
         
-        double err_0 = DBL_MAX;
+        T err_0 = std::numeric_limits<T>::max();
 
 #ifdef USE_DBGTRACE
         DbgTrace(("Mi [%2d] numEntries [%2d]",Mi,numEntries));
@@ -764,7 +815,7 @@ double BC7BlockEncoder::ep_shaker_2_d(
 
         if (Mi==0)
         {
-            double t;
+            T t;
             // either single point from the beginning or collapsed index
             if (alls)
             {
@@ -793,8 +844,8 @@ double BC7BlockEncoder::ep_shaker_2_d(
 
             for(j=0;j<dimension;j++)
             {
-                epo[0][j]= ramp[CLT(clog3)][BTT(max_bits[j])][epo_code[0][j]][epo_code[1][j]][0];
-                epo[1][j]= ramp[CLT(clog3)][BTT(max_bits[j])][epo_code[0][j]][epo_code[1][j]][(1<<clog3)-1];
+                epo[0][j]= ramp_row<T>(clog3, max_bits[j], epo_code[0][j], epo_code[1][j])[0];
+                epo[1][j]= ramp_row<T>(clog3, max_bits[j], epo_code[0][j], epo_code[1][j])[(1<<clog3)-1];
             }
 
             return err_o;
@@ -815,18 +866,18 @@ double BC7BlockEncoder::ep_shaker_2_d(
                 for (k=0;k<numEntries;k++)
                     cidx[k]=index[k] * q + p;
 
-            double epa[2][MAX_DIMENSION_BIG];
+            T epa[2][MAX_DIMENSION_BIG];
 
             {
                 //
                 // solve RMS problem for center
                 //
 
-                double im [2][2] = {{0,0},{0,0}};   // matrix /inverse matrix
-                double rp[2][MAX_DIMENSION_BIG];            // right part for RMS fit problem
+                T im [2][2] = {{0,0},{0,0}};   // matrix /inverse matrix
+                T rp[2][MAX_DIMENSION_BIG];            // right part for RMS fit problem
 
                 // get ideal clustr centers
-                double cc[MAX_CLUSTERS_BIG][MAX_DIMENSION_BIG];
+                T cc[MAX_CLUSTERS_BIG][MAX_DIMENSION_BIG];
                 int i_cnt[MAX_CLUSTERS_BIG]; // count of index entries
                 int i_comp[MAX_CLUSTERS_BIG];   // compacted index
                 int ncl;                        // number of unique indexes
@@ -856,7 +907,7 @@ double BC7BlockEncoder::ep_shaker_2_d(
                     }
                 }
 
-                double dd = im[0][0]*im[1][1]-im[0][1]*im[0][1];
+                T dd = im[0][0]*im[1][1]-im[0][1]*im[0][1];
 
                 assert(dd !=0);
 
@@ -878,16 +929,14 @@ double BC7BlockEncoder::ep_shaker_2_d(
             // shake odd/odd and even/even or                    - same parity
             // shake odd/odd odd/even , even/odd and even/even   - bcc
 
-            double err_1 = DBL_MAX;
+            T err_1 = std::numeric_limits<T>::max();
             int epo_1[2][MAX_DIMENSION_BIG];
             
-            double ed[2][2][MAX_DIMENSION_BIG];
+            T ed[2][2][MAX_DIMENSION_BIG];
             int epo_2_[2][2][2][MAX_DIMENSION_BIG];
 
             for (j=0;j<dimension;j++)
             {
-                double  (*rb) [256][16] =ramp[CLT(clog3)][BTT(max_bits[j])];
-
                 int pp[2]={0,0};
                 int rr = (use_par ? 2:1);
 
@@ -907,13 +956,13 @@ double BC7BlockEncoder::ep_shaker_2_d(
                         }
                         int p1,p2, step=(1<<use_par);
 
-                        ed[pp[0]][pp[1]][j]=DBL_MAX;
+                        ed[pp[0]][pp[1]][j]=std::numeric_limits<T>::max();
 
                         for (p1=epi[0][0];p1<=epi[0][1];p1+=step) 
                             for (p2=epi[1][0];p2<=epi[1][1];p2+=step)
                             {
-                                double *rbp = rb[p1][p2];
-                                double t=0;
+                                T *rbp = ramp_row<T>(clog3, max_bits[j], p1, p2);
+                                T t=0;
                                 int    *ci=cidx;
                                 int    m =numEntries;
 
@@ -942,7 +991,7 @@ double BC7BlockEncoder::ep_shaker_2_d(
             {
                 pv = par_vectors_nd[dimension][type][pn]; 
                 int j1;
-                double err_2=0;
+                T err_2=0;
                 for (j1=0;j1<dimension;j1++) 
                     err_2+=ed[pv[0][j1]][pv[1][j1]][j1];
                 if (err_2 < err_1) {
@@ -973,23 +1022,23 @@ double BC7BlockEncoder::ep_shaker_2_d(
 #endif
 
         // requantize
-        double *r[MAX_DIMENSION_BIG];
+        T *r[MAX_DIMENSION_BIG];
         int idg[MAX_ENTRIES];
 
-        double err_r=0;
+        T err_r=0;
 
         for (j=0;j<dimension;j++) 
-            r[j]= ramp[CLT(clog3)][BTT(max_bits[j])][epo_0[0][j]][epo_0[1][j]];
+            r[j]= ramp_row<T>(clog3, max_bits[j], epo_0[0][j], epo_0[1][j]);
 
         for (i=0;i<numEntries;i++)
         {
-            double  cmin = DBL_MAX;
+            T  cmin = std::numeric_limits<T>::max();
             int        ci = 0;
-            double    *d=data[i];
+            T    *d=data[i];
 
             for(j=0; j < (1<<clog3); j++)
             {
-                double t_=0.;
+                T t_=0.;
 
                 for(k=0;k<dimension;k++)
                 {
@@ -1040,8 +1089,8 @@ double BC7BlockEncoder::ep_shaker_2_d(
 
     for(j=0;j<dimension;j++)
     {
-        epo[0][j]= ramp[CLT(clog3)][BTT(max_bits[j])][epo_code[0][j]][epo_code[1][j]][0];
-        epo[1][j]= ramp[CLT(clog3)][BTT(max_bits[j])][epo_code[0][j]][epo_code[1][j]][(1<<clog3)-1];
+        epo[0][j]= ramp_row<T>(clog3, max_bits[j], epo_code[0][j], epo_code[1][j])[0];
+        epo[1][j]= ramp_row<T>(clog3, max_bits[j], epo_code[0][j], epo_code[1][j])[(1<<clog3)-1];
     }
 
     return err_o;
@@ -1050,11 +1099,12 @@ double BC7BlockEncoder::ep_shaker_2_d(
 
 
 
-double BC7BlockEncoder::ep_shaker_d(
-    double data[MAX_ENTRIES][MAX_DIMENSION_BIG], 
+template <typename T>
+T BC7BlockEncoder::ep_shaker_d(
+    T data[MAX_ENTRIES][MAX_DIMENSION_BIG], 
     int numEntries, 
     int index_[MAX_ENTRIES],
-    double out[MAX_ENTRIES][MAX_DIMENSION_BIG],
+    T out[MAX_ENTRIES][MAX_DIMENSION_BIG],
     int epo_code[2][MAX_DIMENSION_BIG],
     int Mi_,                // last cluster
     int bits[3],            // including parity
@@ -1079,7 +1129,7 @@ double BC7BlockEncoder::ep_shaker_d(
 
     //###########################
 
-    double mean[MAX_DIMENSION_BIG];
+    T mean[MAX_DIMENSION_BIG];
     int index[MAX_ENTRIES];
     int Mi;
 
@@ -1093,7 +1143,7 @@ double BC7BlockEncoder::ep_shaker_d(
 
     int better;  
 
-    double err_o = DBL_MAX;
+    T err_o = std::numeric_limits<T>::max();
 
     // handled below automatically
     int alls= all_same_d(data, numEntries, dimension); 
@@ -1108,13 +1158,13 @@ double BC7BlockEncoder::ep_shaker_d(
         int p, q;
         int p0=-1,q0=-1;
         
-        double err_2 = DBL_MAX;
-        double out_2[MAX_ENTRIES][MAX_DIMENSION_BIG];
+        T err_2 = std::numeric_limits<T>::max();
+        T out_2[MAX_ENTRIES][MAX_DIMENSION_BIG];
         int idx_2[MAX_ENTRIES];
         int    epo_2[2][MAX_DIMENSION_BIG];
 
         if (Mi==0) {
-            double t;
+            T t;
             int    epo_0[2][MAX_DIMENSION_BIG];
             // either sinle point from the beginning or collapsed index
             if (alls) {
@@ -1157,17 +1207,17 @@ double BC7BlockEncoder::ep_shaker_d(
                     cidx[k]=index[k] * q + p;
                 }
 
-                double epa[2][MAX_DIMENSION_BIG];
+                T epa[2][MAX_DIMENSION_BIG];
 
                 {   //
                     // solve RMS problem for center
                     //
 
-                    double im [2][2] = {{0,0},{0,0}};   // matrix /inverse matrix
-                    double rp[2][MAX_DIMENSION_BIG];            // right part for RMS fit problem
+                    T im [2][2] = {{0,0},{0,0}};   // matrix /inverse matrix
+                    T rp[2][MAX_DIMENSION_BIG];            // right part for RMS fit problem
 
                     // get ideal clustr centers
-                    double cc[MAX_CLUSTERS_BIG][MAX_DIMENSION_BIG];
+                    T cc[MAX_CLUSTERS_BIG][MAX_DIMENSION_BIG];
                     int i_cnt[MAX_CLUSTERS_BIG]; // count of index entries
                     int i_comp[MAX_CLUSTERS_BIG];   // compacted index
                     int ncl;                        // number of unique indexes
@@ -1199,7 +1249,7 @@ double BC7BlockEncoder::ep_shaker_d(
                         }
                     }
 
-                    double dd = im[0][0]*im[1][1]-im[0][1]*im[0][1];
+                    T dd = im[0][0]*im[1][1]-im[0][1]*im[0][1];
 
                     assert(dd !=0);
 
@@ -1221,8 +1271,8 @@ double BC7BlockEncoder::ep_shaker_d(
                 // shake odd/odd odd/even , even/odd and even/even   - bcc
                 int odd,flip1;
 
-                double err_1 = DBL_MAX;
-                double out_1[MAX_ENTRIES][MAX_DIMENSION_BIG];
+                T err_1 = std::numeric_limits<T>::max();
+                T out_1[MAX_ENTRIES][MAX_DIMENSION_BIG];
                 int idx_1[MAX_ENTRIES];
                 int epo_1[2][MAX_DIMENSION_BIG];
                 int s1 = 0;       
@@ -1245,24 +1295,30 @@ double BC7BlockEncoder::ep_shaker_d(
                             }
                         }
 
-                        double *r[MAX_DIMENSION_BIG];
+                        T *r[MAX_DIMENSION_BIG];
 
-                        double ce[MAX_ENTRIES][MAX_CLUSTERS_BIG][MAX_DIMENSION_BIG];
+                        T ce[MAX_ENTRIES][MAX_CLUSTERS_BIG][MAX_DIMENSION_BIG];
 
                         for (j=0;j<dimension;j++) 
-                            r[j]= ramp[CLT(clog4)][BTT(bits[j])][epi[0][j][0]][epi[1][j][0]];
+                            r[j]= ramp_row<T>(clog4, bits[j], epi[0][j][0], epi[1][j][0]);
 
-                        double err_0 = 0;
-                        double out_0[MAX_ENTRIES][MAX_DIMENSION_BIG];
+                        T err_0 = 0;
+                        T out_0[MAX_ENTRIES][MAX_DIMENSION_BIG];
                         int idx_0[MAX_ENTRIES];
 
 
                         for(i=0;i<numEntries;i++)
                         {
-                            double *d=data[i];
+                            T *d=data[i];
                             for(j=0;j<(1<<clog4);j++)
+                            {
                                 for(k=0;k<dimension;k++)
                                     ce[i][j][k] = (r[k][j]-d[k])*(r[k][j]-d[k]);
+                                // Unused channels stay zero so the distance below can always sum
+                                // all MAX_DIMENSION_BIG lanes, adding zeros does not change it
+                                for(;k<MAX_DIMENSION_BIG;k++)
+                                    ce[i][j][k] = 0;
+                            }
                         }
 
                         int s=0, p1, g; 
@@ -1288,22 +1344,22 @@ double BC7BlockEncoder::ep_shaker_d(
                                 }
                             }
                             s = s ^ g;
-                            r[j0]= ramp[CLT(clog4)][BTT(bits[j0])][epi[0][j0][ei0]][epi[1][j0][ei1]];
+                            r[j0]= ramp_row<T>(clog4, bits[j0], epi[0][j0][ei0], epi[1][j0][ei1]);
 
                             err_0 = 0;
 
                             for (i=0;i<numEntries;i++)
                             {
-                                double *d=data[i];
+                                T *d=data[i];
                                 int    ci = 0;
-                                double cmin = DBL_MAX;
+                                T cmin = std::numeric_limits<T>::max();
 
                                 for(j=0;j<(1<<clog4);j++)
                                 {
-                                    double t_ = 0.;
+                                    T t_ = 0.;
                                     ce[i][j][j0] = (r[j0][j]-d[j0])*(r[j0][j]-d[j0]);
 
-                                    for(k=0;k<dimension;k++)
+                                    for(k=0;k<MAX_DIMENSION_BIG;k++)
                                     {
                                         t_ += ce[i][j][k];
                                     }
@@ -1406,4 +1462,16 @@ double BC7BlockEncoder::ep_shaker_d(
     return err_o;
 }
 
-
+// Instantiations for the double and the single precision encoders
+template double BC7BlockEncoder::ep_shaker_2_d(double data[MAX_ENTRIES][MAX_DIMENSION_BIG], int numEntries, int index_[MAX_ENTRIES],
+                                               double out[MAX_ENTRIES][MAX_DIMENSION_BIG], int epo_code[2][MAX_DIMENSION_BIG], int size,
+                                               int Mi_, int bits, int dimension, double epo[2][MAX_DIMENSION_BIG]);
+template float  BC7BlockEncoder::ep_shaker_2_d(float data[MAX_ENTRIES][MAX_DIMENSION_BIG], int numEntries, int index_[MAX_ENTRIES],
+                                               float out[MAX_ENTRIES][MAX_DIMENSION_BIG], int epo_code[2][MAX_DIMENSION_BIG], int size,
+                                               int Mi_, int bits, int dimension, float epo[2][MAX_DIMENSION_BIG]);
+template double BC7BlockEncoder::ep_shaker_d(double data[MAX_ENTRIES][MAX_DIMENSION_BIG], int numEntries, int index_[MAX_ENTRIES],
+                                             double out[MAX_ENTRIES][MAX_DIMENSION_BIG], int epo_code[2][MAX_DIMENSION_BIG],
+                                             int Mi_, int bits[3], CMP_qt type, int dimension);
+template float  BC7BlockEncoder::ep_shaker_d(float data[MAX_ENTRIES][MAX_DIMENSION_BIG], int numEntries, int index_[MAX_ENTRIES],
+                                             float out[MAX_ENTRIES][MAX_DIMENSION_BIG], int epo_code[2][MAX_DIMENSION_BIG],
+                                             int Mi_, int bits[3], CMP_qt type, int dimension);
@@ -1,4 +1,5 @@
 void init_ramps (); 
+void init_ramps_f (); 
 
 
 double ep_shaker_2_( 
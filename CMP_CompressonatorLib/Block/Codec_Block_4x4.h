@@ -49,6 +49,7 @@ public:
                                         CMP_DWORD dwWidth, CMP_DWORD dwHeight, CMP_DWORD dwPitch = 0, CMP_BYTE* pData = 0,
                                         CMP_DWORD dwDataSize = 0) const;
 
+    virtual CMP_DWORD GetBlockWidth()  {return 4;};
     virtual CMP_DWORD GetBlockHeight() {return 4;};
 
 protected:
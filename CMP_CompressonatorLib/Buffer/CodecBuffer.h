@@ -355,6 +355,17 @@ public:
     virtual bool ReadBlock(CMP_DWORD x, CMP_DWORD y, CMP_DWORD* pBlock, CMP_DWORD dwBlockSize);
     virtual bool WriteBlock(CMP_DWORD x, CMP_DWORD y, CMP_DWORD* pBlock, CMP_DWORD dwBlockSize);
 
+    // Reads or writes nBlocks 4x4 RGBA blocks lying side by side from (x, y), packed one after
+    // the other in the same layout as ReadBlockRGBA / WriteBlockRGBA. The buffer type is checked
+    // once per row; RGBA8888, RGBA16F and RGBA32F rows are converted directly, everything else
+    // and partial edge blocks go through the per block virtual calls. Views over another
+    // buffer override the reads to convert whole rows.
+    virtual bool ReadBlockRowRGBA(CMP_DWORD x, CMP_DWORD y, CMP_DWORD nBlocks, CMP_BYTE cBlocks[]);
+    bool WriteBlockRowRGBA(CMP_DWORD x, CMP_DWORD y, CMP_DWORD nBlocks, CMP_BYTE cBlocks[]);
+
+    virtual bool ReadBlockRowRGBA(CMP_DWORD x, CMP_DWORD y, CMP_DWORD nBlocks, float fBlocks[]);
+    bool WriteBlockRowRGBA(CMP_DWORD x, CMP_DWORD y, CMP_DWORD nBlocks, float fBlocks[]);
+
     inline CMP_BYTE* GetData() const {return m_pData;}; 
     inline CMP_DWORD GetDataSize() const {return m_DataSize;};
 
@@ -419,7 +430,9 @@ protected:
     CMP_BYTE* m_pData;
     CMP_DWORD m_DataSize;
 
-    bool m_bPerformingConversion;
+    // Recursion guard for the format conversion fallbacks, kept per thread so
+    // several pool workers can read blocks from the same buffer at once
+    static thread_local bool m_bPerformingConversion;
 };
 
 CCodecBuffer*   CreateCodecBuffer(CodecBufferType nCodecBufferType, 
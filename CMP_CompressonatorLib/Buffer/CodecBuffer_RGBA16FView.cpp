@@ -0,0 +1,136 @@
+//===============================================================================
+// Copyright (c) 2007-2016  Advanced Micro Devices, Inc. All rights reserved.
+// Copyright (c) 2004-2006 ATI Technologies Inc.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//
+//  File Name:   CodecBuffer_RGBA16FView.cpp
+//  Description: implementation of the CCodecBuffer_RGBA16FView class
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "Common.h"
+#include "CodecBuffer_RGBA16FView.h"
+
+#define VIEW_ROW_BLOCKS 16
+
+// Byte to half float, as a float, for every byte value
+static const float* GetByteToHalfTable()
+{
+    static const struct ByteToHalfTable
+    {
+        float fValue[256];
+        ByteToHalfTable()
+        {
+            for (int i = 0; i < 256; i++)
+                fValue[i] = (float) CMP_HALF(float(i / 255.0f));
+        }
+    } table;
+    return table.fValue;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////////////
+
+CCodecBuffer_RGBA16FView::CCodecBuffer_RGBA16FView(CCodecBuffer* pSource)
+    : CCodecBuffer(pSource->GetBlockWidth(), pSource->GetBlockHeight(), pSource->GetBlockDepth(),
+                   pSource->GetWidth(), pSource->GetHeight(), pSource->GetPitch(), pSource->GetData(), pSource->GetDataSize())
+{
+    m_pSource = pSource;
+}
+
+CCodecBuffer_RGBA16FView::~CCodecBuffer_RGBA16FView()
+{
+    delete m_pSource;
+}
+
+bool CCodecBuffer_RGBA16FView::ReadBlockRGBA(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, float block[])
+{
+    assert(w * h <= BLOCK_SIZE_8X8);
+    if (w * h > BLOCK_SIZE_8X8)
+        return false;
+
+    // The source may need its own conversion to bytes, even when this read is part of one
+    CMP_BYTE cBlock[BLOCK_SIZE_8X8X4];
+    bool bPerformingConversion = m_bPerformingConversion;
+    m_bPerformingConversion = false;
+    bool bRead = m_pSource->ReadBlockRGBA(x, y, w, h, cBlock);
+    m_bPerformingConversion = bPerformingConversion;
+    if (!bRead)
+        return false;
+
+    const float* pfTable = GetByteToHalfTable();
+    for (CMP_DWORD i = 0; i < (CMP_DWORD) (w * h * 4); i++)
+        block[i] = pfTable[cBlock[i]];
+
+    return true;
+}
+
+bool CCodecBuffer_RGBA16FView::ReadBlock(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, float block[], CMP_DWORD dwChannelIndex)
+{
+    float fBlock[BLOCK_SIZE_8X8X4];
+    if (!ReadBlockRGBA(x, y, w, h, fBlock))
+        return false;
+
+    for (CMP_DWORD i = 0; i < (CMP_DWORD) (w * h); i++)
+        block[i] = fBlock[(i * 4) + dwChannelIndex];
+
+    return true;
+}
+
+bool CCodecBuffer_RGBA16FView::ReadBlockA(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, float block[])
+{
+    return ReadBlock(x, y, w, h, block, RGBA16F_OFFSET_A);
+}
+
+bool CCodecBuffer_RGBA16FView::ReadBlockR(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, float block[])
+{
+    return ReadBlock(x, y, w, h, block, RGBA16F_OFFSET_R);
+}
+
+bool CCodecBuffer_RGBA16FView::ReadBlockG(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, float block[])
+{
+    return ReadBlock(x, y, w, h, block, RGBA16F_OFFSET_G);
+}
+
+bool CCodecBuffer_RGBA16FView::ReadBlockB(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, float block[])
+{
+    return ReadBlock(x, y, w, h, block, RGBA16F_OFFSET_B);
+}
+
+bool CCodecBuffer_RGBA16FView::ReadBlockRowRGBA(CMP_DWORD x, CMP_DWORD y, CMP_DWORD nBlocks, float fBlocks[])
+{
+    // Read the byte row a few blocks at a time so the source is only ever converted on the stack
+    const float* pfTable = GetByteToHalfTable();
+    CMP_BYTE cBlocks[VIEW_ROW_BLOCKS * BLOCK_SIZE_4X4X4];
+    for (CMP_DWORD i = 0; i < nBlocks; i += VIEW_ROW_BLOCKS)
+    {
+        CMP_DWORD dwBlocks = min(nBlocks - i, (CMP_DWORD) VIEW_ROW_BLOCKS);
+        if (!m_pSource->ReadBlockRowRGBA(x + (i * BLOCK_SIZE_4), y, dwBlocks, cBlocks))
+            return false;
+
+        float* pfBlocks = &fBlocks[i * BLOCK_SIZE_4X4X4];
+        for (CMP_DWORD j = 0; j < dwBlocks * BLOCK_SIZE_4X4X4; j++)
+            pfBlocks[j] = pfTable[cBlocks[j]];
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+//===============================================================================
+// Copyright (c) 2007-2016  Advanced Micro Devices, Inc. All rights reserved.
+// Copyright (c) 2004-2006 ATI Technologies Inc.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//  File Name:   CodecBuffer_RGBA16FView.h
+//  Description: interface for the CCodecBuffer_RGBA16FView class
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CODECBUFFER_RGBA16FVIEW_H_INCLUDED_
+#define _CODECBUFFER_RGBA16FVIEW_H_INCLUDED_
+
+#include "CodecBuffer.h"
+
+// A read only half float RGBA view of an 8 bit buffer for the HDR codecs. Each block is
+// read from the source buffer and every channel is expanded to b / 255 rounded to half
+// precision, the values the codec would see in a RGBA16F copy of the image.
+class CCodecBuffer_RGBA16FView : public CCodecBuffer
+{
+public:
+    CCodecBuffer_RGBA16FView(CCodecBuffer* pSource);
+    virtual ~CCodecBuffer_RGBA16FView();
+
+    virtual CodecBufferType GetBufferType() const {return CBT_RGBA16F;};
+    virtual CMP_DWORD GetChannelDepth() const {return 16;};
+    virtual CMP_DWORD GetChannelCount() const {return 4;};
+    virtual bool IsFloat() const {return true;};
+
+    virtual bool ReadBlockR(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, float block[]);
+    virtual bool ReadBlockG(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, float block[]);
+    virtual bool ReadBlockB(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, float block[]);
+    virtual bool ReadBlockA(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, float block[]);
+
+    virtual bool ReadBlockRGBA(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, float block[]);
+
+    virtual bool ReadBlockRowRGBA(CMP_DWORD x, CMP_DWORD y, CMP_DWORD nBlocks, float fBlocks[]);
+
+protected:
+    bool ReadBlock(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, float block[], CMP_DWORD dwChannelIndex);
+
+    CCodecBuffer* m_pSource;
+};
+
+#endif // !defined(_CODECBUFFER_RGBA16FVIEW_H_INCLUDED_)
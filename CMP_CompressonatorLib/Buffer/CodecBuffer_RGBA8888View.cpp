@@ -0,0 +1,336 @@
+//===============================================================================
+// Copyright (c) 2007-2016  Advanced Micro Devices, Inc. All rights reserved.
+// Copyright (c) 2004-2006 ATI Technologies Inc.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//
+//  File Name:   CodecBuffer_RGBA8888View.cpp
+//  Description: implementation of the CCodecBuffer_RGBA8888View class
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "Common.h"
+#include "CodecBuffer_RGBA8888View.h"
+#include <math.h>
+#include <float.h>
+#include <string.h>
+
+#define VIEW_ROW_BLOCKS 16
+
+//////////////////////////////////////////////////////////////////////////////
+// Tone mapping
+//////////////////////////////////////////////////////////////////////////////
+
+static inline float clamp(float a, float l, float h)
+{
+    return (a < l) ? l : ((a > h) ? h : a);
+}
+
+static inline float knee(double x, double f)
+{
+    return float(log(x * f + 1.f) / f);
+}
+
+static float findKneeValue(float x, float y)
+{
+    float f0 = 0;
+    float f1 = 1.f;
+
+    while (knee(x, f1) > y) {
+        f0 = f1;
+        f1 = f1 * 2.f;
+    }
+
+    for (int i = 0; i < 30; ++i) {
+        const float f2 = (f0 + f1) / 2.f;
+        const float y2 = knee(x, f2);
+
+        if (y2 < y) {
+            f1 = f2;
+        }
+        else {
+            f0 = f2;
+        }
+    }
+
+    return (f0 + f1) / 2.f;
+}
+
+static inline float ToneMapChannel(float c, float fGamma, const ToneMapParams& params)
+{
+    //  1) Compensate for fogging by subtracting defog
+    //     from the raw pixel values.
+    if (params.fDefog > 0.0)
+        c = c - params.fDefog;
+
+    //  2) Multiply the defogged pixel values by
+    //     2^(exposure + 2.47393).
+    //  3) Values that are now 1.0 are called "middle gray".
+    //     If defog and exposure are both set to 0.0, then
+    //     middle gray corresponds to a raw pixel value of 0.18.
+    c = c * params.fExposeScale;
+
+    //  4) Apply a knee function. Pixel values below 2^kneeLow are
+    //     not changed, values above are lowered according to a
+    //     logarithmic curve, such that the value 2^kneeHigh is
+    //     mapped to 2^3.5.
+    if (c > params.fKneeLow)
+        c = params.fKneeLow + knee(c - params.fKneeLow, params.fKneeScale);
+
+    //  5) Gamma-correct the pixel values, according to the
+    //     screen's gamma.
+    c = powf(c, fGamma);
+
+    //  6) Scale the values such that middle gray pixels are
+    //     mapped to a frame buffer value that is 3.5 f-stops
+    //     below the display's maximum intensity.
+    c *= params.fScale;
+
+    return clamp(c, 0.f, 255.f);
+}
+
+static inline float FloatFromBits(CMP_DWORD dwBits)
+{
+    float f;
+    memcpy(&f, &dwBits, sizeof(f));
+    return f;
+}
+
+static inline CMP_DWORD BitsFromFloat(float f)
+{
+    CMP_DWORD dwBits;
+    memcpy(&dwBits, &f, sizeof(dwBits));
+    return dwBits;
+}
+
+// Finds the smallest input above fMin that tone maps to each of the bytes 1 to 255.
+// Positive floats order the same as their bit patterns, so each threshold is a
+// bisection over the bits between fMin and infinity.
+static bool BuildThresholds(float fThreshold[255], float fMin, float fGamma, const ToneMapParams& params)
+{
+    const CMP_DWORD dwMin = BitsFromFloat(fMin);
+    const CMP_DWORD dwInf = 0x7F800000;
+    if ((CMP_BYTE) ToneMapChannel(FloatFromBits(dwInf), fGamma, params) != 255)
+        return false;
+
+    CMP_DWORD dwLow = dwMin;
+    for (int k = 1; k < 256; k++)
+    {
+        // byte(dwLow) < k <= byte(dwHigh), dwLow == dwMin stands for "nothing below"
+        CMP_DWORD dwHigh = dwInf;
+        while (dwHigh - dwLow > 1)
+        {
+            CMP_DWORD dwMid = dwLow + (dwHigh - dwLow) / 2;
+            if ((CMP_BYTE) ToneMapChannel(FloatFromBits(dwMid), fGamma, params) >= k)
+                dwHigh = dwMid;
+            else
+                dwLow = dwMid;
+        }
+        fThreshold[k - 1] = FloatFromBits(dwHigh);
+    }
+    return true;
+}
+
+void GetToneMapParams(const CMP_CompressOptions* pOptions, ToneMapParams& params)
+{
+    float fDefog    = AMD_CODEC_DEFOG_DEFAULT;
+    float fExposure = AMD_CODEC_EXPOSURE_DEFAULT;
+    float fKneeLow  = AMD_CODEC_KNEELOW_DEFAULT;
+    float fKneeHigh = AMD_CODEC_KNEEHIGH_DEFAULT;
+    float fGamma    = AMD_CODEC_GAMMA_DEFAULT;
+    if (pOptions && pOptions->dwSize == sizeof(CMP_CompressOptions))
+    {
+        fDefog    = pOptions->fInputDefog;
+        fExposure = pOptions->fInputExposure;
+        fKneeLow  = pOptions->fInputKneeLow;
+        fKneeHigh = pOptions->fInputKneeHigh;
+        fGamma    = pOptions->fInputGamma;
+    }
+
+    // Every tile and mip level of a texture asks for the same settings, keep the last
+    // tables so they are only built once
+    const float fSettings[5] = {fDefog, fExposure, fKneeLow, fKneeHigh, fGamma};
+    static thread_local float fLastSettings[5];
+    static thread_local bool bLastValid = false;
+    static thread_local ToneMapParams lastParams;
+    if (bLastValid && memcmp(fSettings, fLastSettings, sizeof(fSettings)) == 0)
+    {
+        params = lastParams;
+        return;
+    }
+
+    params.fDefog       = fDefog;
+    params.fExposeScale = powf(2, fExposure + 2.47393f);
+    params.fKneeLow     = powf(2.f, fKneeLow);
+    params.fKneeScale   = findKneeValue(powf(2.f, fKneeHigh) - params.fKneeLow, powf(2.f, 3.5f) - params.fKneeLow);
+    params.fGamma       = fGamma;
+    params.fInvGamma    = 1 / fGamma;
+    // always assume max intensity is 1 and 3.5f darker for scale later
+    params.fScale       = (float)255.0 * powf(powf(2, -3.5), params.fInvGamma);
+
+    // Above fLUTMin the defogged and exposed value is positive, so every step of the
+    // curve rises with the input as long as the exposure, knee and gamma are positive
+    params.fLUTMin  = (fDefog > 0.0) ? fDefog : 0.f;
+    params.bUseLUT  = (params.fLUTMin < FLT_MAX) &&
+                      (params.fExposeScale >= 0.f) && (params.fExposeScale <= FLT_MAX) &&
+                      (params.fKneeScale > 0.f)    && (params.fKneeScale <= FLT_MAX) &&
+                      (fGamma > 0.f)               && (fGamma <= FLT_MAX) &&
+                      (params.fInvGamma <= FLT_MAX);
+    if (params.bUseLUT)
+        params.bUseLUT = BuildThresholds(params.fThresholdRGB, params.fLUTMin, params.fInvGamma, params) &&
+                         BuildThresholds(params.fThresholdA, params.fLUTMin, params.fGamma, params);
+
+    memcpy(fLastSettings, fSettings, sizeof(fSettings));
+    lastParams = params;
+    bLastValid = true;
+}
+
+// Number of thresholds that do not exceed c, a fixed eight step binary search
+static inline CMP_BYTE LookupThreshold(float c, const float fThreshold[255])
+{
+    CMP_DWORD dwPos = 0;
+    for (CMP_DWORD dwStep = 128; dwStep > 0; dwStep >>= 1)
+        dwPos += (fThreshold[dwPos + dwStep - 1] <= c) ? dwStep : 0;
+    return (CMP_BYTE) dwPos;
+}
+
+static inline CMP_BYTE ToneMapByte(float c, float fGamma, const float fThreshold[255], const ToneMapParams& params)
+{
+    if (params.bUseLUT && c > params.fLUTMin)
+        return LookupThreshold(c, fThreshold);
+    return (CMP_BYTE) ToneMapChannel(c, fGamma, params);
+}
+
+// Tone maps one RGBA float pixel to a RGBA8888 dword, R in the lowest byte
+static inline CMP_DWORD ToneMapPixel(const float fPixel[4], const ToneMapParams& params)
+{
+    CMP_BYTE r = ToneMapByte(fPixel[0], params.fInvGamma, params.fThresholdRGB, params);
+    CMP_BYTE g = ToneMapByte(fPixel[1], params.fInvGamma, params.fThresholdRGB, params);
+    CMP_BYTE b = ToneMapByte(fPixel[2], params.fInvGamma, params.fThresholdRGB, params);
+    CMP_BYTE a = ToneMapByte(fPixel[3], params.fGamma, params.fThresholdA, params);
+    return ((CMP_DWORD) r) | ((CMP_DWORD) g << 8) | ((CMP_DWORD) b << 16) | ((CMP_DWORD) a << 24);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Construction/Destruction
+//////////////////////////////////////////////////////////////////////////////
+
+CCodecBuffer_RGBA8888View::CCodecBuffer_RGBA8888View(CCodecBuffer* pSource, const ToneMapParams& toneMap)
+    : CCodecBuffer(pSource->GetBlockWidth(), pSource->GetBlockHeight(), pSource->GetBlockDepth(),
+                   pSource->GetWidth(), pSource->GetHeight(), pSource->GetPitch(), pSource->GetData(), pSource->GetDataSize())
+{
+    m_pSource = pSource;
+    m_ToneMap = toneMap;
+}
+
+CCodecBuffer_RGBA8888View::~CCodecBuffer_RGBA8888View()
+{
+    delete m_pSource;
+}
+
+bool CCodecBuffer_RGBA8888View::ReadPixels(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_DWORD dwBlock[])
+{
+    assert(w * h <= BLOCK_SIZE_8X8);
+    if (w * h > BLOCK_SIZE_8X8)
+        return false;
+
+    // The source may need its own conversion to float, even when this read is part of one
+    float fBlock[BLOCK_SIZE_8X8X4];
+    bool bPerformingConversion = m_bPerformingConversion;
+    m_bPerformingConversion = false;
+    bool bRead = m_pSource->ReadBlockRGBA(x, y, w, h, fBlock);
+    m_bPerformingConversion = bPerformingConversion;
+    if (!bRead)
+        return false;
+
+    for (CMP_DWORD i = 0; i < (CMP_DWORD) (w * h); i++)
+        dwBlock[i] = ToneMapPixel(&fBlock[i * 4], m_ToneMap);
+
+    return true;
+}
+
+bool CCodecBuffer_RGBA8888View::ReadBlock(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_BYTE block[], CMP_DWORD dwChannelOffset)
+{
+    CMP_DWORD dwBlock[BLOCK_SIZE_8X8];
+    if (!ReadPixels(x, y, w, h, dwBlock))
+        return false;
+
+    for (CMP_DWORD i = 0; i < (CMP_DWORD) (w * h); i++)
+        block[i] = static_cast<CMP_BYTE>((dwBlock[i] >> dwChannelOffset) & BYTE_MASK);
+
+    return true;
+}
+
+bool CCodecBuffer_RGBA8888View::ReadBlockA(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_BYTE block[])
+{
+    return ReadBlock(x, y, w, h, block, RGBA8888_OFFSET_A);
+}
+
+bool CCodecBuffer_RGBA8888View::ReadBlockR(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_BYTE block[])
+{
+    return ReadBlock(x, y, w, h, block, RGBA8888_OFFSET_R);
+}
+
+bool CCodecBuffer_RGBA8888View::ReadBlockG(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_BYTE block[])
+{
+    return ReadBlock(x, y, w, h, block, RGBA8888_OFFSET_G);
+}
+
+bool CCodecBuffer_RGBA8888View::ReadBlockB(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_BYTE block[])
+{
+    return ReadBlock(x, y, w, h, block, RGBA8888_OFFSET_B);
+}
+
+bool CCodecBuffer_RGBA8888View::ReadBlockRGBA(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_BYTE block[])
+{
+    CMP_DWORD* pdwBlock = (CMP_DWORD*) block;
+    if (!ReadPixels(x, y, w, h, pdwBlock))
+        return false;
+
+    // The codec reqiures a BGRA8888 block
+    if (m_bSwizzle)
+    {
+        for (CMP_DWORD i = 0; i < (CMP_DWORD) (w * h); i++)
+            pdwBlock[i] = SWIZZLE_RGBA_BGRA(pdwBlock[i]);
+    }
+
+    return true;
+}
+
+bool CCodecBuffer_RGBA8888View::ReadBlockRowRGBA(CMP_DWORD x, CMP_DWORD y, CMP_DWORD nBlocks, CMP_BYTE cBlocks[])
+{
+    // Read the float row a few blocks at a time so the source is only ever converted on the stack
+    float fBlocks[VIEW_ROW_BLOCKS * BLOCK_SIZE_4X4X4];
+    for (CMP_DWORD i = 0; i < nBlocks; i += VIEW_ROW_BLOCKS)
+    {
+        CMP_DWORD dwBlocks = min(nBlocks - i, (CMP_DWORD) VIEW_ROW_BLOCKS);
+        if (!m_pSource->ReadBlockRowRGBA(x + (i * BLOCK_SIZE_4), y, dwBlocks, fBlocks))
+            return false;
+
+        CMP_DWORD* pdwBlocks = (CMP_DWORD*) &cBlocks[i * BLOCK_SIZE_4X4X4];
+        for (CMP_DWORD j = 0; j < dwBlocks * BLOCK_SIZE_4X4; j++)
+        {
+            CMP_DWORD dwPixel = ToneMapPixel(&fBlocks[j * 4], m_ToneMap);
+            pdwBlocks[j] = m_bSwizzle ? SWIZZLE_RGBA_BGRA(dwPixel) : dwPixel;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+//===============================================================================
+// Copyright (c) 2007-2016  Advanced Micro Devices, Inc. All rights reserved.
+// Copyright (c) 2004-2006 ATI Technologies Inc.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//  File Name:   CodecBuffer_RGBA8888View.h
+//  Description: interface for the CCodecBuffer_RGBA8888View class
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CODECBUFFER_RGBA8888VIEW_H_INCLUDED_
+#define _CODECBUFFER_RGBA8888VIEW_H_INCLUDED_
+
+#include "CodecBuffer.h"
+
+// Exposure, knee and gamma settings of the HDR to LDR tone map, derived once from
+// the fInput* members of CMP_CompressOptions by GetToneMapParams
+struct ToneMapParams
+{
+    float fDefog;
+    float fExposeScale;     // 2^(exposure + 2.47393)
+    float fKneeLow;         // 2^kneeLow, values below are not changed by the knee
+    float fKneeScale;       // Knee curve factor that maps 2^kneeHigh to 2^3.5
+    float fGamma;
+    float fInvGamma;
+    float fScale;           // Maps middle gray to 3.5 f-stops below 255
+
+    // The tone map only ever rises with the input above fLUTMin, so each output byte k
+    // is reached from a smallest input fThreshold[k - 1] and a byte is the number of
+    // thresholds that do not exceed the input. Inputs at or below fLUTMin, and all
+    // inputs when bUseLUT is false, go through the curve itself.
+    bool  bUseLUT;
+    float fLUTMin;
+    float fThresholdRGB[255];
+    float fThresholdA[255];
+};
+
+void GetToneMapParams(const CMP_CompressOptions* pOptions, ToneMapParams& params);
+
+// A read only 8 bit RGBA view of a float buffer. The view does not own any pixels, each
+// block is read from the source buffer and tone mapped as it is requested, so a float
+// image can be handed to the 8 bit codecs without a converted copy of it.
+// The bytes seen by the codecs are the same as CCodecBuffer_RGBA8888 holding the tone
+// mapped image with R, G, B, A in memory order.
+class CCodecBuffer_RGBA8888View : public CCodecBuffer
+{
+public:
+    CCodecBuffer_RGBA8888View(CCodecBuffer* pSource, const ToneMapParams& toneMap);
+    virtual ~CCodecBuffer_RGBA8888View();
+
+    virtual CodecBufferType GetBufferType() const {return CBT_RGBA8888;};
+    virtual CMP_DWORD GetChannelDepth() const {return 8;};
+    virtual CMP_DWORD GetChannelCount() const {return 4;};
+    virtual bool IsFloat() const {return false;};
+
+    virtual bool ReadBlockR(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_BYTE block[]);
+    virtual bool ReadBlockG(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_BYTE block[]);
+    virtual bool ReadBlockB(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_BYTE block[]);
+    virtual bool ReadBlockA(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_BYTE block[]);
+
+    virtual bool ReadBlockRGBA(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_BYTE block[]);
+
+    virtual bool ReadBlockRowRGBA(CMP_DWORD x, CMP_DWORD y, CMP_DWORD nBlocks, CMP_BYTE cBlocks[]);
+
+protected:
+    bool ReadPixels(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_DWORD dwBlock[]);
+    bool ReadBlock(CMP_DWORD x, CMP_DWORD y, CMP_BYTE w, CMP_BYTE h, CMP_BYTE block[], CMP_DWORD dwChannelOffset);
+
+    CCodecBuffer* m_pSource;
+    ToneMapParams m_ToneMap;
+};
+
+#endif // !defined(_CODECBUFFER_RGBA8888VIEW_H_INCLUDED_)
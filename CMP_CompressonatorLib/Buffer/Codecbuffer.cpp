@@ -48,6 +48,11 @@
 #include "CodecBuffer_R32F.h"
 #include "CodecBuffer_Block.h"
 #include "CodecBuffer_RGB9995EF.h"
+#include "CMP_HalfConvert.h"
+
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif // USE_SSE2
 
 
 CCodecBuffer* CreateCodecBuffer(CodecBufferType nCodecBufferType, 
@@ -208,6 +213,8 @@ CodecBufferType GetCodecBufferType(CMP_FORMAT format)
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
 
+thread_local bool CCodecBuffer::m_bPerformingConversion = false;
+
 CCodecBuffer::CCodecBuffer(
                             CMP_BYTE nBlockWidth, CMP_BYTE nBlockHeight, CMP_BYTE nBlockDepth,
                             CMP_DWORD dwWidth, CMP_DWORD dwHeight, CMP_DWORD dwPitch, CMP_BYTE* pData,CMP_DWORD dwDataSize)
@@ -227,7 +234,6 @@ CCodecBuffer::CCodecBuffer(
     m_bUserAllocedData  = (pData != NULL);
     m_DataSize          = dwDataSize;
 
-    m_bPerformingConversion = false;
     m_bSwizzle = false;
 }
 
@@ -2452,8 +2458,7 @@ void CCodecBuffer::ConvertBlock(float fBlock[], CMP_HALF hBlock[], CMP_DWORD dwB
     assert(dwBlockSize);
     if(fBlock && hBlock && dwBlockSize)
     {
-        for(CMP_DWORD i = 0; i < dwBlockSize; i++)
-            fBlock[i] = (float) hBlock[i];
+        CMP_HalfToFloat(fBlock, hBlock, dwBlockSize);
     }
 }
 
@@ -2532,8 +2537,7 @@ void CCodecBuffer::ConvertBlock(CMP_HALF hBlock[], float fBlock[], CMP_DWORD dwB
     assert(dwBlockSize);
     if(hBlock && fBlock && dwBlockSize)
     {
-        for(CMP_DWORD i = 0; i < dwBlockSize; i++)
-            hBlock[i] = (float) fBlock[i];
+        CMP_FloatToHalf(hBlock, fBlock, dwBlockSize);
     }
 }
 
@@ -2889,3 +2893,270 @@ void CCodecBuffer::SwizzleBlock(CMP_WORD wBlock[], CMP_DWORD dwBlockSize)
         for(CMP_DWORD i = 0; i < dwBlockSize; i++)
             SWAP_WORDS(wBlock[(i* 4)], wBlock[(i* 4) + 2]);
 }
+
+//////////////////////////////////////////////////////////////////////
+// Block row access
+//////////////////////////////////////////////////////////////////////
+
+#define ROW_BLOCK_LINE_SIZE (BLOCK_SIZE_4 * CHANNEL_SIZE_ARGB)
+
+// Number of blocks from (x, y) that lie wholly inside the buffer
+static CMP_DWORD GetWholeBlocksInRow(CMP_DWORD dwWidth, CMP_DWORD dwHeight, CMP_DWORD x, CMP_DWORD y, CMP_DWORD nBlocks)
+{
+    if((y + BLOCK_SIZE_4) > dwHeight)
+        return 0;
+    CMP_DWORD dwBlocks = (dwWidth - x) / BLOCK_SIZE_4;
+    return (dwBlocks < nBlocks) ? dwBlocks : nBlocks;
+}
+
+// The helpers below convert one 4 pixel line of a block
+
+static void CopyBlockLine(CMP_DWORD dwDst[], const CMP_DWORD dwSrc[], bool bSwizzle)
+{
+#ifdef USE_SSE2
+    __m128i v = _mm_loadu_si128((const __m128i*) dwSrc);
+    if(bSwizzle)
+    {
+        __m128i r = _mm_and_si128(_mm_slli_epi32(v, 16), _mm_set1_epi32(0x00FF0000));
+        __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), _mm_set1_epi32(0x000000FF));
+        v = _mm_or_si128(_mm_and_si128(v, _mm_set1_epi32(0xFF00FF00)), _mm_or_si128(r, b));
+    }
+    _mm_storeu_si128((__m128i*) dwDst, v);
+#else
+    if(bSwizzle)
+    {
+        for(int i = 0; i < BLOCK_SIZE_4; i++)
+            dwDst[i] = SWIZZLE_RGBA_BGRA(dwSrc[i]);
+    }
+    else
+        memcpy(dwDst, dwSrc, BLOCK_SIZE_4 * sizeof(CMP_DWORD));
+#endif
+}
+
+// Float to byte, swapping R and B the same way the ReadBlockRGBA(CMP_BYTE) conversion does
+static void ConvertBlockLine(CMP_BYTE cDst[], const float fSrc[])
+{
+#ifdef USE_SSE2
+    // CONVERT_FLOAT_TO_BYTE scales in float and rounds in double, so do the same here
+    const __m128  scale = _mm_set1_ps(BYTE_MAX_FLOAT);
+    const __m128d half  = _mm_set1_pd(0.5);
+    const __m128i mask  = _mm_set1_epi32(0xFF);
+    __m128i c[4];
+    for(int i = 0; i < BLOCK_SIZE_4; i++)
+    {
+        __m128 f = _mm_loadu_ps(&fSrc[i * CHANNEL_SIZE_ARGB]);
+        f = _mm_mul_ps(_mm_shuffle_ps(f, f, _MM_SHUFFLE(3, 0, 1, 2)), scale);
+        __m128i lo = _mm_cvttpd_epi32(_mm_add_pd(_mm_cvtps_pd(f), half));
+        __m128i hi = _mm_cvttpd_epi32(_mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(f, f)), half));
+        c[i] = _mm_and_si128(_mm_unpacklo_epi64(lo, hi), mask);
+    }
+    __m128i w0 = _mm_packs_epi32(c[0], c[1]);
+    __m128i w1 = _mm_packs_epi32(c[2], c[3]);
+    _mm_storeu_si128((__m128i*) cDst, _mm_packus_epi16(w0, w1));
+#else
+    for(int i = 0; i < ROW_BLOCK_LINE_SIZE; i += CHANNEL_SIZE_ARGB)
+    {
+        cDst[i + 0] = CONVERT_FLOAT_TO_BYTE(fSrc[i + 2]);
+        cDst[i + 1] = CONVERT_FLOAT_TO_BYTE(fSrc[i + 1]);
+        cDst[i + 2] = CONVERT_FLOAT_TO_BYTE(fSrc[i + 0]);
+        cDst[i + 3] = CONVERT_FLOAT_TO_BYTE(fSrc[i + 3]);
+    }
+#endif
+}
+
+// Byte to float, swapping R and B the same way the WriteBlockRGBA(CMP_BYTE) conversion does
+static void ConvertBlockLine(float fDst[], const CMP_BYTE cSrc[])
+{
+#ifdef USE_SSE2
+    const __m128  scale = _mm_set1_ps(BYTE_MAX_FLOAT);
+    const __m128i zero  = _mm_setzero_si128();
+    __m128i c  = _mm_loadu_si128((const __m128i*) cSrc);
+    __m128i w[2] = {_mm_unpacklo_epi8(c, zero), _mm_unpackhi_epi8(c, zero)};
+    for(int i = 0; i < BLOCK_SIZE_4; i++)
+    {
+        __m128i d = (i & 1) ? _mm_unpackhi_epi16(w[i >> 1], zero) : _mm_unpacklo_epi16(w[i >> 1], zero);
+        __m128  f = _mm_div_ps(_mm_cvtepi32_ps(d), scale);
+        _mm_storeu_ps(&fDst[i * CHANNEL_SIZE_ARGB], _mm_shuffle_ps(f, f, _MM_SHUFFLE(3, 0, 1, 2)));
+    }
+#else
+    for(int i = 0; i < ROW_BLOCK_LINE_SIZE; i += CHANNEL_SIZE_ARGB)
+    {
+        fDst[i + 0] = CONVERT_BYTE_TO_FLOAT(cSrc[i + 2]);
+        fDst[i + 1] = CONVERT_BYTE_TO_FLOAT(cSrc[i + 1]);
+        fDst[i + 2] = CONVERT_BYTE_TO_FLOAT(cSrc[i + 0]);
+        fDst[i + 3] = CONVERT_BYTE_TO_FLOAT(cSrc[i + 3]);
+    }
+#endif
+}
+
+bool CCodecBuffer::ReadBlockRowRGBA(CMP_DWORD x, CMP_DWORD y, CMP_DWORD nBlocks, CMP_BYTE cBlocks[])
+{
+    assert(x % BLOCK_SIZE_4 == 0);
+    assert(y % BLOCK_SIZE_4 == 0);
+
+    if(x >= GetWidth() || y >= GetHeight())
+        return false;
+
+    CMP_DWORD dwBlocks = GetWholeBlocksInRow(GetWidth(), GetHeight(), x, y, nBlocks);
+    CMP_DWORD i, j;
+    switch(GetBufferType())
+    {
+    case CBT_RGBA8888:
+        for(j = 0; j < BLOCK_SIZE_4; j++)
+        {
+            CMP_DWORD* pData = (CMP_DWORD*) (GetData() + ((y + j) * m_dwPitch) + (x * sizeof(CMP_DWORD)));
+            for(i = 0; i < dwBlocks; i++)
+                CopyBlockLine((CMP_DWORD*) &cBlocks[(i * BLOCK_SIZE_4X4X4) + (j * ROW_BLOCK_LINE_SIZE)], &pData[i * BLOCK_SIZE_4], m_bSwizzle);
+        }
+        break;
+
+    case CBT_RGBA32F:
+        for(j = 0; j < BLOCK_SIZE_4; j++)
+        {
+            float* pData = (float*) (GetData() + ((y + j) * m_dwPitch) + (x * CHANNEL_SIZE_ARGB * sizeof(float)));
+            for(i = 0; i < dwBlocks; i++)
+                ConvertBlockLine(&cBlocks[(i * BLOCK_SIZE_4X4X4) + (j * ROW_BLOCK_LINE_SIZE)], &pData[i * ROW_BLOCK_LINE_SIZE]);
+        }
+        break;
+
+    default:
+        dwBlocks = 0;
+        break;
+    }
+
+    for(i = dwBlocks; i < nBlocks; i++)
+    {
+        if(!ReadBlockRGBA(x + (i * BLOCK_SIZE_4), y, BLOCK_SIZE_4, BLOCK_SIZE_4, &cBlocks[i * BLOCK_SIZE_4X4X4]))
+            return false;
+    }
+    return true;
+}
+
+bool CCodecBuffer::WriteBlockRowRGBA(CMP_DWORD x, CMP_DWORD y, CMP_DWORD nBlocks, CMP_BYTE cBlocks[])
+{
+    assert(x % BLOCK_SIZE_4 == 0);
+    assert(y % BLOCK_SIZE_4 == 0);
+
+    if(x >= GetWidth() || y >= GetHeight())
+        return false;
+
+    CMP_DWORD dwBlocks = GetWholeBlocksInRow(GetWidth(), GetHeight(), x, y, nBlocks);
+    CMP_DWORD i, j;
+    switch(GetBufferType())
+    {
+    case CBT_RGBA8888:
+        for(j = 0; j < BLOCK_SIZE_4; j++)
+        {
+            CMP_DWORD* pData = (CMP_DWORD*) (GetData() + ((y + j) * m_dwPitch) + (x * sizeof(CMP_DWORD)));
+            for(i = 0; i < dwBlocks; i++)
+                CopyBlockLine(&pData[i * BLOCK_SIZE_4], (CMP_DWORD*) &cBlocks[(i * BLOCK_SIZE_4X4X4) + (j * ROW_BLOCK_LINE_SIZE)], false);
+        }
+        break;
+
+    case CBT_RGBA32F:
+        for(j = 0; j < BLOCK_SIZE_4; j++)
+        {
+            float* pData = (float*) (GetData() + ((y + j) * m_dwPitch) + (x * CHANNEL_SIZE_ARGB * sizeof(float)));
+            for(i = 0; i < dwBlocks; i++)
+                ConvertBlockLine(&pData[i * ROW_BLOCK_LINE_SIZE], &cBlocks[(i * BLOCK_SIZE_4X4X4) + (j * ROW_BLOCK_LINE_SIZE)]);
+        }
+        break;
+
+    default:
+        dwBlocks = 0;
+        break;
+    }
+
+    for(i = dwBlocks; i < nBlocks; i++)
+    {
+        if(!WriteBlockRGBA(x + (i * BLOCK_SIZE_4), y, BLOCK_SIZE_4, BLOCK_SIZE_4, &cBlocks[i * BLOCK_SIZE_4X4X4]))
+            return false;
+    }
+    return true;
+}
+
+bool CCodecBuffer::ReadBlockRowRGBA(CMP_DWORD x, CMP_DWORD y, CMP_DWORD nBlocks, float fBlocks[])
+{
+    assert(x % BLOCK_SIZE_4 == 0);
+    assert(y % BLOCK_SIZE_4 == 0);
+
+    if(x >= GetWidth() || y >= GetHeight())
+        return false;
+
+    CMP_DWORD dwBlocks = GetWholeBlocksInRow(GetWidth(), GetHeight(), x, y, nBlocks);
+    CMP_DWORD i, j;
+    switch(GetBufferType())
+    {
+    case CBT_RGBA16F:
+        for(j = 0; j < BLOCK_SIZE_4; j++)
+        {
+            CMP_HALF* pData = (CMP_HALF*) (GetData() + ((y + j) * m_dwPitch) + (x * CHANNEL_SIZE_ARGB * sizeof(CMP_HALF)));
+            for(i = 0; i < dwBlocks; i++)
+                CMP_HalfToFloat(&fBlocks[(i * BLOCK_SIZE_4X4X4) + (j * ROW_BLOCK_LINE_SIZE)], &pData[i * ROW_BLOCK_LINE_SIZE], ROW_BLOCK_LINE_SIZE);
+        }
+        break;
+
+    case CBT_RGBA32F:
+        for(j = 0; j < BLOCK_SIZE_4; j++)
+        {
+            float* pData = (float*) (GetData() + ((y + j) * m_dwPitch) + (x * CHANNEL_SIZE_ARGB * sizeof(float)));
+            for(i = 0; i < dwBlocks; i++)
+                memcpy(&fBlocks[(i * BLOCK_SIZE_4X4X4) + (j * ROW_BLOCK_LINE_SIZE)], &pData[i * ROW_BLOCK_LINE_SIZE], ROW_BLOCK_LINE_SIZE * sizeof(float));
+        }
+        break;
+
+    default:
+        dwBlocks = 0;
+        break;
+    }
+
+    for(i = dwBlocks; i < nBlocks; i++)
+    {
+        if(!ReadBlockRGBA(x + (i * BLOCK_SIZE_4), y, BLOCK_SIZE_4, BLOCK_SIZE_4, &fBlocks[i * BLOCK_SIZE_4X4X4]))
+            return false;
+    }
+    return true;
+}
+
+bool CCodecBuffer::WriteBlockRowRGBA(CMP_DWORD x, CMP_DWORD y, CMP_DWORD nBlocks, float fBlocks[])
+{
+    assert(x % BLOCK_SIZE_4 == 0);
+    assert(y % BLOCK_SIZE_4 == 0);
+
+    if(x >= GetWidth() || y >= GetHeight())
+        return false;
+
+    CMP_DWORD dwBlocks = GetWholeBlocksInRow(GetWidth(), GetHeight(), x, y, nBlocks);
+    CMP_DWORD i, j;
+    switch(GetBufferType())
+    {
+    case CBT_RGBA16F:
+        for(j = 0; j < BLOCK_SIZE_4; j++)
+        {
+            CMP_HALF* pData = (CMP_HALF*) (GetData() + ((y + j) * m_dwPitch) + (x * CHANNEL_SIZE_ARGB * sizeof(CMP_HALF)));
+            for(i = 0; i < dwBlocks; i++)
+                CMP_FloatToHalf(&pData[i * ROW_BLOCK_LINE_SIZE], &fBlocks[(i * BLOCK_SIZE_4X4X4) + (j * ROW_BLOCK_LINE_SIZE)], ROW_BLOCK_LINE_SIZE);
+        }
+        break;
+
+    case CBT_RGBA32F:
+        for(j = 0; j < BLOCK_SIZE_4; j++)
+        {
+            float* pData = (float*) (GetData() + ((y + j) * m_dwPitch) + (x * CHANNEL_SIZE_ARGB * sizeof(float)));
+            for(i = 0; i < dwBlocks; i++)
+                memcpy(&pData[i * ROW_BLOCK_LINE_SIZE], &fBlocks[(i * BLOCK_SIZE_4X4X4) + (j * ROW_BLOCK_LINE_SIZE)], ROW_BLOCK_LINE_SIZE * sizeof(float));
+        }
+        break;
+
+    default:
+        dwBlocks = 0;
+        break;
+    }
+
+    for(i = dwBlocks; i < nBlocks; i++)
+    {
+        if(!WriteBlockRGBA(x + (i * BLOCK_SIZE_4), y, BLOCK_SIZE_4, BLOCK_SIZE_4, &fBlocks[i * BLOCK_SIZE_4X4X4]))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,268 @@
+//===============================================================================
+// Copyright (c) 2020  Advanced Micro Devices, Inc. All rights reserved.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//
+//
+//  File Name:   CMP_BlockClass.cpp
+//  Description: Classifies 4x4 blocks as solid, two colour or gradient so the
+//               encoders can skip their partition searches, and keeps per
+//               format counts of the blocks that took those fast paths and
+//               of the coarse to fine mode search
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "CMP_BlockClass.h"
+
+#include <atomic>
+#include <math.h>
+
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif // USE_SSE2
+
+#ifdef USE_SSE2
+static inline bool SamePixel(const float a[4], const float b[4])
+{
+    return _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(a), _mm_loadu_ps(b))) == 0xF;
+}
+#else
+static inline bool SamePixel(const float a[4], const float b[4])
+{
+    return (a[0] == b[0]) && (a[1] == b[1]) && (a[2] == b[2]) && (a[3] == b[3]);
+}
+#endif // USE_SSE2
+
+// Accumulates the mean and the (unscaled) covariance of the pixels, returns false for a solid block
+static bool BlockStatistics(const float fPixels[16][4], float fMean[4], float fCov[4][4])
+{
+    int i, j;
+#ifdef USE_SSE2
+    __m128 vMin = _mm_loadu_ps(fPixels[0]);
+    __m128 vMax = vMin;
+    __m128 vSum = vMin;
+    for(i = 1; i < 16; i++)
+    {
+        __m128 p = _mm_loadu_ps(fPixels[i]);
+        vMin = _mm_min_ps(vMin, p);
+        vMax = _mm_max_ps(vMax, p);
+        vSum = _mm_add_ps(vSum, p);
+    }
+    if(_mm_movemask_ps(_mm_cmpneq_ps(vMin, vMax)) == 0)
+        return false;
+
+    __m128 vMean = _mm_mul_ps(vSum, _mm_set1_ps(1.0f / 16.0f));
+    __m128 vCov[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+    for(i = 0; i < 16; i++)
+    {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(fPixels[i]), vMean);
+        vCov[0] = _mm_add_ps(vCov[0], _mm_mul_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(0, 0, 0, 0))));
+        vCov[1] = _mm_add_ps(vCov[1], _mm_mul_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 1, 1, 1))));
+        vCov[2] = _mm_add_ps(vCov[2], _mm_mul_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 2, 2, 2))));
+        vCov[3] = _mm_add_ps(vCov[3], _mm_mul_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(3, 3, 3, 3))));
+    }
+    _mm_storeu_ps(fMean, vMean);
+    for(j = 0; j < 4; j++)
+        _mm_storeu_ps(fCov[j], vCov[j]);
+#else
+    float fMin[4], fMax[4];
+    for(j = 0; j < 4; j++)
+        fMin[j] = fMax[j] = fMean[j] = fPixels[0][j];
+    for(i = 1; i < 16; i++)
+    {
+        for(j = 0; j < 4; j++)
+        {
+            fMin[j] = (fPixels[i][j] < fMin[j]) ? fPixels[i][j] : fMin[j];
+            fMax[j] = (fPixels[i][j] > fMax[j]) ? fPixels[i][j] : fMax[j];
+            fMean[j] += fPixels[i][j];
+        }
+    }
+    if((fMin[0] == fMax[0]) && (fMin[1] == fMax[1]) && (fMin[2] == fMax[2]) && (fMin[3] == fMax[3]))
+        return false;
+
+    for(j = 0; j < 4; j++)
+    {
+        fMean[j] *= 1.0f / 16.0f;
+        fCov[j][0] = fCov[j][1] = fCov[j][2] = fCov[j][3] = 0.0f;
+    }
+    for(i = 0; i < 16; i++)
+    {
+        float d[4];
+        for(j = 0; j < 4; j++)
+            d[j] = fPixels[i][j] - fMean[j];
+        for(j = 0; j < 4; j++)
+        {
+            fCov[j][0] += d[0] * d[j];
+            fCov[j][1] += d[1] * d[j];
+            fCov[j][2] += d[2] * d[j];
+            fCov[j][3] += d[3] * d[j];
+        }
+    }
+#endif
+    return true;
+}
+
+CMP_BlockClass CMP_ClassifyBlock(const float fPixels[16][4], float fMaxLineDistSq)
+{
+    float fMean[4];
+    float fCov[4][4];
+    int   i, j, k;
+
+    if(!BlockStatistics(fPixels, fMean, fCov))
+        return CMP_BLOCK_SOLID;
+
+    // Two colours: every pixel matches the first one or the first one that differs from it
+    const float* pOther = NULL;
+    for(i = 1; i < 16; i++)
+    {
+        if(SamePixel(fPixels[i], fPixels[0]))
+            continue;
+        if(pOther == NULL)
+            pOther = fPixels[i];
+        else if(!SamePixel(fPixels[i], pOther))
+            break;
+    }
+    if(i == 16)
+        return CMP_BLOCK_TWO_COLOUR;
+
+    // Principal axis by power iteration, starting from the channel with the largest variance
+    float fAxis[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    k = 0;
+    for(j = 1; j < 4; j++)
+        k = (fCov[j][j] > fCov[k][k]) ? j : k;
+    fAxis[k] = 1.0f;
+
+    for(int iter = 0; iter < 8; iter++)
+    {
+        float fNext[4];
+        float fLen = 0.0f;
+        for(j = 0; j < 4; j++)
+        {
+            fNext[j] = fCov[j][0] * fAxis[0] + fCov[j][1] * fAxis[1] + fCov[j][2] * fAxis[2] + fCov[j][3] * fAxis[3];
+            fLen    += fNext[j] * fNext[j];
+        }
+        if(fLen <= 0.0f)
+            return CMP_BLOCK_COMPLEX;
+        fLen = 1.0f / sqrtf(fLen);
+        for(j = 0; j < 4; j++)
+            fAxis[j] = fNext[j] * fLen;
+    }
+
+    // Gradient: every pixel is close to the line through the mean along the axis
+    for(i = 0; i < 16; i++)
+    {
+        float d[4];
+        float fDot = 0.0f;
+        float fLenSq = 0.0f;
+        for(j = 0; j < 4; j++)
+        {
+            d[j]    = fPixels[i][j] - fMean[j];
+            fDot   += d[j] * fAxis[j];
+            fLenSq += d[j] * d[j];
+        }
+        if(fLenSq - fDot * fDot > fMaxLineDistSq)
+            return CMP_BLOCK_COMPLEX;
+    }
+    return CMP_BLOCK_GRADIENT;
+}
+
+//------------------------------------------------------------------------------
+// Per format counts
+//------------------------------------------------------------------------------
+
+enum
+{
+    STATS_BC7 = 0,
+    STATS_BC6H,
+    STATS_BC6H_SF,
+    STATS_ASTC,
+    STATS_FORMATS
+};
+
+static std::atomic<CMP_DWORD> g_BlockClassCounts[STATS_FORMATS][CMP_BLOCK_CLASSES];
+static std::atomic<CMP_DWORD> g_ModeSearchCounts[STATS_FORMATS][CMP_SEARCH_COUNTS];
+
+static int StatsIndex(CMP_FORMAT format)
+{
+    switch(format)
+    {
+    case CMP_FORMAT_BC7:     return STATS_BC7;
+    case CMP_FORMAT_BC6H:    return STATS_BC6H;
+    case CMP_FORMAT_BC6H_SF: return STATS_BC6H_SF;
+    case CMP_FORMAT_ASTC:    return STATS_ASTC;
+    default:                 return -1;
+    }
+}
+
+void CMP_AddBlockClassCounts(CMP_FORMAT format, const CMP_DWORD dwCounts[CMP_BLOCK_CLASSES])
+{
+    int nIndex = StatsIndex(format);
+    if(nIndex < 0)
+        return;
+    for(int i = 0; i < CMP_BLOCK_CLASSES; i++)
+    {
+        if(dwCounts[i])
+            g_BlockClassCounts[nIndex][i] += dwCounts[i];
+    }
+}
+
+bool CMP_GetBlockClassCounts(CMP_FORMAT format, CMP_DWORD dwCounts[CMP_BLOCK_CLASSES])
+{
+    int nIndex = StatsIndex(format);
+    if(nIndex < 0)
+        return false;
+    for(int i = 0; i < CMP_BLOCK_CLASSES; i++)
+        dwCounts[i] = g_BlockClassCounts[nIndex][i];
+    return true;
+}
+
+void CMP_AddModeSearchCounts(CMP_FORMAT format, const CMP_DWORD dwCounts[CMP_SEARCH_COUNTS])
+{
+    int nIndex = StatsIndex(format);
+    if(nIndex < 0)
+        return;
+    for(int i = 0; i < CMP_SEARCH_COUNTS; i++)
+    {
+        if(dwCounts[i])
+            g_ModeSearchCounts[nIndex][i] += dwCounts[i];
+    }
+}
+
+bool CMP_GetModeSearchCounts(CMP_FORMAT format, CMP_DWORD dwCounts[CMP_SEARCH_COUNTS])
+{
+    int nIndex = StatsIndex(format);
+    if(nIndex < 0)
+        return false;
+    for(int i = 0; i < CMP_SEARCH_COUNTS; i++)
+        dwCounts[i] = g_ModeSearchCounts[nIndex][i];
+    return true;
+}
+
+void CMP_ClearBlockClassCounts()
+{
+    for(int nIndex = 0; nIndex < STATS_FORMATS; nIndex++)
+    {
+        for(int i = 0; i < CMP_BLOCK_CLASSES; i++)
+            g_BlockClassCounts[nIndex][i] = 0;
+        for(int i = 0; i < CMP_SEARCH_COUNTS; i++)
+            g_ModeSearchCounts[nIndex][i] = 0;
+    }
+}
@@ -0,0 +1,83 @@
+//===============================================================================
+// Copyright (c) 2020  Advanced Micro Devices, Inc. All rights reserved.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//
+//
+//  File Name:   CMP_BlockClass.h
+//  Description: Classifies 4x4 blocks as solid, two colour or gradient so the
+//               encoders can skip their partition searches, and keeps per
+//               format counts of the blocks that took those fast paths and
+//               of the coarse to fine mode search
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CMP_BLOCKCLASS_H_INCLUDED_
+#define _CMP_BLOCKCLASS_H_INCLUDED_
+
+#include "Compressonator.h"
+
+enum CMP_BlockClass
+{
+    CMP_BLOCK_COMPLEX = 0,      // None of the below, needs the full search
+    CMP_BLOCK_SOLID,            // All pixels are the same
+    CMP_BLOCK_TWO_COLOUR,       // Every pixel is one of two colours
+    CMP_BLOCK_GRADIENT,         // All pixels lie on a line through colour space
+    CMP_BLOCK_CLASSES
+};
+
+// Classifies the 16 pixels of a block. A block is a gradient when no pixel is further
+// than sqrt(fMaxLineDistSq) from the principal axis of the pixels.
+CMP_BlockClass CMP_ClassifyBlock(const float fPixels[16][4], float fMaxLineDistSq);
+
+// Adds the number of blocks an encoder put in each class, index CMP_BLOCK_COMPLEX
+// counts the blocks that went through the full search
+void CMP_AddBlockClassCounts(CMP_FORMAT format, const CMP_DWORD dwCounts[CMP_BLOCK_CLASSES]);
+
+// Gets the counts added so far for format, returns false if it is not counted
+bool CMP_GetBlockClassCounts(CMP_FORMAT format, CMP_DWORD dwCounts[CMP_BLOCK_CLASSES]);
+
+void CMP_ClearBlockClassCounts();
+
+// Counters of the coarse to fine mode search of the BC7 and BC6H encoders
+enum CMP_ModeSearchCount
+{
+    CMP_SEARCH_BLOCKS = 0,      // Blocks encoded with the search
+    CMP_SEARCH_CANDIDATES,      // Candidates ranked by their quick estimate
+    CMP_SEARCH_REFINED,         // Candidates that were refined
+    CMP_SEARCH_EARLY_OUTS,      // Blocks that met the error threshold before all their top candidates were refined
+    CMP_SEARCH_BEST_RANK,       // CMP_SEARCH_RANKS counts of the blocks whose result came from the candidate of each rank
+    CMP_SEARCH_COUNTS = CMP_SEARCH_BEST_RANK + CMP_SEARCH_RANKS
+};
+
+// Counts the rank of the candidate a block was encoded with, the last rank also takes the ranks after it
+inline void CMP_CountSearchRank(CMP_DWORD dwCounts[CMP_SEARCH_COUNTS], CMP_DWORD dwRank)
+{
+    dwCounts[CMP_SEARCH_BEST_RANK + (dwRank < CMP_SEARCH_RANKS ? dwRank : CMP_SEARCH_RANKS - 1)]++;
+}
+
+// Adds the mode search counts of an encoder, CMP_ClearBlockClassCounts also clears them
+void CMP_AddModeSearchCounts(CMP_FORMAT format, const CMP_DWORD dwCounts[CMP_SEARCH_COUNTS]);
+
+// Gets the mode search counts added so far for format, returns false if it is not counted
+bool CMP_GetModeSearchCounts(CMP_FORMAT format, CMP_DWORD dwCounts[CMP_SEARCH_COUNTS]);
+
+#endif // !defined(_CMP_BLOCKCLASS_H_INCLUDED_)
@@ -0,0 +1,329 @@
+//===============================================================================
+// Copyright (c) 2020  Advanced Micro Devices, Inc. All rights reserved.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//
+//  File Name:   CMP_BlockQueue.h
+//  Description: Bounded multi producer / multi consumer queue used to hand
+//               batches of source blocks from a codec to its pool workers
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CMP_BLOCKQUEUE_H_INCLUDED_
+#define _CMP_BLOCKQUEUE_H_INCLUDED_
+
+#include "CMP_ThreadPool.h"
+
+#include <algorithm>
+
+//
+// Lock free ring of fixed size cells, each cell carries a sequence number that
+// tells producers and consumers whether it is free or holds data for them.
+// Only threads that find the ring empty take the mutex and sleep, so an idle
+// worker uses no CPU and a busy queue never enters the kernel.
+//
+template <typename T>
+class CMP_BlockQueue
+{
+public:
+    CMP_BlockQueue(CMP_DWORD dwCapacity)
+    {
+        size_t capacity = 2;
+        while (capacity < dwCapacity)
+            capacity <<= 1;
+
+        m_Mask   = capacity - 1;
+        m_pCells = new Cell[capacity];
+        for (size_t i = 0; i < capacity; i++)
+            m_pCells[i].m_Sequence.store(i, std::memory_order_relaxed);
+
+        m_EnqueuePos.store(0, std::memory_order_relaxed);
+        m_DequeuePos.store(0, std::memory_order_relaxed);
+        m_WaitingPop = 0;
+        m_Closed     = false;
+    }
+
+    ~CMP_BlockQueue()
+    {
+        delete[] m_pCells;
+    }
+
+    // Returns false if the queue is full
+    bool TryPush(T& item)
+    {
+        Cell*  cell;
+        size_t pos = m_EnqueuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell          = &m_pCells[pos & m_Mask];
+            size_t   seq  = cell->m_Sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = m_EnqueuePos.load(std::memory_order_relaxed);
+        }
+
+        cell->m_Data = std::move(item);
+        cell->m_Sequence.store(pos + 1, std::memory_order_release);
+
+        // Pairs with the fence in Pop(): either the consumer sees the new
+        // item before it sleeps or we see it waiting and wake it
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_WaitingPop.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_NotEmpty.notify_one();
+        }
+        return true;
+    }
+
+    // Returns false if the queue is empty
+    bool TryPop(T& item)
+    {
+        Cell*  cell;
+        size_t pos = m_DequeuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            cell          = &m_pCells[pos & m_Mask];
+            size_t   seq  = cell->m_Sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (m_DequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = m_DequeuePos.load(std::memory_order_relaxed);
+        }
+
+        item = std::move(cell->m_Data);
+        cell->m_Sequence.store(pos + m_Mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Blocks until an item is available, returns false once the queue is closed and empty
+    bool Pop(T& item)
+    {
+        for (;;)
+        {
+            if (TryPop(item))
+                return true;
+
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WaitingPop++;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_NotEmpty.wait(lock, [this] { return !IsEmpty() || m_Closed; });
+            m_WaitingPop--;
+
+            if (m_Closed && IsEmpty())
+                return false;
+        }
+    }
+
+    // No more items will be pushed, wakes all the waiting consumers
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Closed = true;
+        m_NotEmpty.notify_all();
+    }
+
+    bool IsEmpty() const
+    {
+        size_t pos = m_DequeuePos.load(std::memory_order_relaxed);
+        return m_pCells[pos & m_Mask].m_Sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> m_Sequence;
+        T                   m_Data;
+    };
+
+    Cell*  m_pCells;
+    size_t m_Mask;
+
+    // Keep the producer and consumer positions on separate cache lines
+    alignas(64) std::atomic<size_t> m_EnqueuePos;
+    alignas(64) std::atomic<size_t> m_DequeuePos;
+    alignas(64) std::atomic<CMP_INT> m_WaitingPop;
+    std::atomic<bool>       m_Closed;
+
+    std::mutex              m_Mutex;
+    std::condition_variable m_NotEmpty;
+};
+
+//
+// Encodes dwNumBatches batches of blocks on the thread pool.
+//
+// The calling thread fills each batch with fillProc(batch, index) and queues it,
+// at most dwMaxTasks pool workers (0 = all) take batches off the queue and call
+// encodeProc(batch). When the queue is full the caller encodes a batch itself
+// rather than waiting, this bounds the memory used and can not deadlock when
+// the caller is itself a pool worker. Progress (0..100) is reported from the
+// calling thread at most every CMP_PROGRESS_INTERVAL_MS, returns false if
+// progressProc asked to abort.
+//
+// When the pool workers are placed on NUMA nodes the batches are split into one range
+// and one queue per node, as CMP_ParallelRows splits its rows. The caller fills the
+// ranges in turn and workers drain their own node's queue before helping the others, so
+// the destination blocks of a range are written, and first touched, on one node and the
+// batch copies of the source blocks are read there.
+//
+// cancelProc, if given, is polled before every batch is filled or encoded. A batch
+// can take long at high quality, so encodeProc should also poll the cancel between
+// its blocks for a cancel to stop the caller and the workers within one block.
+//
+template <typename Batch>
+bool CMP_ProcessBatches(CMP_DWORD                              dwNumBatches,
+                        CMP_DWORD                              dwMaxTasks,
+                        const std::function<void(Batch&, CMP_DWORD)>& fillProc,
+                        const std::function<void(Batch&)>&     encodeProc,
+                        const CMP_ProgressProc&                progressProc,
+                        const std::function<bool()>&           cancelProc = nullptr)
+{
+    if (dwNumBatches == 0)
+        return true;
+
+    std::shared_ptr<CMP_ThreadPool> pPool      = CMP_ThreadPool::GetThreadPool();
+    CMP_DWORD                       dwNumTasks = pPool->GetNumThreads();
+    if ((dwMaxTasks > 0) && (dwMaxTasks < dwNumTasks))
+        dwNumTasks = dwMaxTasks;
+    if (dwNumTasks > dwNumBatches)
+        dwNumTasks = dwNumBatches;
+
+    // One range of batches per node, range n is [n * batches / nodes, (n + 1) * batches / nodes)
+    CMP_DWORD dwNumRanges = (std::min)(pPool->GetNumNodes(), dwNumTasks);
+    auto RangeStart = [&](CMP_DWORD dwRange) {
+        return (CMP_DWORD)(((std::uint64_t)dwRange * dwNumBatches) / dwNumRanges);
+    };
+
+    std::vector<std::unique_ptr<CMP_BlockQueue<Batch>>> queues;
+    std::vector<CMP_DWORD>                              nextBatch(dwNumRanges);
+    for (CMP_DWORD n = 0; n < dwNumRanges; n++)
+    {
+        queues.emplace_back(new CMP_BlockQueue<Batch>((dwNumTasks * 4 + dwNumRanges - 1) / dwNumRanges));
+        nextBatch[n] = RangeStart(n);
+    }
+
+    CMP_ProgressCounter batchesDone;
+    CMP_TaskGroup       taskGroup;
+
+    for (CMP_DWORD i = 0; i < dwNumTasks; i++)
+    {
+        taskGroup.Run([&]() {
+            CMP_INT   nNode   = CMP_ThreadPool::GetWorkerNode();
+            CMP_DWORD dwFirst = (nNode >= 0) ? (CMP_DWORD)nNode % dwNumRanges : 0;
+            Batch*    pBatch  = new Batch;
+            for (CMP_DWORD r = 0; r < dwNumRanges; r++)
+            {
+                CMP_BlockQueue<Batch>& queue = *queues[(dwFirst + r) % dwNumRanges];
+                while (queue.Pop(*pBatch))
+                {
+                    if (!taskGroup.IsCanceled() && !(cancelProc && cancelProc()))
+                        encodeProc(*pBatch);
+                    batchesDone.Add();
+                }
+            }
+            delete pBatch;
+        });
+    }
+
+    bool                 bAborted  = false;
+    CMP_ProgressThrottle throttle(progressProc);
+    Batch*               pBatch    = new Batch;
+    Batch*               pOwnBatch = new Batch;
+
+    auto ReportProgress = [&]() {
+        if (!progressProc)
+            return;
+        CMP_INT nProgress = (CMP_INT)((100.0f * batchesDone.GetTotal()) / dwNumBatches);
+        if (throttle.Report((float)nProgress))
+            bAborted = true;
+    };
+
+    CMP_DWORD dwRange = 0;
+    for (CMP_DWORD k = 0; (k < dwNumBatches) && !bAborted; k++)
+    {
+        if (cancelProc && cancelProc())
+        {
+            bAborted = true;
+            break;
+        }
+
+        // Take the next batch of each range in turn so every node has work from the start
+        while (nextBatch[dwRange] >= RangeStart(dwRange + 1))
+            dwRange = (dwRange + 1) % dwNumRanges;
+        CMP_BlockQueue<Batch>& queue = *queues[dwRange];
+        fillProc(*pBatch, nextBatch[dwRange]++);
+        dwRange = (dwRange + 1) % dwNumRanges;
+
+        while (!queue.TryPush(*pBatch))
+        {
+            if (queue.TryPop(*pOwnBatch))
+            {
+                if (!(cancelProc && cancelProc()))
+                    encodeProc(*pOwnBatch);
+                batchesDone.Add();
+            }
+        }
+        ReportProgress();
+    }
+
+    if (bAborted)
+        taskGroup.Cancel();
+    for (auto& queue : queues)
+        queue->Close();
+
+    while (!taskGroup.WaitFor(10))
+    {
+        if (!bAborted)
+        {
+            ReportProgress();
+            if (cancelProc && cancelProc())
+                bAborted = true;
+            if (bAborted)
+                taskGroup.Cancel();
+        }
+    }
+
+    // A cancel seen only by the workers still fails the whole encode
+    if (!bAborted && cancelProc && cancelProc())
+        bAborted = true;
+    if (!bAborted)
+        ReportProgress();
+
+    delete pBatch;
+    delete pOwnBatch;
+
+    return !bAborted;
+}
+
+#endif // !defined(_CMP_BLOCKQUEUE_H_INCLUDED_)
@@ -0,0 +1,88 @@
+//===============================================================================
+// Copyright (c) 2020  Advanced Micro Devices, Inc. All rights reserved.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//
+//  File Name:   CMP_CancelToken.h
+//  Description: State behind the CMP_CancelToken handle, polled by the codec
+//               block loops and the thread pool workers
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CMP_CANCELTOKEN_H_INCLUDED_
+#define _CMP_CANCELTOKEN_H_INCLUDED_
+
+#include "Compressonator.h"
+
+#include <atomic>
+#include <chrono>
+
+// Quality the BC7 and BC6H encoders drop to once a token is degraded
+#define CMP_DEGRADED_QUALITY 0.05f
+
+struct CMP_CancelTokenData
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::atomic<bool> m_Canceled;
+    std::atomic<bool> m_Degraded;
+    bool              m_bHasDeadline;
+    bool              m_bHasDegradeTime;
+    Clock::time_point m_Deadline;
+    Clock::time_point m_DegradeTime;
+
+    // Cheap enough to call once per block, the clock is only read while a deadline is pending
+    bool IsCanceled()
+    {
+        if (m_Canceled.load(std::memory_order_relaxed))
+            return true;
+        if (m_bHasDeadline && (Clock::now() >= m_Deadline))
+        {
+            m_Canceled = true;
+            return true;
+        }
+        return false;
+    }
+
+    bool IsDegraded()
+    {
+        if (m_Degraded.load(std::memory_order_relaxed))
+            return true;
+        if (m_bHasDegradeTime && (Clock::now() >= m_DegradeTime))
+        {
+            m_Degraded = true;
+            return true;
+        }
+        return false;
+    }
+};
+
+inline bool CMP_IsCanceled(CMP_CancelToken hToken)
+{
+    return hToken && hToken->IsCanceled();
+}
+
+inline bool CMP_IsDegraded(CMP_CancelToken hToken)
+{
+    return hToken && hToken->IsDegraded();
+}
+
+#endif // !defined(_CMP_CANCELTOKEN_H_INCLUDED_)
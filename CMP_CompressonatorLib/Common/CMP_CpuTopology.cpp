@@ -0,0 +1,340 @@
+//===============================================================================
+// Copyright (c) 2020  Advanced Micro Devices, Inc. All rights reserved.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//
+//  File Name:   CMP_CpuTopology.cpp
+//  Description: NUMA node and core type layout of the processors the library
+//               may run on, used to place the thread pool workers
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "CMP_CpuTopology.h"
+
+#include <algorithm>
+#include <string.h>
+#include <thread>
+
+#ifdef _WIN32
+#include "windows.h"
+#elif defined(__linux__)
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#endif
+
+#if defined(__linux__)
+
+// Parses a sysfs cpu list such as "0-7,16-23"
+static bool ReadCpuList(const char* pszPath, std::vector<CMP_INT>& cpus)
+{
+    FILE* pFile = fopen(pszPath, "r");
+    if (pFile == NULL)
+        return false;
+
+    char szList[4096];
+    bool bRead = fgets(szList, sizeof(szList), pFile) != NULL;
+    fclose(pFile);
+    if (!bRead)
+        return false;
+
+    char* p = szList;
+    while (*p)
+    {
+        char*   pEnd;
+        CMP_INT nFirst = (CMP_INT)strtol(p, &pEnd, 10);
+        if (pEnd == p)
+            break;
+        CMP_INT nLast = nFirst;
+        p = pEnd;
+        if (*p == '-')
+        {
+            nLast = (CMP_INT)strtol(p + 1, &pEnd, 10);
+            p     = pEnd;
+        }
+        for (CMP_INT cpu = nFirst; cpu <= nLast; cpu++)
+            cpus.push_back(cpu);
+        if (*p == ',')
+            p++;
+    }
+    return true;
+}
+
+static void DetectTopology(CMP_CpuTopology& topology)
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool bHaveAffinity = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    auto IsAllowed = [&](CMP_INT cpu) {
+        return !bHaveAffinity || ((cpu < CPU_SETSIZE) && CPU_ISSET(cpu, &allowed));
+    };
+
+    DIR* pDir = opendir("/sys/devices/system/node");
+    if (pDir)
+    {
+        while (struct dirent* pEntry = readdir(pDir))
+        {
+            if (strncmp(pEntry->d_name, "node", 4) != 0 || pEntry->d_name[4] < '0' || pEntry->d_name[4] > '9')
+                continue;
+
+            char szPath[320];
+            int nPath = snprintf(szPath, sizeof(szPath), "/sys/devices/system/node/%s/cpulist", pEntry->d_name);
+            if (nPath < 0 || nPath >= (int)sizeof(szPath))
+                continue;
+
+            std::vector<CMP_INT> cpus;
+            if (!ReadCpuList(szPath, cpus))
+                continue;
+
+            // Memory only nodes and nodes outside our affinity mask get no workers
+            CMP_CpuNode node;
+            node.nNodeId = (CMP_INT)atoi(pEntry->d_name + 4);
+            for (CMP_INT cpu : cpus)
+            {
+                if (IsAllowed(cpu))
+                    node.cpus.push_back(cpu);
+            }
+            if (!node.cpus.empty())
+                topology.nodes.push_back(node);
+        }
+        closedir(pDir);
+    }
+
+    std::sort(topology.nodes.begin(), topology.nodes.end(),
+              [](const CMP_CpuNode& a, const CMP_CpuNode& b) { return a.nNodeId < b.nNodeId; });
+
+    if (topology.nodes.empty() && bHaveAffinity)
+    {
+        CMP_CpuNode node;
+        node.nNodeId = 0;
+        for (CMP_INT cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if (CPU_ISSET(cpu, &allowed))
+                node.cpus.push_back(cpu);
+        }
+        if (!node.cpus.empty())
+            topology.nodes.push_back(node);
+    }
+
+    // Hybrid processors list their performance and efficiency cores as separate PMUs
+    std::vector<CMP_INT> perfCpus, effCpus;
+    if (ReadCpuList("/sys/devices/cpu_core/cpus", perfCpus) && ReadCpuList("/sys/devices/cpu_atom/cpus", effCpus))
+    {
+        topology.nNumPerfCpus = (CMP_INT)std::count_if(perfCpus.begin(), perfCpus.end(), IsAllowed);
+        topology.nNumEffCpus  = (CMP_INT)std::count_if(effCpus.begin(), effCpus.end(), IsAllowed);
+    }
+}
+
+bool CMP_SetThreadNodeAffinity(const CMP_CpuNode& node)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (CMP_INT cpu : node.cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+#elif defined(_WIN32)
+
+// Processors of each group this process may run on, the Windows counterpart of sched_getaffinity.
+// A process restricted to one group reports its mask through GetProcessAffinityMask, a process
+// spanning several groups can run on all processors of those groups.
+static void GetAllowedGroupMasks(std::vector<KAFFINITY>& allowed)
+{
+    allowed.assign(GetActiveProcessorGroupCount(), ~(KAFFINITY)0);
+
+    USHORT nGroups = 0;
+    GetProcessGroupAffinity(GetCurrentProcess(), &nGroups, NULL);
+    std::vector<USHORT> groups(nGroups);
+    if (!nGroups || !GetProcessGroupAffinity(GetCurrentProcess(), &nGroups, groups.data()))
+        return;
+
+    std::vector<KAFFINITY> processMasks(allowed.size(), 0);
+    for (USHORT i = 0; i < nGroups; i++)
+    {
+        if (groups[i] < processMasks.size())
+            processMasks[groups[i]] = ~(KAFFINITY)0;
+    }
+
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if ((nGroups == 1) && (groups[0] < processMasks.size()) &&
+        GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) && processMask)
+        processMasks[groups[0]] = (KAFFINITY)processMask;
+
+    allowed = processMasks;
+}
+
+static void DetectTopology(CMP_CpuTopology& topology)
+{
+    std::vector<KAFFINITY> allowed;
+    GetAllowedGroupMasks(allowed);
+
+    auto AllowedMask = [&](WORD group, KAFFINITY mask) {
+        return (group < allowed.size()) ? (mask & allowed[group]) : (KAFFINITY)0;
+    };
+
+    ULONG ulHighestNode = 0;
+    if (GetNumaHighestNodeNumber(&ulHighestNode))
+    {
+        for (USHORT n = 0; n <= (USHORT)ulHighestNode; n++)
+        {
+            // Memory only nodes and nodes outside our affinity mask get no workers
+            GROUP_AFFINITY affinity;
+            if (!GetNumaNodeProcessorMaskEx(n, &affinity))
+                continue;
+            affinity.Mask = AllowedMask(affinity.Group, affinity.Mask);
+            if (affinity.Mask == 0)
+                continue;
+
+            CMP_CpuNode node;
+            node.nNodeId = n;
+            for (CMP_INT bit = 0; bit < 64; bit++)
+            {
+                if (affinity.Mask & ((KAFFINITY)1 << bit))
+                    node.cpus.push_back(affinity.Group * 64 + bit);
+            }
+            topology.nodes.push_back(node);
+        }
+    }
+
+    if (topology.nodes.empty())
+    {
+        CMP_CpuNode node;
+        node.nNodeId = 0;
+        for (WORD g = 0; g < (WORD)allowed.size(); g++)
+        {
+            DWORD dwCpus = (std::min)(GetActiveProcessorCount(g), (DWORD)64);
+            for (DWORD bit = 0; bit < dwCpus; bit++)
+            {
+                if (allowed[g] & ((KAFFINITY)1 << bit))
+                    node.cpus.push_back(g * 64 + bit);
+            }
+        }
+        if (!node.cpus.empty())
+            topology.nodes.push_back(node);
+    }
+
+    // Cores of a hybrid processor report different efficiency classes, the highest class is the fastest
+    DWORD dwLength = 0;
+    GetLogicalProcessorInformationEx(RelationProcessorCore, NULL, &dwLength);
+    std::vector<BYTE> buffer(dwLength);
+    if (dwLength && GetLogicalProcessorInformationEx(RelationProcessorCore, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer.data(), &dwLength))
+    {
+        BYTE    maxClass = 0, minClass = 0xFF;
+        CMP_INT nMaxClassCpus = 0, nOtherCpus = 0;
+        for (DWORD offset = 0; offset < dwLength;)
+        {
+            PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX pInfo = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)(buffer.data() + offset);
+            BYTE    effClass = pInfo->Processor.EfficiencyClass;
+            CMP_INT nCpus    = 0;
+            for (WORD g = 0; g < pInfo->Processor.GroupCount; g++)
+            {
+                const GROUP_AFFINITY& groupMask = pInfo->Processor.GroupMask[g];
+                for (KAFFINITY mask = AllowedMask(groupMask.Group, groupMask.Mask); mask; mask &= mask - 1)
+                    nCpus++;
+            }
+
+            if (effClass > maxClass)
+            {
+                nOtherCpus += nMaxClassCpus;
+                nMaxClassCpus = 0;
+                maxClass      = effClass;
+            }
+            if (effClass == maxClass)
+                nMaxClassCpus += nCpus;
+            else
+                nOtherCpus += nCpus;
+            minClass = (std::min)(minClass, effClass);
+
+            offset += pInfo->Size;
+        }
+
+        if (minClass != maxClass)
+        {
+            topology.nNumPerfCpus = nMaxClassCpus;
+            topology.nNumEffCpus  = nOtherCpus;
+        }
+    }
+}
+
+bool CMP_SetThreadNodeAffinity(const CMP_CpuNode& node)
+{
+    if (node.cpus.empty())
+        return false;
+
+    GROUP_AFFINITY affinity;
+    memset(&affinity, 0, sizeof(affinity));
+    affinity.Group = (WORD)(node.cpus[0] / 64);
+    for (CMP_INT cpu : node.cpus)
+    {
+        if (cpu / 64 == affinity.Group)
+            affinity.Mask |= (KAFFINITY)1 << (cpu % 64);
+    }
+    return SetThreadGroupAffinity(GetCurrentThread(), &affinity, NULL) != 0;
+}
+
+#else
+
+static void DetectTopology(CMP_CpuTopology& topology)
+{
+    (void)topology;
+}
+
+bool CMP_SetThreadNodeAffinity(const CMP_CpuNode& node)
+{
+    (void)node;
+    return false;
+}
+
+#endif
+
+const CMP_CpuTopology& CMP_GetCpuTopology()
+{
+    static CMP_CpuTopology topology = []() {
+        CMP_CpuTopology detected;
+        detected.nNumPerfCpus = 0;
+        detected.nNumEffCpus  = 0;
+        DetectTopology(detected);
+
+        // Without node information treat the machine as a single node
+        if (detected.nodes.empty())
+        {
+            CMP_CpuNode node;
+            node.nNodeId = 0;
+            CMP_INT nCpus = (CMP_INT)std::thread::hardware_concurrency();
+            for (CMP_INT cpu = 0; cpu < (std::max)(nCpus, 1); cpu++)
+                node.cpus.push_back(cpu);
+            detected.nodes.push_back(node);
+        }
+
+        detected.nNumCpus = 0;
+        for (auto& node : detected.nodes)
+            detected.nNumCpus += (CMP_INT)node.cpus.size();
+        return detected;
+    }();
+    return topology;
+}
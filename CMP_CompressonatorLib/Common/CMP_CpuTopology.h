@@ -0,0 +1,57 @@
+//===============================================================================
+// Copyright (c) 2020  Advanced Micro Devices, Inc. All rights reserved.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//
+//  File Name:   CMP_CpuTopology.h
+//  Description: NUMA node and core type layout of the processors the library
+//               may run on, used to place the thread pool workers
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CMP_CPUTOPOLOGY_H_INCLUDED_
+#define _CMP_CPUTOPOLOGY_H_INCLUDED_
+
+#include "Compressonator.h"
+
+#include <vector>
+
+struct CMP_CpuNode
+{
+    CMP_INT              nNodeId;   // Operating system node number
+    std::vector<CMP_INT> cpus;      // Logical processors of the node the process may run on
+};
+
+struct CMP_CpuTopology
+{
+    std::vector<CMP_CpuNode> nodes;         // Nodes with at least one usable processor, always at least one
+    CMP_INT                  nNumCpus;      // Usable logical processors over all the nodes
+    CMP_INT                  nNumPerfCpus;  // Logical processors on performance cores (0 = single core type)
+    CMP_INT                  nNumEffCpus;   // Logical processors on efficiency cores
+};
+
+// Returns the topology, detected on the first call
+const CMP_CpuTopology& CMP_GetCpuTopology();
+
+// Restricts the calling thread to the processors of node, returns false if not supported
+bool CMP_SetThreadNodeAffinity(const CMP_CpuNode& node);
+
+#endif // !defined(_CMP_CPUTOPOLOGY_H_INCLUDED_)
@@ -0,0 +1,161 @@
+//===============================================================================
+// Copyright (c) 2020  Advanced Micro Devices, Inc. All rights reserved.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//
+//  File Name:   CMP_HalfConvert.cpp
+//  Description: Bulk conversion between half and float arrays
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "CMP_HalfConvert.h"
+#include "Codec.h"
+
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif // USE_SSE2
+
+typedef void (*HalfToFloatProc)(float fDst[], const CMP_HALF hSrc[], CMP_DWORD dwCount);
+typedef void (*FloatToHalfProc)(CMP_HALF hDst[], const float fSrc[], CMP_DWORD dwCount);
+
+#ifdef USE_SSE2
+// Same result as the half to float table: normals are rebiased, Inf/NaN get the
+// full exponent and denormals are normalised with a float subtract that never
+// produces a denormal, so it is also safe with DAZ/FTZ enabled
+static inline __m128i HalfToFloat4(__m128i h)
+{
+    const __m128i zero      = _mm_setzero_si128();
+    const __m128i expMask   = _mm_set1_epi32(0x0F800000);
+    const __m128i expAdjust = _mm_set1_epi32(0x38000000);
+    const __m128i expDenorm = _mm_set1_epi32(0x00800000);
+    const __m128  magic     = _mm_castsi128_ps(_mm_set1_epi32(0x38800000));
+
+    __m128i o    = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7FFF)), 13);
+    __m128i exp  = _mm_and_si128(o, expMask);
+    o = _mm_add_epi32(o, expAdjust);
+    o = _mm_add_epi32(o, _mm_and_si128(_mm_cmpeq_epi32(exp, expMask), expAdjust));
+
+    __m128i isDenorm = _mm_cmpeq_epi32(exp, zero);
+    __m128i denorm   = _mm_castps_si128(_mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(o, expDenorm)), magic));
+    o = _mm_or_si128(_mm_andnot_si128(isDenorm, o), _mm_and_si128(isDenorm, denorm));
+    return _mm_or_si128(o, _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16));
+}
+
+// Round to nearest even. Normals are rebiased and rounded in the integer domain, values
+// too small for a normal half are rounded by adding them to a float whose last mantissa
+// bit is the smallest half denormal. NaN lanes are left to the caller.
+static inline __m128i FloatToHalf4(__m128i i)
+{
+    const __m128i f16Max      = _mm_set1_epi32(((127 + 16) << 23) - 1);
+    const __m128i denormMax   = _mm_set1_epi32(113 << 23);
+    const __m128i denormMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i rebias      = _mm_set1_epi32(((15 - 127) << 23) + 0xFFF);
+    const __m128i one         = _mm_set1_epi32(1);
+
+    __m128i sign = _mm_and_si128(i, _mm_set1_epi32(0x80000000));
+    i = _mm_xor_si128(i, sign);
+
+    __m128i normal = _mm_add_epi32(_mm_add_epi32(i, rebias), _mm_and_si128(_mm_srli_epi32(i, 13), one));
+    normal = _mm_srli_epi32(normal, 13);
+    __m128i denorm = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(i), _mm_castsi128_ps(denormMagic))), denormMagic);
+
+    __m128i isDenorm   = _mm_cmplt_epi32(i, denormMax);
+    __m128i isOverflow = _mm_cmpgt_epi32(i, f16Max);
+    __m128i o = _mm_or_si128(_mm_andnot_si128(isDenorm, normal), _mm_and_si128(isDenorm, denorm));
+    o = _mm_or_si128(_mm_andnot_si128(isOverflow, o), _mm_and_si128(isOverflow, _mm_set1_epi32(0x7C00)));
+    return _mm_or_si128(o, _mm_srli_epi32(sign, 16));
+}
+#endif // USE_SSE2
+
+static void HalfToFloat(float fDst[], const CMP_HALF hSrc[], CMP_DWORD dwCount)
+{
+    CMP_DWORD i = 0;
+#ifdef USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for(; i + 8 <= dwCount; i += 8)
+    {
+        __m128i h8 = _mm_loadu_si128((const __m128i*) &hSrc[i]);
+        _mm_storeu_ps(&fDst[i],     _mm_castsi128_ps(HalfToFloat4(_mm_unpacklo_epi16(h8, zero))));
+        _mm_storeu_ps(&fDst[i + 4], _mm_castsi128_ps(HalfToFloat4(_mm_unpackhi_epi16(h8, zero))));
+    }
+#endif
+    for(; i < dwCount; i++)
+        fDst[i] = (float) hSrc[i];
+}
+
+static void FloatToHalf(CMP_HALF hDst[], const float fSrc[], CMP_DWORD dwCount)
+{
+    CMP_DWORD i = 0;
+#ifdef USE_SSE2
+    const __m128i absMask = _mm_set1_epi32(0x7FFFFFFF);
+    const __m128i infBits = _mm_set1_epi32(0x7F800000);
+    for(; i + 8 <= dwCount; i += 8)
+    {
+        __m128i f0 = _mm_castps_si128(_mm_loadu_ps(&fSrc[i]));
+        __m128i f1 = _mm_castps_si128(_mm_loadu_ps(&fSrc[i + 4]));
+
+        // Sign extend the halves so the signed pack keeps their bits
+        __m128i h0 = _mm_srai_epi32(_mm_slli_epi32(FloatToHalf4(f0), 16), 16);
+        __m128i h1 = _mm_srai_epi32(_mm_slli_epi32(FloatToHalf4(f1), 16), 16);
+        _mm_storeu_si128((__m128i*) &hDst[i], _mm_packs_epi32(h0, h1));
+
+        __m128i nan = _mm_or_si128(_mm_cmpgt_epi32(_mm_and_si128(f0, absMask), infBits),
+                                   _mm_cmpgt_epi32(_mm_and_si128(f1, absMask), infBits));
+        if(_mm_movemask_epi8(nan))
+        {
+            for(CMP_DWORD k = i; k < i + 8; k++)
+                hDst[k] = fSrc[k];
+        }
+    }
+#endif
+    for(; i < dwCount; i++)
+        hDst[i] = fSrc[i];
+}
+
+static HalfToFloatProc GetHalfToFloatProc()
+{
+#ifdef CMP_HALF_F16C
+    if(SupportsF16C())
+        return CMP_HalfToFloat_F16C;
+#endif
+    return HalfToFloat;
+}
+
+static FloatToHalfProc GetFloatToHalfProc()
+{
+#ifdef CMP_HALF_F16C
+    if(SupportsF16C())
+        return CMP_FloatToHalf_F16C;
+#endif
+    return FloatToHalf;
+}
+
+void CMP_HalfToFloat(float fDst[], const CMP_HALF hSrc[], CMP_DWORD dwCount)
+{
+    static const HalfToFloatProc pHalfToFloat = GetHalfToFloatProc();
+    pHalfToFloat(fDst, hSrc, dwCount);
+}
+
+void CMP_FloatToHalf(CMP_HALF hDst[], const float fSrc[], CMP_DWORD dwCount)
+{
+    static const FloatToHalfProc pFloatToHalf = GetFloatToHalfProc();
+    pFloatToHalf(hDst, fSrc, dwCount);
+}
@@ -0,0 +1,50 @@
+//===============================================================================
+// Copyright (c) 2020  Advanced Micro Devices, Inc. All rights reserved.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//
+//  File Name:   CMP_HalfConvert.h
+//  Description: Bulk conversion between half and float arrays
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CMP_HALFCONVERT_H_INCLUDED_
+#define _CMP_HALFCONVERT_H_INCLUDED_
+
+#include "Common.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CMP_HALF_F16C
+#endif
+
+// Both directions give the same bits as converting each value with CMP_HALF, rounding
+// to nearest even and keeping NaN payloads. The widest of F16C, SSE2 or plain code the
+// processor supports is picked on the first call.
+void CMP_HalfToFloat(float fDst[], const CMP_HALF hSrc[], CMP_DWORD dwCount);
+void CMP_FloatToHalf(CMP_HALF hDst[], const float fSrc[], CMP_DWORD dwCount);
+
+#ifdef CMP_HALF_F16C
+// F16C variants, only to be called when SupportsF16C() is true
+void CMP_HalfToFloat_F16C(float fDst[], const CMP_HALF hSrc[], CMP_DWORD dwCount);
+void CMP_FloatToHalf_F16C(CMP_HALF hDst[], const float fSrc[], CMP_DWORD dwCount);
+#endif
+
+#endif // !defined(_CMP_HALFCONVERT_H_INCLUDED_)
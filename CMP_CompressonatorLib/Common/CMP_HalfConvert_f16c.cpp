@@ -0,0 +1,80 @@
+//===============================================================================
+// Copyright (c) 2020  Advanced Micro Devices, Inc. All rights reserved.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//
+//  File Name:   CMP_HalfConvert_f16c.cpp
+//  Description: F16C half and float conversion, built with AVX and F16C code
+//               generation and only called on processors that support both
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "CMP_HalfConvert.h"
+
+#ifdef CMP_HALF_F16C
+
+#include <immintrin.h>
+
+// The F16C instructions quiet signaling NaNs, lanes holding a NaN are redone with
+// CMP_HALF so the payload comes out the same as on the other paths
+
+void CMP_HalfToFloat_F16C(float fDst[], const CMP_HALF hSrc[], CMP_DWORD dwCount)
+{
+    const __m128i absMask = _mm_set1_epi16(0x7FFF);
+    const __m128i infBits = _mm_set1_epi16(0x7C00);
+
+    CMP_DWORD i = 0;
+    for(; i + 8 <= dwCount; i += 8)
+    {
+        __m128i h8 = _mm_loadu_si128((const __m128i*) &hSrc[i]);
+        _mm256_storeu_ps(&fDst[i], _mm256_cvtph_ps(h8));
+
+        if(_mm_movemask_epi8(_mm_cmpgt_epi16(_mm_and_si128(h8, absMask), infBits)))
+        {
+            for(CMP_DWORD k = i; k < i + 8; k++)
+                fDst[k] = (float) hSrc[k];
+        }
+    }
+    _mm256_zeroupper();
+    for(; i < dwCount; i++)
+        fDst[i] = (float) hSrc[i];
+}
+
+void CMP_FloatToHalf_F16C(CMP_HALF hDst[], const float fSrc[], CMP_DWORD dwCount)
+{
+    CMP_DWORD i = 0;
+    for(; i + 8 <= dwCount; i += 8)
+    {
+        __m256 f8 = _mm256_loadu_ps(&fSrc[i]);
+        _mm_storeu_si128((__m128i*) &hDst[i], _mm256_cvtps_ph(f8, _MM_FROUND_TO_NEAREST_INT));
+
+        if(_mm256_movemask_ps(_mm256_cmp_ps(f8, f8, _CMP_UNORD_Q)))
+        {
+            for(CMP_DWORD k = i; k < i + 8; k++)
+                hDst[k] = fSrc[k];
+        }
+    }
+    _mm256_zeroupper();
+    for(; i < dwCount; i++)
+        hDst[i] = fSrc[i];
+}
+
+#endif // CMP_HALF_F16C
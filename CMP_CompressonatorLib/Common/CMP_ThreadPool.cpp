@@ -0,0 +1,442 @@
+//===============================================================================
+// Copyright (c) 2020  Advanced Micro Devices, Inc. All rights reserved.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//
+//  File Name:   CMP_ThreadPool.cpp
+//  Description: Library wide work-stealing thread pool used by the CPU codecs
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include "CMP_ThreadPool.h"
+#include "CMP_CpuTopology.h"
+
+#include <algorithm>
+#include <chrono>
+
+extern CMP_INT CMP_GetNumberOfProcessors();
+
+// The pool is released by Initialize() and Shutdown() only when this is its last reference
+static std::mutex                      g_ThreadPoolMutex;
+static std::shared_ptr<CMP_ThreadPool> g_pThreadPool;
+
+static thread_local CMP_INT t_WorkerSlot = CMP_EXTERNAL_SLOT;
+static thread_local CMP_INT t_WorkerNode = -1;
+
+CMP_ThreadPool::CMP_ThreadPool(CMP_DWORD dwNumThreads, CMP_ThreadPlacement placement)
+{
+    if (dwNumThreads == 0)
+        dwNumThreads = (CMP_DWORD)CMP_GetNumberOfProcessors();
+    if (dwNumThreads == 0)
+        dwNumThreads = 1;
+    if (dwNumThreads > CMP_MAX_POOL_THREADS)
+        dwNumThreads = CMP_MAX_POOL_THREADS;
+
+    m_NextQueue    = 0;
+    m_PendingTasks = 0;
+    m_Exit         = false;
+    m_dwNumNodes   = 1;
+
+    const CMP_CpuTopology& topology = CMP_GetCpuTopology();
+    if ((placement == CMP_THREAD_PLACEMENT_NUMA) && (topology.nodes.size() > 1))
+        m_dwNumNodes = (CMP_DWORD)(std::min)(topology.nodes.size(), (size_t)dwNumThreads);
+
+    for (CMP_DWORD i = 0; i < dwNumThreads; i++)
+        m_Queues.push_back(new WorkQueue);
+
+    // Consecutive workers share a node, node n gets workers [n * threads / nodes, (n + 1) * threads / nodes)
+    for (CMP_DWORD i = 0; i < dwNumThreads; i++)
+    {
+        CMP_INT nNode = (m_dwNumNodes > 1) ? (CMP_INT)((i * m_dwNumNodes) / dwNumThreads) : -1;
+        m_Workers.push_back(std::thread(&CMP_ThreadPool::WorkerProc, this, (CMP_INT)i, nNode));
+    }
+}
+
+CMP_ThreadPool::~CMP_ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_WakeMutex);
+        m_Exit = true;
+    }
+    m_WakeCondition.notify_all();
+
+    for (auto& worker : m_Workers)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+
+    for (auto queue : m_Queues)
+        delete queue;
+}
+
+std::shared_ptr<CMP_ThreadPool> CMP_ThreadPool::GetThreadPool()
+{
+    std::lock_guard<std::mutex> lock(g_ThreadPoolMutex);
+    if (!g_pThreadPool)
+        g_pThreadPool = std::make_shared<CMP_ThreadPool>(0);
+    return g_pThreadPool;
+}
+
+// Moves the library pool out of g_pThreadPool if nothing else references it. Tasks can only be
+// queued through a reference, so the pool is idle apart from tasks that are returning and
+// joining its workers can not wait on work that needs the pool mutex.
+static bool TakeIdleThreadPool(std::shared_ptr<CMP_ThreadPool>& pPool)
+{
+    if (g_pThreadPool && (g_pThreadPool.use_count() > 1))
+        return false;
+    pPool = std::move(g_pThreadPool);
+    return true;
+}
+
+bool CMP_ThreadPool::Initialize(CMP_DWORD dwNumThreads, CMP_ThreadPlacement placement)
+{
+    // Can not resize the pool from one of its own workers
+    if (t_WorkerSlot != CMP_EXTERNAL_SLOT)
+        return false;
+
+    std::shared_ptr<CMP_ThreadPool> pOldPool;
+    {
+        std::lock_guard<std::mutex> lock(g_ThreadPoolMutex);
+        if (!TakeIdleThreadPool(pOldPool))
+            return false;
+        g_pThreadPool = std::make_shared<CMP_ThreadPool>(dwNumThreads, placement);
+    }
+
+    // The old workers are joined here, outside the lock
+    pOldPool.reset();
+    return true;
+}
+
+bool CMP_ThreadPool::Shutdown()
+{
+    if (t_WorkerSlot != CMP_EXTERNAL_SLOT)
+        return false;
+
+    std::shared_ptr<CMP_ThreadPool> pOldPool;
+    {
+        std::lock_guard<std::mutex> lock(g_ThreadPoolMutex);
+        if (!TakeIdleThreadPool(pOldPool))
+            return false;
+    }
+
+    pOldPool.reset();
+    return true;
+}
+
+CMP_INT CMP_ThreadPool::GetWorkerSlot()
+{
+    return t_WorkerSlot;
+}
+
+CMP_INT CMP_ThreadPool::GetWorkerNode()
+{
+    return t_WorkerNode;
+}
+
+void CMP_ThreadPool::Submit(CMP_Task task)
+{
+    CMP_DWORD dwQueue;
+    if (t_WorkerSlot < (CMP_INT)m_Queues.size())
+        dwQueue = (CMP_DWORD)t_WorkerSlot;
+    else
+        dwQueue = m_NextQueue++ % (CMP_DWORD)m_Queues.size();
+
+    {
+        std::lock_guard<std::mutex> lock(m_Queues[dwQueue]->m_Mutex);
+        m_Queues[dwQueue]->m_Tasks.push_back(std::move(task));
+    }
+    m_PendingTasks++;
+
+    {
+        std::lock_guard<std::mutex> lock(m_WakeMutex);
+    }
+    m_WakeCondition.notify_one();
+}
+
+bool CMP_ThreadPool::PopTask(CMP_INT nIndex, CMP_Task& task)
+{
+    CMP_INT nQueues = (CMP_INT)m_Queues.size();
+
+    // Newest work from our own queue first, it is most likely still in cache
+    {
+        WorkQueue*                  queue = m_Queues[nIndex];
+        std::lock_guard<std::mutex> lock(queue->m_Mutex);
+        if (!queue->m_Tasks.empty())
+        {
+            task = std::move(queue->m_Tasks.back());
+            queue->m_Tasks.pop_back();
+            m_PendingTasks--;
+            return true;
+        }
+    }
+
+    // Then steal the oldest work from the other workers
+    for (CMP_INT i = 1; i < nQueues; i++)
+    {
+        WorkQueue*                  queue = m_Queues[(nIndex + i) % nQueues];
+        std::lock_guard<std::mutex> lock(queue->m_Mutex);
+        if (!queue->m_Tasks.empty())
+        {
+            task = std::move(queue->m_Tasks.front());
+            queue->m_Tasks.pop_front();
+            m_PendingTasks--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool CMP_ThreadPool::RunPendingTask()
+{
+    // Only pool workers help out. Threads outside the pool share the single
+    // CMP_EXTERNAL_SLOT and running another caller's task on it is not safe.
+    if (t_WorkerSlot >= (CMP_INT)m_Queues.size())
+        return false;
+
+    CMP_Task task;
+    if (!PopTask(t_WorkerSlot, task))
+        return false;
+
+    task();
+    return true;
+}
+
+void CMP_ThreadPool::WorkerProc(CMP_INT nIndex, CMP_INT nNode)
+{
+    t_WorkerSlot = nIndex;
+    if ((nNode >= 0) && CMP_SetThreadNodeAffinity(CMP_GetCpuTopology().nodes[nNode]))
+        t_WorkerNode = nNode;
+
+    for (;;)
+    {
+        CMP_Task task;
+        if (PopTask(nIndex, task))
+        {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_WakeMutex);
+        m_WakeCondition.wait(lock, [this] { return m_Exit || m_PendingTasks > 0; });
+        if (m_Exit && m_PendingTasks <= 0)
+            break;
+    }
+
+    t_WorkerSlot = CMP_EXTERNAL_SLOT;
+    t_WorkerNode = -1;
+}
+
+//=================================================================================
+
+CMP_TaskGroup::CMP_TaskGroup()
+{
+    m_pPool    = CMP_ThreadPool::GetThreadPool();
+    m_Pending  = 0;
+    m_Canceled = false;
+}
+
+CMP_TaskGroup::~CMP_TaskGroup()
+{
+    Wait();
+}
+
+void CMP_TaskGroup::Run(CMP_Task task)
+{
+    m_Pending++;
+    m_pPool->Submit([this, task]() {
+        if (!m_Canceled)
+            task();
+
+        // Signal under the lock so the group can not be destroyed by a waiter
+        // between the decrement and the notify
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (--m_Pending == 0)
+            m_Done.notify_all();
+    });
+}
+
+void CMP_TaskGroup::Wait()
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            if (m_Pending == 0)
+                return;
+        }
+
+        if (!m_pPool->RunPendingTask())
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            if (CMP_ThreadPool::GetWorkerSlot() == CMP_EXTERNAL_SLOT)
+                m_Done.wait(lock, [this] { return m_Pending == 0; });
+            else
+                m_Done.wait_for(lock, std::chrono::milliseconds(1), [this] { return m_Pending == 0; });
+        }
+    }
+}
+
+bool CMP_TaskGroup::WaitFor(CMP_DWORD dwMilliseconds)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(dwMilliseconds);
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            if (m_Pending == 0)
+                return true;
+        }
+
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+
+        if (!m_pPool->RunPendingTask())
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            if (CMP_ThreadPool::GetWorkerSlot() == CMP_EXTERNAL_SLOT)
+                return m_Done.wait_until(lock, deadline, [this] { return m_Pending == 0; });
+            m_Done.wait_for(lock, std::chrono::milliseconds(1), [this] { return m_Pending == 0; });
+        }
+    }
+}
+
+//=================================================================================
+
+CMP_ProgressCounter::CMP_ProgressCounter() : m_Counts(CMP_ThreadPool::GetThreadPool()->GetNumThreads() + 1)
+{
+    for (auto& count : m_Counts)
+        count.m_Count.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t CMP_ProgressCounter::GetTotal() const
+{
+    std::uint64_t dwTotal = 0;
+    for (auto& count : m_Counts)
+        dwTotal += count.m_Count.load(std::memory_order_relaxed);
+    return dwTotal;
+}
+
+//=================================================================================
+
+CMP_ProgressThrottle::CMP_ProgressThrottle(const CMP_ProgressProc& progressProc)
+    : m_ProgressProc(progressProc)
+    , m_NextReport(std::chrono::steady_clock::now())
+    , m_fLastProgress(-1.0f)
+    , m_fHeldProgress(-1.0f)
+    , m_bAborted(false)
+{
+}
+
+bool CMP_ProgressThrottle::Report(float fProgress)
+{
+    if (m_bAborted || !m_ProgressProc || (fProgress == m_fLastProgress))
+        return m_bAborted;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if ((now < m_NextReport) && (fProgress < 100.0f))
+    {
+        m_fHeldProgress = fProgress;
+        return false;
+    }
+
+    m_NextReport    = now + std::chrono::milliseconds(CMP_PROGRESS_INTERVAL_MS);
+    m_fLastProgress = fProgress;
+    m_bAborted      = m_ProgressProc(fProgress);
+    return m_bAborted;
+}
+
+void CMP_ProgressThrottle::Flush()
+{
+    if (!m_bAborted && m_ProgressProc && (m_fHeldProgress > m_fLastProgress))
+    {
+        m_fLastProgress = m_fHeldProgress;
+        m_bAborted      = m_ProgressProc(m_fHeldProgress);
+    }
+}
+
+//=================================================================================
+
+bool CMP_ParallelRows(CMP_DWORD dwRows, CMP_DWORD dwMaxTasks, CMP_RowProc rowProc, CMP_ProgressProc progressProc)
+{
+    if (dwRows == 0)
+        return true;
+
+    CMP_TaskGroup       taskGroup;
+    CMP_ProgressCounter rowsDone;
+
+    std::shared_ptr<CMP_ThreadPool> pPool      = CMP_ThreadPool::GetThreadPool();
+    CMP_DWORD                       dwNumTasks = pPool->GetNumThreads();
+    if ((dwMaxTasks > 0) && (dwMaxTasks < dwNumTasks))
+        dwNumTasks = dwMaxTasks;
+    if (dwNumTasks > dwRows)
+        dwNumTasks = dwRows;
+
+    // One range of rows per node, range n is [n * rows / nodes, (n + 1) * rows / nodes)
+    CMP_DWORD dwNumRanges = (std::min)(pPool->GetNumNodes(), dwRows);
+    std::vector<std::atomic<CMP_DWORD>> nextRow(dwNumRanges);
+    for (CMP_DWORD n = 0; n < dwNumRanges; n++)
+        nextRow[n] = (CMP_DWORD)(((std::uint64_t)n * dwRows) / dwNumRanges);
+
+    for (CMP_DWORD i = 0; i < dwNumTasks; i++)
+    {
+        taskGroup.Run([&]() {
+            CMP_INT   nNode   = CMP_ThreadPool::GetWorkerNode();
+            CMP_DWORD dwFirst = (nNode >= 0) ? (CMP_DWORD)nNode % dwNumRanges : 0;
+            for (CMP_DWORD r = 0; r < dwNumRanges; r++)
+            {
+                CMP_DWORD dwRange = (dwFirst + r) % dwNumRanges;
+                CMP_DWORD dwEnd   = (CMP_DWORD)(((std::uint64_t)(dwRange + 1) * dwRows) / dwNumRanges);
+                for (;;)
+                {
+                    if (taskGroup.IsCanceled())
+                        return;
+                    CMP_DWORD dwRow = nextRow[dwRange]++;
+                    if (dwRow >= dwEnd)
+                        break;
+                    rowProc(dwRow);
+                    rowsDone.Add();
+                }
+            }
+        });
+    }
+
+    CMP_ProgressThrottle throttle(progressProc);
+    while (!taskGroup.WaitFor(progressProc ? 10 : 1000))
+    {
+        if (!progressProc)
+            continue;
+
+        if (throttle.Report((100.0f * rowsDone.GetTotal()) / dwRows))
+        {
+            taskGroup.Cancel();
+            taskGroup.Wait();
+            return false;
+        }
+    }
+
+    // The work is complete, an abort asked for now is too late to matter
+    throttle.Report(100.0f);
+
+    return true;
+}
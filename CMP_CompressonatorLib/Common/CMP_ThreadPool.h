@@ -0,0 +1,235 @@
+//===============================================================================
+// Copyright (c) 2020  Advanced Micro Devices, Inc. All rights reserved.
+//===============================================================================
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//
+//  File Name:   CMP_ThreadPool.h
+//  Description: Library wide work-stealing thread pool used by the CPU codecs
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CMP_THREADPOOL_H_INCLUDED_
+#define _CMP_THREADPOOL_H_INCLUDED_
+
+#include "Compressonator.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Maximum number of worker threads the pool will create
+#define CMP_MAX_POOL_THREADS    128
+
+// Slot index returned by CMP_ThreadPool::GetWorkerSlot() for threads that do not
+// belong to the pool (for example the application thread calling into the SDK).
+// Codecs that keep per thread encoder instances size their tables with
+// CMP_MAX_POOL_SLOTS so both pool workers and the calling thread have a slot.
+#define CMP_EXTERNAL_SLOT       CMP_MAX_POOL_THREADS
+#define CMP_MAX_POOL_SLOTS      (CMP_MAX_POOL_THREADS + 1)
+
+typedef std::function<void()> CMP_Task;
+
+class CMP_ThreadPool
+{
+public:
+    CMP_ThreadPool(CMP_DWORD dwNumThreads, CMP_ThreadPlacement placement = CMP_THREAD_PLACEMENT_NONE);
+    ~CMP_ThreadPool();
+
+    // Returns the library pool, creating it on first use with one worker per processor.
+    // Whoever queues work on the pool keeps the returned reference until that work is done.
+    static std::shared_ptr<CMP_ThreadPool> GetThreadPool();
+
+    // Recreates the library pool using dwNumThreads workers (0 = number of processors).
+    // Returns false if the pool is still referenced, that is while any work may be queued on it.
+    static bool Initialize(CMP_DWORD dwNumThreads, CMP_ThreadPlacement placement = CMP_THREAD_PLACEMENT_NONE);
+
+    // Destroys the library pool, returns false if it is still referenced as for Initialize()
+    static bool Shutdown();
+
+    // Returns the pool worker index of the calling thread or CMP_EXTERNAL_SLOT
+    static CMP_INT GetWorkerSlot();
+
+    // Returns the index in CMP_GetCpuTopology().nodes of the node the calling worker
+    // is kept on, or -1 for threads that are not placed on a node
+    static CMP_INT GetWorkerNode();
+
+    CMP_DWORD GetNumThreads() const
+    {
+        return (CMP_DWORD)m_Workers.size();
+    }
+
+    // Number of nodes the workers are placed on, 1 unless placed with CMP_THREAD_PLACEMENT_NUMA
+    CMP_DWORD GetNumNodes() const
+    {
+        return m_dwNumNodes;
+    }
+
+    // Queues a task. Tasks queued from a worker go to that worker's own queue,
+    // tasks queued from any other thread are distributed over all the workers.
+    void Submit(CMP_Task task);
+
+    // Runs one queued task on the calling thread, returns false if none were found.
+    // Used by threads that wait on work so they help rather than block.
+    bool RunPendingTask();
+
+private:
+    struct WorkQueue
+    {
+        std::mutex           m_Mutex;
+        std::deque<CMP_Task> m_Tasks;
+    };
+
+    void WorkerProc(CMP_INT nIndex, CMP_INT nNode);
+    bool PopTask(CMP_INT nIndex, CMP_Task& task);
+
+    std::vector<std::thread> m_Workers;
+    std::vector<WorkQueue*>  m_Queues;
+    std::atomic<CMP_DWORD>   m_NextQueue;
+    std::atomic<CMP_INT>     m_PendingTasks;
+    CMP_DWORD                m_dwNumNodes;
+
+    std::mutex               m_WakeMutex;
+    std::condition_variable  m_WakeCondition;
+    bool                     m_Exit;
+};
+
+//
+// A set of tasks that can be waited on as a unit.
+//
+// The thread calling Wait() executes queued pool tasks while it waits, this
+// keeps the pool deadlock free when a task itself submits and waits on more work
+// (for example a mip level job that compresses its block rows on the pool).
+//
+class CMP_TaskGroup
+{
+public:
+    CMP_TaskGroup();
+    ~CMP_TaskGroup();
+
+    void Run(CMP_Task task);
+    void Wait();
+
+    // Waits at most dwMilliseconds, returns true if all the tasks have completed
+    bool WaitFor(CMP_DWORD dwMilliseconds);
+
+    // Tasks that have not started yet are skipped once the group is canceled
+    void Cancel()
+    {
+        m_Canceled = true;
+    }
+    bool IsCanceled() const
+    {
+        return m_Canceled;
+    }
+
+private:
+    std::shared_ptr<CMP_ThreadPool> m_pPool;
+    std::atomic<CMP_INT>     m_Pending;
+    std::atomic<bool>        m_Canceled;
+    std::mutex               m_Mutex;
+    std::condition_variable  m_Done;
+};
+
+//
+// Count of finished work items kept as one counter per pool slot, each on its own
+// cache line, so workers never contend on it. Only the reporting thread sums them.
+//
+class CMP_ProgressCounter
+{
+public:
+    CMP_ProgressCounter();
+
+    // Called by any thread when it finishes dwCount items
+    void Add(CMP_DWORD dwCount = 1)
+    {
+        CMP_INT slot = CMP_ThreadPool::GetWorkerSlot();
+        if (slot >= (CMP_INT)m_Counts.size())
+            slot = (CMP_INT)m_Counts.size() - 1;
+        m_Counts[slot].m_Count.fetch_add(dwCount, std::memory_order_relaxed);
+    }
+
+    // 64 bit, the pixels of all the levels and faces of a large cube map array do not fit a CMP_DWORD
+    std::uint64_t GetTotal() const;
+
+private:
+    // Padded rather than aligned, the vector allocator does not honour over alignment before C++17
+    struct Count
+    {
+        std::atomic<std::uint64_t> m_Count;
+        char                       m_Padding[64 - sizeof(std::atomic<std::uint64_t>)];
+    };
+
+    // One count per pool worker, the last one is shared by the threads outside the pool
+    std::vector<Count> m_Counts;
+};
+
+typedef std::function<bool(float)> CMP_ProgressProc;
+
+// Rate at which progress is reported to the application
+#define CMP_PROGRESS_INTERVAL_MS 100
+
+//
+// Forwards progress to progressProc at most once every CMP_PROGRESS_INTERVAL_MS,
+// 100% is always forwarded. Used on the reporting thread only, so progress output
+// such as a console line costs the same whatever the number of blocks or workers.
+//
+class CMP_ProgressThrottle
+{
+public:
+    CMP_ProgressThrottle(const CMP_ProgressProc& progressProc);
+
+    // Returns true if progressProc asked to abort, now or on an earlier call
+    bool Report(float fProgress);
+
+    // Forwards the last progress value held back by the rate limit
+    void Flush();
+
+private:
+    const CMP_ProgressProc&               m_ProgressProc;
+    std::chrono::steady_clock::time_point m_NextReport;
+    float                                 m_fLastProgress;
+    float                                 m_fHeldProgress;
+    bool                                  m_bAborted;
+};
+
+//
+// Runs rowProc(row) for every row in [0, dwRows) using at most dwMaxTasks pool tasks
+// (0 = one per pool worker). Rows are handed out in order from a shared counter, the
+// calling thread reports progress (0..100) through progressProc, at most every
+// CMP_PROGRESS_INTERVAL_MS, until all the rows are done. Returns false if
+// progressProc asked to abort.
+//
+// When the pool workers are placed on NUMA nodes the rows are split into one range
+// per node and workers take rows from their own node's range first, so the output
+// pages a row writes are first touched, and allocated, on that node.
+//
+typedef std::function<void(CMP_DWORD)> CMP_RowProc;
+
+bool CMP_ParallelRows(CMP_DWORD dwRows, CMP_DWORD dwMaxTasks, CMP_RowProc rowProc, CMP_ProgressProc progressProc);
+
+#endif // !defined(_CMP_THREADPOOL_H_INCLUDED_)
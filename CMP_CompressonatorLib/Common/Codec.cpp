@@ -29,6 +29,7 @@
 
 #include "Common.h"
 #include "Codec.h"
+#include "CMP_CancelToken.h"
 #include "Codec_ATI1N.h"
 #include "Codec_ATI2N.h"
 #include "Codec_ATI2N_DXT5.h"
@@ -65,13 +66,24 @@
 
 CCodec::CCodec(CodecType codecType)
 {
-    m_CodecType = codecType;
+    m_CodecType    = codecType;
+    m_hCancelToken = NULL;
 }
 
 CCodec::~CCodec()
 {
 }
 
+bool CCodec::IsCanceled() const
+{
+    return CMP_IsCanceled(m_hCancelToken);
+}
+
+bool CCodec::IsDegraded() const
+{
+    return CMP_IsDegraded(m_hCancelToken);
+}
+
 bool CCodec::SetParameter(const CMP_CHAR* /*pszParamName*/, CMP_CHAR* /*dwValue*/)
 {
     return false;
@@ -147,6 +159,33 @@ bool SupportsSSE2()
     return false;
 }
 
+// F16C is VEX encoded, so the OS must also save the YMM registers
+bool SupportsF16C()
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    int info[4];
+    cpuid(info, 0);
+    if (info[0] < 1)
+        return false;
+
+    cpuid(info, 1);
+    const int nF16C_AVX_OSXSAVE = ((int)1 << 29) | ((int)1 << 28) | ((int)1 << 27);
+    if ((info[2] & nF16C_AVX_OSXSAVE) != nF16C_AVX_OSXSAVE)
+        return false;
+
+#ifdef _WIN32
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    unsigned long long xcr0 = ((unsigned long long)edx << 32) | eax;
+#endif
+    return (xcr0 & 0x06) == 0x06;
+#else
+    return false;
+#endif
+}
+
 CCodec* CreateCodec(CodecType nCodecType)
 {
 #ifdef USE_DBGTRACE
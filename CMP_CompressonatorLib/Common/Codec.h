@@ -54,6 +54,7 @@ public:
     
     virtual CodecType GetType() const {return m_CodecType;};
 
+    virtual CMP_DWORD GetBlockWidth()  {return 1;};
     virtual CMP_DWORD GetBlockHeight() {return 1;};
 
     virtual CCodecBuffer* CreateBuffer(
@@ -63,8 +64,14 @@ public:
     virtual CodecError Compress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut, Codec_Feedback_Proc pFeedbackProc = NULL, CMP_DWORD_PTR pUser1 = NULL, CMP_DWORD_PTR pUser2 = NULL) = 0;
     virtual CodecError Decompress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut, Codec_Feedback_Proc pFeedbackProc = NULL, CMP_DWORD_PTR pUser1 = NULL, CMP_DWORD_PTR pUser2 = NULL) = 0;
 
+    // Token polled by the block loops, Compress() returns CE_Aborted once it is canceled
+    void SetCancelToken(CMP_CancelToken hCancelToken) {m_hCancelToken = hCancelToken;};
+    bool IsCanceled() const;
+    bool IsDegraded() const;
+
 protected:
-    CodecType m_CodecType;
+    CodecType       m_CodecType;
+    CMP_CancelToken m_hCancelToken;
 };
 
 } // namespace AMD_Compress
@@ -73,6 +80,7 @@ using namespace AMD_Compress;
 
 bool SupportsSSE();
 bool SupportsSSE2();
+bool SupportsF16C();
 
 CCodec* CreateCodec(CodecType nCodecType);
 CMP_DWORD CalcBufferSize(CodecType nCodecType, CMP_DWORD dwWidth, CMP_DWORD dwHeight, CMP_BYTE nBlockWidth, CMP_BYTE nBlockHeight);
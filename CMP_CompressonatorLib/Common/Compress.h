@@ -62,6 +62,14 @@ was #define THREADED_COMPRESS
 #include <thread>
 
 #define MAX_THREADS 64u
+
+// Width and height in pixels of the work items ThreadedCompressTexture hands to the pool
+#define THREADED_COMPRESS_TILE_SIZE 64u
+
+// CMP_ConvertMipTexture with bParallelMipSet: levels with no more than MIPSET_SMALL_LEVEL_PIXELS pixels
+// are compressed single threaded and grouped into jobs of about MIPSET_BATCH_PIXELS pixels
+#define MIPSET_SMALL_LEVEL_PIXELS   (64u * 64u)
+#define MIPSET_BATCH_PIXELS         (128u * 128u)
 static CMP_DWORD GetProcessorCount()
 {
     return std::thread::hardware_concurrency();
@@ -31,6 +31,11 @@
 #include "Common.h"
 #include "Compressonator.h"
 #include "Compress.h"
+#include "CMP_ThreadPool.h"
+#include "CMP_CpuTopology.h"
+#include "CMP_CancelToken.h"
+#include "CodecBuffer_RGBA8888View.h"
+#include "CodecBuffer_RGBA16FView.h"
 #include <assert.h>
 #include <algorithm>
 
@@ -42,8 +47,8 @@
 CMP_INT CMP_GetNumberOfProcessors()
 {
 #ifndef _WIN32
-//    return sysconf(_SC_NPROCESSORS_ONLN);
-    return std::thread::hardware_concurrency();
+    // Processors in the affinity mask of the process, not all the ones installed
+    return CMP_GetCpuTopology().nNumCpus;
 #else
     // Figure out how many cores there are on this machine
     SYSTEM_INFO sysinfo;
@@ -181,211 +186,6 @@ bool NeedSwizzle(CMP_FORMAT destformat)
     return false;
 }
 
-inline float clamp(float a, float l, float h)
-{
-    return (a < l) ? l : ((a > h) ? h : a);
-}
-
-inline float knee(double x, double f)
-{
-    return float(log(x * f + 1.f) / f);
-}
-
-float findKneeValue(float x, float y)
-{
-    float f0 = 0;
-    float f1 = 1.f;
-
-    while (knee(x, f1) > y) {
-        f0 = f1;
-        f1 = f1 * 2.f;
-    }
-
-    for (int i = 0; i < 30; ++i) {
-        const float f2 = (f0 + f1) / 2.f;
-        const float y2 = knee(x, f2);
-
-        if (y2 < y) {
-            f1 = f2;
-        }
-        else {
-            f0 = f2;
-        }
-    }
-
-    return (f0 + f1) / 2.f;
-}
-
-CMP_ERROR Byte2HalfShort(CMP_HALFSHORT* hfsBlock, CMP_BYTE* cBlock, CMP_DWORD dwcBlockSize)
-{
-    assert(hfsBlock);
-    assert(cBlock);
-    assert(dwcBlockSize);
-    if (hfsBlock && cBlock && dwcBlockSize)
-    {
-        for (CMP_DWORD i = 0; i < dwcBlockSize; i++)
-        {
-            hfsBlock[i] = CMP_HALF(float(cBlock[i] / 255.0f)).bits();
-        }
-    }
-
-    return CMP_OK;
-}
-
-
-CMP_ERROR Float2Byte(CMP_BYTE cBlock[], CMP_FLOAT* fBlock, CMP_Texture* srcTexture, CMP_FORMAT destFormat, const CMP_CompressOptions* pOptions)
-{
-    assert(cBlock);
-    assert(fBlock);
-    assert(&srcTexture);
-
-    if (cBlock && fBlock)
-    {
-        CMP_HALF* hfData = (CMP_HALF*)fBlock;
-        float r = 0, g = 0, b = 0, a = 0;
-
-        float kl = powf(2.f, pOptions->fInputKneeLow);
-        float f = findKneeValue(powf(2.f, pOptions->fInputKneeHigh) - kl, powf(2.f, 3.5f) - kl);
-        float luminance3f = powf(2, -3.5);         // always assume max intensity is 1 and 3.5f darker for scale later
-        float invGamma = 1/ pOptions->fInputGamma; //for gamma correction
-        float scale = (float)255.0 * powf(luminance3f, invGamma);
-        int i = 0;
-        bool needSwizzle = false; // NeedSwizzle(destFormat); Bug Fix This is no longer needed for <=BC5 and rel
-        for (unsigned int y = 0; y < srcTexture->dwHeight; y++) {
-            for (unsigned int x = 0; x < srcTexture->dwWidth; x++) {
-                if (srcTexture->format == CMP_FORMAT_ARGB_16F) {
-                    if (needSwizzle) {
-                        b = (float)(*hfData);
-                        hfData++;
-                        g = (float)(*hfData);
-                        hfData++;
-                        r = (float)(*hfData);
-                        hfData++;
-                        a = (float)(*hfData);
-                        hfData++;
-                    }
-                    else 
-                    {
-                        r = (float)(*hfData);
-                        hfData++;
-                        g = (float)(*hfData);
-                        hfData++;
-                        b = (float)(*hfData);
-                        hfData++;
-                        a = (float)(*hfData);
-                        hfData++;
-                    }
-                }
-                else if (srcTexture->format == CMP_FORMAT_ARGB_32F) {
-                    if (needSwizzle) {
-                        b = (float)(*fBlock);
-                        fBlock++;
-                        g = (float)(*fBlock);
-                        fBlock++;
-                        r = (float)(*fBlock);
-                        fBlock++;
-                        a = (float)(*fBlock);
-                        fBlock++;
-                    }
-                    else
-                    {
-                        r = (float)(*fBlock);
-                        fBlock++;
-                        g = (float)(*fBlock);
-                        fBlock++;
-                        b = (float)(*fBlock);
-                        fBlock++;
-                        a = (float)(*fBlock);
-                        fBlock++;
-                    }
-                }
-
-                CMP_BYTE r_b, g_b, b_b, a_b;
-
-
-                //  1) Compensate for fogging by subtracting defog
-                //     from the raw pixel values.
-                // We assume a defog of 0
-                if (pOptions->fInputDefog > 0.0)
-                {
-                    r = r - pOptions->fInputDefog;
-                    g = g - pOptions->fInputDefog;
-                    b = b - pOptions->fInputDefog;
-                    a = a - pOptions->fInputDefog;
-                }
-
-                //  2) Multiply the defogged pixel values by
-                //     2^(exposure + 2.47393).
-                const float exposeScale = powf(2, pOptions->fInputExposure + 2.47393f);
-                r = r * exposeScale;
-                g = g * exposeScale;
-                b = b * exposeScale;
-                a = a * exposeScale;
-
-                //  3) Values that are now 1.0 are called "middle gray".
-                //     If defog and exposure are both set to 0.0, then
-                //     middle gray corresponds to a raw pixel value of 0.18.
-                //     In step 6, middle gray values will be mapped to an
-                //     intensity 3.5 f-stops below the display's maximum
-                //     intensity.
-
-                //  4) Apply a knee function.  The knee function has two
-                //     parameters, kneeLow and kneeHigh.  Pixel values
-                //     below 2^kneeLow are not changed by the knee
-                //     function.  Pixel values above kneeLow are lowered
-                //     according to a logarithmic curve, such that the
-                //     value 2^kneeHigh is mapped to 2^3.5.  (In step 6,
-                //     this value will be mapped to the the display's
-                //     maximum intensity.)
-                if (r > kl) {
-                    r = kl + knee(r - kl, f);
-                }
-                if (g > kl) {
-                    g = kl + knee(g - kl, f);
-                }
-                if (b > kl) {
-                    b = kl + knee(b - kl, f);
-                }
-                if (a > kl) {
-                    a = kl + knee(a - kl, f);
-                }
-
-                //  5) Gamma-correct the pixel values, according to the
-                //     screen's gamma.  (We assume that the gamma curve
-                //     is a simple power function.)
-                r = powf(r, invGamma);
-                g = powf(g, invGamma);
-                b = powf(b, invGamma);
-                a = powf(a, pOptions->fInputGamma);
-
-                //  6) Scale the values such that middle gray pixels are
-                //     mapped to a frame buffer value that is 3.5 f-stops
-                //     below the display's maximum intensity. 
-                r *= scale;
-                g *= scale;
-                b *= scale;
-                a *= scale;
-
-                r_b = (CMP_BYTE)clamp(r, 0.f, 255.f);
-                g_b = (CMP_BYTE)clamp(g, 0.f, 255.f);
-                b_b = (CMP_BYTE)clamp(b, 0.f, 255.f);
-                a_b = (CMP_BYTE)clamp(a, 0.f, 255.f);
-                cBlock[i] = r_b;
-                i++;
-                cBlock[i] = g_b;
-                i++;
-                cBlock[i] = b_b;
-                i++;
-                cBlock[i] = a_b;
-                i++;
-            }
-
-        }
-
-    }
-
-    return CMP_OK;
-}
 #endif
 CMP_ERROR GetError(CodecError err)
 {
@@ -438,102 +238,200 @@ CMP_ERROR CheckTexture(const CMP_Texture* pTexture, bool bSource)
     return CMP_OK;
 }
 
-CMP_ERROR CompressTexture(const CMP_Texture* pSourceTexture, CMP_Texture* pDestTexture, const CMP_CompressOptions* pOptions, CMP_Feedback_Proc pFeedbackProc, CodecType destType)
+//
+// Creates the buffer a codec reads the source texture through, dwWidth x dwHeight pixels
+// from pData with a row pitch of dwPitch. The buffer reads the caller's memory in place;
+// when the source is float and the destination is not, or the other way round, it is
+// wrapped in a view that converts each block as it is read instead of the whole image
+// being converted up front.
+//
+CCodecBuffer* CreateSourceBuffer(const CMP_Texture* pSourceTexture, CMP_FORMAT destFormat, const CMP_CompressOptions* pOptions,
+                                 CMP_DWORD dwWidth, CMP_DWORD dwHeight, CMP_DWORD dwPitch, CMP_BYTE* pData)
 {
-    // Compressing
-    CCodec* pCodec = CreateCodec(destType);
-    assert(pCodec);
-    if(pCodec == NULL)
-        return CMP_ERR_UNABLE_TO_INIT_CODEC;
+    CCodecBuffer* pBuffer = CreateCodecBuffer(GetCodecBufferType(pSourceTexture->format),
+                                              pSourceTexture->nBlockWidth, pSourceTexture->nBlockHeight, pSourceTexture->nBlockDepth,
+                                              dwWidth, dwHeight, dwPitch, pData,
+                                              pSourceTexture->dwDataSize);
+#ifdef ENABLE_MAKE_COMPATIBLE_API
+    if(pBuffer == NULL)
+        return NULL;
 
-    CMP_BOOL swizzleSrcBuffer = false;
+    bool srcFloat  = IsFloatFormat(pSourceTexture->format);
+    bool destFloat = IsFloatFormat(destFormat);
+    if(srcFloat && !destFloat)
+    {
+        ToneMapParams toneMap;
+        GetToneMapParams(pOptions, toneMap);
+        return new CCodecBuffer_RGBA8888View(pBuffer, toneMap);
+    }
+    else if(!srcFloat && destFloat)
+        return new CCodecBuffer_RGBA16FView(pBuffer);
+#endif
+    return pBuffer;
+}
+
+//
+// Between BeginCodecReuse() and EndCodecReuse() the CompressTexture calls made on a
+// thread keep their codec, the next call with the same destination type and options
+// uses it again rather than creating a codec and parsing the options (and CmdSet) for
+// every small texture. Scopes nest, each one keeps its own codec.
+//
+struct CodecReuseScope
+{
+    CodecReuseScope*           pOuter;
+    CCodec*                    pCodec;
+    CodecType                  destType;
+    const CMP_CompressOptions* pOptions;
+};
+
+static thread_local CodecReuseScope* t_pCodecReuse = NULL;
 
+void BeginCodecReuse()
+{
+    CodecReuseScope* pScope = new CodecReuseScope;
+    pScope->pOuter   = t_pCodecReuse;
+    pScope->pCodec   = NULL;
+    pScope->destType = CT_None;
+    pScope->pOptions = NULL;
+    t_pCodecReuse    = pScope;
+}
+
+void EndCodecReuse()
+{
+    CodecReuseScope* pScope = t_pCodecReuse;
+    assert(pScope);
+    if (pScope == NULL)
+        return;
+    t_pCodecReuse = pScope->pOuter;
+    SAFE_DELETE(pScope->pCodec);
+    delete pScope;
+}
+
+//
+// Sets up a newly created codec from pOptions. Used by CompressTexture and by every
+// codec ThreadedCompressTexture creates, so the two paths parse the options the same way.
+//
+static void SetCodecOptions(CCodec* pCodec, CodecType destType, const CMP_CompressOptions* pOptions)
+{
     // Have we got valid options ?
-    if(pOptions && pOptions->dwSize == sizeof(CMP_CompressOptions))
+    if(pOptions == NULL || pOptions->dwSize != sizeof(CMP_CompressOptions))
+        return;
+
+    // Set weightings ?
+    if(pOptions->bUseChannelWeighting && (pOptions->fWeightingRed > 0.0 || pOptions->fWeightingGreen > 0.0 || pOptions->fWeightingBlue > 0.0))
+    {
+        pCodec->SetParameter("UseChannelWeighting", (CMP_DWORD) 1);
+        pCodec->SetParameter("WeightR",
+            pOptions->fWeightingRed > MINIMUM_WEIGHT_VALUE ?
+            (CODECFLOAT) pOptions->fWeightingRed : MINIMUM_WEIGHT_VALUE);
+        pCodec->SetParameter("WeightG",
+            pOptions->fWeightingGreen > MINIMUM_WEIGHT_VALUE ?
+            (CODECFLOAT) pOptions->fWeightingGreen : MINIMUM_WEIGHT_VALUE);
+        pCodec->SetParameter("WeightB",
+            pOptions->fWeightingBlue > MINIMUM_WEIGHT_VALUE ?
+            (CODECFLOAT) pOptions->fWeightingBlue : MINIMUM_WEIGHT_VALUE);
+    }
+    pCodec->SetParameter("UseAdaptiveWeighting", (CMP_DWORD) pOptions->bUseAdaptiveWeighting);
+    pCodec->SetParameter("DXT1UseAlpha", (CMP_DWORD) pOptions->bDXT1UseAlpha);
+    pCodec->SetParameter("AlphaThreshold", (CMP_DWORD) pOptions->nAlphaThreshold);
+    // New override to that set quality if compresion for DXTn & ATInN codecs
+    if (pOptions->fquality != AMD_CODEC_QUALITY_DEFAULT)
     {
-        // Set weightings ?
-        if(pOptions->bUseChannelWeighting && (pOptions->fWeightingRed > 0.0 || pOptions->fWeightingGreen > 0.0 || pOptions->fWeightingBlue > 0.0))
-        {
-            pCodec->SetParameter("UseChannelWeighting", (CMP_DWORD) 1);
-            pCodec->SetParameter("WeightR",
-                pOptions->fWeightingRed > MINIMUM_WEIGHT_VALUE ?
-                (CODECFLOAT) pOptions->fWeightingRed : MINIMUM_WEIGHT_VALUE);
-            pCodec->SetParameter("WeightG",
-                pOptions->fWeightingGreen > MINIMUM_WEIGHT_VALUE ?
-                (CODECFLOAT) pOptions->fWeightingGreen : MINIMUM_WEIGHT_VALUE);
-            pCodec->SetParameter("WeightB",
-                pOptions->fWeightingBlue > MINIMUM_WEIGHT_VALUE ?
-                (CODECFLOAT) pOptions->fWeightingBlue : MINIMUM_WEIGHT_VALUE);
-        }
-        pCodec->SetParameter("UseAdaptiveWeighting", (CMP_DWORD) pOptions->bUseAdaptiveWeighting);
-        pCodec->SetParameter("DXT1UseAlpha", (CMP_DWORD) pOptions->bDXT1UseAlpha);
-        pCodec->SetParameter("AlphaThreshold", (CMP_DWORD) pOptions->nAlphaThreshold);
-        // New override to that set quality if compresion for DXTn & ATInN codecs
-        if (pOptions->fquality != AMD_CODEC_QUALITY_DEFAULT)
-        {
 #ifndef _WIN64
-            if (pOptions->fquality < 0.3)
-                pCodec->SetParameter("CompressionSpeed", (CMP_DWORD)CMP_Speed_SuperFast);
+        if (pOptions->fquality < 0.3)
+            pCodec->SetParameter("CompressionSpeed", (CMP_DWORD)CMP_Speed_SuperFast);
+        else
+            if (pOptions->fquality < 0.6)
+                pCodec->SetParameter("CompressionSpeed", (CMP_DWORD)CMP_Speed_Fast);
             else
-                if (pOptions->fquality < 0.6)
-                    pCodec->SetParameter("CompressionSpeed", (CMP_DWORD)CMP_Speed_Fast);
-                else
 #endif
-                    pCodec->SetParameter("CompressionSpeed", (CMP_DWORD)CMP_Speed_Normal);
-        }
-        else
-            pCodec->SetParameter("CompressionSpeed", (CMP_DWORD)pOptions->nCompressionSpeed);
+                pCodec->SetParameter("CompressionSpeed", (CMP_DWORD)CMP_Speed_Normal);
+    }
+    else
+        pCodec->SetParameter("CompressionSpeed", (CMP_DWORD)pOptions->nCompressionSpeed);
 
 
-        switch(destType)
-        {
-        case CT_BC7:
-                pCodec->SetParameter("MultiThreading", (CMP_DWORD) !pOptions->bDisableMultiThreading);
-                
-                if (!pOptions->bDisableMultiThreading)
-                    pCodec->SetParameter("NumThreads", (CMP_DWORD) pOptions->dwnumThreads);
-                else
-                    pCodec->SetParameter("NumThreads", (CMP_DWORD) 1);
-
-                pCodec->SetParameter("ModeMask", (CMP_DWORD) pOptions->dwmodeMask);
-                pCodec->SetParameter("ColourRestrict", (CMP_DWORD) pOptions->brestrictColour);
-                pCodec->SetParameter("AlphaRestrict", (CMP_DWORD) pOptions->brestrictAlpha);
-                pCodec->SetParameter("Quality", (CODECFLOAT) pOptions->fquality);
-                break;
+    switch(destType)
+    {
+    case CT_BC7:
+            pCodec->SetParameter("MultiThreading", (CMP_DWORD) !pOptions->bDisableMultiThreading);
+            
+            if (!pOptions->bDisableMultiThreading)
+                pCodec->SetParameter("NumThreads", (CMP_DWORD) pOptions->dwnumThreads);
+            else
+                pCodec->SetParameter("NumThreads", (CMP_DWORD) 1);
+
+            pCodec->SetParameter("ModeMask", (CMP_DWORD) pOptions->dwmodeMask);
+            pCodec->SetParameter("ColourRestrict", (CMP_DWORD) pOptions->brestrictColour);
+            pCodec->SetParameter("AlphaRestrict", (CMP_DWORD) pOptions->brestrictAlpha);
+            pCodec->SetParameter("SinglePrecision", (CMP_DWORD) pOptions->bBC7SinglePrecision);
+            pCodec->SetParameter("ModeSearchCandidates", (CMP_DWORD) pOptions->dwModeSearchCandidates);
+            pCodec->SetParameter("Quality", (CODECFLOAT) pOptions->fquality);
+            break;
 #ifdef USE_BASIS
-        case CT_BASIS:
+    case CT_BASIS:
 #endif
-        case CT_ASTC:
-                pCodec->SetParameter("Quality", (CODECFLOAT)pOptions->fquality);
-                if (!pOptions->bDisableMultiThreading)
-                    pCodec->SetParameter("NumThreads", (CMP_DWORD)pOptions->dwnumThreads);
-                else
-                    pCodec->SetParameter("NumThreads", (CMP_DWORD)1);
-                break;
-        case CT_GTC:
-        case CT_BC6H:
-        case CT_BC6H_SF:
-                pCodec->SetParameter("Quality", (CODECFLOAT)pOptions->fquality);
-                if (!pOptions->bDisableMultiThreading)
-                    pCodec->SetParameter("NumThreads", (CMP_DWORD)pOptions->dwnumThreads);
-                else
-                    pCodec->SetParameter("NumThreads", (CMP_DWORD)1);
+    case CT_ASTC:
+            pCodec->SetParameter("Quality", (CODECFLOAT)pOptions->fquality);
+            if (!pOptions->bDisableMultiThreading)
+                pCodec->SetParameter("NumThreads", (CMP_DWORD)pOptions->dwnumThreads);
+            else
+                pCodec->SetParameter("NumThreads", (CMP_DWORD)1);
+            break;
+    case CT_GTC:
+    case CT_BC6H:
+    case CT_BC6H_SF:
+            pCodec->SetParameter("Quality", (CODECFLOAT)pOptions->fquality);
+            if (!pOptions->bDisableMultiThreading)
+                pCodec->SetParameter("NumThreads", (CMP_DWORD)pOptions->dwnumThreads);
+            else
+                pCodec->SetParameter("NumThreads", (CMP_DWORD)1);
+            pCodec->SetParameter("ModeSearchCandidates", (CMP_DWORD)pOptions->dwModeSearchCandidates);
 #ifdef _DEBUG
-                // napatel : remove this after
-                // pCodec->SetParameter("NumThreads", (CMP_DWORD)1);
+            // napatel : remove this after
+            // pCodec->SetParameter("NumThreads", (CMP_DWORD)1);
 #endif
-                break;
-        }
+            break;
+    }
 
-        // This will eventually replace the above code for setting codec options
-        if (pOptions->NumCmds > 0)
-        {
-            int maxCmds=pOptions->NumCmds;
-            if (pOptions->NumCmds > AMD_MAX_CMDS) maxCmds = AMD_MAX_CMDS;
-            for (int i=0; i<maxCmds; i++)
-                pCodec->SetParameter(pOptions->CmdSet[i].strCommand, (CMP_CHAR*)pOptions->CmdSet[i].strParameter);
-        }
+    // This will eventually replace the above code for setting codec options
+    if (pOptions->NumCmds > 0)
+    {
+        int maxCmds=pOptions->NumCmds;
+        if (pOptions->NumCmds > AMD_MAX_CMDS) maxCmds = AMD_MAX_CMDS;
+        for (int i=0; i<maxCmds; i++)
+            pCodec->SetParameter(pOptions->CmdSet[i].strCommand, (CMP_CHAR*)pOptions->CmdSet[i].strParameter);
+    }
+
+    pCodec->SetCancelToken(pOptions->pCancelToken);
+}
+
+CMP_ERROR CompressTexture(const CMP_Texture* pSourceTexture, CMP_Texture* pDestTexture, const CMP_CompressOptions* pOptions, CMP_Feedback_Proc pFeedbackProc, CodecType destType)
+{
+    // Compressing, the codec is taken out of the reuse scope while it is in use
+    CodecReuseScope* pReuse = t_pCodecReuse;
+    CCodec*          pCodec = NULL;
+    if (pReuse && pReuse->pCodec && (pReuse->destType == destType) && (pReuse->pOptions == pOptions))
+    {
+        pCodec = pReuse->pCodec;
+        pReuse->pCodec = NULL;
+    }
+    bool bConfigure = (pCodec == NULL);
+
+    if (pCodec == NULL)
+        pCodec = CreateCodec(destType);
+    assert(pCodec);
+    if(pCodec == NULL)
+        return CMP_ERR_UNABLE_TO_INIT_CODEC;
 
+    CMP_BOOL swizzleSrcBuffer = false;
+
+    // A codec taken from the reuse scope is already set up
+    if(bConfigure)
+        SetCodecOptions(pCodec, destType, pOptions);
+
+    if(pOptions && pOptions->dwSize == sizeof(CMP_CompressOptions))
+    {
         // GPUOpen issue # 59 fix
         CodecBufferType srcBufferType = GetCodecBufferType(pSourceTexture->format);
         if (NeedSwizzle(pDestTexture->format))
@@ -551,12 +449,8 @@ CMP_ERROR CompressTexture(const CMP_Texture* pSourceTexture, CMP_Texture* pDestT
         }
     }
 
-    CodecBufferType srcBufferType = GetCodecBufferType(pSourceTexture->format);
-
-    CCodecBuffer* pSrcBuffer  = CreateCodecBuffer(srcBufferType, 
-                                                  pSourceTexture->nBlockWidth, pSourceTexture->nBlockHeight, pSourceTexture->nBlockDepth,
-                                                  pSourceTexture->dwWidth, pSourceTexture->dwHeight, pSourceTexture->dwPitch, pSourceTexture->pData,
-                                                  pSourceTexture->dwDataSize);
+    CCodecBuffer* pSrcBuffer  = CreateSourceBuffer(pSourceTexture, pDestTexture->format, pOptions,
+                                                  pSourceTexture->dwWidth, pSourceTexture->dwHeight, pSourceTexture->dwPitch, pSourceTexture->pData);
     CCodecBuffer* pDestBuffer = pCodec->CreateBuffer(
                                                   pDestTexture->nBlockWidth, pDestTexture->nBlockHeight, pDestTexture->nBlockDepth,
                                                   pDestTexture->dwWidth, pDestTexture->dwHeight, pDestTexture->dwPitch, pDestTexture->pData,
@@ -578,6 +472,15 @@ CMP_ERROR CompressTexture(const CMP_Texture* pSourceTexture, CMP_Texture* pDestT
     CodecError err = pCodec->Compress(*pSrcBuffer, *pDestBuffer, pFeedbackProc);
     RESTORE_FP_EXCEPTIONS;
 
+    if (pReuse && (pReuse == t_pCodecReuse))
+    {
+        SAFE_DELETE(pReuse->pCodec);
+        pReuse->pCodec   = pCodec;
+        pReuse->destType = destType;
+        pReuse->pOptions = pOptions;
+        pCodec           = NULL;
+    }
+
     SAFE_DELETE(pCodec);
     SAFE_DELETE(pSrcBuffer);
     SAFE_DELETE(pDestBuffer);
@@ -587,41 +490,25 @@ CMP_ERROR CompressTexture(const CMP_Texture* pSourceTexture, CMP_Texture* pDestT
 
 #ifdef THREADED_COMPRESS
 
-class CATICompressThreadData
+// Creates a codec configured from pOptions for use by ThreadedCompressTexture
+static CCodec* CreateThreadedCodec(CodecType destType, const CMP_CompressOptions* pOptions)
 {
-public:
-    CATICompressThreadData();
-    ~CATICompressThreadData();
-
-    CCodec* m_pCodec;
-    CCodecBuffer* m_pSrcBuffer;
-    CCodecBuffer* m_pDestBuffer;
-    CMP_Feedback_Proc m_pFeedbackProc;
-    CodecError m_errorCode;
-};
+    CCodec* pCodec = CreateCodec(destType);
+    assert(pCodec);
+    if(pCodec == NULL)
+        return NULL;
 
-CATICompressThreadData::CATICompressThreadData() : m_pCodec(NULL), m_pSrcBuffer(NULL), m_pDestBuffer(NULL), 
-                                                   m_pFeedbackProc(NULL),
-                                                   m_errorCode( CE_OK )
-{
-}
+    SetCodecOptions(pCodec, destType, pOptions);
 
-CATICompressThreadData::~CATICompressThreadData()
-{
-    SAFE_DELETE(m_pCodec);
-    SAFE_DELETE(m_pSrcBuffer);
-    SAFE_DELETE(m_pDestBuffer);
-}
-
-void ThreadedCompressProc(void *lpParameter)
-{
-    CATICompressThreadData *pThreadData = (CATICompressThreadData*) lpParameter;
-    DISABLE_FP_EXCEPTIONS;
-    CodecError err = pThreadData->m_pCodec->Compress(*pThreadData->m_pSrcBuffer, *pThreadData->m_pDestBuffer, pThreadData->m_pFeedbackProc);
-    RESTORE_FP_EXCEPTIONS;
-    pThreadData->m_errorCode = err;
+    return pCodec;
 }
 
+//
+// The texture is split into tiles of THREADED_COMPRESS_TILE_SIZE pixels that the
+// pool tasks take from a shared counter, so a thread that finishes early keeps
+// pulling work instead of idling while a slower strip completes. Each worker
+// configures one codec the first time it runs a tile and reuses it for the rest.
+//
 CMP_ERROR ThreadedCompressTexture(const CMP_Texture* pSourceTexture, CMP_Texture* pDestTexture, const CMP_CompressOptions* pOptions, CMP_Feedback_Proc pFeedbackProc, CodecType destType)
 {
     // Note function should not be called for the following Codecs....
@@ -632,165 +519,144 @@ CMP_ERROR ThreadedCompressTexture(const CMP_Texture* pSourceTexture, CMP_Texture
 #endif
     if (destType == CT_ASTC)  return CMP_ABORTED;
 
-    CMP_DWORD dwMaxThreadCount = min(f_dwProcessorCount, MAX_THREADS);
-    CMP_DWORD dwLinesRemaining = pDestTexture->dwHeight;
-    CMP_BYTE* pSourceData = pSourceTexture->pData;
-    CMP_BYTE* pDestData = pDestTexture->pData;
+    CMP_DWORD dwMaxThreadCount = min(CMP_ThreadPool::GetThreadPool()->GetNumThreads(), MAX_THREADS);
     CMP_BOOL swizzleSrcBuffer = false;
 
-#ifdef _DEBUG
-    if (
-        (pDestTexture->format == CMP_FORMAT_ETC2_RGBA) ||
-        (pDestTexture->format == CMP_FORMAT_ETC2_RGBA1)
-        )
-         dwMaxThreadCount = 1;
-#endif
-
-    CATICompressThreadData aThreadData[MAX_THREADS];
-    std::thread ahThread[MAX_THREADS];
+    // Codecs are kept per pool slot and only created when a slot runs its first tile
+    CCodec*    aCodecs[CMP_MAX_POOL_SLOTS] = {NULL};
+    std::mutex codecMutex;
 
-    CMP_DWORD dwThreadCount = 0;
-    for(CMP_DWORD dwThread = 0; dwThread < dwMaxThreadCount; dwThread++)
-    {
-        CATICompressThreadData& threadData = aThreadData[dwThread];
+    CCodec* pCodec = CreateThreadedCodec(destType, pOptions);
+    if(pCodec == NULL)
+        return CMP_ERR_UNABLE_TO_INIT_CODEC;
+    aCodecs[CMP_ThreadPool::GetWorkerSlot()] = pCodec;
 
-        // Compressing
-        threadData.m_pCodec = CreateCodec(destType);
-        assert(threadData.m_pCodec);
-        if(threadData.m_pCodec == NULL)
-            return CMP_ERR_UNABLE_TO_INIT_CODEC;
+    CodecBufferType srcBufferType = GetCodecBufferType(pSourceTexture->format);
 
-        // Have we got valid options ?
-        if(pOptions && pOptions->dwSize == sizeof(CMP_CompressOptions))
+    // GPUOpen issue # 59 fix
+    if(pOptions && pOptions->dwSize == sizeof(CMP_CompressOptions) && NeedSwizzle(pDestTexture->format))
+    {
+        switch (srcBufferType)
         {
-            // Set weightings ?
-            if(pOptions->bUseChannelWeighting && (pOptions->fWeightingRed > 0.0 || pOptions->fWeightingGreen > 0.0 || pOptions->fWeightingBlue > 0.0))
-            {
-                threadData.m_pCodec->SetParameter("UseChannelWeighting", (CMP_DWORD) 1);
-                threadData.m_pCodec->SetParameter("WeightR",
-                    pOptions->fWeightingRed > MINIMUM_WEIGHT_VALUE ?
-                    (CODECFLOAT) pOptions->fWeightingRed : MINIMUM_WEIGHT_VALUE);
-                threadData.m_pCodec->SetParameter("WeightG",
-                    pOptions->fWeightingGreen > MINIMUM_WEIGHT_VALUE ?
-                    (CODECFLOAT) pOptions->fWeightingGreen : MINIMUM_WEIGHT_VALUE);
-                threadData.m_pCodec->SetParameter("WeightB",
-                    pOptions->fWeightingBlue > MINIMUM_WEIGHT_VALUE ?
-                    (CODECFLOAT) pOptions->fWeightingBlue : MINIMUM_WEIGHT_VALUE);
-            }
-            threadData.m_pCodec->SetParameter("UseAdaptiveWeighting", (CMP_DWORD) pOptions->bUseAdaptiveWeighting);
-            threadData.m_pCodec->SetParameter("DXT1UseAlpha", (CMP_DWORD) pOptions->bDXT1UseAlpha);
-            threadData.m_pCodec->SetParameter("AlphaThreshold", (CMP_DWORD) pOptions->nAlphaThreshold);
+        case CBT_BGRA8888:
+        case CBT_BGR888:
+            swizzleSrcBuffer = false;
+            break;
+        default:
+            swizzleSrcBuffer = true;
+            break;
+        }
+    }
 
-            // New override to that set quality if compresion for DXTn & ATInN codecs
-            if (pOptions->fquality != AMD_CODEC_QUALITY_DEFAULT)
-            {
-                if (pOptions->fquality < 0.3)
-                    threadData.m_pCodec->SetParameter("CompressionSpeed", (CMP_DWORD)CMP_Speed_SuperFast);
-                else
-                    if (pOptions->fquality < 0.6)
-                        threadData.m_pCodec->SetParameter("CompressionSpeed", (CMP_DWORD)CMP_Speed_Fast);
-                    else
-                        threadData.m_pCodec->SetParameter("CompressionSpeed", (CMP_DWORD)CMP_Speed_Normal);
-            }
-            else
-                threadData.m_pCodec->SetParameter("CompressionSpeed", (CMP_DWORD)pOptions->nCompressionSpeed);
+    // Round the tile size to whole blocks
+    CMP_DWORD dwBlockWidth  = pCodec->GetBlockWidth();
+    CMP_DWORD dwBlockHeight = pCodec->GetBlockHeight();
+    CMP_DWORD dwTileWidth   = max(THREADED_COMPRESS_TILE_SIZE / dwBlockWidth, 1u) * dwBlockWidth;
+    CMP_DWORD dwTileHeight  = max(THREADED_COMPRESS_TILE_SIZE / dwBlockHeight, 1u) * dwBlockHeight;
+    CMP_DWORD dwTilesX      = (pSourceTexture->dwWidth + dwTileWidth - 1) / dwTileWidth;
+    CMP_DWORD dwTilesY      = (pSourceTexture->dwHeight + dwTileHeight - 1) / dwTileHeight;
+
+    // Let the buffer classes work out the source pitch and the size of a tile row,
+    // the per pixel size is not the same in CalcBufferSize for every format
+    CCodecBuffer* pSrcBuffer = CreateCodecBuffer(srcBufferType,
+                                                 pSourceTexture->nBlockWidth, pSourceTexture->nBlockHeight, pSourceTexture->nBlockDepth,
+                                                 pSourceTexture->dwWidth, pSourceTexture->dwHeight, pSourceTexture->dwPitch, pSourceTexture->pData,
+                                                 pSourceTexture->dwDataSize);
+    CCodecBuffer* pSrcTile   = CreateCodecBuffer(srcBufferType,
+                                                 pSourceTexture->nBlockWidth, pSourceTexture->nBlockHeight, pSourceTexture->nBlockDepth,
+                                                 dwTileWidth, 1, 0, pSourceTexture->pData,
+                                                 pSourceTexture->dwDataSize);
+    assert(pSrcBuffer);
+    assert(pSrcTile);
+    if(pSrcBuffer == NULL || pSrcTile == NULL)
+    {
+        SAFE_DELETE(pSrcBuffer);
+        SAFE_DELETE(pSrcTile);
+        SAFE_DELETE(pCodec);
+        return CMP_ERR_GENERIC;
+    }
 
+    CMP_DWORD dwSrcPitch     = pSrcBuffer->GetPitch();
+    CMP_DWORD dwSrcTileBytes = pSrcTile->GetPitch();
+    CMP_DWORD dwDestPitch    = CalcBufferSize(destType, pDestTexture->dwWidth, dwBlockHeight, pDestTexture->nBlockWidth, pDestTexture->nBlockHeight);
+    CMP_DWORD dwDestTileBytes = CalcBufferSize(destType, dwTileWidth, dwBlockHeight, pDestTexture->nBlockWidth, pDestTexture->nBlockHeight);
+    SAFE_DELETE(pSrcBuffer);
+    SAFE_DELETE(pSrcTile);
 
+    std::atomic<int> tileError(CE_OK);
 
-            switch(destType)
-            {
-            case CT_BC6H: 
-                    // Reserved 
-                    break;
-            }
+    CMP_CancelToken hCancelToken = (pOptions && pOptions->dwSize == sizeof(CMP_CompressOptions)) ? pOptions->pCancelToken : NULL;
+
+    auto CompressTile = [&](CMP_DWORD dwTile) {
+        if(tileError != CE_OK || CMP_IsCanceled(hCancelToken))
+            return;
 
-            // This will eventually replace the above code for setting codec options
-            // It is currently implemented with BC6H and can be expanded to other codec
-            if (pOptions->NumCmds > 0)
+        CMP_INT nSlot  = CMP_ThreadPool::GetWorkerSlot();
+        CCodec* pTileCodec = aCodecs[nSlot];
+        if(pTileCodec == NULL)
+        {
+            std::lock_guard<std::mutex> lock(codecMutex);
+            pTileCodec = aCodecs[nSlot] = CreateThreadedCodec(destType, pOptions);
+            if(pTileCodec == NULL)
             {
-                int maxCmds = pOptions->NumCmds;
-                if (pOptions->NumCmds > AMD_MAX_CMDS) maxCmds = AMD_MAX_CMDS;
-                for (int i = 0; i<maxCmds; i++)
-                    threadData.m_pCodec->SetParameter(pOptions->CmdSet[i].strCommand, (CMP_CHAR*)pOptions->CmdSet[i].strParameter);
+                tileError = CE_Unknown;
+                return;
             }
+        }
 
+        CMP_DWORD dwTileX  = (dwTile % dwTilesX) * dwTileWidth;
+        CMP_DWORD dwTileY  = (dwTile / dwTilesX) * dwTileHeight;
+        CMP_DWORD dwWidth  = min(dwTileWidth, pSourceTexture->dwWidth - dwTileX);
+        CMP_DWORD dwHeight = min(dwTileHeight, pSourceTexture->dwHeight - dwTileY);
 
-        }
+        CMP_BYTE* pSrcData  = pSourceTexture->pData + (dwTileY * dwSrcPitch) + ((dwTileX / dwTileWidth) * dwSrcTileBytes);
+        CMP_BYTE* pDestData = pDestTexture->pData + ((dwTileY / dwBlockHeight) * dwDestPitch) + ((dwTileX / dwTileWidth) * dwDestTileBytes);
 
-        CodecBufferType srcBufferType = GetCodecBufferType(pSourceTexture->format);
+        CCodecBuffer* pTileSrcBuffer  = CreateSourceBuffer(pSourceTexture, pDestTexture->format, pOptions,
+                                                          dwWidth, dwHeight, dwSrcPitch, pSrcData);
+        CCodecBuffer* pTileDestBuffer = pTileCodec->CreateBuffer(
+                                                          pDestTexture->nBlockWidth, pDestTexture->nBlockHeight, pDestTexture->nBlockDepth,
+                                                          dwWidth, dwHeight, 0, pDestData,
+                                                          pDestTexture->dwDataSize);
 
-        // GPUOpen issue # 59 fix
-        if (NeedSwizzle(pDestTexture->format))
+        assert(pTileSrcBuffer);
+        assert(pTileDestBuffer);
+        if(pTileSrcBuffer == NULL || pTileDestBuffer == NULL)
         {
-            switch (srcBufferType)
-            {
-            case CBT_BGRA8888:
-            case CBT_BGR888:
-                swizzleSrcBuffer = false;
-                break;
-            default:
-                swizzleSrcBuffer = true;
-                break;
-            }
+            SAFE_DELETE(pTileSrcBuffer);
+            SAFE_DELETE(pTileDestBuffer);
+            tileError = CE_Unknown;
+            return;
         }
 
-        CMP_DWORD dwThreadsRemaining = dwMaxThreadCount - dwThread;
-        CMP_DWORD dwHeight = 0;
-        if(dwThreadsRemaining > 1)
-        {
-            CMP_DWORD dwBlockHeight = threadData.m_pCodec->GetBlockHeight();
-            dwHeight = dwLinesRemaining / dwThreadsRemaining;
-            dwHeight = min(((dwHeight + dwBlockHeight - 1) / dwBlockHeight) * dwBlockHeight, dwLinesRemaining); // Round by block height
-            dwLinesRemaining -= dwHeight;
-        }
-        else
-            dwHeight = dwLinesRemaining;
+        // Block rows of the tile are a full texture row of blocks apart
+        pTileDestBuffer->SetPitch(dwDestPitch);
+        pTileSrcBuffer->m_bSwizzle = swizzleSrcBuffer;
 
-        if(dwHeight > 0)
-        {
-            threadData.m_pSrcBuffer = CreateCodecBuffer(srcBufferType, 
-                                                        pSourceTexture->nBlockWidth, pSourceTexture->nBlockHeight, pSourceTexture->nBlockDepth,
-                                                        pSourceTexture->dwWidth, dwHeight, pSourceTexture->dwPitch, pSourceData,
-                                                        pSourceTexture->dwDataSize);
-            threadData.m_pDestBuffer = threadData.m_pCodec->CreateBuffer(
-                                                        pDestTexture->nBlockWidth, pDestTexture->nBlockHeight, pDestTexture->nBlockDepth,
-                                                        pDestTexture->dwWidth, dwHeight, pDestTexture->dwPitch, pDestData,
-                                                        pDestTexture->dwDataSize);
-
-            pSourceData += CalcBufferSize(pSourceTexture->format, pSourceTexture->dwWidth, dwHeight, pSourceTexture->dwPitch, pSourceTexture->nBlockWidth, pSourceTexture->nBlockHeight);
-            pDestData += CalcBufferSize(destType, pDestTexture->dwWidth, dwHeight, pDestTexture->nBlockWidth, pDestTexture->nBlockHeight);
-
-            assert(threadData.m_pSrcBuffer);
-            assert(threadData.m_pDestBuffer);
-            if(threadData.m_pSrcBuffer == NULL || threadData.m_pDestBuffer == NULL)
-                return CMP_ERR_GENERIC;
-
-            threadData.m_pSrcBuffer->m_bSwizzle = swizzleSrcBuffer;
-            threadData.m_pFeedbackProc = pFeedbackProc;
-
-            ahThread[dwThreadCount++] = std::thread(ThreadedCompressProc, &threadData);
-        }
-    }
+        DISABLE_FP_EXCEPTIONS;
+        CodecError err = pTileCodec->Compress(*pTileSrcBuffer, *pTileDestBuffer, NULL);
+        RESTORE_FP_EXCEPTIONS;
 
-    for ( CMP_DWORD dwThread = 0; dwThread < dwThreadCount; dwThread++ )
-    {
-        std::thread& curThread = ahThread[dwThread];
+        if(err != CE_OK)
+            tileError = err;
 
-        curThread.join();
-    }
+        SAFE_DELETE(pTileSrcBuffer);
+        SAFE_DELETE(pTileDestBuffer);
+    };
 
-    CodecError err = CE_OK;
-    for(CMP_DWORD dwThread = 0; dwThread < dwThreadCount; dwThread++)
-    {
-        CATICompressThreadData& threadData = aThreadData[dwThread];
+    CMP_ProgressProc progressProc;
+    if(pFeedbackProc)
+        progressProc = [pFeedbackProc](float fProgress) { return pFeedbackProc(fProgress, NULL, NULL); };
 
-        if(err == CE_OK)
-            err = threadData.m_errorCode;
+    bool bCompleted = CMP_ParallelRows(dwTilesX * dwTilesY, dwMaxThreadCount, CompressTile, progressProc);
 
-        ahThread[dwThread] = std::thread();
-    }
+    for(CMP_DWORD dwSlot = 0; dwSlot < CMP_MAX_POOL_SLOTS; dwSlot++)
+        SAFE_DELETE(aCodecs[dwSlot]);
 
-    return GetError(err);
+    if(!bCompleted || CMP_IsCanceled(hCancelToken))
+        return CMP_ABORTED;
+
+    return GetError((CodecError)tileError.load());
 }
 #endif // THREADED_COMPRESS
 
@@ -35,9 +35,23 @@
 #include "Compressonator.h"  // User shared: Keep priviate code out of this header
 #include "Compress.h"
 #include "CMP_MIPS.h"
+#include "CMP_ThreadPool.h"
+#include "CMP_CpuTopology.h"
+#include "CMP_BlockClass.h"
+#include "CMP_CancelToken.h"
 #include "debug.h"
 
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
 
 using namespace CMP;
 
@@ -45,12 +59,14 @@ extern CodecType GetCodecType(CMP_FORMAT format);
 extern CMP_ERROR GetError(CodecError err);
 #ifdef ENABLE_MAKE_COMPATIBLE_API
 extern bool IsFloatFormat(CMP_FORMAT InFormat);
-extern CMP_ERROR Byte2HalfShort(CMP_HALFSHORT* hfsBlock, CMP_BYTE* cBlock, CMP_DWORD dwBlockSize);
-extern CMP_ERROR Float2Byte(CMP_BYTE cBlock[], CMP_FLOAT* fBlock, CMP_Texture* srcTexture, CMP_FORMAT destFormat, const CMP_CompressOptions* pOptions);
 #endif
 extern CMP_ERROR CheckTexture(const CMP_Texture* pTexture, bool bSource);
+extern CCodecBuffer* CreateSourceBuffer(const CMP_Texture* pSourceTexture, CMP_FORMAT destFormat, const CMP_CompressOptions* pOptions,
+                                        CMP_DWORD dwWidth, CMP_DWORD dwHeight, CMP_DWORD dwPitch, CMP_BYTE* pData);
 extern CMP_ERROR CompressTexture(const CMP_Texture* pSourceTexture, CMP_Texture* pDestTexture, const CMP_CompressOptions* pOptions, CMP_Feedback_Proc pFeedbackProc,CodecType destType);
 extern CMP_ERROR ThreadedCompressTexture(const CMP_Texture* pSourceTexture, CMP_Texture* pDestTexture, const CMP_CompressOptions* pOptions, CMP_Feedback_Proc pFeedbackProc, CodecType destType);
+extern void      BeginCodecReuse();
+extern void      EndCodecReuse();
 
 #ifdef _LOCAL_DEBUG
 char    DbgTracer::buff[MAX_DBGBUFF_SIZE];
@@ -440,7 +456,7 @@ void CMP_PrepareCMPSourceForIMG_Destination(CMP_Texture* pDstTexture, CMP_FORMAT
 }
 #endif
 
-CMP_ERROR CMP_API CMP_ConvertTexture(CMP_Texture* pSourceTexture, CMP_Texture* pDestTexture, const CMP_CompressOptions* pOptions, CMP_Feedback_Proc pFeedbackProc)
+static CMP_ERROR ConvertTexture(CMP_Texture* pSourceTexture, CMP_Texture* pDestTexture, const CMP_CompressOptions* pOptions, CMP_Feedback_Proc pFeedbackProc)
 {
 #ifdef USE_DBGTRACE
     DbgTrace(("-------> pSourceTexture [%x] pDestTexture [%x] pOptions [%x]",pSourceTexture, pDestTexture, pOptions));
@@ -449,43 +465,6 @@ CMP_ERROR CMP_API CMP_ConvertTexture(CMP_Texture* pSourceTexture, CMP_Texture* p
     if(tc_err != CMP_OK)
         return tc_err;
 
-#ifdef ENABLE_MAKE_COMPATIBLE_API
-    bool srcFloat = IsFloatFormat(pSourceTexture->format);
-    bool destFloat = IsFloatFormat(pDestTexture->format);
-
-    bool newBuffer = false;
-    if (srcFloat && !destFloat)
-    {
-        CMP_DWORD size = pSourceTexture->dwWidth * pSourceTexture->dwHeight;
-        CMP_FLOAT*pfData = new CMP_FLOAT[pSourceTexture->dwDataSize] ;
-
-        memcpy(pfData, pSourceTexture->pData, pSourceTexture->dwDataSize);
-
-        CMP_BYTE *byteData = new CMP_BYTE[size * 4];
-
-        Float2Byte(byteData, pfData, pSourceTexture, pDestTexture->format, pOptions);
-
-        delete[] pfData;
-        pSourceTexture->pData = byteData;
-
-        pSourceTexture->format = CMP_FORMAT_ARGB_8888;
-        pSourceTexture->dwDataSize = size * 4;
-        newBuffer = true;
-    }
-
-    else if (!srcFloat && destFloat)
-    {
-        CMP_DWORD size = pSourceTexture->dwWidth * pSourceTexture->dwHeight;
-        CMP_BYTE *pbData = pSourceTexture->pData;
-        CMP_HALFSHORT *hfloatSData = new CMP_HALFSHORT[size * 4];   // wxh*4 channels of type half
-        Byte2HalfShort(hfloatSData, pbData, size * 4);
-        pSourceTexture->pData = (CMP_BYTE*)hfloatSData;
-        pSourceTexture->format = CMP_FORMAT_ARGB_16F;
-        pSourceTexture->dwDataSize = size * 4 * sizeof(CMP_HALFSHORT);
-        pSourceTexture->dwPitch = pSourceTexture->dwWidth * 4 * sizeof(CMP_HALFSHORT);
-        newBuffer = true;
-    }
-#endif
     tc_err = CheckTexture(pDestTexture, false);
     if(tc_err != CMP_OK)
         return tc_err;
@@ -510,13 +489,10 @@ CMP_ERROR CMP_API CMP_ConvertTexture(CMP_Texture* pSourceTexture, CMP_Texture* p
             memcpy(pDestTexture->pData, pSourceTexture->pData, CMP_CalculateBufferSize(pSourceTexture));
         else
         {
-            CodecBufferType srcBufferType = GetCodecBufferType(pSourceTexture->format);
             CodecBufferType destBufferType = GetCodecBufferType(pDestTexture->format);
 
-            CCodecBuffer* pSrcBuffer = CreateCodecBuffer(srcBufferType,
-                                                         pSourceTexture->nBlockWidth, pSourceTexture->nBlockHeight, pSourceTexture->nBlockDepth,
-                                                         pSourceTexture->dwWidth, pSourceTexture->dwHeight, pSourceTexture->dwPitch, pSourceTexture->pData,
-                                                         pSourceTexture->dwDataSize);
+            CCodecBuffer* pSrcBuffer = CreateSourceBuffer(pSourceTexture, pDestTexture->format, pOptions,
+                                                          pSourceTexture->dwWidth, pSourceTexture->dwHeight, pSourceTexture->dwPitch, pSourceTexture->pData);
             assert(pSrcBuffer);
             if(!pSrcBuffer)
                 return CMP_ERR_GENERIC;
@@ -559,7 +535,7 @@ CMP_ERROR CMP_API CMP_ConvertTexture(CMP_Texture* pSourceTexture, CMP_Texture* p
         // this call is disabled for BC7/BC6H ASTC Codecs.
         // if the use has set DiableMultiThreading then numThreads will be set to 1 (regradless of its original value)
         if(
-            ((!pOptions || !pOptions->bDisableMultiThreading) && f_dwProcessorCount > 1) 
+            ((!pOptions || !pOptions->bDisableMultiThreading) && CMP_ThreadPool::GetThreadPool()->GetNumThreads() > 1) 
             && (bMultithread)
             && (destType != CT_ASTC)
             && (destType != CT_BC7)
@@ -572,26 +548,12 @@ CMP_ERROR CMP_API CMP_ConvertTexture(CMP_Texture* pSourceTexture, CMP_Texture* p
             )
         {
             tc_err = ThreadedCompressTexture(pSourceTexture, pDestTexture, pOptions, pFeedbackProc,destType);
-#ifdef ENABLE_MAKE_COMPATIBLE_API
-            if (pSourceTexture->pData && newBuffer)
-            {
-                free(pSourceTexture->pData);
-                pSourceTexture->pData = NULL;
-            }
-#endif
             return tc_err;
          }
         else
 #endif // THREADED_COMPRESS
         {
             tc_err =  CompressTexture(pSourceTexture, pDestTexture, pOptions, pFeedbackProc, destType);
-#ifdef ENABLE_MAKE_COMPATIBLE_API
-            if (pSourceTexture->pData && newBuffer)
-            {
-                free(pSourceTexture->pData);
-                pSourceTexture->pData = NULL;
-            }
-#endif
             return tc_err;
         }
     }
@@ -599,18 +561,16 @@ CMP_ERROR CMP_API CMP_ConvertTexture(CMP_Texture* pSourceTexture, CMP_Texture* p
     {
         // Decompressing
 
+#ifdef ENABLE_MAKE_COMPATIBLE_API
+        // The HDR codecs only write float blocks, tone mapping down to 8 bits is done on sources
+        if(IsFloatFormat(pSourceTexture->format) && !IsFloatFormat(pDestTexture->format))
+            return CMP_ERR_UNSUPPORTED_DEST_FORMAT;
+#endif
 
         CCodec* pCodec = CreateCodec(srcType);
         assert(pCodec);
         if (pCodec == NULL)
         {
-#ifdef ENABLE_MAKE_COMPATIBLE_API
-            if (pSourceTexture->pData && newBuffer)
-            {
-                free(pSourceTexture->pData);
-                pSourceTexture->pData = NULL;
-            }
-#endif
             return CMP_ERR_UNABLE_TO_INIT_CODEC;
         }
 
@@ -640,13 +600,6 @@ CMP_ERROR CMP_API CMP_ConvertTexture(CMP_Texture* pSourceTexture, CMP_Texture* p
             SAFE_DELETE(pCodec);
             SAFE_DELETE(pSrcBuffer);
             SAFE_DELETE(pDestBuffer);
-#ifdef ENABLE_MAKE_COMPATIBLE_API
-            if (pSourceTexture->pData && newBuffer)
-            {
-                free(pSourceTexture->pData);
-                pSourceTexture->pData = NULL;
-            }
-#endif
             return CMP_ERR_GENERIC;
         }
 
@@ -669,13 +622,6 @@ CMP_ERROR CMP_API CMP_ConvertTexture(CMP_Texture* pSourceTexture, CMP_Texture* p
         SAFE_DELETE(pSrcBuffer);
         SAFE_DELETE(pDestBuffer);
 
-#ifdef ENABLE_MAKE_COMPATIBLE_API
-        if (pSourceTexture->pData && newBuffer)
-        {
-            free(pSourceTexture->pData);
-            pSourceTexture->pData = NULL;
-        }
-#endif
         return GetError(err1);
     }
     else // Decompressing & then compressing
@@ -690,13 +636,6 @@ CMP_ERROR CMP_API CMP_ConvertTexture(CMP_Texture* pSourceTexture, CMP_Texture* p
         {
             SAFE_DELETE(pCodecIn);
             SAFE_DELETE(pCodecOut);
-#ifdef ENABLE_MAKE_COMPATIBLE_API
-            if (pSourceTexture->pData && newBuffer)
-            {
-                free(pSourceTexture->pData);
-                pSourceTexture->pData = NULL;
-            }
-#endif
             return CMP_ERR_UNABLE_TO_INIT_CODEC;
         }
 
@@ -722,13 +661,6 @@ CMP_ERROR CMP_API CMP_ConvertTexture(CMP_Texture* pSourceTexture, CMP_Texture* p
             SAFE_DELETE(pSrcBuffer);
             SAFE_DELETE(pTempBuffer);
             SAFE_DELETE(pDestBuffer);
-#ifdef ENABLE_MAKE_COMPATIBLE_API
-            if (pSourceTexture->pData && newBuffer)
-            {
-                free(pSourceTexture->pData);
-                pSourceTexture->pData = NULL;
-            }
-#endif
             return CMP_ERR_GENERIC;
         }
 
@@ -740,18 +672,227 @@ CMP_ERROR CMP_API CMP_ConvertTexture(CMP_Texture* pSourceTexture, CMP_Texture* p
         }
         RESTORE_FP_EXCEPTIONS;
 
-#ifdef ENABLE_MAKE_COMPATIBLE_API
-        if (pSourceTexture->pData && newBuffer)
+        return GetError(err2);
+    }
+}
+
+// Set while CMP_ConvertTexture runs. The codecs that report progress per block row
+// call ConvertFeedbackProc, which forwards to the application at a bounded rate and
+// turns a cancel of the token into an abort request.
+struct CMP_ConvertFeedback
+{
+    CMP_CancelToken       hCancelToken;
+    CMP_ProgressThrottle* pThrottle;
+};
+
+static thread_local CMP_ConvertFeedback* t_pConvertFeedback = NULL;
+
+static bool CMP_API ConvertFeedbackProc(CMP_FLOAT fProgress, CMP_DWORD_PTR pUser1, CMP_DWORD_PTR pUser2)
+{
+    (void)pUser1;
+    (void)pUser2;
+
+    CMP_ConvertFeedback* pConvertFeedback = t_pConvertFeedback;
+    if (pConvertFeedback == NULL)
+        return false;
+    if (CMP_IsCanceled(pConvertFeedback->hCancelToken))
+        return true;
+    return pConvertFeedback->pThrottle->Report(fProgress);
+}
+
+CMP_ERROR CMP_API CMP_ConvertTexture(CMP_Texture* pSourceTexture, CMP_Texture* pDestTexture, const CMP_CompressOptions* pOptions, CMP_Feedback_Proc pFeedbackProc)
+{
+    CMP_CancelToken hCancelToken = (pOptions && pOptions->dwSize == sizeof(CMP_CompressOptions)) ? pOptions->pCancelToken : NULL;
+    if ((hCancelToken == NULL) && (pFeedbackProc == NULL))
+        return ConvertTexture(pSourceTexture, pDestTexture, pOptions, NULL);
+
+    if (CMP_IsCanceled(hCancelToken))
+        return CMP_ABORTED;
+
+    CMP_ProgressProc progressProc;
+    if (pFeedbackProc)
+        progressProc = [pFeedbackProc](float fProgress) { return pFeedbackProc(fProgress, NULL, NULL); };
+    CMP_ProgressThrottle throttle(progressProc);
+
+    // Nested calls run by this thread while it waits on the pool restore the outer feedback
+    CMP_ConvertFeedback  convertFeedback = {hCancelToken, &throttle};
+    CMP_ConvertFeedback* pOldFeedback    = t_pConvertFeedback;
+    t_pConvertFeedback                   = &convertFeedback;
+
+    CMP_ERROR err = ConvertTexture(pSourceTexture, pDestTexture, pOptions, ConvertFeedbackProc);
+
+    t_pConvertFeedback = pOldFeedback;
+    if (err == CMP_OK)
+        throttle.Flush();
+
+    if ((err != CMP_OK) && CMP_IsCanceled(hCancelToken))
+        return CMP_ABORTED;
+    return err;
+}
+
+// One (level, face) of a MipSet waiting to be compressed by ConvertMipSetJobs
+struct CMP_MipSetJob
+{
+    CMP_Texture srcTexture;
+    CMP_Texture destTexture;
+    CMP_ERROR   status;
+    CMP_INT     nItem;          // Index of the MipSet the job belongs to (CMP_BatchCompress)
+};
+
+typedef std::function<void(CMP_MipSetJob&)> CMP_MipSetJobProc;
+typedef std::function<bool()>               CMP_MipSetPollProc;
+
+// Set while a pool thread runs a ConvertMipSetJobs job, lets the codecs see an abort
+static thread_local std::atomic<bool>* t_pMipSetAbort = NULL;
+
+static bool CMP_API MipSetJobFeedbackProc(CMP_FLOAT fProgress, CMP_DWORD_PTR pUser1, CMP_DWORD_PTR pUser2)
+{
+    (void)fProgress;
+    (void)pUser1;
+    (void)pUser2;
+    return (t_pMipSetAbort != NULL) && t_pMipSetAbort->load();
+}
+
+//
+// Compresses all the jobs of a MipSet as one task group.
+//
+// Large levels get a task each and still split their blocks over the pool from
+// inside it. Levels of up to MIPSET_SMALL_LEVEL_PIXELS are compressed single
+// threaded and grouped into tasks of about MIPSET_BATCH_PIXELS, so the tail of
+// a mip chain or the six faces of a small cube map are not dominated by setup.
+// Progress is reported from the calling thread by the number of pixels done.
+//
+// jobDoneProc is called on the pool thread that finished a job. pollProc is
+// called on the calling thread while it waits, returning true aborts the jobs
+// that have not completed, as does a cancel of hCancelToken.
+//
+static CMP_ERROR ConvertMipSetJobs(std::vector<CMP_MipSetJob>& jobs,
+                                   const CMP_CompressOptions*  pOptions,
+                                   CMP_Feedback_Proc           pFeedbackProc,
+                                   CMP_CancelToken             hCancelToken,
+                                   const CMP_MipSetJobProc&    jobDoneProc = nullptr,
+                                   const CMP_MipSetPollProc&   pollProc    = nullptr)
+{
+    CMP_CompressOptions smallOptions = *pOptions;
+    smallOptions.bDisableMultiThreading = true;
+    smallOptions.m_PrintInfoStr         = NULL;
+
+    CMP_CompressOptions largeOptions = *pOptions;
+    largeOptions.m_PrintInfoStr      = NULL;
+
+    std::atomic<bool>   abort(false);
+    CMP_ProgressCounter pixelsDone;
+    std::uint64_t       dwTotalPixels = 0;
+    CMP_TaskGroup       taskGroup;
+
+    auto RunJobs = [&](const std::vector<size_t>& jobIndices, const CMP_CompressOptions* pJobOptions) {
+        std::atomic<bool>* pOldAbort = t_pMipSetAbort;
+        t_pMipSetAbort = &abort;
+        BeginCodecReuse();
+        for (size_t i : jobIndices)
         {
-            free(pSourceTexture->pData);
-            pSourceTexture->pData = NULL;
+            CMP_MipSetJob& job = jobs[i];
+            if (abort)
+                job.status = CMP_ABORTED;
+            else
+            {
+                job.status = CMP_ConvertTexture(&job.srcTexture, &job.destTexture, pJobOptions, MipSetJobFeedbackProc);
+                pixelsDone.Add(job.srcTexture.dwWidth * job.srcTexture.dwHeight);
+            }
+            if (jobDoneProc)
+                jobDoneProc(job);
+        }
+        EndCodecReuse();
+        t_pMipSetAbort = pOldAbort;
+    };
+
+    for (auto& job : jobs)
+    {
+        job.status = CMP_ABORTED;
+        dwTotalPixels += (std::uint64_t)job.srcTexture.dwWidth * job.srcTexture.dwHeight;
+    }
+
+    std::vector<size_t> smallJobs;
+    CMP_DWORD           dwBatchPixels = 0;
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        CMP_DWORD dwPixels = jobs[i].srcTexture.dwWidth * jobs[i].srcTexture.dwHeight;
+        if (dwPixels > MIPSET_SMALL_LEVEL_PIXELS)
+        {
+            std::vector<size_t> largeJob(1, i);
+            taskGroup.Run([&RunJobs, &largeOptions, largeJob]() { RunJobs(largeJob, &largeOptions); });
+            continue;
+        }
+
+        smallJobs.push_back(i);
+        dwBatchPixels += dwPixels;
+        if (dwBatchPixels >= MIPSET_BATCH_PIXELS)
+        {
+            taskGroup.Run([&RunJobs, &smallOptions, smallJobs]() { RunJobs(smallJobs, &smallOptions); });
+            smallJobs.clear();
+            dwBatchPixels = 0;
+        }
+    }
+    if (!smallJobs.empty())
+        taskGroup.Run([&RunJobs, &smallOptions, smallJobs]() { RunJobs(smallJobs, &smallOptions); });
+
+    CMP_ProgressProc progressProc;
+    if (pFeedbackProc)
+        progressProc = [pFeedbackProc](float fProgress) { return pFeedbackProc(fProgress, NULL, NULL); };
+    CMP_ProgressThrottle throttle(progressProc);
+
+    while (!taskGroup.WaitFor(10))
+    {
+        if (!abort && ((pollProc && pollProc()) || CMP_IsCanceled(hCancelToken)))
+        {
+            abort = true;
+            taskGroup.Cancel();
+        }
+
+        if (!pFeedbackProc || abort || (dwTotalPixels == 0))
+            continue;
+
+        CMP_INT nProgress = (CMP_INT)((100.0f * pixelsDone.GetTotal()) / dwTotalPixels);
+        if (throttle.Report((CMP_FLOAT)nProgress))
+        {
+            abort = true;
+            taskGroup.Cancel();
         }
-#endif
-        return GetError(err2);
     }
+
+    if (abort)
+        return CMP_ABORTED;
+
+    for (auto& job : jobs)
+    {
+        if (job.status != CMP_OK)
+            return job.status;
+    }
+
+    return CMP_OK;
 }
 
-CMP_ERROR CMP_API CMP_ConvertMipTexture(CMP_MipSet* p_MipSetIn, CMP_MipSet* p_MipSetOut, const CMP_CompressOptions* pOptions, CMP_Feedback_Proc pFeedbackProc) {
+// Levels of these formats can be handed to ConvertMipSetJobs. The GTC codec keeps its
+// encoder tables in globals that every instance rewrites, so its levels can not be
+// compressed side by side, BASIS encodes the whole MipSet as one item.
+static bool CanRunMipSetJobs(const CMP_CompressOptions* pOptions)
+{
+    CodecType destType = GetCodecType(pOptions->DestFormat);
+    if (destType == CT_GTC)
+        return false;
+#ifdef USE_BASIS
+    if (destType == CT_BASIS)
+        return false;
+#endif
+    return true;
+}
+
+//
+// Sets up p_MipSetOut for p_MipSetIn and compresses every level. If pJobs is given
+// the levels are only allocated and added to it, for ConvertMipSetJobs to compress.
+//
+static CMP_ERROR ConvertMipTexture(CMP_MipSet* p_MipSetIn, CMP_MipSet* p_MipSetOut, const CMP_CompressOptions* pOptions, CMP_Feedback_Proc pFeedbackProc,
+                                   std::vector<CMP_MipSetJob>* pJobs) {
     assert(p_MipSetIn);
     assert(p_MipSetOut);
     assert(pOptions);
@@ -935,6 +1076,17 @@ CMP_ERROR CMP_API CMP_ConvertMipTexture(CMP_MipSet* p_MipSetIn, CMP_MipSet* p_Mi
                    }
                 }
 
+                if (pJobs)
+                {
+                    CMP_MipSetJob job;
+                    job.srcTexture  = srcTexture;
+                    job.destTexture = destTexture;
+                    job.status      = CMP_ABORTED;
+                    job.nItem       = 0;
+                    pJobs->push_back(job);
+                    continue;
+                }
+
                 //========================
                 // Process ConvertTexture
                 //========================
@@ -947,10 +1099,433 @@ CMP_ERROR CMP_API CMP_ConvertMipTexture(CMP_MipSet* p_MipSetIn, CMP_MipSet* p_Mi
             }
         }
     }
+    if (pFeedbackProc && !pJobs)
+        pFeedbackProc(100, NULL, NULL);
+
+    return CMP_OK;
+}
+
+CMP_ERROR CMP_API CMP_ConvertMipTexture(CMP_MipSet* p_MipSetIn, CMP_MipSet* p_MipSetOut, const CMP_CompressOptions* pOptions, CMP_Feedback_Proc pFeedbackProc) {
+    assert(pOptions);
+
+    // bParallelMipSet is not part of the options of applications built against an older CMP_CompressOptions
+    bool bParallelMipSet = (pOptions->dwSize == sizeof(CMP_CompressOptions)) && pOptions->bParallelMipSet;
+    if (!bParallelMipSet || pOptions->bDisableMultiThreading || (CMP_ThreadPool::GetThreadPool()->GetNumThreads() < 2) ||
+        !CanRunMipSetJobs(pOptions))
+        return ConvertMipTexture(p_MipSetIn, p_MipSetOut, pOptions, pFeedbackProc, NULL);
+
+    std::vector<CMP_MipSetJob> jobs;
+    CMP_ERROR cmp_status = ConvertMipTexture(p_MipSetIn, p_MipSetOut, pOptions, pFeedbackProc, &jobs);
+    if (cmp_status != CMP_OK)
+        return cmp_status;
+
+    CMP_CancelToken hCancelToken = (pOptions->dwSize == sizeof(CMP_CompressOptions)) ? pOptions->pCancelToken : NULL;
+    cmp_status = ConvertMipSetJobs(jobs, pOptions, pFeedbackProc, hCancelToken);
+    for (auto& job : jobs)
+    {
+        if (job.status == CMP_OK)
+            p_MipSetOut->m_nIterations++;
+    }
+    if (cmp_status != CMP_OK)
+        return cmp_status;
+
     if (pFeedbackProc)
         pFeedbackProc(100, NULL, NULL);
 
     return CMP_OK;
 }
 
+CMP_ERROR CMP_API CMP_BatchCompress(CMP_INT numItems, CMP_MipSet* pMipSetsIn, CMP_MipSet* pMipSetsOut, const CMP_CompressOptions* pOptions,
+                                    CMP_BatchItem_Proc pItemProc, CMP_DWORD_PTR pUser)
+{
+    if ((numItems < 0) || (numItems > 0 && (!pMipSetsIn || !pMipSetsOut)) || !pOptions)
+        return CMP_ERR_GENERIC;
+
+    CMP_ERROR result = CMP_OK;
+
+    // Formats that can not share the pool between items, or a single threaded batch,
+    // are compressed one item after the other
+    if (pOptions->bDisableMultiThreading || !CanRunMipSetJobs(pOptions))
+    {
+        bool bAbort = false;
+        for (CMP_INT nItem = 0; nItem < numItems; nItem++)
+        {
+            CMP_ERROR status = bAbort ? CMP_ABORTED : CMP_ConvertMipTexture(&pMipSetsIn[nItem], &pMipSetsOut[nItem], pOptions, NULL);
+            if ((status != CMP_OK) && (result == CMP_OK))
+                result = status;
+            if (pItemProc && !bAbort)
+                bAbort = pItemProc(nItem, status, pUser);
+            else if (pItemProc)
+                pItemProc(nItem, status, pUser);
+        }
+        return bAbort ? CMP_ABORTED : result;
+    }
+
+    // Set up every output MipSet first, then compress all their levels as one set of jobs
+    std::vector<CMP_MipSetJob>          jobs;
+    std::vector<CMP_ERROR>              itemStatus(numItems, CMP_OK);
+    std::vector<std::atomic<CMP_INT>>   itemJobsLeft(numItems);
+    std::vector<std::atomic<CMP_INT>>   itemLevelsDone(numItems);
+    std::vector<size_t>                 itemFirstJob(numItems, 0);
+    std::vector<size_t>                 itemNumJobs(numItems, 0);
+    std::vector<CMP_INT>                itemsDone;
+    std::mutex                          itemsDoneMutex;
+
+    for (CMP_INT nItem = 0; nItem < numItems; nItem++)
+    {
+        size_t nFirstJob = jobs.size();
+        itemStatus[nItem] = ConvertMipTexture(&pMipSetsIn[nItem], &pMipSetsOut[nItem], pOptions, NULL, &jobs);
+        if (itemStatus[nItem] != CMP_OK)
+            jobs.resize(nFirstJob);
+
+        for (size_t i = nFirstJob; i < jobs.size(); i++)
+            jobs[i].nItem = nItem;
+
+        itemFirstJob[nItem]   = nFirstJob;
+        itemNumJobs[nItem]    = jobs.size() - nFirstJob;
+        itemLevelsDone[nItem] = 0;
+        itemJobsLeft[nItem]   = (CMP_INT)itemNumJobs[nItem];
+        if (itemJobsLeft[nItem] == 0)
+            itemsDone.push_back(nItem);
+    }
+
+    auto JobDone = [&](CMP_MipSetJob& job) {
+        if (job.status == CMP_OK)
+            itemLevelsDone[job.nItem]++;
+        if (--itemJobsLeft[job.nItem] == 0)
+        {
+            std::lock_guard<std::mutex> lock(itemsDoneMutex);
+            itemsDone.push_back(job.nItem);
+        }
+    };
+
+    // Completed items are reported from this thread
+    bool              bAbort = false;
+    std::vector<bool> itemReported(numItems, false);
+    auto ReportItems = [&]() {
+        std::vector<CMP_INT> items;
+        {
+            std::lock_guard<std::mutex> lock(itemsDoneMutex);
+            items.swap(itemsDone);
+        }
+        for (CMP_INT nItem : items)
+        {
+            itemReported[nItem] = true;
+            pMipSetsOut[nItem].m_nIterations = itemLevelsDone[nItem];
+            for (size_t i = itemFirstJob[nItem]; i < itemFirstJob[nItem] + itemNumJobs[nItem]; i++)
+            {
+                if ((jobs[i].status != CMP_OK) && (itemStatus[nItem] == CMP_OK))
+                    itemStatus[nItem] = jobs[i].status;
+            }
+            if ((itemStatus[nItem] != CMP_OK) && (result == CMP_OK))
+                result = itemStatus[nItem];
+            if (pItemProc && pItemProc(nItem, itemStatus[nItem], pUser))
+                bAbort = true;
+        }
+        return bAbort;
+    };
+
+    CMP_CancelToken hCancelToken = (pOptions->dwSize == sizeof(CMP_CompressOptions)) ? pOptions->pCancelToken : NULL;
+    ConvertMipSetJobs(jobs, pOptions, NULL, hCancelToken, JobDone, ReportItems);
+
+    // Jobs skipped after an abort never complete, their items are reported as aborted
+    for (CMP_INT nItem = 0; nItem < numItems; nItem++)
+    {
+        if ((itemJobsLeft[nItem] > 0) && !itemReported[nItem])
+        {
+            std::lock_guard<std::mutex> lock(itemsDoneMutex);
+            itemsDone.push_back(nItem);
+        }
+    }
+    ReportItems();
+
+    return bAbort ? CMP_ABORTED : result;
+}
+
+// State behind a CMP_AsyncTask handle, shared by the application and the pool
+struct CMP_AsyncTaskData
+{
+    CMP_MipSet*             pMipSetIn;
+    CMP_MipSet*             pMipSetOut;
+    CMP_CompressOptions     options;
+    CMP_INT                 nLane;          // Index in g_AsyncLanes
+
+    std::atomic<CMP_INT>    m_RefCount;     // The application handle and the queued task
+    std::mutex              m_Mutex;
+    std::condition_variable m_DoneCondition;
+    bool                    m_bDone;
+    CMP_ERROR               m_Status;
+    CMP_AsyncTask_Proc      m_pTaskProc;
+    CMP_DWORD_PTR           m_pUser;
+};
+
+static void ReleaseAsyncTask(CMP_AsyncTaskData* pTask)
+{
+    if (--pTask->m_RefCount == 0)
+        delete pTask;
+}
+
+//
+// Async tasks wait here and at most one runner per pool worker is queued on the pool.
+// A runner is queued with the task it compresses, taken off the lane under the lock so
+// no two runners are handed the same task, and then queues a runner for the next task.
+// A worker waiting inside a compression helps by running queued pool tasks, bounding the
+// runners bounds how deep such a worker can nest other async compressions on its stack.
+//
+// Formats that can not be compressed side by side (see CanRunMipSetJobs) wait in their
+// own lane that has a single runner, so those tasks run one after the other. A mutex
+// held around the compression could not be used instead: the runner holding it may
+// pick up the next runner of the lane while it waits inside its compression.
+//
+// While any runner exists the lanes keep a reference to the pool, so it can not be
+// shut down under them.
+//
+#define CMP_ASYNC_LANE_PARALLEL 0
+#define CMP_ASYNC_LANE_SERIAL   1
+
+struct CMP_AsyncLane
+{
+    std::deque<CMP_AsyncTaskData*> tasks;
+    CMP_DWORD                      dwRunners;
+};
+
+static std::mutex                      g_AsyncMutex;
+static CMP_AsyncLane                   g_AsyncLanes[2];
+static std::shared_ptr<CMP_ThreadPool> g_pAsyncPool;
+
+static void RunAsyncTask(CMP_AsyncTaskData* pTask)
+{
+    CMP_INT        nLane = pTask->nLane;
+    CMP_AsyncLane& lane  = g_AsyncLanes[nLane];
+
+    CMP_ERROR status = CMP_ConvertMipTexture(pTask->pMipSetIn, pTask->pMipSetOut, &pTask->options, NULL);
+
+    // Queue the next runner or give up the pool before the task is reported done, so an
+    // application that saw its last task finish can shut the pool down
+    std::shared_ptr<CMP_ThreadPool> pPool;
+    CMP_AsyncTaskData*              pNextTask = NULL;
+    {
+        std::lock_guard<std::mutex> lock(g_AsyncMutex);
+        if (!lane.tasks.empty())
+        {
+            pNextTask = lane.tasks.front();
+            lane.tasks.pop_front();
+            pPool = g_pAsyncPool;
+        }
+        else if ((--lane.dwRunners == 0) && (g_AsyncLanes[1 - nLane].dwRunners == 0))
+            g_pAsyncPool.reset();
+    }
+    if (pNextTask)
+        pPool->Submit([pNextTask]() { RunAsyncTask(pNextTask); });
+
+    CMP_AsyncTask_Proc pTaskProc;
+    {
+        std::lock_guard<std::mutex> lock(pTask->m_Mutex);
+        pTask->m_Status = status;
+        pTask->m_bDone  = true;
+        pTaskProc       = pTask->m_pTaskProc;
+        pTask->m_DoneCondition.notify_all();
+    }
+    if (pTaskProc)
+        pTaskProc(pTask, status, pTask->m_pUser);
+    ReleaseAsyncTask(pTask);
+}
+
+CMP_ERROR CMP_API CMP_ConvertMipTextureAsync(CMP_MipSet* p_MipSetIn, CMP_MipSet* p_MipSetOut, const CMP_CompressOptions* pOptions,
+                                             CMP_AsyncTask* phTask)
+{
+    if (!p_MipSetIn || !p_MipSetOut || !pOptions || !phTask)
+        return CMP_ERR_GENERIC;
+
+    CMP_AsyncTaskData* pTask = new CMP_AsyncTaskData;
+    pTask->pMipSetIn  = p_MipSetIn;
+    pTask->pMipSetOut = p_MipSetOut;
+    pTask->options    = *pOptions;
+    pTask->nLane      = CanRunMipSetJobs(pOptions) ? CMP_ASYNC_LANE_PARALLEL : CMP_ASYNC_LANE_SERIAL;
+    pTask->m_RefCount = 2;
+    pTask->m_bDone    = false;
+    pTask->m_Status   = CMP_ABORTED;
+    pTask->m_pTaskProc = NULL;
+    pTask->m_pUser     = 0;
+    *phTask = pTask;
+
+    std::shared_ptr<CMP_ThreadPool> pPool = CMP_ThreadPool::GetThreadPool();
+    CMP_AsyncTaskData*              pRunTask = NULL;
+    {
+        std::lock_guard<std::mutex> lock(g_AsyncMutex);
+        CMP_AsyncLane& lane = g_AsyncLanes[pTask->nLane];
+        lane.tasks.push_back(pTask);
+        CMP_DWORD dwMaxRunners = (pTask->nLane == CMP_ASYNC_LANE_SERIAL) ? 1 : pPool->GetNumThreads();
+        if (lane.dwRunners < dwMaxRunners)
+        {
+            lane.dwRunners++;
+            if (!g_pAsyncPool)
+                g_pAsyncPool = pPool;
+            pRunTask = lane.tasks.front();
+            lane.tasks.pop_front();
+        }
+    }
+    if (pRunTask)
+        pPool->Submit([pRunTask]() { RunAsyncTask(pRunTask); });
+
+    return CMP_OK;
+}
+
+CMP_BOOL CMP_API CMP_IsAsyncTaskDone(CMP_AsyncTask hTask, CMP_ERROR* pStatus)
+{
+    return CMP_WaitAsyncTask(hTask, 0, pStatus);
+}
+
+CMP_BOOL CMP_API CMP_WaitAsyncTask(CMP_AsyncTask hTask, CMP_DWORD dwTimeoutMS, CMP_ERROR* pStatus)
+{
+    if (!hTask)
+        return false;
+
+    std::unique_lock<std::mutex> lock(hTask->m_Mutex);
+    if (dwTimeoutMS == CMP_ASYNC_INFINITE)
+        hTask->m_DoneCondition.wait(lock, [hTask] { return hTask->m_bDone; });
+    else if (dwTimeoutMS > 0)
+        hTask->m_DoneCondition.wait_for(lock, std::chrono::milliseconds(dwTimeoutMS), [hTask] { return hTask->m_bDone; });
+
+    if (hTask->m_bDone && pStatus)
+        *pStatus = hTask->m_Status;
+    return hTask->m_bDone;
+}
+
+CMP_VOID CMP_API CMP_SetAsyncTaskCallback(CMP_AsyncTask hTask, CMP_AsyncTask_Proc pTaskProc, CMP_DWORD_PTR pUser)
+{
+    if (!hTask)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(hTask->m_Mutex);
+        if (!hTask->m_bDone)
+        {
+            hTask->m_pTaskProc = pTaskProc;
+            hTask->m_pUser     = pUser;
+            return;
+        }
+    }
+
+    if (pTaskProc)
+        pTaskProc(hTask, hTask->m_Status, pUser);
+}
+
+CMP_VOID CMP_API CMP_ReleaseAsyncTask(CMP_AsyncTask hTask)
+{
+    if (hTask)
+        ReleaseAsyncTask(hTask);
+}
+
+CMP_ERROR CMP_API CMP_InitializeThreadPool(CMP_INT numThreads)
+{
+    return CMP_InitializeThreadPoolEx(numThreads, CMP_THREAD_PLACEMENT_NONE);
+}
+
+CMP_ERROR CMP_API CMP_InitializeThreadPoolEx(CMP_INT numThreads, CMP_ThreadPlacement placement)
+{
+    if (numThreads < 0)
+        return CMP_ERR_GENERIC;
+
+    if (!CMP_ThreadPool::Initialize((CMP_DWORD)numThreads, placement))
+        return CMP_ERR_GENERIC;
+
+    return CMP_OK;
+}
+
+CMP_ERROR CMP_API CMP_ShutdownThreadPool()
+{
+    if (!CMP_ThreadPool::Shutdown())
+        return CMP_ERR_GENERIC;
+
+    return CMP_OK;
+}
+
+CMP_ERROR CMP_API CMP_GetCPUTopology(KernelDeviceInfo* pDeviceInfo)
+{
+    if (!pDeviceInfo)
+        return CMP_ERR_GENERIC;
+
+    const CMP_CpuTopology& topology = CMP_GetCpuTopology();
+
+    pDeviceInfo->m_maxUCores = topology.nNumCpus;
+    pDeviceInfo->m_numNodes  = (CMP_INT)topology.nodes.size();
+    for (CMP_INT i = 0; i < CMP_MAX_NUMA_NODES; i++)
+        pDeviceInfo->m_nodeCores[i] = (i < pDeviceInfo->m_numNodes) ? (CMP_INT)topology.nodes[i].cpus.size() : 0;
+    pDeviceInfo->m_numPerfCores       = topology.nNumPerfCpus;
+    pDeviceInfo->m_numEfficiencyCores = topology.nNumEffCpus;
+
+    return CMP_OK;
+}
+
+CMP_ERROR CMP_API CMP_GetBlockStats(CMP_FORMAT format, CMP_BlockStats* pBlockStats)
+{
+    if (!pBlockStats)
+        return CMP_ERR_GENERIC;
+
+    CMP_DWORD dwCounts[CMP_BLOCK_CLASSES];
+    if (!CMP_GetBlockClassCounts(format, dwCounts))
+        return CMP_ERR_UNSUPPORTED_DEST_FORMAT;
+
+    pBlockStats->dwBlocks          = dwCounts[CMP_BLOCK_COMPLEX] + dwCounts[CMP_BLOCK_SOLID] + dwCounts[CMP_BLOCK_TWO_COLOUR] + dwCounts[CMP_BLOCK_GRADIENT];
+    pBlockStats->dwSolidBlocks     = dwCounts[CMP_BLOCK_SOLID];
+    pBlockStats->dwTwoColourBlocks = dwCounts[CMP_BLOCK_TWO_COLOUR];
+    pBlockStats->dwGradientBlocks  = dwCounts[CMP_BLOCK_GRADIENT];
+
+    CMP_DWORD dwSearchCounts[CMP_SEARCH_COUNTS];
+    CMP_GetModeSearchCounts(format, dwSearchCounts);
 
+    pBlockStats->dwSearchBlocks     = dwSearchCounts[CMP_SEARCH_BLOCKS];
+    pBlockStats->dwSearchCandidates = dwSearchCounts[CMP_SEARCH_CANDIDATES];
+    pBlockStats->dwSearchRefined    = dwSearchCounts[CMP_SEARCH_REFINED];
+    pBlockStats->dwSearchEarlyOuts  = dwSearchCounts[CMP_SEARCH_EARLY_OUTS];
+    for (CMP_INT i = 0; i < CMP_SEARCH_RANKS; i++)
+        pBlockStats->dwSearchBestRank[i] = dwSearchCounts[CMP_SEARCH_BEST_RANK + i];
+
+    return CMP_OK;
+}
+
+CMP_VOID CMP_API CMP_ResetBlockStats()
+{
+    CMP_ClearBlockClassCounts();
+}
+
+CMP_CancelToken CMP_API CMP_CreateCancelToken(CMP_DWORD dwDeadlineMS, CMP_FLOAT fDegradeAt)
+{
+    CMP_CancelToken hCancelToken = new (std::nothrow) CMP_CancelTokenData;
+    if (!hCancelToken)
+        return NULL;
+
+    hCancelToken->m_Canceled        = false;
+    hCancelToken->m_Degraded        = false;
+    hCancelToken->m_bHasDeadline    = dwDeadlineMS > 0;
+    hCancelToken->m_bHasDegradeTime = (dwDeadlineMS > 0) && (fDegradeAt > 0.0f);
+
+    CMP_CancelTokenData::Clock::time_point start = CMP_CancelTokenData::Clock::now();
+    hCancelToken->m_Deadline    = start + std::chrono::milliseconds(dwDeadlineMS);
+    hCancelToken->m_DegradeTime = start + std::chrono::milliseconds((long long)(fDegradeAt * dwDeadlineMS));
+
+    return hCancelToken;
+}
+
+CMP_VOID CMP_API CMP_CancelCompression(CMP_CancelToken hCancelToken)
+{
+    if (hCancelToken)
+        hCancelToken->m_Canceled = true;
+}
+
+CMP_VOID CMP_API CMP_DegradeCompression(CMP_CancelToken hCancelToken)
+{
+    if (hCancelToken)
+        hCancelToken->m_Degraded = true;
+}
+
+CMP_BOOL CMP_API CMP_IsCompressionCanceled(CMP_CancelToken hCancelToken)
+{
+    return CMP_IsCanceled(hCancelToken);
+}
+
+CMP_VOID CMP_API CMP_DestroyCancelToken(CMP_CancelToken hCancelToken)
+{
+    delete hCancelToken;
+}
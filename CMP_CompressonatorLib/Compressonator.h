@@ -203,6 +203,14 @@ struct ComputeOptions {
     void *plugin_compute;                   ///< Ref to Encoder codec plugin: For Internal use (will be removed!)
 };
 
+#define CMP_MAX_NUMA_NODES 16
+
+// How the library thread pool places its workers on the processors
+typedef enum CMPThreadPlacement {
+    CMP_THREAD_PLACEMENT_NONE = 0,          ///< Workers may run on any processor, left to the OS scheduler
+    CMP_THREAD_PLACEMENT_NUMA = 1,          ///< Workers are spread evenly over the NUMA nodes and kept on their node
+} CMP_ThreadPlacement;
+
 typedef enum CMPComputeExtensions {
     CMP_COMPUTE_FP16        = 0x0001,       ///< Enable Packed Math Option for GPU
     CMP_COMPUTE_MAX_ENUM    = 0x7FFF
@@ -220,6 +228,25 @@ struct KernelDeviceInfo {
     CMP_INT       m_maxUCores;           // Max Unit device CPU cores or GPU compute units (CU)
                                          // AMD GCN::One compute unit combines 64 shader processors 
                                          // with 4 Texture Mapping units (TMU)
+    CMP_INT       m_numNodes;            // CPU: Number of NUMA nodes with processors the library may use
+    CMP_INT       m_nodeCores[CMP_MAX_NUMA_NODES]; // CPU: Logical processors on each of the first m_numNodes nodes
+    CMP_INT       m_numPerfCores;        // CPU: Logical processors on performance cores, 0 if all the cores are of one type
+    CMP_INT       m_numEfficiencyCores;  // CPU: Logical processors on efficiency cores
+};
+
+#define CMP_SEARCH_RANKS 8
+
+struct CMP_BlockStats {
+    CMP_DWORD     dwBlocks;              // Blocks encoded
+    CMP_DWORD     dwSolidBlocks;         // Blocks of one colour, encoded without a search
+    CMP_DWORD     dwTwoColourBlocks;     // Blocks of two colours, searched with single subset modes only (not ASTC)
+    CMP_DWORD     dwGradientBlocks;      // Blocks with colours along a line, searched as above (not ASTC)
+    CMP_DWORD     dwSearchBlocks;        // Blocks encoded with the coarse to fine mode search (dwModeSearchCandidates, BC7 and BC6H only)
+    CMP_DWORD     dwSearchCandidates;    // Candidates the search ranked by their quick estimate in those blocks
+    CMP_DWORD     dwSearchRefined;       // Candidates it refined, at most dwModeSearchCandidates per block
+    CMP_DWORD     dwSearchEarlyOuts;     // Blocks that met the error threshold before all their top candidates were refined (BC7)
+    CMP_DWORD     dwSearchBestRank[CMP_SEARCH_RANKS]; // Blocks whose result came from the candidate ranked i by the estimate,
+                                                      // the last entry also counts the ranks after it. Use it to pick dwModeSearchCandidates
 };
 
 struct KernelOptions {
@@ -287,6 +314,15 @@ typedef enum {
 // function for printing std out info to users.
 typedef void (CMP_API* CMP_PrintInfoStr)(const char* InfoStr );
 
+// Handle used to stop, or speed up, a compression running on another thread. See CMP_CreateCancelToken
+typedef struct CMP_CancelTokenData* CMP_CancelToken;
+
+// Handle of a compression running in the background. See CMP_ConvertMipTextureAsync
+typedef struct CMP_AsyncTaskData* CMP_AsyncTask;
+
+// Timeout for CMP_WaitAsyncTask that never expires
+#define CMP_ASYNC_INFINITE 0xFFFFFFFF
+
 
 // User options and setting used for processing
 typedef struct {
@@ -370,6 +406,16 @@ typedef struct {
     CMP_BOOL   getDeviceInfo;           // Set to true if you want to get target device info
     KernelDeviceInfo deviceInfo;        // Data storage for the performance stats obtained from GPU or CPU while running encoder processing
 
+    CMP_BOOL   bParallelMipSet;         // CMP_ConvertMipTexture: compress all MIP levels and cube faces of the MipSet at the same time on the
+                                        // library thread pool, small levels are grouped into larger jobs. Default is false (one level after the other)
+    CMP_CancelToken pCancelToken;       // Optional token checked by the codec block loops and pool workers, once it is canceled or its deadline
+                                        // has passed the compression stops and returns CMP_ABORTED. Default is NULL
+    CMP_BOOL   bBC7SinglePrecision;     // BC7: run the block encoder in single instead of double precision. It is faster and the quality
+                                        // stays within a small PSNR tolerance of the double precision encoder. Default is false
+    CMP_DWORD  dwModeSearchCandidates;  // BC7 and BC6H: rank every mode and partition of a block by a quick estimate and refine only this many
+                                        // of the best, BC7 stops as soon as one is within the error threshold. CMP_GetBlockStats reports which
+                                        // ranks the blocks ended up with. Default is 0, every mode is refined in turn
+
 } CMP_CompressOptions;
 
 /// The format of data in the channels of texture.
@@ -745,6 +791,116 @@ extern "C"
     /// Converts the source texture to the destination texture using MipSets with MIP MAP Levels
     CMP_ERROR CMP_API CMP_ConvertMipTexture(CMP_MipSet* p_MipSetIn, CMP_MipSet* p_MipSetOut, const CMP_CompressOptions* pOptions, CMP_Feedback_Proc pFeedbackProc);
 
+    /// CMP_BatchItem_Proc
+    /// Called by CMP_BatchCompress once for every item, on the thread that called CMP_BatchCompress.
+    /// \param[in] nItem The index of the item in the batch.
+    /// \param[in] status CMP_OK if the item was compressed, otherwise the error code.
+    /// \param[in] pUser User data passed to CMP_BatchCompress.
+    /// \return non-NULL(true) value to abort the items that have not completed
+    typedef bool(CMP_API* CMP_BatchItem_Proc)(CMP_INT nItem, CMP_ERROR status, CMP_DWORD_PTR pUser);
+
+    /// Compresses numItems MipSets with the same options.
+    /// The MIP levels of all the items are compressed together on the library thread pool, so a batch of
+    /// small textures keeps every worker busy. Items are reported through pItemProc as they complete.
+    /// \param[in]  numItems Number of MipSets in pMipSetsIn and pMipSetsOut.
+    /// \param[in]  pMipSetsIn Array of source MipSets.
+    /// \param[out] pMipSetsOut Array of destination MipSets, set up as for CMP_ConvertMipTexture.
+    /// \param[in]  pOptions The compression options to use for every item.
+    /// \param[in]  pItemProc A pointer to the item completion function - can be NULL.
+    /// \param[in]  pUser User data passed to pItemProc.
+    /// \return    CMP_OK if all the items were compressed, otherwise the error code of the first item that failed.
+    CMP_ERROR CMP_API CMP_BatchCompress(CMP_INT numItems, CMP_MipSet* pMipSetsIn, CMP_MipSet* pMipSetsOut, const CMP_CompressOptions* pOptions,
+                                        CMP_BatchItem_Proc pItemProc, CMP_DWORD_PTR pUser);
+
+    /// Starts CMP_ConvertMipTexture on the library thread pool and returns without waiting for it.
+    /// The options are copied, the MipSets and any data the options point to must stay valid until the task is done.
+    /// Any number of tasks can be in flight, they are started as pool workers become free.
+    /// The GTC encoder keeps its tables in globals, so tasks compressing to that format run one at a time,
+    /// and must not overlap a synchronous GTC compression started by the application.
+    /// Use pOptions->pCancelToken to cancel a task.
+    /// \param[in]  p_MipSetIn The source MipSet.
+    /// \param[out] p_MipSetOut The destination MipSet, set up as for CMP_ConvertMipTexture.
+    /// \param[in]  pOptions The compression options.
+    /// \param[out] phTask Receives the task handle, release it with CMP_ReleaseAsyncTask.
+    /// \return    CMP_OK if the task was started
+    CMP_ERROR CMP_API CMP_ConvertMipTextureAsync(CMP_MipSet* p_MipSetIn, CMP_MipSet* p_MipSetOut, const CMP_CompressOptions* pOptions,
+                                                 CMP_AsyncTask* phTask);
+
+    /// CMP_AsyncTask_Proc
+    /// Called once when an async task is done, on the pool thread that finished it.
+    /// \param[in] hTask The task, it remains valid until the callback returns even if already released.
+    /// \param[in] status The result of the compression.
+    /// \param[in] pUser User data passed to CMP_SetAsyncTaskCallback.
+    typedef void(CMP_API* CMP_AsyncTask_Proc)(CMP_AsyncTask hTask, CMP_ERROR status, CMP_DWORD_PTR pUser);
+
+    /// Returns true if the task is done and sets *pStatus (can be NULL) to its result, never blocks.
+    CMP_BOOL CMP_API CMP_IsAsyncTaskDone(CMP_AsyncTask hTask, CMP_ERROR* pStatus);
+
+    /// Waits at most dwTimeoutMS milliseconds (CMP_ASYNC_INFINITE = no limit) for the task.
+    /// Must not be called from inside a CMP_AsyncTask_Proc.
+    /// \return true if the task is done, *pStatus (can be NULL) is then set to its result
+    CMP_BOOL CMP_API CMP_WaitAsyncTask(CMP_AsyncTask hTask, CMP_DWORD dwTimeoutMS, CMP_ERROR* pStatus);
+
+    /// Sets the function called when the task is done. If the task is already done it is called
+    /// right away on the calling thread. Only one function can be set per task.
+    CMP_VOID CMP_API CMP_SetAsyncTaskCallback(CMP_AsyncTask hTask, CMP_AsyncTask_Proc pTaskProc, CMP_DWORD_PTR pUser);
+
+    /// Releases the handle, a task that is not done yet still runs to completion.
+    CMP_VOID CMP_API CMP_ReleaseAsyncTask(CMP_AsyncTask hTask);
+
+    /// Creates a token for CMP_CompressOptions::pCancelToken, one token can be shared by several compressions.
+    /// \param[in] dwDeadlineMS Wall clock time in milliseconds from now after which the compressions are canceled, 0 for no deadline
+    /// \param[in] fDegradeAt Fraction (0..1) of dwDeadlineMS after which the remaining BC7 and BC6H blocks are encoded
+    ///                       at the lowest quality so the compression can still finish in time, 0 to never degrade
+    /// \return The token, NULL if it could not be created
+    CMP_CancelToken CMP_API CMP_CreateCancelToken(CMP_DWORD dwDeadlineMS, CMP_FLOAT fDegradeAt);
+
+    /// Cancels the compressions using the token, they return CMP_ABORTED. Can be called from any thread.
+    CMP_VOID CMP_API CMP_CancelCompression(CMP_CancelToken hToken);
+
+    /// Encodes the remaining BC7 and BC6H blocks of the compressions using the token at the lowest quality.
+    CMP_VOID CMP_API CMP_DegradeCompression(CMP_CancelToken hToken);
+
+    /// Returns true once the token is canceled or its deadline has passed.
+    CMP_BOOL CMP_API CMP_IsCompressionCanceled(CMP_CancelToken hToken);
+
+    /// Releases the token, it must no longer be used by any compression.
+    CMP_VOID CMP_API CMP_DestroyCancelToken(CMP_CancelToken hToken);
+
+    /// Creates the library thread pool used by the CPU codecs.
+    /// The pool is otherwise created on first use with one worker per processor.
+    /// \param[in] numThreads Number of worker threads, 0 uses the number of processors (max 128)
+    /// \return CMP_OK if the pool was created, CMP_ERR_GENERIC while a compression or an async task that is
+    ///         not yet done is using the current pool
+    CMP_ERROR CMP_API CMP_InitializeThreadPool(CMP_INT numThreads);
+
+    /// Creates the library thread pool with the given worker placement.
+    /// With CMP_THREAD_PLACEMENT_NUMA each worker is kept on one NUMA node and the rows of a texture
+    /// are split between the nodes, so the destination memory a worker writes is allocated on its node.
+    /// \param[in] numThreads Number of worker threads, 0 uses the number of processors (max 128)
+    /// \param[in] placement How the workers are placed on the processors
+    /// \return CMP_OK if the pool was created, CMP_ERR_GENERIC while the current pool is in use as for CMP_InitializeThreadPool
+    CMP_ERROR CMP_API CMP_InitializeThreadPoolEx(CMP_INT numThreads, CMP_ThreadPlacement placement);
+
+    /// Fills the CPU topology fields of pDeviceInfo (m_maxUCores, m_numNodes, m_nodeCores and the core
+    /// type counts) for the processors the library thread pool may use.
+    CMP_ERROR CMP_API CMP_GetCPUTopology(KernelDeviceInfo* pDeviceInfo);
+
+    /// Fills pBlockStats with the number of blocks the BC7, BC6H and ASTC encoders have encoded
+    /// since the library was loaded or the stats were last reset, and how many of them took the
+    /// solid, two colour or gradient fast paths, and what the coarse to fine mode search did.
+    /// Counts are added when an encoder is destroyed.
+    /// \return CMP_ERR_UNSUPPORTED_DEST_FORMAT for formats that are not counted
+    CMP_ERROR CMP_API CMP_GetBlockStats(CMP_FORMAT format, CMP_BlockStats* pBlockStats);
+
+    /// Sets the block counts of all the formats back to zero.
+    CMP_VOID CMP_API CMP_ResetBlockStats();
+
+    /// Releases the library thread pool, it is created again on the next compression.
+    /// \return CMP_OK, or CMP_ERR_GENERIC without releasing the pool while a compression or an async task
+    ///         that is not yet done is using it
+    CMP_ERROR CMP_API CMP_ShutdownThreadPool();
+
 
 //--------------------------------------------
 // CMP_Compute Lib: Texture Encoder Interfaces
@@ -31,6 +31,8 @@
 #include "Common.h"
 #include "Codec_DXT3.h"
 
+#include <vector>
+
 #ifdef TEST_CMP_CORE_DECODER
 #include "CMP_Core.h"
 #endif
@@ -67,21 +69,28 @@ CodecError CCodec_DXT3::Compress(CCodecBuffer& bufferIn, CCodecBuffer& bufferOut
 
     bool bUseFixed = (!bufferIn.IsFloat() && bufferIn.GetChannelDepth() == 8 && !m_bUseFloat);
 
+    // Source blocks are gathered a whole row at a time
+    std::vector<CMP_BYTE> srcRowFixed(bUseFixed ? dwBlocksX * BLOCK_SIZE_4X4X4 : 0);
+    std::vector<float> srcRowFloat(bUseFixed ? 0 : dwBlocksX * BLOCK_SIZE_4X4X4);
+
     for(CMP_DWORD j = 0; j < dwBlocksY; j++)
     {
+        if(bUseFixed)
+            bufferIn.ReadBlockRowRGBA(0, j*4, dwBlocksX, &srcRowFixed[0]);
+        else
+            bufferIn.ReadBlockRowRGBA(0, j*4, dwBlocksX, &srcRowFloat[0]);
+
         for(CMP_DWORD i = 0; i < dwBlocksX; i++)
         {
             CMP_DWORD compressedBlock[4];
             if(bUseFixed)
             {
-                CMP_BYTE srcBlock[BLOCK_SIZE_4X4X4];
-                bufferIn.ReadBlockRGBA(i*4, j*4, 4, 4, srcBlock);
+                CMP_BYTE* srcBlock = &srcRowFixed[i * BLOCK_SIZE_4X4X4];
                 CompressRGBABlock_ExplicitAlpha(srcBlock, compressedBlock, CalculateColourWeightings(srcBlock));
             }
             else
             {
-                float srcBlock[BLOCK_SIZE_4X4X4];
-                bufferIn.ReadBlockRGBA(i*4, j*4, 4, 4, srcBlock);
+                float* srcBlock = &srcRowFloat[i * BLOCK_SIZE_4X4X4];
                 CompressRGBABlock_ExplicitAlpha(srcBlock, compressedBlock, CalculateColourWeightings(srcBlock));
             }
             bufferOut.WriteBlock(i*4, j*4, compressedBlock, 4);
@@ -175,6 +184,10 @@ CodecError CCodec_DXT3::Decompress(CCodecBuffer& bufferIn, CCodecBuffer& bufferO
 
     bool bUseFixed = (!bufferOut.IsFloat() && bufferOut.GetChannelDepth() == 8 && !m_bUseFloat);
 
+    // Decoded blocks are written back a whole row at a time
+    std::vector<CMP_BYTE> destRowFixed(bUseFixed ? dwBlocksX * BLOCK_SIZE_4X4X4 : 0);
+    std::vector<float> destRowFloat(bUseFixed ? 0 : dwBlocksX * BLOCK_SIZE_4X4X4);
+
     for(CMP_DWORD j = 0; j < dwBlocksY; j++)
     {
         for(CMP_DWORD i = 0; i < dwBlocksX; i++)
@@ -183,21 +196,23 @@ CodecError CCodec_DXT3::Decompress(CCodecBuffer& bufferIn, CCodecBuffer& bufferO
             bufferIn.ReadBlock(i*4, j*4, compressedBlock, 4);
             if(bUseFixed)
             {
-                CMP_BYTE destBlock[BLOCK_SIZE_4X4X4];
+                CMP_BYTE* destBlock = &destRowFixed[i * BLOCK_SIZE_4X4X4];
                 #ifdef TEST_CMP_CORE_DECODER
                     DecompressBlockBC2((CMP_BYTE *)compressedBlock,destBlock);
                 #else
                     DecompressRGBABlock_ExplicitAlpha(destBlock, compressedBlock);
                 #endif
-                bufferOut.WriteBlockRGBA(i*4, j*4, 4, 4, destBlock);
             }
             else
             {
-                float destBlock[BLOCK_SIZE_4X4X4];
+                float* destBlock = &destRowFloat[i * BLOCK_SIZE_4X4X4];
                 DecompressRGBABlock_ExplicitAlpha(destBlock, compressedBlock);
-                bufferOut.WriteBlockRGBA(i*4, j*4, 4, 4, destBlock);
             }
         }
+        if(bUseFixed)
+            bufferOut.WriteBlockRowRGBA(0, j*4, dwBlocksX, &destRowFixed[0]);
+        else
+            bufferOut.WriteBlockRowRGBA(0, j*4, dwBlocksX, &destRowFloat[0]);
 
         if (pFeedbackProc)
         {
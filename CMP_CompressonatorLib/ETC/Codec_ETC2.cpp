@@ -28,12 +28,15 @@
 
 #include "Codec_ETC2.h"
 
+#include <mutex>
+#include <string>
+
 #pragma warning( push )
 #pragma warning(disable:4244)
 
 using namespace CMP;
 
-bool g_alphaTableInitialized = false;
+static std::once_flag g_alphaTableOnce;
 
 
 //////////////////////////////////////////////////////////////////////////////
@@ -42,15 +45,15 @@ bool g_alphaTableInitialized = false;
 
 void CCodec_ETC2::setupAlphaTable()
 {
-    if (!g_alphaTableInitialized)
+    // Codecs created on different threads share the tables, the first one builds them
+    std::call_once(g_alphaTableOnce, []()
     {
 #ifdef USE_ETCPACK
         setupAlphaTableAndValtab();
 #else
         cmp_setupAlphaTable();
 #endif
-        g_alphaTableInitialized = true;
-    }
+    });
 }
 
 CCodec_ETC2::CCodec_ETC2(CodecType codecType) :
@@ -62,20 +65,20 @@ CCodec_Block_4x4(codecType)
     {
     case  CT_ETC2_RGB:
     case  CT_ETC2_SRGB:
-        format = ETC2PACKAGE_RGB_NO_MIPMAPS;
+        m_etcpackFormat = ETC2PACKAGE_RGB_NO_MIPMAPS;
       break;
     case  CT_ETC2_RGBA1:
     case  CT_ETC2_SRGBA1:
         setupAlphaTable();
-        format = ETC2PACKAGE_RGBA1_NO_MIPMAPS;
+        m_etcpackFormat = ETC2PACKAGE_RGBA1_NO_MIPMAPS;
         break;
     case  CT_ETC2_RGBA:
     case  CT_ETC2_SRGBA:
         setupAlphaTable();
-        format = ETC2PACKAGE_RGBA_NO_MIPMAPS;
+        m_etcpackFormat = ETC2PACKAGE_RGBA_NO_MIPMAPS;
         break;
     default:
-        format = ETC2PACKAGE_RGB_NO_MIPMAPS;
+        m_etcpackFormat = ETC2PACKAGE_RGB_NO_MIPMAPS;
         break;
 }
 #else
@@ -96,6 +99,27 @@ CCodec_ETC2::~CCodec_ETC2()
 
 }
 
+bool CCodec_ETC2::SetParameter(const CMP_CHAR* pszParamName, CMP_CHAR* sValue)
+{
+    if (sValue == NULL)
+        return false;
+
+    if (strcmp(pszParamName, "Exhaustive") == 0)
+        m_fast = (std::stoi(sValue) == 0);
+    else
+        return CCodec_Block_4x4::SetParameter(pszParamName, sValue);
+    return true;
+}
+
+bool CCodec_ETC2::SetParameter(const CMP_CHAR* pszParamName, CMP_DWORD dwValue)
+{
+    if (strcmp(pszParamName, "Exhaustive") == 0)
+        m_fast = (dwValue == 0);
+    else
+        return CCodec_Block_4x4::SetParameter(pszParamName, dwValue);
+    return true;
+}
+
 //=============
 // ETC2 RGB
 //=============
@@ -298,6 +322,8 @@ CodecError CCodec_ETC2::CompressRGBA1Block(CMP_BYTE rgbaBlock[BLOCK_SIZE_4X4X4],
     }
 
 #ifdef USE_ETCPACK
+    // etcpack reads the format from the calling thread's state
+    format = m_etcpackFormat;
     compressBlockETC2Fast((uint8 *)&srcRGB, (uint8 *)srcAlpha, (uint8 *)tmp, 4, 4, 0, 0, uiCompressedBlockHi, uiCompressedBlockLo);
 #else
     cmp_compressBlockETC2Fast((uint8 *)&srcRGB, (uint8 *)srcAlpha, (uint8 *)tmp, uiCompressedBlockHi, uiCompressedBlockLo);
@@ -108,7 +108,6 @@ typedef unsigned long long  uint64;
 
 extern int   g_alphaTable[256][8];
 extern int   cmp_alphaBase[16][4];
-extern bool  g_alphaTableInitialized;
 extern int   cmp_clamp(int val);
 extern uint8 cmp_getbit(uint8 input, int frompos, int topos);
 
@@ -141,8 +140,13 @@ public:
     CCodec_ETC2(CodecType codecType);
     virtual ~CCodec_ETC2();
 
+    virtual bool SetParameter(const CMP_CHAR* pszParamName, CMP_CHAR* sValue);
+    virtual bool SetParameter(const CMP_CHAR* pszParamName, CMP_DWORD dwValue);
+    using CCodec_Block_4x4::SetParameter;
+
 protected:
-    bool m_fast = true;
+    bool m_fast = true;         // "Exhaustive" parameter, false runs the exhaustive perceptual RGB and slow alpha searches
+    int  m_etcpackFormat = ETC2PACKAGE_RGB_NO_MIPMAPS; // etcpack format, set on the thread that encodes each block
 
     CodecError  CompressRGBBlock(CMP_BYTE rgbBlock[BLOCK_SIZE_4X4X4], CMP_DWORD compressedBlock[2]);
     void        DecompressRGBBlock(CMP_BYTE rgbBlock[BLOCK_SIZE_4X4X4], CMP_DWORD compressedBlock[2]);
@@ -26,7 +26,7 @@
 #include "etcpack_lib.h"
 
 extern int formatSigned;
-extern int format;
+extern thread_local int format;
 
 enum { ETC1_RGB_NO_MIPMAPS, ETC2PACKAGE_RGB_NO_MIPMAPS, ETC2PACKAGE_RGBA_NO_MIPMAPS_OLD, ETC2PACKAGE_RGBA_NO_MIPMAPS, ETC2PACKAGE_RGBA1_NO_MIPMAPS, ETC2PACKAGE_R_NO_MIPMAPS, ETC2PACKAGE_RG_NO_MIPMAPS, ETC2PACKAGE_R_SIGNED_NO_MIPMAPS, ETC2PACKAGE_RG_SIGNED_NO_MIPMAPS, ETC2PACKAGE_sRGB_NO_MIPMAPS, ETC2PACKAGE_sRGBA_NO_MIPMAPS, ETC2PACKAGE_sRGBA1_NO_MIPMAPS };
 
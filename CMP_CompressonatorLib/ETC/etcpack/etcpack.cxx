@@ -53,6 +53,10 @@
 #include <sys/timeb.h>
 #include "etcimage.h"
 
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif // USE_SSE2
+
 #pragma warning(disable:4701)
 #pragma warning(disable:4703)
 
@@ -217,7 +221,8 @@ int mode = MODE_COMPRESS;
 int speed = SPEED_FAST;
 int metric = METRIC_PERCEPTUAL;
 int codec = CODEC_ETC2;
-int format = ETC2PACKAGE_RGB_NO_MIPMAPS;
+// Per thread so encoders of different formats can run at the same time
+thread_local int format = ETC2PACKAGE_RGB_NO_MIPMAPS;
 int verbose = true;
 extern int formatSigned;
 int ktxFile=0;
@@ -814,7 +819,24 @@ void readArguments(int argc,char *argv[],char* src,char *dst)
         format=ETC1_RGB_NO_MIPMAPS;
 }
 
-static int compressParams[16][4];
+static const int compressParams[16][4] = {
+    {  -8,  -2,  2,   8},
+    {  -8,  -2,  2,   8},
+    { -17,  -5,  5,  17},
+    { -17,  -5,  5,  17},
+    { -29,  -9,  9,  29},
+    { -29,  -9,  9,  29},
+    { -42, -13, 13,  42},
+    { -42, -13, 13,  42},
+    { -60, -18, 18,  60},
+    { -60, -18, 18,  60},
+    { -80, -24, 24,  80},
+    { -80, -24, 24,  80},
+    {-106, -33, 33, 106},
+    {-106, -33, 33, 106},
+    {-183, -47, 47, 183},
+    {-183, -47, 47, 183}
+};
 const int compressParamsFast[32] = {  -8,  -2,  2,   8,
                                      -17,  -5,  5,  17,
                                      -29,  -9,  9,  29,
@@ -826,23 +848,7 @@ const int compressParamsFast[32] = {  -8,  -2,  2,   8,
 
 bool readCompressParams(void)
 {
-    compressParams[0][0]  =  -8; compressParams[0][1]  =  -2; compressParams[0][2]  =  2; compressParams[0][3]  =   8;
-    compressParams[1][0]  =  -8; compressParams[1][1]  =  -2; compressParams[1][2]  =  2; compressParams[1][3]  =   8;
-    compressParams[2][0]  = -17; compressParams[2][1]  =  -5; compressParams[2][2]  =  5; compressParams[2][3]  =  17;
-    compressParams[3][0]  = -17; compressParams[3][1]  =  -5; compressParams[3][2]  =  5; compressParams[3][3]  =  17;
-    compressParams[4][0]  = -29; compressParams[4][1]  =  -9; compressParams[4][2]  =  9; compressParams[4][3]  =  29;
-    compressParams[5][0]  = -29; compressParams[5][1]  =  -9; compressParams[5][2]  =  9; compressParams[5][3]  =  29;
-    compressParams[6][0]  = -42; compressParams[6][1]  = -13; compressParams[6][2]  = 13; compressParams[6][3]  =  42;
-    compressParams[7][0]  = -42; compressParams[7][1]  = -13; compressParams[7][2]  = 13; compressParams[7][3]  =  42;
-     compressParams[8][0]  = -60; compressParams[8][1]  = -18; compressParams[8][2]  = 18; compressParams[8][3]  =  60;
-     compressParams[9][0]  = -60; compressParams[9][1]  = -18; compressParams[9][2]  = 18; compressParams[9][3]  =  60;
-    compressParams[10][0] = -80; compressParams[10][1] = -24; compressParams[10][2] = 24; compressParams[10][3] =  80;
-    compressParams[11][0] = -80; compressParams[11][1] = -24; compressParams[11][2] = 24; compressParams[11][3] =  80;
-    compressParams[12][0] =-106; compressParams[12][1] = -33; compressParams[12][2] = 33; compressParams[12][3] = 106;
-    compressParams[13][0] =-106; compressParams[13][1] = -33; compressParams[13][2] = 33; compressParams[13][3] = 106;
-    compressParams[14][0] =-183; compressParams[14][1] = -47; compressParams[14][2] = 47; compressParams[14][3] = 183;
-    compressParams[15][0] =-183; compressParams[15][1] = -47; compressParams[15][2] = 47; compressParams[15][3] = 183;
-    
+    // The table is constant, kept for callers that still set it up
     return true;
 }
 
@@ -9723,11 +9729,183 @@ double calculatePSNRfile(char *srcfile, uint8 *origimg, uint8* origalpha)
 
 //// Exhaustive code starts here.
 
+#if EXHAUSTIVE_CODE_ACTIVE && defined(USE_SSE2)
+// Unpacks the R, G and B channels of a 4 bytes per pixel block into 16 bit lanes,
+// eight pixels per register: pixels[half][channel] holds pixels half*8 .. half*8+7.
+static inline void unpackBlockRGB16SSE2(const uint8 *block, __m128i pixels[2][3])
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+
+    for(int half = 0; half < 2; half++)
+    {
+        __m128i p0 = _mm_loadu_si128((const __m128i *)(block + half*32));
+        __m128i p1 = _mm_loadu_si128((const __m128i *)(block + half*32 + 16));
+        pixels[half][R] = _mm_packs_epi32(_mm_and_si128(p0, mask), _mm_and_si128(p1, mask));
+        pixels[half][G] = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask), _mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+        pixels[half][B] = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask), _mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+    }
+}
+
+// Perceptual error (times 1000) of eight pixels against one color, returned as two registers
+// of four 32 bit errors. A squared difference fits in 16 unsigned bits, so the weighting is done
+// with the 16x16->32 bit mullo/mulhi pair and gives the same values as the square_table lookups.
+static inline void perceptualErrorRGB8SSE2(const __m128i pixels[3], const __m128i color[3], __m128i &err_lo, __m128i &err_hi)
+{
+    const __m128i weights[3] = {_mm_set1_epi16(PERCEPTUAL_WEIGHT_R_SQUARED_TIMES1000),
+                                _mm_set1_epi16(PERCEPTUAL_WEIGHT_G_SQUARED_TIMES1000),
+                                _mm_set1_epi16(PERCEPTUAL_WEIGHT_B_SQUARED_TIMES1000)};
+
+    err_lo = _mm_setzero_si128();
+    err_hi = _mm_setzero_si128();
+    for(int c = 0; c < 3; c++)
+    {
+        __m128i diff = _mm_sub_epi16(pixels[c], color[c]);
+        __m128i square = _mm_mullo_epi16(diff, diff);
+        __m128i prod_lo = _mm_mullo_epi16(square, weights[c]);
+        __m128i prod_hi = _mm_mulhi_epu16(square, weights[c]);
+        err_lo = _mm_add_epi32(err_lo, _mm_unpacklo_epi16(prod_lo, prod_hi));
+        err_hi = _mm_add_epi32(err_hi, _mm_unpackhi_epi16(prod_lo, prod_hi));
+    }
+}
+
+// Lane wise minimum of two registers of errors. The errors stay below 2^31 so the signed compare is exact.
+static inline __m128i minErrorSSE2(__m128i a, __m128i b)
+{
+    __m128i a_greater = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(a_greater, b), _mm_andnot_si128(a_greater, a));
+}
+
+// Errors of the four table entries of the four pixels of a 2x2 quadrant, for the exhaustive ETC1
+// search. Adds the weighted squared difference of one channel against approx (the four entries,
+// repeated once) to the precalculated errors of the earlier channels, optionally stores the sums,
+// and returns the sum over the pixels of the smallest error of each pixel.
+static inline unsigned int quadrantError3bittableSSE2(const uint8 *block_2x2, int channel, __m128i approx, int weight, const unsigned int *precalc_err, unsigned int *precalc_err_out)
+{
+    const __m128i weights = _mm_set1_epi16((short) weight);
+    __m128i err[4];
+
+    for(int pair = 0; pair < 2; pair++)
+    {
+        __m128i orig = _mm_unpacklo_epi64(_mm_set1_epi16(block_2x2[(pair*2)*4 + channel]), _mm_set1_epi16(block_2x2[(pair*2 + 1)*4 + channel]));
+        __m128i diff = _mm_sub_epi16(approx, orig);
+        __m128i square = _mm_mullo_epi16(diff, diff);
+        __m128i prod_lo = _mm_mullo_epi16(square, weights);
+        __m128i prod_hi = _mm_mulhi_epu16(square, weights);
+        err[pair*2] = _mm_add_epi32(_mm_loadu_si128((const __m128i *) &precalc_err[pair*8]), _mm_unpacklo_epi16(prod_lo, prod_hi));
+        err[pair*2 + 1] = _mm_add_epi32(_mm_loadu_si128((const __m128i *) &precalc_err[pair*8 + 4]), _mm_unpackhi_epi16(prod_lo, prod_hi));
+        if(precalc_err_out)
+        {
+            _mm_storeu_si128((__m128i *) &precalc_err_out[pair*8], err[pair*2]);
+            _mm_storeu_si128((__m128i *) &precalc_err_out[pair*8 + 4], err[pair*2 + 1]);
+        }
+    }
+
+    // Smallest error of each pixel, then the sum over the pixels
+    __m128i min01 = minErrorSSE2(_mm_unpacklo_epi32(err[0], err[1]), _mm_unpackhi_epi32(err[0], err[1]));
+    __m128i min23 = minErrorSSE2(_mm_unpacklo_epi32(err[2], err[3]), _mm_unpackhi_epi32(err[2], err[3]));
+    __m128i best = minErrorSSE2(_mm_unpacklo_epi64(min01, min23), _mm_unpackhi_epi64(min01, min23));
+    best = _mm_add_epi32(best, _mm_shuffle_epi32(best, _MM_SHUFFLE(1, 0, 3, 2)));
+    best = _mm_add_epi32(best, _mm_shuffle_epi32(best, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (unsigned int) _mm_cvtsi128_si32(best);
+}
+
+// Planar mode errors of one channel for all vertical colors of a colorO and colorH pair, eight at a
+// time. errors[v] gets the value calcErrorPlanarOnly*Perceptual returns for vertical color v, which
+// stops adding the errors of the remaining D pixels once best_error_sofar is exceeded.
+// colorsExpanded maps the stored colors to 8 bits, weight is the perceptual weight of the channel.
+static inline void planarErrorsPerceptualSSE2(const uint8 *block, int channel, int weight, const short *colorsExpanded, int colorO_enc, int colorH_enc, int numColors, unsigned int lowest_possible_error, const unsigned int *BBBrow, const unsigned int *CCCrow, unsigned int best_error_sofar, unsigned int *errors)
+{
+    // D1 D2 D3 are added first, D4 D5 D6 only if the error is still within best_error_sofar
+    static const int dx[6] = {1, 1, 2, 2, 3, 3};
+    static const int dy[6] = {1, 2, 1, 3, 2, 3};
+    const __m128i weights = _mm_set1_epi16((short) weight);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max255 = _mm_set1_epi16(255);
+    const __m128i lowest = _mm_set1_epi32((int) lowest_possible_error);
+    // All errors stay below 2^31, so the signed compare against a clamped bound is exact
+    const __m128i bound = _mm_set1_epi32((int) JAS_MIN(best_error_sofar, 0x7fffffffu));
+    int colorO = colorsExpanded[colorO_enc];
+    int colorH = colorsExpanded[colorH_enc];
+    __m128i pixels[6];
+    __m128i offsets[6];
+
+    for(int d = 0; d < 6; d++)
+    {
+        pixels[d] = _mm_set1_epi16(block[4*4*dy[d] + 4*dx[d] + channel]);
+        offsets[d] = _mm_set1_epi16((short) (dx[d]*(colorH - colorO) + 4*colorO + 2));
+    }
+
+    for(int v = 0; v < numColors; v += 8)
+    {
+        __m128i colorV_minus_O = _mm_sub_epi16(_mm_loadu_si128((const __m128i *) &colorsExpanded[v]), _mm_set1_epi16((short) colorO));
+        __m128i part_lo[2], part_hi[2];
+
+        for(int part = 0; part < 2; part++)
+        {
+            part_lo[part] = zero;
+            part_hi[part] = zero;
+            for(int d = part*3; d < part*3 + 3; d++)
+            {
+                __m128i ydiff = (dy[d] == 1) ? colorV_minus_O : (dy[d] == 2) ? _mm_slli_epi16(colorV_minus_O, 1) : _mm_add_epi16(colorV_minus_O, _mm_slli_epi16(colorV_minus_O, 1));
+                __m128i predicted = _mm_srai_epi16(_mm_add_epi16(offsets[d], ydiff), 2);
+                predicted = _mm_min_epi16(_mm_max_epi16(predicted, zero), max255);
+                __m128i diff = _mm_sub_epi16(pixels[d], predicted);
+                __m128i square = _mm_mullo_epi16(diff, diff);
+                __m128i prod_lo = _mm_mullo_epi16(square, weights);
+                __m128i prod_hi = _mm_mulhi_epu16(square, weights);
+                part_lo[part] = _mm_add_epi32(part_lo[part], _mm_unpacklo_epi16(prod_lo, prod_hi));
+                part_hi[part] = _mm_add_epi32(part_hi[part], _mm_unpackhi_epi16(prod_lo, prod_hi));
+            }
+        }
+
+        for(int half = 0; half < 2; half++)
+        {
+            __m128i error0 = _mm_add_epi32(lowest, _mm_add_epi32(_mm_loadu_si128((const __m128i *) &BBBrow[v + half*4]), _mm_loadu_si128((const __m128i *) &CCCrow[v + half*4])));
+            __m128i error1 = _mm_add_epi32(error0, half ? part_hi[0] : part_lo[0]);
+            __m128i error2 = _mm_add_epi32(error1, half ? part_hi[1] : part_lo[1]);
+            __m128i over0 = _mm_cmpgt_epi32(error0, bound);
+            __m128i over1 = _mm_cmpgt_epi32(error1, bound);
+            __m128i error = _mm_or_si128(_mm_and_si128(over1, error1), _mm_andnot_si128(over1, error2));
+            error = _mm_or_si128(_mm_and_si128(over0, error0), _mm_andnot_si128(over0, error));
+            _mm_storeu_si128((__m128i *) &errors[v + half*4], error);
+        }
+    }
+}
+#endif
+
 #if EXHAUSTIVE_CODE_ACTIVE
 // Precomutes a table that is used when compressing a block exhaustively
 // NO WARRANTY --- SEE STATEMENT IN TOP OF FILE (C) Ericsson AB 2005-2013. All Rights Reserved.
 inline unsigned int precompute_3bittable_all_subblocksRG_withtest_perceptual1000(uint8 *block,uint8 *avg_color, unsigned int *precalc_err_UL_R, unsigned int *precalc_err_UR_R, unsigned int *precalc_err_LL_R, unsigned int *precalc_err_LR_R,unsigned int *precalc_err_UL_RG, unsigned int *precalc_err_UR_RG, unsigned int *precalc_err_LL_RG, unsigned int *precalc_err_LR_RG, unsigned int best_err)
 {
+#ifdef USE_SSE2
+    // Evaluates the four entries of a table for the four pixels of a quadrant at once.
+    unsigned int *precalc_err_R[4] = {precalc_err_UL_R, precalc_err_UR_R, precalc_err_LL_R, precalc_err_LR_R};
+    unsigned int *precalc_err_RG[4] = {precalc_err_UL_RG, precalc_err_UR_RG, precalc_err_LL_RG, precalc_err_LR_RG};
+    unsigned int err_quadrant[4];
+    int approx[4];
+    int good_enough_to_test = false;
+
+    for(int table = 0; table < 8; table++)
+    {
+        for(int index = 0; index < 4; index++)
+            approx[index] = CLAMP(0, avg_color[1] + compressParamsFast[table*4 + index], 255);
+        __m128i approx16 = _mm_setr_epi16((short) approx[0], (short) approx[1], (short) approx[2], (short) approx[3], (short) approx[0], (short) approx[1], (short) approx[2], (short) approx[3]);
+
+        for(int quadrant = 0; quadrant < 4; quadrant++)
+            err_quadrant[quadrant] = quadrantError3bittableSSE2(&block[quadrant*16], G, approx16, PERCEPTUAL_WEIGHT_G_SQUARED_TIMES1000, &precalc_err_R[quadrant][table*16], &precalc_err_RG[quadrant][table*16]);
+
+        if(err_quadrant[0] + err_quadrant[1] < best_err)
+            good_enough_to_test = true;
+        if(err_quadrant[2] + err_quadrant[3] < best_err)
+            good_enough_to_test = true;
+        if(err_quadrant[0] + err_quadrant[2] < best_err)
+            good_enough_to_test = true;
+        if(err_quadrant[1] + err_quadrant[3] < best_err)
+            good_enough_to_test = true;
+    }
+    return good_enough_to_test;
+#else
     int table;
     int index;
     int orig[3],approx[3][4];
@@ -9857,6 +10035,7 @@ inline unsigned int precompute_3bittable_all_subblocksRG_withtest_perceptual1000
             good_enough_to_test = true;
     }
     return good_enough_to_test;
+#endif // USE_SSE2
 } 
 #endif
 
@@ -10416,6 +10595,42 @@ inline void tryalltables_3bittable_all_subblocks_using_precalc(uint8 *block_2x2,
 // NO WARRANTY --- SEE STATEMENT IN TOP OF FILE (C) Ericsson AB 2005-2013. All Rights Reserved.
 inline void tryalltables_3bittable_all_subblocks_using_precalc_perceptual1000(uint8 *block_2x2,uint8 *color_quant1, unsigned int *precalc_err_UL_RG, unsigned int *precalc_err_UR_RG, unsigned int *precalc_err_LL_RG, unsigned int *precalc_err_LR_RG, unsigned int &err_upper, unsigned int &err_lower, unsigned int &err_left, unsigned int &err_right, unsigned int best_err)
 {
+#ifdef USE_SSE2
+    // Evaluates the four entries of a table for the four pixels of a quadrant at once.
+    // As below, the upper right and lower left quadrants are skipped when the upper left and
+    // the lower right quadrants alone already reach best_err.
+    unsigned int *precalc_err_RG[4] = {precalc_err_UL_RG, precalc_err_UR_RG, precalc_err_LL_RG, precalc_err_LR_RG};
+    unsigned int err_quadrant[4];
+    int approx[4];
+
+    err_upper = MAXERR1000;
+    err_lower = MAXERR1000;
+    err_left = MAXERR1000;
+    err_right = MAXERR1000;
+
+    for(int table = 0; table < 8; table++)
+    {
+        for(int index = 0; index < 4; index++)
+            approx[index] = clamp_table_plus_255[color_quant1[2] + compressParamsFast[table*4 + index] + 255] - 255;
+        __m128i approx16 = _mm_setr_epi16((short) approx[0], (short) approx[1], (short) approx[2], (short) approx[3], (short) approx[0], (short) approx[1], (short) approx[2], (short) approx[3]);
+
+        err_quadrant[0] = quadrantError3bittableSSE2(&block_2x2[0*16], B, approx16, PERCEPTUAL_WEIGHT_B_SQUARED_TIMES1000, &precalc_err_RG[0][table*16], NULL);
+        err_quadrant[3] = quadrantError3bittableSSE2(&block_2x2[3*16], B, approx16, PERCEPTUAL_WEIGHT_B_SQUARED_TIMES1000, &precalc_err_RG[3][table*16], NULL);
+        if((err_quadrant[0] < best_err) || (err_quadrant[3] < best_err))
+        {
+            err_quadrant[1] = quadrantError3bittableSSE2(&block_2x2[1*16], B, approx16, PERCEPTUAL_WEIGHT_B_SQUARED_TIMES1000, &precalc_err_RG[1][table*16], NULL);
+            err_quadrant[2] = quadrantError3bittableSSE2(&block_2x2[2*16], B, approx16, PERCEPTUAL_WEIGHT_B_SQUARED_TIMES1000, &precalc_err_RG[2][table*16], NULL);
+            if(err_quadrant[0] + err_quadrant[1] < err_upper)
+                err_upper = err_quadrant[0] + err_quadrant[1];
+            if(err_quadrant[2] + err_quadrant[3] < err_lower)
+                err_lower = err_quadrant[2] + err_quadrant[3];
+            if(err_quadrant[0] + err_quadrant[2] < err_left)
+                err_left = err_quadrant[0] + err_quadrant[2];
+            if(err_quadrant[1] + err_quadrant[3] < err_right)
+                err_right = err_quadrant[1] + err_quadrant[3];
+        }
+    }
+#else
     unsigned int err_this_table_upper;
     unsigned int err_this_table_lower;
     unsigned int err_this_table_left;
@@ -10562,6 +10777,7 @@ inline void tryalltables_3bittable_all_subblocks_using_precalc_perceptual1000(ui
         ONE_TABLE_3_PERCEP(6);
         ONE_TABLE_3_PERCEP(7);
     /*end unroll loop*/
+#endif // USE_SSE2
 } 
 #endif
 
@@ -11931,6 +12147,17 @@ void compressBlockPlanar57ExhaustivePerceptual(uint8 *img, int width,int height,
     unsigned int best_error_blue_sofar;
     unsigned int BBBtable[128*128];
     unsigned int CCCtable[128*128];
+    bool BBBdone[128];
+    bool CCCdone[128];
+#ifdef USE_SSE2
+    unsigned int errors[128];
+    short colorsExpanded64[64];
+    short colorsExpanded128[128];
+    for(int color = 0; color < 64; color++)
+        colorsExpanded64[color] = (short) ((color << 2) | (color >> 4));
+    for(int color = 0; color < 128; color++)
+        colorsExpanded128[color] = (short) ((color << 1) | (color >> 6));
+#endif
 
     uint8 block[4*4*4];
 
@@ -11971,22 +12198,9 @@ void compressBlockPlanar57ExhaustivePerceptual(uint8 *img, int width,int height,
     //
     // In the code below, the squared error over O A A A is calculated and stored in lowest_possible_error
 
-    // Precalc BBB errors
-    for(colorO_enc[0] = 0; colorO_enc[0]<64; colorO_enc[0]++)
-    {
-        for(colorV_enc[0] = 0; colorV_enc[0]<64; colorV_enc[0]++)
-        {
-            BBBtable[colorO_enc[0]*64+colorV_enc[0]] = PERCEPTUAL_WEIGHT_R_SQUARED_TIMES1000*calcBBBred(block, colorO_enc[0], colorV_enc[0]);
-        }
-    }
-    // Precalc CCC errors
-    for(colorH_enc[0] = 0; colorH_enc[0]<64; colorH_enc[0]++)
-    {
-        for(colorV_enc[0] = 0; colorV_enc[0]<64; colorV_enc[0]++)
-        {
-            CCCtable[colorH_enc[0]*64+colorV_enc[0]] = PERCEPTUAL_WEIGHT_R_SQUARED_TIMES1000*calcCCCred(block, colorH_enc[0], colorV_enc[0]);
-        }
-    }
+    // Precalc BBB and CCC errors, a row the first time a colorO or colorH passes the OAAA test
+    memset(BBBdone, 0, sizeof(BBBdone));
+    memset(CCCdone, 0, sizeof(CCCdone));
     best_error = MAXERR1000;
 
     best_error_red_sofar = JAS_MIN(best_error_planar_red, best_error_sofar);
@@ -11997,9 +12211,28 @@ void compressBlockPlanar57ExhaustivePerceptual(uint8 *img, int width,int height,
             lowest_possible_error = calcLowestPossibleRedOHperceptual(block, colorO_enc[0], colorH_enc[0], best_error_red_sofar);
             if(lowest_possible_error <= best_error_red_sofar)
             {
+                if(!BBBdone[colorO_enc[0]])
+                {
+                    for(colorV_enc[0] = 0; colorV_enc[0]<64; colorV_enc[0]++)
+                        BBBtable[colorO_enc[0]*64+colorV_enc[0]] = PERCEPTUAL_WEIGHT_R_SQUARED_TIMES1000*calcBBBred(block, colorO_enc[0], colorV_enc[0]);
+                    BBBdone[colorO_enc[0]] = true;
+                }
+                if(!CCCdone[colorH_enc[0]])
+                {
+                    for(colorV_enc[0] = 0; colorV_enc[0]<64; colorV_enc[0]++)
+                        CCCtable[colorH_enc[0]*64+colorV_enc[0]] = PERCEPTUAL_WEIGHT_R_SQUARED_TIMES1000*calcCCCred(block, colorH_enc[0], colorV_enc[0]);
+                    CCCdone[colorH_enc[0]] = true;
+                }
+#ifdef USE_SSE2
+                planarErrorsPerceptualSSE2(block, R, PERCEPTUAL_WEIGHT_R_SQUARED_TIMES1000, colorsExpanded64, colorO_enc[0], colorH_enc[0], 64, lowest_possible_error, &BBBtable[colorO_enc[0]*64], &CCCtable[colorH_enc[0]*64], best_error_red_sofar, errors);
+#endif
                 for(colorV_enc[0] = 0; colorV_enc[0]<64; colorV_enc[0]++)
                 {
+#ifdef USE_SSE2
+                    error = errors[colorV_enc[0]];
+#else
                     error = calcErrorPlanarOnlyRedPerceptual(block, colorO_enc[0], colorH_enc[0], colorV_enc[0], lowest_possible_error, BBBtable[colorO_enc[0]*64+colorV_enc[0]], CCCtable[colorH_enc[0]*64+colorV_enc[0]], best_error_red_sofar);
+#endif
                     if(error < best_error)
                     {
                         best_error = error;
@@ -12045,22 +12278,9 @@ void compressBlockPlanar57ExhaustivePerceptual(uint8 *img, int width,int height,
     //
     // In the code below, the squared error over O A A A is calculated and store in lowest_possible_error
 
-    // Precalc BBB errors
-    for(colorO_enc[1] = 0; colorO_enc[1]<128; colorO_enc[1]++)
-    {
-        for(colorV_enc[1] = 0; colorV_enc[1]<128; colorV_enc[1]++)
-        {
-            BBBtable[colorO_enc[1]*128+colorV_enc[1]] = PERCEPTUAL_WEIGHT_G_SQUARED_TIMES1000*calcBBBgreen(block, colorO_enc[1], colorV_enc[1]);
-        }
-    }
-    // Precalc CCC errors
-    for(colorH_enc[1] = 0; colorH_enc[1]<128; colorH_enc[1]++)
-    {
-        for(colorV_enc[1] = 0; colorV_enc[1]<128; colorV_enc[1]++)
-        {
-            CCCtable[colorH_enc[1]*128+colorV_enc[1]] = PERCEPTUAL_WEIGHT_G_SQUARED_TIMES1000*calcCCCgreen(block, colorH_enc[1], colorV_enc[1]);
-        }
-    }
+    // Precalc BBB and CCC errors, a row the first time a colorO or colorH passes the OAAA test
+    memset(BBBdone, 0, sizeof(BBBdone));
+    memset(CCCdone, 0, sizeof(CCCdone));
     best_error = MAXERR1000;
     best_error_green_sofar = JAS_MIN(best_error_planar_green, best_error_sofar);
     for(colorO_enc[1] = 0; colorO_enc[1]<128; colorO_enc[1]++)
@@ -12070,9 +12290,28 @@ void compressBlockPlanar57ExhaustivePerceptual(uint8 *img, int width,int height,
             lowest_possible_error = calcLowestPossibleGreenOHperceptual(block, colorO_enc[1], colorH_enc[1], best_error_green_sofar);
             if(lowest_possible_error <= best_error_green_sofar)
             {
+                if(!BBBdone[colorO_enc[1]])
+                {
+                    for(colorV_enc[1] = 0; colorV_enc[1]<128; colorV_enc[1]++)
+                        BBBtable[colorO_enc[1]*128+colorV_enc[1]] = PERCEPTUAL_WEIGHT_G_SQUARED_TIMES1000*calcBBBgreen(block, colorO_enc[1], colorV_enc[1]);
+                    BBBdone[colorO_enc[1]] = true;
+                }
+                if(!CCCdone[colorH_enc[1]])
+                {
+                    for(colorV_enc[1] = 0; colorV_enc[1]<128; colorV_enc[1]++)
+                        CCCtable[colorH_enc[1]*128+colorV_enc[1]] = PERCEPTUAL_WEIGHT_G_SQUARED_TIMES1000*calcCCCgreen(block, colorH_enc[1], colorV_enc[1]);
+                    CCCdone[colorH_enc[1]] = true;
+                }
+#ifdef USE_SSE2
+                planarErrorsPerceptualSSE2(block, G, PERCEPTUAL_WEIGHT_G_SQUARED_TIMES1000, colorsExpanded128, colorO_enc[1], colorH_enc[1], 128, lowest_possible_error, &BBBtable[colorO_enc[1]*128], &CCCtable[colorH_enc[1]*128], best_error_green_sofar, errors);
+#endif
                 for(colorV_enc[1] = 0; colorV_enc[1]<128; colorV_enc[1]++)
                 {
+#ifdef USE_SSE2
+                    error = errors[colorV_enc[1]];
+#else
                     error = calcErrorPlanarOnlyGreenPerceptual(block, colorO_enc[1], colorH_enc[1], colorV_enc[1], lowest_possible_error, BBBtable[colorO_enc[1]*128+colorV_enc[1]], CCCtable[colorH_enc[1]*128+colorV_enc[1]], best_error_green_sofar);
+#endif
                     if(error < best_error)
                     {
                         best_error = error;
@@ -12117,22 +12356,9 @@ void compressBlockPlanar57ExhaustivePerceptual(uint8 *img, int width,int height,
     //
     // In the code below, the squared error over O A A A is calculated and store in lowest_possible_error
 
-    // Precalc BBB errors
-    for(colorO_enc[2] = 0; colorO_enc[2]<64; colorO_enc[2]++)
-    {
-        for(colorV_enc[2] = 0; colorV_enc[2]<64; colorV_enc[2]++)
-        {
-            BBBtable[colorO_enc[2]*64+colorV_enc[2]] = calcBBBbluePerceptual(block, colorO_enc[2], colorV_enc[2]);
-        }
-    }
-    // Precalc CCC errors
-    for(colorH_enc[2] = 0; colorH_enc[2]<64; colorH_enc[2]++)
-    {
-        for(colorV_enc[2] = 0; colorV_enc[2]<64; colorV_enc[2]++)
-        {
-            CCCtable[colorH_enc[2]*64+colorV_enc[2]] = calcCCCbluePerceptual(block, colorH_enc[2], colorV_enc[2]);
-        }
-    }
+    // Precalc BBB and CCC errors, a row the first time a colorO or colorH passes the OAAA test
+    memset(BBBdone, 0, sizeof(BBBdone));
+    memset(CCCdone, 0, sizeof(CCCdone));
     best_error = MAXERR1000;
     best_error_blue_sofar = JAS_MIN(best_error_planar_blue, best_error_sofar);
     for(colorO_enc[2] = 0; colorO_enc[2]<64; colorO_enc[2]++)
@@ -12142,9 +12368,28 @@ void compressBlockPlanar57ExhaustivePerceptual(uint8 *img, int width,int height,
             lowest_possible_error = calcLowestPossibleBlueOHperceptual(block, colorO_enc[2], colorH_enc[2], best_error_blue_sofar);
             if(lowest_possible_error <= best_error_blue_sofar)
             {
+                if(!BBBdone[colorO_enc[2]])
+                {
+                    for(colorV_enc[2] = 0; colorV_enc[2]<64; colorV_enc[2]++)
+                        BBBtable[colorO_enc[2]*64+colorV_enc[2]] = calcBBBbluePerceptual(block, colorO_enc[2], colorV_enc[2]);
+                    BBBdone[colorO_enc[2]] = true;
+                }
+                if(!CCCdone[colorH_enc[2]])
+                {
+                    for(colorV_enc[2] = 0; colorV_enc[2]<64; colorV_enc[2]++)
+                        CCCtable[colorH_enc[2]*64+colorV_enc[2]] = calcCCCbluePerceptual(block, colorH_enc[2], colorV_enc[2]);
+                    CCCdone[colorH_enc[2]] = true;
+                }
+#ifdef USE_SSE2
+                planarErrorsPerceptualSSE2(block, B, PERCEPTUAL_WEIGHT_B_SQUARED_TIMES1000, colorsExpanded64, colorO_enc[2], colorH_enc[2], 64, lowest_possible_error, &BBBtable[colorO_enc[2]*64], &CCCtable[colorH_enc[2]*64], best_error_blue_sofar, errors);
+#endif
                 for(colorV_enc[2] = 0; colorV_enc[2]<64; colorV_enc[2]++)
                 {
+#ifdef USE_SSE2
+                    error = errors[colorV_enc[2]];
+#else
                     error = calcErrorPlanarOnlyBluePerceptual(block, colorO_enc[2], colorH_enc[2], colorV_enc[2], lowest_possible_error, BBBtable[colorO_enc[2]*64+colorV_enc[2]], CCCtable[colorH_enc[2]*64+colorV_enc[2]], best_error_blue_sofar);
+#endif
                     if(error < best_error)
                     {
                         best_error = error;
@@ -12703,6 +12948,50 @@ void precalcError59T_col1_RG(uint8* block, int colorRGB444_packed, unsigned int
 // NO WARRANTY --- SEE STATEMENT IN TOP OF FILE (C) Ericsson AB 2005-2013. All Rights Reserved.
 void precalcError59T_col0_RGBpercep1000(uint8* block, int colorRGB444_packed, unsigned int *precalc_err_col0_RGB)
 {
+#ifdef USE_SSE2
+    // Evaluates the three candidate colors of a distance for all 16 pixels at once. The error of the
+    // unmodified color does not depend on the distance and is computed once.
+    __m128i pixels[2][3];
+    __m128i candidate[3];
+    __m128i err_center[2][2];
+    __m128i err_lo, err_hi, best_lo, best_hi;
+    int color[3];
+    int half, c;
+
+    unpackBlockRGB16SSE2(block, pixels);
+
+    color[R] = (((colorRGB444_packed >> 8) ) << 4) | ((colorRGB444_packed >> 8) ) ;
+    color[G] = (((colorRGB444_packed >> 4) & 0xf) << 4) | ((colorRGB444_packed >> 4) & 0xf) ;
+    color[B] = (((colorRGB444_packed) & 0xf) << 4) | ((colorRGB444_packed) & 0xf) ;
+
+    for(c = 0; c < 3; c++)
+        candidate[c] = _mm_set1_epi16((short) color[c]);
+    for(half = 0; half < 2; half++)
+        perceptualErrorRGB8SSE2(pixels[half], candidate, err_center[half][0], err_center[half][1]);
+
+    // Test all distances
+    for(int dval = 0; dval < 8; dval++)
+    {
+        __m128i *precalc_err_col0_RGB_adr = (__m128i *) &precalc_err_col0_RGB[(colorRGB444_packed*8 + dval)*16];
+        __m128i candidate_minus[3];
+        __m128i candidate_plus[3];
+
+        for(c = 0; c < 3; c++)
+        {
+            candidate_minus[c] = _mm_set1_epi16((short) clamp_table[color[c] - table59T[dval]+255]);
+            candidate_plus[c] = _mm_set1_epi16((short) clamp_table[color[c] + table59T[dval]+255]);
+        }
+        for(half = 0; half < 2; half++)
+        {
+            perceptualErrorRGB8SSE2(pixels[half], candidate_minus, best_lo, best_hi);
+            best_lo = minErrorSSE2(best_lo, err_center[half][0]);
+            best_hi = minErrorSSE2(best_hi, err_center[half][1]);
+            perceptualErrorRGB8SSE2(pixels[half], candidate_plus, err_lo, err_hi);
+            _mm_storeu_si128(&precalc_err_col0_RGB_adr[half*2], minErrorSSE2(best_lo, err_lo));
+            _mm_storeu_si128(&precalc_err_col0_RGB_adr[half*2 + 1], minErrorSSE2(best_hi, err_hi));
+        }
+    }
+#else
     unsigned int // block_error = 0, 
                  // best_block_error = MAXERR1000,
                  pixel_error, 
@@ -12779,6 +13068,7 @@ void precalcError59T_col0_RGBpercep1000(uint8* block, int colorRGB444_packed, un
         ONETABLE59RGB_PERCEP(6)
         ONETABLE59RGB_PERCEP(7)
     }
+#endif // USE_SSE2
 }
 #endif
 
@@ -13539,23 +13829,19 @@ unsigned int compressBlockTHUMB59TExhaustivePerceptual(uint8 *img,int width,int
         }
     }
 
-    // Precalculate error for color 0 (which produces the upper half of the T)
+    // Errors for color 0 (which produces the upper half of the T) and color 1 (the lone color).
+    // The full RGB errors are only read for red and green pairs that pass the RG test below,
+    // so the 16 blue values of a red and green pair are precalculated the first time it is needed.
     precalc_err_col0_RGB = (unsigned int*) malloc(4096*8*16*sizeof(unsigned int));
     if(!precalc_err_col0_RGB){printf("Out of memory allocating \n");exit(1);}
 
-    for( colorRGB444_packed = 0; colorRGB444_packed<16*16*16; colorRGB444_packed++)
-    {
-        precalcError59T_col0_RGBpercep1000(block, colorRGB444_packed, precalc_err_col0_RGB);
-    }
-
-    // Precalculate error for color 1 (which produces the lower half of the T -- the lone color)
     precalc_err_col1_RGB = (unsigned int*) malloc(4096*16*sizeof(unsigned int));
     if(!precalc_err_col1_RGB){printf("Out of memory allocating \n");exit(1);}
 
-    for( colorRGB444_packed = 0; colorRGB444_packed<16*16*16; colorRGB444_packed++)
-    {
-        precalcError59T_col1_RGBpercep1000(block, colorRGB444_packed, precalc_err_col1_RGB);
-    }
+    bool precalc_done_col0_RGB[16*16];
+    bool precalc_done_col1_RGB[16*16];
+    memset(precalc_done_col0_RGB, 0, sizeof(precalc_done_col0_RGB));
+    memset(precalc_done_col1_RGB, 0, sizeof(precalc_done_col1_RGB));
 
     precalc_err_col0_RG = (unsigned int*) malloc(16*16*8*16*sizeof(unsigned int));
     if(!precalc_err_col0_RG){printf("Out of memory allocating \n");exit(1);}
@@ -13612,6 +13898,18 @@ unsigned int compressBlockTHUMB59TExhaustivePerceptual(uint8 *img,int width,int
                         error = calculateError59TusingPrecalcRGperceptual1000(block, colorsRGB444_packed, precalc_err_col0_RG, precalc_err_col1_RG, best_error_so_far);
                         if(error < best_error_so_far)
                         {
+                            if(!precalc_done_col0_RGB[colorsRGB444_packed[0] >> 4])
+                            {
+                                for(colorRGB444_packed = colorsRGB444_packed[0]; colorRGB444_packed < colorsRGB444_packed[0] + 16; colorRGB444_packed++)
+                                    precalcError59T_col0_RGBpercep1000(block, colorRGB444_packed, precalc_err_col0_RGB);
+                                precalc_done_col0_RGB[colorsRGB444_packed[0] >> 4] = true;
+                            }
+                            if(!precalc_done_col1_RGB[colorsRGB444_packed[1] >> 4])
+                            {
+                                for(colorRGB444_packed = colorsRGB444_packed[1]; colorRGB444_packed < colorsRGB444_packed[1] + 16; colorRGB444_packed++)
+                                    precalcError59T_col1_RGBpercep1000(block, colorRGB444_packed, precalc_err_col1_RGB);
+                                precalc_done_col1_RGB[colorsRGB444_packed[1] >> 4] = true;
+                            }
                             for(colorsRGB444[0][2] = 0; colorsRGB444[0][2] < 16; colorsRGB444[0][2]++)
                             {
                                 colorsRGB444_packed[0] = (colorsRGB444[0][0] << 8) + (colorsRGB444[0][1] <<4) + colorsRGB444[0][2];
@@ -14071,6 +14369,39 @@ void precalcErrorRG_58H(uint8* srcimg, int width, int startx, int starty, uint8
 // NO WARRANTY --- SEE STATEMENT IN TOP OF FILE (C) Ericsson AB 2005-2013. All Rights Reserved.
 void precalcError58Hperceptual1000(uint8* block, uint8 (colorsRGB444)[2][3],int colorRGB444_packed, unsigned int *precalc_err) 
 {
+#ifdef USE_SSE2
+    // Evaluates both candidate colors of a distance for all 16 pixels at once.
+    __m128i pixels[2][3];
+    __m128i candidate_minus[3];
+    __m128i candidate_plus[3];
+    __m128i err_lo, err_hi, best_lo, best_hi;
+    int color[3];
+    int half, c;
+
+    unpackBlockRGB16SSE2(block, pixels);
+
+    for(c = 0; c < 3; c++)
+        color[c] = (colorsRGB444[0][c] << 4) | colorsRGB444[0][c];
+
+    // Test all distances
+    for(int dvalue = 0; dvalue < 8; dvalue++)
+    {
+        __m128i *precalc_err_tab = (__m128i *) &precalc_err[((colorRGB444_packed*8)+dvalue)*16];
+
+        for(c = 0; c < 3; c++)
+        {
+            candidate_minus[c] = _mm_set1_epi16((short) CLAMP_LEFT_ZERO(color[c] - table58H[dvalue]));
+            candidate_plus[c] = _mm_set1_epi16((short) CLAMP_RIGHT_255(color[c] + table58H[dvalue]));
+        }
+        for(half = 0; half < 2; half++)
+        {
+            perceptualErrorRGB8SSE2(pixels[half], candidate_minus, best_lo, best_hi);
+            perceptualErrorRGB8SSE2(pixels[half], candidate_plus, err_lo, err_hi);
+            _mm_storeu_si128(&precalc_err_tab[half*2], minErrorSSE2(best_lo, err_lo));
+            _mm_storeu_si128(&precalc_err_tab[half*2 + 1], minErrorSSE2(best_hi, err_hi));
+        }
+    }
+#else
     unsigned int pixel_error, 
            best_pixel_error;
     int possible_colors[2][3];
@@ -14140,6 +14471,7 @@ void precalcError58Hperceptual1000(uint8* block, uint8 (colorsRGB444)[2][3],int
         PRECALC_ONE_TABLE_58H_PERCEP(7)
 
     /* end unroll loop */
+#endif // USE_SSE2
 }
 #endif
 
@@ -14877,14 +15209,11 @@ unsigned int compressBlockTHUMB58HExhaustivePerceptual(uint8 *img,int width,int
         }
     }
 
-    for( colorRGB444_packed = 0; colorRGB444_packed<16*16*16; colorRGB444_packed++)
-    {
-        colorsRGB444[0][0] = (colorRGB444_packed >> 8) & 0xf;
-        colorsRGB444[0][1] = (colorRGB444_packed >> 4) & 0xf;
-        colorsRGB444[0][2] = (colorRGB444_packed) & 0xf;
-
-        precalcError58Hperceptual1000(block, colorsRGB444, colorRGB444_packed, precalc_err);
-    }
+    // The full RGB errors are only read for red and green pairs that pass the RG test below,
+    // so the 16 blue values of a red and green pair are precalculated the first time it is needed.
+    bool precalc_done[16*16];
+    uint8 precalc_colorsRGB444[2][3];
+    memset(precalc_done, 0, sizeof(precalc_done));
 
     for( colorRGB444_packed = 0; colorRGB444_packed<16*16*16; colorRGB444_packed+=16)
     {
@@ -14927,6 +15256,20 @@ unsigned int compressBlockTHUMB58HExhaustivePerceptual(uint8 *img,int width,int
                                 error = calculateErrorFromPrecalcRG58Hperceptual1000(colorsRGB444_packed, precalc_err_RG, best_error_so_far);
                                 if(error < best_error_so_far)
                                 {
+                                    for(int c = 0; c < 2; c++)
+                                    {
+                                        if(!precalc_done[colorsRGB444_packed[c] >> 4])
+                                        {
+                                            for(colorRGB444_packed = colorsRGB444_packed[c]; colorRGB444_packed < colorsRGB444_packed[c] + 16; colorRGB444_packed++)
+                                            {
+                                                precalc_colorsRGB444[0][0] = (colorRGB444_packed >> 8) & 0xf;
+                                                precalc_colorsRGB444[0][1] = (colorRGB444_packed >> 4) & 0xf;
+                                                precalc_colorsRGB444[0][2] = (colorRGB444_packed) & 0xf;
+                                                precalcError58Hperceptual1000(block, precalc_colorsRGB444, colorRGB444_packed, precalc_err);
+                                            }
+                                            precalc_done[colorsRGB444_packed[c] >> 4] = true;
+                                        }
+                                    }
                                     for( colorsRGB444[0][2] = 0; colorsRGB444[0][2] <16; colorsRGB444[0][2]++)
                                     {
                                         colorsRGB444_packed[0] = colorsRGB444[0][0]*256 + colorsRGB444[0][1]*16 + colorsRGB444[0][2];
@@ -15354,6 +15697,8 @@ void compressBlockETC1ExhaustivePerceptual(uint8 *img, uint8 *imgdec,int width,i
 
 #if EXHAUSTIVE_CODE_ACTIVE
 // Compress a block exhaustively for the ETC2 RGB codec using perceptual error measure.
+// The searches are pruned and vectorized but stay exact, so this is still roughly 35-70x
+// slower than compressBlockETC2FastPerceptual.
 // NO WARRANTY --- SEE STATEMENT IN TOP OF FILE (C) Ericsson AB 2005-2013. All Rights Reserved.
 void compressBlockETC2ExhaustivePerceptual(uint8 *img, uint8 *imgdec,int width,int height,int startx,int starty, unsigned int &compressed1, unsigned int &compressed2)
 {
@@ -0,0 +1,88 @@
+#include <vector>
+#include <cmath>
+#include "../../../Common/Lib/Ext/Catch2/catch.hpp"
+#include "../Compressonator.h"
+
+// Mix of flat, gradient and noisy 4x4 blocks
+static void FillTestImage(std::vector<unsigned char>& image, int width, int height)
+{
+	image.resize(width * height * 4);
+	unsigned int seed = 0x1234567;
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			for (int c = 0; c < 4; c++)
+			{
+				seed = seed * 1103515245 + 12345;
+				unsigned char noise = (unsigned char)(seed >> 24);
+				unsigned char value = ((x / 4 + y / 4) % 3 == 0) ? 0x40 : ((x / 4 + y / 4) % 3 == 1) ? (unsigned char)(x * 5 + y * 3 + c * 60) : noise;
+				image[(y * width + x) * 4 + c] = value;
+			}
+}
+
+static void InitTexture(CMP_Texture& texture, int width, int height, CMP_FORMAT format, std::vector<unsigned char>& data)
+{
+	texture = {0};
+	texture.dwSize = sizeof(texture);
+	texture.dwWidth = width;
+	texture.dwHeight = height;
+	texture.format = format;
+	if (format == CMP_FORMAT_RGBA_8888)
+		texture.dwPitch = width * 4;
+	texture.dwDataSize = CMP_CalculateBufferSize(&texture);
+	data.resize(texture.dwDataSize);
+	texture.pData = data.data();
+}
+
+static CMP_ERROR CompressImageBC7(std::vector<unsigned char>& image, int width, int height, float quality, bool singlePrecision, std::vector<unsigned char>& cmpBlocks)
+{
+	CMP_Texture srcTexture, destTexture;
+	InitTexture(srcTexture, width, height, CMP_FORMAT_RGBA_8888, image);
+	InitTexture(destTexture, width, height, CMP_FORMAT_BC7, cmpBlocks);
+
+	CMP_CompressOptions options = {0};
+	options.dwSize = sizeof(options);
+	options.fquality = quality;
+	options.bBC7SinglePrecision = singlePrecision;
+	return CMP_ConvertTexture(&srcTexture, &destTexture, &options, nullptr);
+}
+
+static double PSNRBC7(const std::vector<unsigned char>& image, int width, int height, std::vector<unsigned char>& cmpBlocks)
+{
+	std::vector<unsigned char> decompressed;
+	CMP_Texture srcTexture, destTexture;
+	InitTexture(srcTexture, width, height, CMP_FORMAT_BC7, cmpBlocks);
+	InitTexture(destTexture, width, height, CMP_FORMAT_RGBA_8888, decompressed);
+	CMP_CompressOptions options = {0};
+	options.dwSize = sizeof(options);
+	REQUIRE(CMP_ConvertTexture(&srcTexture, &destTexture, &options, nullptr) == CMP_OK);
+
+	double error = 0.0;
+	for (size_t i = 0; i < image.size(); i++)
+	{
+		double diff = (double)decompressed[i] - (double)image[i];
+		error += diff * diff;
+	}
+	return 10.0 * log10(255.0 * 255.0 / (error / image.size()));
+}
+
+// The single precision BC7 encoder must stay within a small PSNR tolerance of the double precision one
+TEST_CASE("BC7_Single_Precision_PSNR", "[BC7]")
+{
+	const int width = 16;
+	const int height = 16;
+	const float qualities[] = { 0.05f, 0.6f };
+
+	std::vector<unsigned char> imageRGBA;
+	FillTestImage(imageRGBA, width, height);
+
+	for (float quality : qualities)
+	{
+		std::vector<unsigned char> cmpDouble, cmpFloat;
+		REQUIRE(CompressImageBC7(imageRGBA, width, height, quality, false, cmpDouble) == CMP_OK);
+		REQUIRE(CompressImageBC7(imageRGBA, width, height, quality, true, cmpFloat) == CMP_OK);
+
+		double psnrDouble = PSNRBC7(imageRGBA, width, height, cmpDouble);
+		double psnrFloat = PSNRBC7(imageRGBA, width, height, cmpFloat);
+		CHECK(psnrFloat > psnrDouble - 0.1);
+	}
+}
@@ -184,7 +184,8 @@ __constant CGU_UINT8   BC6_PARTITIONS[MAX_BC6H_PARTITIONS][MAX_SUBSET_SIZE] = {
    },
 };
 
-CGU_DWORD get_partition_subset(CGU_INT subset, CGU_INT partI, CGU_INT index)
+// Local to this file, BC7_Encode_kernel.cpp has its own get_partition_subset with the same signature
+static CGU_DWORD get_partition_subset(CGU_INT subset, CGU_INT partI, CGU_INT index)
 {
     if (subset)
         return BC6_PARTITIONS[partI][index];
@@ -2974,6 +2975,147 @@ CGU_FLOAT  EncodePattern(BC6H_Encode_local *BC6H_data, CGU_FLOAT  error)
     return error;
 }
 
+#ifndef ASPM_GPU
+//======================= TWO REGION SHAPE SEARCH ========================================
+// ScoreBC6Shapes is also run with the shapes in SIMD lanes by the CompressBlocksBC6 API
+// (BCn_Blocks_simd.h), any change here must be made to both so they give the same scores.
+
+void GetBC6ShapeMasks(CGU_FLOAT masks[MAX_SUBSET_SIZE][MAX_BC6H_PARTITIONS])
+{
+    for (CGU_INT i = 0; i < MAX_SUBSET_SIZE; i++)
+        for (CGU_INT shape = 0; shape < MAX_BC6H_PARTITIONS; shape++)
+            masks[i][shape] = (CGU_FLOAT)BC6_PARTITIONS[shape][i];
+}
+
+// Squared distance of a region's pixels from their best fit line, given the region's scatter
+// matrix {rr, gg, bb, rg, rb, gb}: the trace less the largest eigenvalue, which is found by
+// power iteration starting from the row with the largest diagonal
+static CGU_FLOAT BC6LineFitError(const CGU_FLOAT cov[6])
+{
+    CGU_FLOAT t = cov[0] + cov[1] + cov[2];
+    if (t <= 0.0f)
+        return 0.0f;
+
+    CGU_FLOAT a[6];
+    for (CGU_INT k = 0; k < 6; k++)
+        a[k] = cov[k] / t;
+
+    CGU_FLOAT vx = a[0], vy = a[3], vz = a[4], d = a[0];
+    if (a[1] > d)
+    {
+        vx = a[3]; vy = a[1]; vz = a[5]; d = a[1];
+    }
+    if (a[2] > d)
+    {
+        vx = a[4]; vy = a[5]; vz = a[2];
+    }
+
+    CGU_FLOAT x, y, z;
+    for (CGU_INT k = 0; k < 3; k++)
+    {
+        x  = a[0] * vx + a[3] * vy + a[4] * vz;
+        y  = a[3] * vx + a[1] * vy + a[5] * vz;
+        z  = a[4] * vx + a[5] * vy + a[2] * vz;
+        vx = x; vy = y; vz = z;
+    }
+
+    CGU_FLOAT vv = vx * vx + vy * vy + vz * vz;
+    if (vv <= 0.0f)
+        return t;
+
+    x = a[0] * vx + a[3] * vy + a[4] * vz;
+    y = a[3] * vx + a[1] * vy + a[5] * vz;
+    z = a[4] * vx + a[5] * vy + a[2] * vz;
+    CGU_FLOAT vAv = vx * x + vy * y + vz * z;
+
+    CGU_FLOAT err = t * (1.0f - vAv / vv);
+    return (err > 0.0f) ? err : 0.0f;
+}
+
+void ScoreBC6Shapes(const CGU_FLOAT din[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG], CGU_FLOAT score[MAX_BC6H_PARTITIONS])
+{
+    CGU_FLOAT total[3] = { 0.0f, 0.0f, 0.0f };
+    for (CGU_INT i = 0; i < MAX_SUBSET_SIZE; i++)
+        for (CGU_INT c = 0; c < 3; c++)
+            total[c] += din[i][c];
+
+    for (CGU_INT shape = 0; shape < MAX_BC6H_PARTITIONS; shape++)
+    {
+        CGU_FLOAT n1 = 0.0f;
+        CGU_FLOAT sum1[3] = { 0.0f, 0.0f, 0.0f };
+        for (CGU_INT i = 0; i < MAX_SUBSET_SIZE; i++)
+        {
+            CGU_FLOAT m = (CGU_FLOAT)BC6_PARTITIONS[shape][i];
+            n1 += m;
+            for (CGU_INT c = 0; c < 3; c++)
+                sum1[c] += m * din[i][c];
+        }
+
+        // Every shape has pixels in both regions
+        CGU_FLOAT n0 = (CGU_FLOAT)MAX_SUBSET_SIZE - n1;
+        CGU_FLOAT mean0[3], mean1[3];
+        for (CGU_INT c = 0; c < 3; c++)
+        {
+            mean0[c] = (total[c] - sum1[c]) / n0;
+            mean1[c] = sum1[c] / n1;
+        }
+
+        CGU_FLOAT cov0[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        CGU_FLOAT cov1[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        for (CGU_INT i = 0; i < MAX_SUBSET_SIZE; i++)
+        {
+            CGU_FLOAT m1 = (CGU_FLOAT)BC6_PARTITIONS[shape][i];
+            CGU_FLOAT m0 = 1.0f - m1;
+            CGU_FLOAT d0[3], d1[3];
+            for (CGU_INT c = 0; c < 3; c++)
+            {
+                d0[c] = din[i][c] - mean0[c];
+                d1[c] = din[i][c] - mean1[c];
+            }
+            cov0[0] += m0 * (d0[0] * d0[0]);
+            cov0[1] += m0 * (d0[1] * d0[1]);
+            cov0[2] += m0 * (d0[2] * d0[2]);
+            cov0[3] += m0 * (d0[0] * d0[1]);
+            cov0[4] += m0 * (d0[0] * d0[2]);
+            cov0[5] += m0 * (d0[1] * d0[2]);
+            cov1[0] += m1 * (d1[0] * d1[0]);
+            cov1[1] += m1 * (d1[1] * d1[1]);
+            cov1[2] += m1 * (d1[2] * d1[2]);
+            cov1[3] += m1 * (d1[0] * d1[1]);
+            cov1[4] += m1 * (d1[0] * d1[2]);
+            cov1[5] += m1 * (d1[1] * d1[2]);
+        }
+
+        score[shape] = BC6LineFitError(cov0) + BC6LineFitError(cov1);
+    }
+}
+
+CGU_UINT32 SelectBC6Shapes(const CGU_FLOAT score[MAX_BC6H_PARTITIONS], CGU_FLOAT partitionSearchSize)
+{
+    CGU_INT numShapes = (CGU_INT)(partitionSearchSize * MAX_BC6H_PARTITIONS + 0.5f);
+    if (numShapes >= MAX_BC6H_PARTITIONS)
+        return 0xFFFFFFFF;
+    if (numShapes < 1)
+        numShapes = 1;
+
+    // Lowest scores first, ties go to the lower shape number
+    CGU_UINT32 shapeMask = 0;
+    for (CGU_INT n = 0; n < numShapes; n++)
+    {
+        CGU_INT best = -1;
+        for (CGU_INT shape = 0; shape < MAX_BC6H_PARTITIONS; shape++)
+        {
+            if (shapeMask & (1u << shape))
+                continue;
+            if ((best < 0) || (score[shape] < score[best]))
+                best = shape;
+        }
+        shapeMask |= 1u << best;
+    }
+    return shapeMask;
+}
+#endif
+
 void CompressBlockBC6_Internal(CMP_GLOBAL  unsigned char*outdata, 
                                CGU_UINT32 destIdx,
                                BC6H_Encode_local * BC6HEncode_local,
@@ -3011,9 +3153,28 @@ void CompressBlockBC6_Internal(CMP_GLOBAL  unsigned char*outdata,
     }
 
 
+#ifndef ASPM_GPU
+    // Limit the two region search to the shapes most likely to fit
+    CGU_UINT32 shapeMask = BC6HEncode_local->shape_search_mask;
+    if (shapeMask == 0)
+    {
+        shapeMask = 0xFFFFFFFF;
+        if (BC6HEncode->m_partitionSearchSize < 1.0f)
+        {
+            CGU_FLOAT score[MAX_BC6H_PARTITIONS];
+            ScoreBC6Shapes(BC6HEncode_local->din, score);
+            shapeMask = SelectBC6Shapes(score, BC6HEncode->m_partitionSearchSize);
+        }
+    }
+#endif
+
     // run through 32 possible partition set
     for (CGU_INT8 shape = 0; shape < MAX_BC6H_PARTITIONS; shape++)
     {
+#ifndef ASPM_GPU
+        if ((shapeMask & (1u << shape)) == 0)
+            continue;
+#endif
         error = FindBestPattern(BC6HEncode_local, true, shape, quality);
         if (error < bestError)
         {
@@ -255,6 +255,7 @@ typedef struct
     CGU_FLOAT     partition[MAX_SUBSETS][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
     CGU_FLOAT     cur_best_partition[MAX_SUBSETS][MAX_SUBSET_SIZE][MAX_DIMENSION_BIG];
     CGU_BOOL      optimized;           // were end points optimized during final encoding
+    CGU_UINT32    shape_search_mask;   // two region shapes to search, bit n for shape n, 0 = select from m_partitionSearchSize
 
 } BC6H_Encode_local;
 
@@ -464,7 +465,7 @@ CMP_STATIC void SetDefaultBC6Options(BC6H_Encode *BC6Encode)
         BC6Encode->m_quality = 1.0f;
         BC6Encode->m_quantizerRangeThreshold = 0.0f;
         BC6Encode->m_shakerRangeThreshold = 0.0f;
-        BC6Encode->m_partitionSearchSize = 0.20f;
+        BC6Encode->m_partitionSearchSize = 1.0f;
         BC6Encode->m_performance = 0.0f;
         BC6Encode->m_errorThreshold = 0.0f;
         BC6Encode->m_validModeMask = 0;
@@ -478,4 +479,19 @@ CMP_STATIC void SetDefaultBC6Options(BC6H_Encode *BC6Encode)
     }
 }
 
+#ifndef ASPM_GPU
+//-------------------------------------------------------------------------------------------
+// Two region shape search. Every shape is scored by the squared distance of the pixels in
+// each of its regions from the line that best fits the region, only the m_partitionSearchSize
+// fraction of the 32 shapes with the lowest scores are then fully evaluated.
+//-------------------------------------------------------------------------------------------
+
+// Region 1 membership (0.0 or 1.0) of each pixel for every shape, with the shape innermost
+void GetBC6ShapeMasks(CGU_FLOAT masks[MAX_SUBSET_SIZE][MAX_BC6H_PARTITIONS]);
+void ScoreBC6Shapes(const CGU_FLOAT din[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG], CGU_FLOAT score[MAX_BC6H_PARTITIONS]);
+CGU_UINT32 SelectBC6Shapes(const CGU_FLOAT score[MAX_BC6H_PARTITIONS], CGU_FLOAT partitionSearchSize);
+
+void CompressBlockBC6_Internal(unsigned char *outdata, CGU_UINT32 destIdx, BC6H_Encode_local *BC6HEncode_local, const BC6H_Encode *BC6HEncode);
+#endif
+
 #endif
\ No newline at end of file
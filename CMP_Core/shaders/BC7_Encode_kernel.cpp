@@ -42,6 +42,21 @@
 //--------------------------------------
 #include "BC7_Encode_kernel.h"
 
+#ifdef CMP_BC7_ISA
+//---------------------------------------------
+// Instruction set specific build of the encoder
+// (see BC7_Encode_kernel_avx2.cpp), the ramp
+// tables are shared with the default build.
+// Everything but the entry point has internal
+// linkage so no code built for the instruction
+// set can be picked by the linker for callers
+// in other files
+//---------------------------------------------
+extern BC7_EncodeRamps BC7EncodeRamps;
+namespace CMP_BC7_ISA {
+namespace {
+#endif
+
 #ifndef ASPM
 //---------------------------------------------
 // Predefinitions for GPU and CPU compiled code
@@ -64,11 +79,13 @@ INLINE CGU_INT a_compare( const void *arg1, const void *arg2 )
 #endif
 
 #ifndef ASPM_GPU
+#ifndef CMP_BC7_ISA
 CMP_GLOBAL BC7_EncodeRamps BC7EncodeRamps
 #ifndef ASPM
     = {0}
 #endif
 ;
+#endif
 
 //---------------------------------------------
 // CPU: Computes max of two float values
@@ -126,6 +143,7 @@ CMP_EXPORT CGU_INT bc7_isa() {
     return -1;
 }
 
+#ifndef CMP_BC7_ISA
 CMP_EXPORT void init_BC7ramps()
 {
 #ifdef ASPM_GPU
@@ -260,6 +278,7 @@ CMP_EXPORT void init_BC7ramps()
     } //clogBC7<LOG_CL_RANGE
 #endif
 }
+#endif // CMP_BC7_ISA
 
 //----------------------------------------------------------
 //====== Common BC7 ASPM Code used for SPMD (CPU/GPU) ======
@@ -5120,6 +5139,94 @@ void  CompressBlockBC7_Internal(
     }
 }
 
+//-------------------------------------------------------------------------------
+// Encodes one 4x4 RGBA:8888 block, built once for each instruction set variant
+//-------------------------------------------------------------------------------
+void CompressBlockBC7_Encode(const unsigned char *srcBlock,
+                             unsigned int         srcStrideInBytes,
+                             unsigned char        cmpBlock[16],
+                             BC7_Encode          *u_BC7Encode)
+{
+    BC7_EncodeState EncodeState 
+#ifndef ASPM
+        = { 0 }
+#endif
+    ;
+    EncodeState.best_err        = CMP_FLOAT_MAX;
+    EncodeState.validModeMask   = u_BC7Encode->validModeMask;
+    EncodeState.part_count      = u_BC7Encode->part_count;
+    EncodeState.channels        = CMP_STATIC_CAST(CGU_CHANNEL,u_BC7Encode->channels);
+
+    CGU_UINT8 offsetR = 0;
+    CGU_UINT8 offsetG = 16;
+    CGU_UINT8 offsetB = 32;
+    CGU_UINT8 offsetA = 48;
+    for (CGU_UINT8 row = 0; row < 4; row++)
+    {
+        const unsigned char *srcRow = srcBlock + row * srcStrideInBytes;
+        for (CGU_UINT8 col = 0; col < 4; col++)
+        {
+            EncodeState.image_src[offsetR++] = (CGV_IMAGE)srcRow[col * 4 + 0];
+            EncodeState.image_src[offsetG++] = (CGV_IMAGE)srcRow[col * 4 + 1];
+            EncodeState.image_src[offsetB++] = (CGV_IMAGE)srcRow[col * 4 + 2];
+            EncodeState.image_src[offsetA++] = (CGV_IMAGE)srcRow[col * 4 + 3];
+        }
+    }
+
+    BC7_CompressBlock(&EncodeState, u_BC7Encode);
+
+    if (EncodeState.cmp_isout16Bytes)
+    {
+        for (CGU_UINT8 i = 0; i < COMPRESSED_BLOCK_SIZE; i++)
+        {
+            cmpBlock[i] = EncodeState.cmp_out[i];
+        }
+    }
+    else
+    {
+        memcpy(cmpBlock, EncodeState.best_cmp_out, 16);
+    }
+}
+
+#ifdef CMP_BC7_ISA
+} // namespace
+
+void CompressBlockBC7_ISA(const unsigned char *srcBlock,
+                          unsigned int         srcStrideInBytes,
+                          unsigned char        cmpBlock[16],
+                          BC7_Encode          *u_BC7Encode)
+{
+    CompressBlockBC7_Encode(srcBlock, srcStrideInBytes, cmpBlock, u_BC7Encode);
+}
+} // namespace CMP_BC7_ISA
+#else
+
+//======================= CPU DISPATCH ===========================================
+// The same encoder built with AVX2 and AVX-512 code generation, the default build
+// targets the compilers baseline (SSE2 on x64). All variants give the same output.
+
+#ifdef CMP_BC7_X86
+#include "../../Applications/_Libs/CMP_Math/cmp_math_cpuid.h"
+#endif
+
+static CMP_BC7EncodeProc cmp_selectBC7Encoder()
+{
+#ifdef CMP_BC7_X86
+    cmp_cpufeatures cpu = cmp_get_cpufeatures();
+    if (cpu.feature[SSP_AVX512_F])
+        return cmp_bc7_avx512::CompressBlockBC7_ISA;
+    if (cpu.feature[SSP_AVX2])
+        return cmp_bc7_avx2::CompressBlockBC7_ISA;
+#endif
+    return CompressBlockBC7_Encode;
+}
+
+static CMP_BC7EncodeProc cmp_getBC7Encoder()
+{
+    static const CMP_BC7EncodeProc encoder = cmp_selectBC7Encoder();
+    return encoder;
+}
+
 //======================= CPU USER INTERFACES ====================================
 
 int CMP_CDECL CreateOptionsBC7(void **options)
@@ -5202,27 +5309,6 @@ int CMP_CDECL CompressBlockBC7( const unsigned char *srcBlock,
                                 CMP_GLOBAL unsigned char cmpBlock[16],
                                 const void* options = NULL) 
 {
-    CMP_Vec4uc inBlock[SOURCE_BLOCK_SIZE];
-
-    //----------------------------------
-    // Fill the inBlock with source data
-    //----------------------------------
-    CGU_INT srcpos = 0;
-    CGU_INT dstptr = 0;
-    for (CGU_UINT8 row = 0; row < 4; row++)
-    {
-        srcpos = row * srcStrideInBytes;
-        for (CGU_UINT8 col = 0; col < 4; col++)
-        {
-            inBlock[dstptr].x = CGU_UINT8(srcBlock[srcpos++]);
-            inBlock[dstptr].y = CGU_UINT8(srcBlock[srcpos++]);
-            inBlock[dstptr].z = CGU_UINT8(srcBlock[srcpos++]);
-            inBlock[dstptr].w = CGU_UINT8(srcBlock[srcpos++]);
-            dstptr++;
-        }
-    }
-
-
     BC7_Encode *u_BC7Encode = (BC7_Encode *)options;
     BC7_Encode       BC7EncodeDefault = { 0 };
     if (u_BC7Encode == NULL)
@@ -5232,43 +5318,65 @@ int CMP_CDECL CompressBlockBC7( const unsigned char *srcBlock,
         init_BC7ramps();
     }
 
-    BC7_EncodeState EncodeState 
-#ifndef ASPM
-        = { 0 }
-#endif
-    ;
-    EncodeState.best_err        = CMP_FLOAT_MAX;
-    EncodeState.validModeMask   = u_BC7Encode->validModeMask;
-    EncodeState.part_count      = u_BC7Encode->part_count;
-    EncodeState.channels        = CMP_STATIC_CAST(CGU_CHANNEL,u_BC7Encode->channels);
+    cmp_getBC7Encoder()(srcBlock, srcStrideInBytes, cmpBlock, u_BC7Encode);
 
-    CGU_UINT8 offsetR = 0;
-    CGU_UINT8 offsetG = 16;
-    CGU_UINT8 offsetB = 32;
-    CGU_UINT8 offsetA = 48;
-    CGU_UINT32 offsetSRC = 0;
-    for (CGU_UINT8 i = 0; i < SOURCE_BLOCK_SIZE; i++)
+    return CGU_CORE_OK;
+}
+
+int CMP_CDECL CompressBlocksBC7(const unsigned char *srcBlocks,
+                                unsigned int         srcStrideInBytes,
+                                unsigned int         width,
+                                unsigned int         height,
+                                unsigned char       *cmpBlocks,
+                                const void          *options)
+{
+    if ((srcBlocks == NULL) || (cmpBlocks == NULL))
+        return CGU_CORE_ERR_INVALIDPTR;
+    if ((width == 0) || (height == 0))
+        return CGU_CORE_OK;
+
+    BC7_Encode *u_BC7Encode = (BC7_Encode *)options;
+    BC7_Encode       BC7EncodeDefault = { 0 };
+    if (u_BC7Encode == NULL)
     {
-        EncodeState.image_src[offsetR++] = (CGV_IMAGE)inBlock[offsetSRC].x;
-        EncodeState.image_src[offsetG++] = (CGV_IMAGE)inBlock[offsetSRC].y;
-        EncodeState.image_src[offsetB++] = (CGV_IMAGE)inBlock[offsetSRC].z;
-        EncodeState.image_src[offsetA++] = (CGV_IMAGE)inBlock[offsetSRC].w;
-        offsetSRC++;
+        u_BC7Encode = &BC7EncodeDefault;
+        SetDefaultBC7Options(u_BC7Encode);
+        init_BC7ramps();
     }
 
-    BC7_CompressBlock(&EncodeState, u_BC7Encode);
+    CMP_BC7EncodeProc encoder = cmp_getBC7Encoder();
+    CGU_UINT32        blocksX = (width + 3) / 4;
+    CGU_UINT32        blocksY = (height + 3) / 4;
 
-    if (EncodeState.cmp_isout16Bytes)
+    CGU_UINT8 edgeBlock[SOURCE_BLOCK_SIZE * 4];
+    for (CGU_UINT32 by = 0; by < blocksY; by++)
     {
-        for (CGU_UINT8 i = 0; i < COMPRESSED_BLOCK_SIZE; i++)
+        for (CGU_UINT32 bx = 0; bx < blocksX; bx++)
         {
-            cmpBlock[i] = EncodeState.cmp_out[i];
+            CGU_UINT8 *cmpBlock = cmpBlocks + (by * blocksX + bx) * COMPRESSED_BLOCK_SIZE;
+            if ((bx * 4 + 4 <= width) && (by * 4 + 4 <= height))
+            {
+                encoder(srcBlocks + by * 4 * srcStrideInBytes + bx * 16, srcStrideInBytes, cmpBlock, u_BC7Encode);
+                continue;
+            }
+
+            // Texels past the right and bottom edges repeat the last column / row
+            for (CGU_UINT32 row = 0; row < 4; row++)
+            {
+                CGU_UINT32 y = by * 4 + row;
+                if (y >= height)
+                    y = height - 1;
+                for (CGU_UINT32 col = 0; col < 4; col++)
+                {
+                    CGU_UINT32 x = bx * 4 + col;
+                    if (x >= width)
+                        x = width - 1;
+                    memcpy(&edgeBlock[(row * 4 + col) * 4], srcBlocks + y * srcStrideInBytes + x * 4, 4);
+                }
+            }
+            encoder(edgeBlock, 16, cmpBlock, u_BC7Encode);
         }
     }
-    else
-    {
-        memcpy(cmpBlock, EncodeState.best_cmp_out, 16);
-    }
 
     return CGU_CORE_OK;
 }
@@ -5289,6 +5397,7 @@ int  CMP_CDECL DecompressBlockBC7(const unsigned char cmpBlock[16],
     DecompressBC7_internal((CGU_UINT8(*)[4])srcBlock, (CGU_UINT8 *)cmpBlock,u_BC7Encode);
     return CGU_CORE_OK;
 }
+#endif // CMP_BC7_ISA
 #endif
 #endif
 
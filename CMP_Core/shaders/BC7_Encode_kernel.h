@@ -288,6 +288,32 @@ BC7_EncodeRamps
 BC7_EncodeRamps
 #endif
 ;
+
+//---------------------------------------------
+// Encodes one 4x4 RGBA:8888 block. The default
+// build targets the compilers baseline, the
+// instruction set builds (BC7_Encode_kernel_avx2.cpp)
+// must only be called on CPUs that support them
+//---------------------------------------------
+typedef void (*CMP_BC7EncodeProc)(const unsigned char *srcBlock, unsigned int srcStrideInBytes, unsigned char cmpBlock[16], BC7_Encode *u_BC7Encode);
+
+#ifndef CMP_BC7_ISA
+void CompressBlockBC7_Encode(const unsigned char *srcBlock, unsigned int srcStrideInBytes, unsigned char cmpBlock[16], BC7_Encode *u_BC7Encode);
+#endif
+
+#if (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CMP_BC7_X86
+
+namespace cmp_bc7_avx2
+{
+void CompressBlockBC7_ISA(const unsigned char *srcBlock, unsigned int srcStrideInBytes, unsigned char cmpBlock[16], BC7_Encode *u_BC7Encode);
+}
+
+namespace cmp_bc7_avx512
+{
+void CompressBlockBC7_ISA(const unsigned char *srcBlock, unsigned int srcStrideInBytes, unsigned char cmpBlock[16], BC7_Encode *u_BC7Encode);
+}
+#endif
 #endif
 
 CMP_CONSTANT CGU_UINT8    npv_nd[2][8] = {
@@ -0,0 +1,538 @@
+//=====================================================================
+// Copyright (c) 2020    Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//=====================================================================
+#include "BCn_Common_kernel.h"
+#include "BCn_Blocks_kernel.h"
+#include "BC6_Encode_kernel.h"
+
+#ifndef ASPM_GPU
+#include "CMP_Core.h"
+#include "../../Applications/_Libs/CMP_Math/cmp_math_cpuid.h"
+
+//============================================== MULTIPLE BLOCK INTERFACES ===========================================
+//
+// The blocks of a surface are processed one row of blocks at a time in groups of nLanes blocks.
+// Each group is transposed into a CMP_BlockLanes and compressed by the lane kernels of the
+// widest instruction set the CPU supports, any work the kernels do not cover (high quality
+// refinement, high quality alpha) is then run per block with the single block code.
+//
+//====================================================================================================================
+
+static CMP_LaneKernels cmp_selectLaneKernels()
+{
+    CMP_LaneKernels kernels = {1, NULL, NULL, NULL};
+
+#ifdef CMP_BLOCKS_X86
+    cmp_cpufeatures cpu = cmp_get_cpufeatures();
+    if (cpu.feature[SSP_AVX512_F])
+    {
+        kernels.nLanes         = 16;
+        kernels.CompressRGB    = cmp_compressRGBLanes_AVX512;
+        kernels.CompressAlpha  = cmp_compressAlphaLanes_AVX512;
+        kernels.ScoreBC6Shapes = cmp_scoreBC6ShapesLanes_AVX512;
+    }
+    else if (cpu.feature[SSP_AVX2])
+    {
+        kernels.nLanes         = 8;
+        kernels.CompressRGB    = cmp_compressRGBLanes_AVX2;
+        kernels.CompressAlpha  = cmp_compressAlphaLanes_AVX2;
+        kernels.ScoreBC6Shapes = cmp_scoreBC6ShapesLanes_AVX2;
+    }
+    else if (cpu.feature[SSP_SSE4_1])
+    {
+        kernels.nLanes         = 4;
+        kernels.CompressRGB    = cmp_compressRGBLanes_SSE41;
+        kernels.CompressAlpha  = cmp_compressAlphaLanes_SSE41;
+        kernels.ScoreBC6Shapes = cmp_scoreBC6ShapesLanes_SSE41;
+    }
+#endif
+
+    return kernels;
+}
+
+static const CMP_LaneKernels &cmp_getLaneKernels()
+{
+    static const CMP_LaneKernels kernels = cmp_selectLaneKernels();
+    return kernels;
+}
+
+static const CMP_BC15Options *cmp_getBlocksOptions(const void *options, CMP_BC15Options *defaultOptions)
+{
+    if (options)
+        return (const CMP_BC15Options *)options;
+    SetDefaultBC15Options(defaultOptions);
+    return defaultOptions;
+}
+
+//----------------------------------------------------------------------------------
+// Source access, texels past the right and bottom edges repeat the last column / row
+//----------------------------------------------------------------------------------
+typedef struct
+{
+    const CGU_UINT8 *src[2];
+    CGU_UINT32       stride[2];
+    CGU_UINT32       width;
+    CGU_UINT32       height;
+} CMP_BlocksSource;
+
+// Gathers block (bx, by) as RGBA:8888 (4 channel source) or packed 8 bit channels
+// (1 and 2 channel sources) into lane l
+static void cmp_gatherBlock(const CMP_BlocksSource &source,
+                            CGU_UINT32              nChannels,
+                            CGU_UINT32              bx,
+                            CGU_UINT32              by,
+                            CMP_BlockLanes         &lanes,
+                            CGU_INT                 l)
+{
+    for (CGU_UINT32 row = 0; row < 4; row++)
+    {
+        CGU_UINT32 y = by * 4 + row;
+        if (y >= source.height)
+            y = source.height - 1;
+        for (CGU_UINT32 col = 0; col < 4; col++)
+        {
+            CGU_UINT32 x = bx * 4 + col;
+            if (x >= source.width)
+                x = source.width - 1;
+
+            CGU_UINT32 texel;
+            if (nChannels == 4)
+            {
+                const CGU_UINT8 *p = source.src[0] + y * source.stride[0] + x * 4;
+                texel = (CGU_UINT32)p[0] | ((CGU_UINT32)p[1] << 8) | ((CGU_UINT32)p[2] << 16) | ((CGU_UINT32)p[3] << 24);
+            }
+            else
+            {
+                texel = source.src[0][y * source.stride[0] + x];
+                if (nChannels == 2)
+                    texel |= (CGU_UINT32)source.src[1][y * source.stride[1] + x] << 8;
+            }
+            lanes.texels[row * 4 + col][l] = texel;
+        }
+    }
+}
+
+static void cmp_laneRGBA(const CMP_BlockLanes &lanes, CGU_INT l, CGU_UINT8 rgbaBlock[BLOCK_SIZE_4X4X4])
+{
+    for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+    {
+        CGU_UINT32 texel     = lanes.texels[i][l];
+        rgbaBlock[i * 4]     = (CGU_UINT8)(texel & 0xFF);
+        rgbaBlock[i * 4 + 1] = (CGU_UINT8)((texel >> 8) & 0xFF);
+        rgbaBlock[i * 4 + 2] = (CGU_UINT8)((texel >> 16) & 0xFF);
+        rgbaBlock[i * 4 + 3] = (CGU_UINT8)((texel >> 24) & 0xFF);
+    }
+}
+
+static void cmp_laneChannel(const CMP_BlockLanes &lanes, CGU_INT l, CGU_UINT32 shift, CGU_UINT8 block[BLOCK_SIZE_4X4])
+{
+    for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+        block[i] = (CGU_UINT8)((lanes.texels[i][l] >> shift) & 0xFF);
+}
+
+//----------------------------------------------------------------------------------
+// Per group work shared by the codecs, nValid lanes hold blocks
+//----------------------------------------------------------------------------------
+
+// BC1 colour block for each lane, same as CompressBlockBC1_RGBA_Internal with isSRGB false
+static void cmp_compressRGBGroup(const CMP_LaneKernels  &kernels,
+                                 const CMP_BlockLanes   &lanes,
+                                 CGU_INT                 nValid,
+                                 const CMP_BC15Options  *BC15options,
+                                 CMP_LaneResults        &results)
+{
+    CGU_FLOAT fquality = BC15options->m_fquality;
+    kernels.CompressRGB(lanes, fquality, results);
+
+    if (fquality <= CMP_QUALITY2)
+        return;
+
+    for (CGU_INT l = 0; l < nValid; l++)
+    {
+        if (!(results.err[l] > 0.0f))
+            continue;
+
+        CGU_Vec3f rgbBlock[BLOCK_SIZE_4X4];
+        CGU_FLOAT BlockA[BLOCK_SIZE_4X4];
+        for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+        {
+            CGU_UINT32 texel = lanes.texels[i][l];
+            rgbBlock[i].x    = (CGU_FLOAT)(texel & 0xFF) / 255.0f;
+            rgbBlock[i].y    = (CGU_FLOAT)((texel >> 8) & 0xFF) / 255.0f;
+            rgbBlock[i].z    = (CGU_FLOAT)((texel >> 16) & 0xFF) / 255.0f;
+            BlockA[i]        = 0.0f;  // only read for an alpha threshold, the BCn codecs use 0
+        }
+
+        CMP_BC15Options internalOptions = *BC15options;
+        internalOptions                 = CalculateColourWeightings3f(rgbBlock, internalOptions);
+        CGU_Vec3f channelWeights        = {internalOptions.m_fChannelWeights[0], internalOptions.m_fChannelWeights[1], internalOptions.m_fChannelWeights[2]};
+
+        CGU_Vec2ui cmpBlock = {results.x[l], results.y[l]};
+        cmpBlock            = CompressBlockBC1_RGBA_Refine(rgbBlock, BlockA, channelWeights, 0, 1, fquality, FALSE, cmpBlock, results.err[l]);
+        results.x[l]        = cmpBlock.x;
+        results.y[l]        = cmpBlock.y;
+    }
+}
+
+// BC4 block of the channel at bits [shift, shift + 8) for each lane, same as cmp_compressAlphaBlock
+static void cmp_compressAlphaGroup(const CMP_LaneKernels &kernels,
+                                   const CMP_BlockLanes  &lanes,
+                                   CGU_INT                nValid,
+                                   CGU_UINT32             shift,
+                                   CGU_FLOAT              fquality,
+                                   CMP_LaneResults       &results)
+{
+    if (fquality < CMP_QUALITY2)
+    {
+        kernels.CompressAlpha(lanes, shift, results);
+        return;
+    }
+
+    for (CGU_INT l = 0; l < nValid; l++)
+    {
+        CGU_FLOAT alphaBlock[BLOCK_SIZE_4X4];
+        for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+            alphaBlock[i] = (CGU_FLOAT)((lanes.texels[i][l] >> shift) & 0xFF) / 255.0f;
+
+        CGU_Vec2ui cmpBlock = cmp_compressAlphaBlock(alphaBlock, fquality);
+        results.x[l]        = cmpBlock.x;
+        results.y[l]        = cmpBlock.y;
+    }
+}
+
+typedef enum
+{
+    CMP_BLOCKS_BC1,
+    CMP_BLOCKS_BC2,
+    CMP_BLOCKS_BC3,
+    CMP_BLOCKS_BC4,
+    CMP_BLOCKS_BC5
+} CMP_BlocksCodec;
+
+// Compresses a group of blocks with the lane kernels, results go to cmpBlocks in lane order
+static void cmp_compressGroup(const CMP_LaneKernels &kernels,
+                              CMP_BlocksCodec        codec,
+                              const CMP_BlockLanes  &lanes,
+                              CGU_INT                nValid,
+                              const CMP_BC15Options *BC15options,
+                              CGU_UINT8             *cmpBlocks)
+{
+    CMP_LaneResults results;
+    CMP_LaneResults alphaResults;
+
+    switch (codec)
+    {
+    case CMP_BLOCKS_BC1:
+        cmp_compressRGBGroup(kernels, lanes, nValid, BC15options, results);
+        for (CGU_INT l = 0; l < nValid; l++)
+        {
+            CGU_UINT32 *compressedBlock = (CGU_UINT32 *)(cmpBlocks + l * 8);
+            compressedBlock[0]          = results.x[l];
+            compressedBlock[1]          = results.y[l];
+        }
+        break;
+
+    case CMP_BLOCKS_BC2:
+        cmp_compressRGBGroup(kernels, lanes, nValid, BC15options, results);
+        for (CGU_INT l = 0; l < nValid; l++)
+        {
+            CGU_FLOAT BlockA[BLOCK_SIZE_4X4];
+            for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+                BlockA[i] = (CGU_FLOAT)(lanes.texels[i][l] >> 24) / 255.0f;
+
+            CGU_Vec2ui  cmpBlock        = cmp_compressExplicitAlphaBlock(BlockA);
+            CGU_UINT32 *compressedBlock = (CGU_UINT32 *)(cmpBlocks + l * 16);
+            compressedBlock[DXTC_OFFSET_ALPHA]     = cmpBlock.x;
+            compressedBlock[DXTC_OFFSET_ALPHA + 1] = cmpBlock.y;
+            compressedBlock[DXTC_OFFSET_RGB]       = results.x[l];
+            compressedBlock[DXTC_OFFSET_RGB + 1]   = results.y[l];
+        }
+        break;
+
+    case CMP_BLOCKS_BC3:
+        cmp_compressAlphaGroup(kernels, lanes, nValid, 24, BC15options->m_fquality, alphaResults);
+        cmp_compressRGBGroup(kernels, lanes, nValid, BC15options, results);
+        for (CGU_INT l = 0; l < nValid; l++)
+        {
+            CGU_UINT32 *compressedBlock = (CGU_UINT32 *)(cmpBlocks + l * 16);
+            compressedBlock[0]          = alphaResults.x[l];
+            compressedBlock[1]          = alphaResults.y[l];
+            compressedBlock[2]          = results.x[l];
+            compressedBlock[3]          = results.y[l];
+        }
+        break;
+
+    case CMP_BLOCKS_BC4:
+        cmp_compressAlphaGroup(kernels, lanes, nValid, 0, BC15options->m_fquality, results);
+        for (CGU_INT l = 0; l < nValid; l++)
+        {
+            CGU_UINT32 *compressedBlock = (CGU_UINT32 *)(cmpBlocks + l * 8);
+            compressedBlock[0]          = results.x[l];
+            compressedBlock[1]          = results.y[l];
+        }
+        break;
+
+    case CMP_BLOCKS_BC5:
+        cmp_compressAlphaGroup(kernels, lanes, nValid, 0, BC15options->m_fquality, results);
+        cmp_compressAlphaGroup(kernels, lanes, nValid, 8, BC15options->m_fquality, alphaResults);
+        for (CGU_INT l = 0; l < nValid; l++)
+        {
+            CGU_UINT32 *compressedBlock = (CGU_UINT32 *)(cmpBlocks + l * 16);
+            compressedBlock[0]          = results.x[l];
+            compressedBlock[1]          = results.y[l];
+            compressedBlock[2]          = alphaResults.x[l];
+            compressedBlock[3]          = alphaResults.y[l];
+        }
+        break;
+    }
+}
+
+// Single block fallback, used when there are no lane kernels for the CPU or the options need sRGB
+static void cmp_compressBlock(CMP_BlocksCodec        codec,
+                              const CMP_BlockLanes  &lanes,
+                              CGU_INT                l,
+                              const CMP_BC15Options *BC15options,
+                              CGU_UINT8             *cmpBlock)
+{
+    CGU_UINT8 rgbaBlock[BLOCK_SIZE_4X4X4];
+    CGU_UINT8 channelR[BLOCK_SIZE_4X4];
+    CGU_UINT8 channelG[BLOCK_SIZE_4X4];
+
+    switch (codec)
+    {
+    case CMP_BLOCKS_BC1:
+        cmp_laneRGBA(lanes, l, rgbaBlock);
+        CompressBlockBC1(rgbaBlock, 16, cmpBlock, BC15options);
+        break;
+    case CMP_BLOCKS_BC2:
+        cmp_laneRGBA(lanes, l, rgbaBlock);
+        CompressBlockBC2(rgbaBlock, 16, cmpBlock, BC15options);
+        break;
+    case CMP_BLOCKS_BC3:
+        cmp_laneRGBA(lanes, l, rgbaBlock);
+        CompressBlockBC3(rgbaBlock, 16, cmpBlock, BC15options);
+        break;
+    case CMP_BLOCKS_BC4:
+        cmp_laneChannel(lanes, l, 0, channelR);
+        CompressBlockBC4(channelR, 4, cmpBlock, BC15options);
+        break;
+    case CMP_BLOCKS_BC5:
+        cmp_laneChannel(lanes, l, 0, channelR);
+        cmp_laneChannel(lanes, l, 8, channelG);
+        CompressBlockBC5(channelR, 4, channelG, 4, cmpBlock, BC15options);
+        break;
+    }
+}
+
+static int cmp_compressBlocks(CMP_BlocksCodec         codec,
+                              const CMP_BlocksSource &source,
+                              CGU_UINT8              *cmpBlocks,
+                              const void             *options)
+{
+    if ((source.src[0] == NULL) || (cmpBlocks == NULL))
+        return CGU_CORE_ERR_INVALIDPTR;
+    if ((source.width == 0) || (source.height == 0))
+        return CGU_CORE_OK;
+
+    CMP_BC15Options        BC15optionsDefault;
+    const CMP_BC15Options *BC15options = cmp_getBlocksOptions(options, &BC15optionsDefault);
+
+    CGU_UINT32 nChannels  = (codec == CMP_BLOCKS_BC4) ? 1 : (codec == CMP_BLOCKS_BC5) ? 2 : 4;
+    CGU_UINT32 blockBytes = ((codec == CMP_BLOCKS_BC1) || (codec == CMP_BLOCKS_BC4)) ? 8 : 16;
+    CGU_UINT32 blocksX    = (source.width + 3) / 4;
+    CGU_UINT32 blocksY    = (source.height + 3) / 4;
+
+    CMP_LaneKernels kernels = cmp_getLaneKernels();
+    if ((codec == CMP_BLOCKS_BC1) && BC15options->m_bIsSRGB)
+        kernels.nLanes = 1;
+
+    CMP_BlockLanes lanes;
+    for (CGU_UINT32 by = 0; by < blocksY; by++)
+    {
+        for (CGU_UINT32 bx = 0; bx < blocksX; bx += kernels.nLanes)
+        {
+            CGU_INT nValid = kernels.nLanes;
+            if (bx + nValid > blocksX)
+                nValid = (CGU_INT)(blocksX - bx);
+
+            // Unused lanes repeat the last block so they can not produce NaNs or denormals of their own
+            for (CGU_INT l = 0; l < kernels.nLanes; l++)
+                cmp_gatherBlock(source, nChannels, bx + ((l < nValid) ? l : nValid - 1), by, lanes, l);
+
+            CGU_UINT8 *cmpGroup = cmpBlocks + (by * blocksX + bx) * blockBytes;
+            if (kernels.nLanes == 1)
+                cmp_compressBlock(codec, lanes, 0, BC15options, cmpGroup);
+            else
+                cmp_compressGroup(kernels, codec, lanes, nValid, BC15options, cmpGroup);
+        }
+    }
+
+    return CGU_CORE_OK;
+}
+
+int CMP_CDECL CompressBlocksBC1(const unsigned char *srcBlocks,
+                                unsigned int         srcStrideInBytes,
+                                unsigned int         width,
+                                unsigned int         height,
+                                unsigned char       *cmpBlocks,
+                                const void          *options)
+{
+    CMP_BlocksSource source = {{srcBlocks, NULL}, {srcStrideInBytes, 0}, width, height};
+    return cmp_compressBlocks(CMP_BLOCKS_BC1, source, cmpBlocks, options);
+}
+
+int CMP_CDECL CompressBlocksBC2(const unsigned char *srcBlocks,
+                                unsigned int         srcStrideInBytes,
+                                unsigned int         width,
+                                unsigned int         height,
+                                unsigned char       *cmpBlocks,
+                                const void          *options)
+{
+    CMP_BlocksSource source = {{srcBlocks, NULL}, {srcStrideInBytes, 0}, width, height};
+    return cmp_compressBlocks(CMP_BLOCKS_BC2, source, cmpBlocks, options);
+}
+
+int CMP_CDECL CompressBlocksBC3(const unsigned char *srcBlocks,
+                                unsigned int         srcStrideInBytes,
+                                unsigned int         width,
+                                unsigned int         height,
+                                unsigned char       *cmpBlocks,
+                                const void          *options)
+{
+    CMP_BlocksSource source = {{srcBlocks, NULL}, {srcStrideInBytes, 0}, width, height};
+    return cmp_compressBlocks(CMP_BLOCKS_BC3, source, cmpBlocks, options);
+}
+
+int CMP_CDECL CompressBlocksBC4(const unsigned char *srcBlocks,
+                                unsigned int         srcStrideInBytes,
+                                unsigned int         width,
+                                unsigned int         height,
+                                unsigned char       *cmpBlocks,
+                                const void          *options)
+{
+    CMP_BlocksSource source = {{srcBlocks, NULL}, {srcStrideInBytes, 0}, width, height};
+    return cmp_compressBlocks(CMP_BLOCKS_BC4, source, cmpBlocks, options);
+}
+
+int CMP_CDECL CompressBlocksBC5(const unsigned char *srcBlocks1,
+                                unsigned int         srcStrideInBytes1,
+                                const unsigned char *srcBlocks2,
+                                unsigned int         srcStrideInBytes2,
+                                unsigned int         width,
+                                unsigned int         height,
+                                unsigned char       *cmpBlocks,
+                                const void          *options)
+{
+    if (srcBlocks2 == NULL)
+        return CGU_CORE_ERR_INVALIDPTR;
+    CMP_BlocksSource source = {{srcBlocks1, srcBlocks2}, {srcStrideInBytes1, srcStrideInBytes2}, width, height};
+    return cmp_compressBlocks(CMP_BLOCKS_BC5, source, cmpBlocks, options);
+}
+
+//----------------------------------------------------------------------------------
+// BC6H: the blocks are compressed one at a time, the lane kernels score the two
+// region shapes of each block when the options limit the shape search
+//----------------------------------------------------------------------------------
+typedef struct
+{
+    CGU_FLOAT masks[MAX_SUBSET_SIZE][CMP_BC6_SHAPES];
+} CMP_BC6ShapeMasks;
+
+static CMP_BC6ShapeMasks cmp_makeBC6ShapeMasks()
+{
+    CMP_BC6ShapeMasks shapeMasks;
+    GetBC6ShapeMasks(shapeMasks.masks);
+    return shapeMasks;
+}
+
+static const CMP_BC6ShapeMasks &cmp_getBC6ShapeMasks()
+{
+    static const CMP_BC6ShapeMasks shapeMasks = cmp_makeBC6ShapeMasks();
+    return shapeMasks;
+}
+
+int CMP_CDECL CompressBlocksBC6(const unsigned short *srcBlocks,
+                                unsigned int          srcStrideInShorts,
+                                unsigned int          width,
+                                unsigned int          height,
+                                unsigned char        *cmpBlocks,
+                                const void           *options)
+{
+    if ((srcBlocks == NULL) || (cmpBlocks == NULL))
+        return CGU_CORE_ERR_INVALIDPTR;
+    if ((width == 0) || (height == 0))
+        return CGU_CORE_OK;
+
+    const BC6H_Encode *BC6HEncode = (const BC6H_Encode *)options;
+    BC6H_Encode        BC6HEncodeDefault;
+    if (BC6HEncode == NULL)
+    {
+        SetDefaultBC6Options(&BC6HEncodeDefault);
+        BC6HEncode = &BC6HEncodeDefault;
+    }
+
+    const CMP_LaneKernels &kernels     = cmp_getLaneKernels();
+    CGU_BOOL               scoreShapes = (kernels.ScoreBC6Shapes != NULL) && (BC6HEncode->m_partitionSearchSize < 1.0f);
+
+    CGU_UINT32 blocksX = (width + 3) / 4;
+    CGU_UINT32 blocksY = (height + 3) / 4;
+
+    BC6H_Encode_local BC6HEncode_local;
+    for (CGU_UINT32 by = 0; by < blocksY; by++)
+    {
+        for (CGU_UINT32 bx = 0; bx < blocksX; bx++)
+        {
+            memset((CGU_UINT8 *)&BC6HEncode_local, 0, sizeof(BC6H_Encode_local));
+            for (CGU_UINT32 row = 0; row < 4; row++)
+            {
+                CGU_UINT32 y = by * 4 + row;
+                if (y >= height)
+                    y = height - 1;
+                for (CGU_UINT32 col = 0; col < 4; col++)
+                {
+                    CGU_UINT32 x = bx * 4 + col;
+                    if (x >= width)
+                        x = width - 1;
+
+                    const CGU_UINT16 *p     = srcBlocks + y * srcStrideInShorts + x * 3;
+                    CGU_FLOAT        *texel = BC6HEncode_local.din[row * 4 + col];
+                    texel[0]               = p[0];  // R
+                    texel[1]               = p[1];  // G
+                    texel[2]               = p[2];  // B
+                }
+            }
+
+            if (scoreShapes)
+            {
+                CGU_FLOAT score[CMP_BC6_SHAPES];
+                kernels.ScoreBC6Shapes(BC6HEncode_local.din, cmp_getBC6ShapeMasks().masks, score);
+                BC6HEncode_local.shape_search_mask = SelectBC6Shapes(score, BC6HEncode->m_partitionSearchSize);
+            }
+
+            CompressBlockBC6_Internal(cmpBlocks + (by * blocksX + bx) * 16, 0, &BC6HEncode_local, BC6HEncode);
+        }
+    }
+
+    return CGU_CORE_OK;
+}
+
+#endif // ASPM_GPU
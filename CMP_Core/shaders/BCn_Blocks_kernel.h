@@ -0,0 +1,94 @@
+//=====================================================================
+// Copyright (c) 2020    Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//=====================================================================
+#ifndef BCN_BLOCKS_KERNEL_H
+#define BCN_BLOCKS_KERNEL_H
+
+#include "Common_Def.h"
+
+#ifndef ASPM_GPU
+
+//====================================================================================
+// Multiple block (lane) interface shared by the CompressBlocksBCn API and the SIMD
+// kernels. A group of blocks is held in structure of arrays form: texel i of block
+// (lane) l is at texels[i][l], so one SIMD load reads the same texel of N blocks.
+//====================================================================================
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CMP_BLOCKS_X86
+#endif
+
+// Widest group of blocks processed at once, one lane per block (AVX-512)
+#define CMP_MAX_LANES 16
+
+// BC6H two region shapes, MAX_BC6H_PARTITIONS in BC6_Encode_kernel.h
+#define CMP_BC6_SHAPES 32
+
+typedef struct
+{
+    // RGBA:8888 texels with red in the low byte, single channel sources use the low byte
+    CGU_UINT32 texels[BLOCK_SIZE_4X4][CMP_MAX_LANES];
+} CMP_BlockLanes;
+
+typedef struct
+{
+    CGU_UINT32 x[CMP_MAX_LANES];
+    CGU_UINT32 y[CMP_MAX_LANES];
+    CGU_FLOAT  err[CMP_MAX_LANES];
+} CMP_LaneResults;
+
+// Runs CompressRGBBlock_FM (non sRGB) for every lane, err is set to its errout
+typedef void (*CMP_CompressRGBLanesProc)(const CMP_BlockLanes& lanes, CGU_FLOAT fquality, CMP_LaneResults& results);
+
+// Runs cmp_compressAlphaBlock for every lane for qualities below CMP_QUALITY2,
+// the channel is read from bits [shift, shift + 8) of each texel
+typedef void (*CMP_CompressAlphaLanesProc)(const CMP_BlockLanes& lanes, CGU_UINT32 shift, CMP_LaneResults& results);
+
+// Runs ScoreBC6Shapes for one BC6H block with the shapes in lanes, masks[i][shape] is 1.0
+// when pixel i is in region 1 of the shape (GetBC6ShapeMasks)
+typedef void (*CMP_ScoreBC6ShapesLanesProc)(const CGU_FLOAT din[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+                                            const CGU_FLOAT masks[MAX_SUBSET_SIZE][CMP_BC6_SHAPES],
+                                            CGU_FLOAT       score[CMP_BC6_SHAPES]);
+
+typedef struct
+{
+    CGU_INT                     nLanes;
+    CMP_CompressRGBLanesProc    CompressRGB;
+    CMP_CompressAlphaLanesProc  CompressAlpha;
+    CMP_ScoreBC6ShapesLanesProc ScoreBC6Shapes;
+} CMP_LaneKernels;
+
+#ifdef CMP_BLOCKS_X86
+void cmp_compressRGBLanes_SSE41(const CMP_BlockLanes& lanes, CGU_FLOAT fquality, CMP_LaneResults& results);
+void cmp_compressAlphaLanes_SSE41(const CMP_BlockLanes& lanes, CGU_UINT32 shift, CMP_LaneResults& results);
+void cmp_scoreBC6ShapesLanes_SSE41(const CGU_FLOAT din[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG], const CGU_FLOAT masks[MAX_SUBSET_SIZE][CMP_BC6_SHAPES], CGU_FLOAT score[CMP_BC6_SHAPES]);
+void cmp_compressRGBLanes_AVX2(const CMP_BlockLanes& lanes, CGU_FLOAT fquality, CMP_LaneResults& results);
+void cmp_compressAlphaLanes_AVX2(const CMP_BlockLanes& lanes, CGU_UINT32 shift, CMP_LaneResults& results);
+void cmp_scoreBC6ShapesLanes_AVX2(const CGU_FLOAT din[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG], const CGU_FLOAT masks[MAX_SUBSET_SIZE][CMP_BC6_SHAPES], CGU_FLOAT score[CMP_BC6_SHAPES]);
+void cmp_compressRGBLanes_AVX512(const CMP_BlockLanes& lanes, CGU_FLOAT fquality, CMP_LaneResults& results);
+void cmp_compressAlphaLanes_AVX512(const CMP_BlockLanes& lanes, CGU_UINT32 shift, CMP_LaneResults& results);
+void cmp_scoreBC6ShapesLanes_AVX512(const CGU_FLOAT din[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG], const CGU_FLOAT masks[MAX_SUBSET_SIZE][CMP_BC6_SHAPES], CGU_FLOAT score[CMP_BC6_SHAPES]);
+#endif
+
+#endif // ASPM_GPU
+
+#endif
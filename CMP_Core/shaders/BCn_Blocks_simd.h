@@ -0,0 +1,723 @@
+//=====================================================================
+// Copyright (c) 2020    Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//=====================================================================
+#ifndef BCN_BLOCKS_SIMD_H
+#define BCN_BLOCKS_SIMD_H
+
+//====================================================================================
+// Lane kernels for the multiple block API. Included once by each of
+// BCn_Blocks_sse41.cpp, BCn_Blocks_avx2.cpp and BCn_Blocks_avx512.cpp, which define
+// CMP_BLOCKS_SSE41, CMP_BLOCKS_AVX2 or CMP_BLOCKS_AVX512. The kernels are built
+// with the matching instruction set enabled.
+//
+// Each kernel is a line by line transcription of its scalar version in
+// BCn_Common_kernel.h with one block per lane. The operations are done in the same
+// order and with the same rounding, so every lane gives a bit exact copy of the
+// scalar result. These files must be built without floating point contraction (FMA).
+//====================================================================================
+
+#include "BCn_Common_kernel.h"
+#include "BCn_Blocks_kernel.h"
+
+#if defined(CMP_BLOCKS_X86) && !defined(ASPM_GPU)
+
+#include <immintrin.h>
+
+// Only the kernels below are built for the instruction set. The shared headers above are
+// built for the baseline, so the linker can never pick an instruction set copy of one of
+// their inline functions for code in other files. MSVC compiles the intrinsics as is.
+#if defined(__clang__)
+#if defined(CMP_BLOCKS_AVX512)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(CMP_BLOCKS_AVX2)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma clang attribute push(__attribute__((target("sse4.1"))), apply_to = function)
+#endif
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#if defined(CMP_BLOCKS_AVX512)
+#pragma GCC target("avx512f")
+#elif defined(CMP_BLOCKS_AVX2)
+#pragma GCC target("avx2")
+#else
+#pragma GCC target("sse4.1")
+#endif
+#endif
+
+namespace {
+
+#if defined(CMP_BLOCKS_AVX512)
+
+#define CMP_LANES 16
+#define CMP_BLOCKS_FUNC(name) name##_AVX512
+
+struct cmp_vf { __m512  v; };
+struct cmp_vi { __m512i v; };
+struct cmp_vm { __mmask16 v; };
+
+static inline cmp_vf vf(__m512  v) { cmp_vf r; r.v = v; return r; }
+static inline cmp_vi vi(__m512i v) { cmp_vi r; r.v = v; return r; }
+static inline cmp_vm vm(__mmask16 v) { cmp_vm r; r.v = v; return r; }
+
+static inline cmp_vf vset(CGU_FLOAT f)                 { return vf(_mm512_set1_ps(f)); }
+static inline cmp_vf operator+(cmp_vf a, cmp_vf b)     { return vf(_mm512_add_ps(a.v, b.v)); }
+static inline cmp_vf operator-(cmp_vf a, cmp_vf b)     { return vf(_mm512_sub_ps(a.v, b.v)); }
+static inline cmp_vf operator*(cmp_vf a, cmp_vf b)     { return vf(_mm512_mul_ps(a.v, b.v)); }
+static inline cmp_vf operator/(cmp_vf a, cmp_vf b)     { return vf(_mm512_div_ps(a.v, b.v)); }
+static inline cmp_vf vmin(cmp_vf a, cmp_vf b)          { return vf(_mm512_min_ps(a.v, b.v)); }
+static inline cmp_vf vmax(cmp_vf a, cmp_vf b)          { return vf(_mm512_max_ps(a.v, b.v)); }
+static inline cmp_vf vfloor(cmp_vf a)                  { return vf(_mm512_roundscale_ps(a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)); }
+static inline cmp_vf vceil(cmp_vf a)                   { return vf(_mm512_roundscale_ps(a.v, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC)); }
+static inline cmp_vf vtrunc(cmp_vf a)                  { return vf(_mm512_roundscale_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC)); }
+static inline cmp_vf vsqrt(cmp_vf a)                   { return vf(_mm512_sqrt_ps(a.v)); }
+static inline cmp_vf vabs(cmp_vf a)                    { return vf(_mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a.v), _mm512_set1_epi32(0x7FFFFFFF)))); }
+static inline cmp_vf vsignbit(cmp_vf a)                { return vf(_mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a.v), _mm512_set1_epi32((int)0x80000000)))); }
+static inline cmp_vf vxorbits(cmp_vf a, cmp_vf b)      { return vf(_mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a.v), _mm512_castps_si512(b.v)))); }
+static inline cmp_vm vlt(cmp_vf a, cmp_vf b)           { return vm(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ)); }
+static inline cmp_vm vle(cmp_vf a, cmp_vf b)           { return vm(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ)); }
+static inline cmp_vm vgt(cmp_vf a, cmp_vf b)           { return vm(_mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ)); }
+static inline cmp_vm vge(cmp_vf a, cmp_vf b)           { return vm(_mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ)); }
+static inline cmp_vm veq(cmp_vf a, cmp_vf b)           { return vm(_mm512_cmp_ps_mask(a.v, b.v, _CMP_EQ_OQ)); }
+static inline cmp_vm vneq(cmp_vf a, cmp_vf b)          { return vm(_mm512_cmp_ps_mask(a.v, b.v, _CMP_NEQ_UQ)); }
+static inline cmp_vf vselect(cmp_vm m, cmp_vf a, cmp_vf b) { return vf(_mm512_mask_blend_ps(m.v, b.v, a.v)); }
+static inline cmp_vm vand(cmp_vm a, cmp_vm b)          { return vm((__mmask16)(a.v & b.v)); }
+static inline cmp_vm vandnot(cmp_vm a, cmp_vm b)       { return vm((__mmask16)(~a.v & b.v)); }
+
+static inline cmp_vi viset(CGU_INT32 i)                { return vi(_mm512_set1_epi32(i)); }
+static inline cmp_vi viload(const CGU_UINT32* p)       { return vi(_mm512_loadu_si512((const void*)p)); }
+static inline void   vistore(CGU_UINT32* p, cmp_vi a)  { _mm512_storeu_si512((void*)p, a.v); }
+static inline cmp_vf vload(const CGU_FLOAT* p)        { return vf(_mm512_loadu_ps(p)); }
+static inline void   vstore(CGU_FLOAT* p, cmp_vf a)    { _mm512_storeu_ps(p, a.v); }
+static inline cmp_vi viadd(cmp_vi a, cmp_vi b)         { return vi(_mm512_add_epi32(a.v, b.v)); }
+static inline cmp_vi visub(cmp_vi a, cmp_vi b)         { return vi(_mm512_sub_epi32(a.v, b.v)); }
+static inline cmp_vi vior(cmp_vi a, cmp_vi b)          { return vi(_mm512_or_si512(a.v, b.v)); }
+static inline cmp_vi viand(cmp_vi a, cmp_vi b)         { return vi(_mm512_and_si512(a.v, b.v)); }
+static inline cmp_vi vixor(cmp_vi a, cmp_vi b)         { return vi(_mm512_xor_si512(a.v, b.v)); }
+static inline cmp_vi visll(cmp_vi a, CGU_INT n)        { return vi(_mm512_sll_epi32(a.v, _mm_cvtsi32_si128(n))); }
+static inline cmp_vi visrl(cmp_vi a, CGU_INT n)        { return vi(_mm512_srl_epi32(a.v, _mm_cvtsi32_si128(n))); }
+static inline cmp_vm vieq(cmp_vi a, cmp_vi b)          { return vm(_mm512_cmpeq_epi32_mask(a.v, b.v)); }
+static inline cmp_vm vigt(cmp_vi a, cmp_vi b)          { return vm(_mm512_cmpgt_epi32_mask(a.v, b.v)); }
+static inline cmp_vi viselect(cmp_vm m, cmp_vi a, cmp_vi b) { return vi(_mm512_mask_blend_epi32(m.v, b.v, a.v)); }
+static inline cmp_vi vcvt(cmp_vf a)                    { return vi(_mm512_cvttps_epi32(a.v)); }
+static inline cmp_vf vtof(cmp_vi a)                    { return vf(_mm512_cvtepi32_ps(a.v)); }
+
+#elif defined(CMP_BLOCKS_AVX2)
+
+#define CMP_LANES 8
+#define CMP_BLOCKS_FUNC(name) name##_AVX2
+
+struct cmp_vf { __m256  v; };
+struct cmp_vi { __m256i v; };
+struct cmp_vm { __m256  v; };
+
+static inline cmp_vf vf(__m256  v) { cmp_vf r; r.v = v; return r; }
+static inline cmp_vi vi(__m256i v) { cmp_vi r; r.v = v; return r; }
+static inline cmp_vm vm(__m256  v) { cmp_vm r; r.v = v; return r; }
+
+static inline cmp_vf vset(CGU_FLOAT f)                 { return vf(_mm256_set1_ps(f)); }
+static inline cmp_vf operator+(cmp_vf a, cmp_vf b)     { return vf(_mm256_add_ps(a.v, b.v)); }
+static inline cmp_vf operator-(cmp_vf a, cmp_vf b)     { return vf(_mm256_sub_ps(a.v, b.v)); }
+static inline cmp_vf operator*(cmp_vf a, cmp_vf b)     { return vf(_mm256_mul_ps(a.v, b.v)); }
+static inline cmp_vf operator/(cmp_vf a, cmp_vf b)     { return vf(_mm256_div_ps(a.v, b.v)); }
+static inline cmp_vf vmin(cmp_vf a, cmp_vf b)          { return vf(_mm256_min_ps(a.v, b.v)); }
+static inline cmp_vf vmax(cmp_vf a, cmp_vf b)          { return vf(_mm256_max_ps(a.v, b.v)); }
+static inline cmp_vf vfloor(cmp_vf a)                  { return vf(_mm256_floor_ps(a.v)); }
+static inline cmp_vf vceil(cmp_vf a)                   { return vf(_mm256_ceil_ps(a.v)); }
+static inline cmp_vf vtrunc(cmp_vf a)                  { return vf(_mm256_round_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC)); }
+static inline cmp_vf vsqrt(cmp_vf a)                   { return vf(_mm256_sqrt_ps(a.v)); }
+static inline cmp_vf vabs(cmp_vf a)                    { return vf(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)); }
+static inline cmp_vf vsignbit(cmp_vf a)                { return vf(_mm256_and_ps(_mm256_set1_ps(-0.0f), a.v)); }
+static inline cmp_vf vxorbits(cmp_vf a, cmp_vf b)      { return vf(_mm256_xor_ps(a.v, b.v)); }
+static inline cmp_vm vlt(cmp_vf a, cmp_vf b)           { return vm(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)); }
+static inline cmp_vm vle(cmp_vf a, cmp_vf b)           { return vm(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)); }
+static inline cmp_vm vgt(cmp_vf a, cmp_vf b)           { return vm(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)); }
+static inline cmp_vm vge(cmp_vf a, cmp_vf b)           { return vm(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)); }
+static inline cmp_vm veq(cmp_vf a, cmp_vf b)           { return vm(_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ)); }
+static inline cmp_vm vneq(cmp_vf a, cmp_vf b)          { return vm(_mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ)); }
+static inline cmp_vf vselect(cmp_vm m, cmp_vf a, cmp_vf b) { return vf(_mm256_blendv_ps(b.v, a.v, m.v)); }
+static inline cmp_vm vand(cmp_vm a, cmp_vm b)          { return vm(_mm256_and_ps(a.v, b.v)); }
+static inline cmp_vm vandnot(cmp_vm a, cmp_vm b)       { return vm(_mm256_andnot_ps(a.v, b.v)); }
+
+static inline cmp_vi viset(CGU_INT32 i)                { return vi(_mm256_set1_epi32(i)); }
+static inline cmp_vi viload(const CGU_UINT32* p)       { return vi(_mm256_loadu_si256((const __m256i*)p)); }
+static inline void   vistore(CGU_UINT32* p, cmp_vi a)  { _mm256_storeu_si256((__m256i*)p, a.v); }
+static inline cmp_vf vload(const CGU_FLOAT* p)        { return vf(_mm256_loadu_ps(p)); }
+static inline void   vstore(CGU_FLOAT* p, cmp_vf a)    { _mm256_storeu_ps(p, a.v); }
+static inline cmp_vi viadd(cmp_vi a, cmp_vi b)         { return vi(_mm256_add_epi32(a.v, b.v)); }
+static inline cmp_vi visub(cmp_vi a, cmp_vi b)         { return vi(_mm256_sub_epi32(a.v, b.v)); }
+static inline cmp_vi vior(cmp_vi a, cmp_vi b)          { return vi(_mm256_or_si256(a.v, b.v)); }
+static inline cmp_vi viand(cmp_vi a, cmp_vi b)         { return vi(_mm256_and_si256(a.v, b.v)); }
+static inline cmp_vi vixor(cmp_vi a, cmp_vi b)         { return vi(_mm256_xor_si256(a.v, b.v)); }
+static inline cmp_vi visll(cmp_vi a, CGU_INT n)        { return vi(_mm256_sll_epi32(a.v, _mm_cvtsi32_si128(n))); }
+static inline cmp_vi visrl(cmp_vi a, CGU_INT n)        { return vi(_mm256_srl_epi32(a.v, _mm_cvtsi32_si128(n))); }
+static inline cmp_vm vieq(cmp_vi a, cmp_vi b)          { return vm(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a.v, b.v))); }
+static inline cmp_vm vigt(cmp_vi a, cmp_vi b)          { return vm(_mm256_castsi256_ps(_mm256_cmpgt_epi32(a.v, b.v))); }
+static inline cmp_vi viselect(cmp_vm m, cmp_vi a, cmp_vi b) { return vi(_mm256_blendv_epi8(b.v, a.v, _mm256_castps_si256(m.v))); }
+static inline cmp_vi vcvt(cmp_vf a)                    { return vi(_mm256_cvttps_epi32(a.v)); }
+static inline cmp_vf vtof(cmp_vi a)                    { return vf(_mm256_cvtepi32_ps(a.v)); }
+
+#else // CMP_BLOCKS_SSE41
+
+#define CMP_LANES 4
+#define CMP_BLOCKS_FUNC(name) name##_SSE41
+
+struct cmp_vf { __m128  v; };
+struct cmp_vi { __m128i v; };
+struct cmp_vm { __m128  v; };
+
+static inline cmp_vf vf(__m128  v) { cmp_vf r; r.v = v; return r; }
+static inline cmp_vi vi(__m128i v) { cmp_vi r; r.v = v; return r; }
+static inline cmp_vm vm(__m128  v) { cmp_vm r; r.v = v; return r; }
+
+static inline cmp_vf vset(CGU_FLOAT f)                 { return vf(_mm_set1_ps(f)); }
+static inline cmp_vf operator+(cmp_vf a, cmp_vf b)     { return vf(_mm_add_ps(a.v, b.v)); }
+static inline cmp_vf operator-(cmp_vf a, cmp_vf b)     { return vf(_mm_sub_ps(a.v, b.v)); }
+static inline cmp_vf operator*(cmp_vf a, cmp_vf b)     { return vf(_mm_mul_ps(a.v, b.v)); }
+static inline cmp_vf operator/(cmp_vf a, cmp_vf b)     { return vf(_mm_div_ps(a.v, b.v)); }
+static inline cmp_vf vmin(cmp_vf a, cmp_vf b)          { return vf(_mm_min_ps(a.v, b.v)); }
+static inline cmp_vf vmax(cmp_vf a, cmp_vf b)          { return vf(_mm_max_ps(a.v, b.v)); }
+static inline cmp_vf vfloor(cmp_vf a)                  { return vf(_mm_floor_ps(a.v)); }
+static inline cmp_vf vceil(cmp_vf a)                   { return vf(_mm_ceil_ps(a.v)); }
+static inline cmp_vf vtrunc(cmp_vf a)                  { return vf(_mm_round_ps(a.v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC)); }
+static inline cmp_vf vsqrt(cmp_vf a)                   { return vf(_mm_sqrt_ps(a.v)); }
+static inline cmp_vf vabs(cmp_vf a)                    { return vf(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+static inline cmp_vf vsignbit(cmp_vf a)                { return vf(_mm_and_ps(_mm_set1_ps(-0.0f), a.v)); }
+static inline cmp_vf vxorbits(cmp_vf a, cmp_vf b)      { return vf(_mm_xor_ps(a.v, b.v)); }
+static inline cmp_vm vlt(cmp_vf a, cmp_vf b)           { return vm(_mm_cmplt_ps(a.v, b.v)); }
+static inline cmp_vm vle(cmp_vf a, cmp_vf b)           { return vm(_mm_cmple_ps(a.v, b.v)); }
+static inline cmp_vm vgt(cmp_vf a, cmp_vf b)           { return vm(_mm_cmpgt_ps(a.v, b.v)); }
+static inline cmp_vm vge(cmp_vf a, cmp_vf b)           { return vm(_mm_cmpge_ps(a.v, b.v)); }
+static inline cmp_vm veq(cmp_vf a, cmp_vf b)           { return vm(_mm_cmpeq_ps(a.v, b.v)); }
+static inline cmp_vm vneq(cmp_vf a, cmp_vf b)          { return vm(_mm_cmpneq_ps(a.v, b.v)); }
+static inline cmp_vf vselect(cmp_vm m, cmp_vf a, cmp_vf b) { return vf(_mm_blendv_ps(b.v, a.v, m.v)); }
+static inline cmp_vm vand(cmp_vm a, cmp_vm b)          { return vm(_mm_and_ps(a.v, b.v)); }
+static inline cmp_vm vandnot(cmp_vm a, cmp_vm b)       { return vm(_mm_andnot_ps(a.v, b.v)); }
+
+static inline cmp_vi viset(CGU_INT32 i)                { return vi(_mm_set1_epi32(i)); }
+static inline cmp_vi viload(const CGU_UINT32* p)       { return vi(_mm_loadu_si128((const __m128i*)p)); }
+static inline void   vistore(CGU_UINT32* p, cmp_vi a)  { _mm_storeu_si128((__m128i*)p, a.v); }
+static inline cmp_vf vload(const CGU_FLOAT* p)        { return vf(_mm_loadu_ps(p)); }
+static inline void   vstore(CGU_FLOAT* p, cmp_vf a)    { _mm_storeu_ps(p, a.v); }
+static inline cmp_vi viadd(cmp_vi a, cmp_vi b)         { return vi(_mm_add_epi32(a.v, b.v)); }
+static inline cmp_vi visub(cmp_vi a, cmp_vi b)         { return vi(_mm_sub_epi32(a.v, b.v)); }
+static inline cmp_vi vior(cmp_vi a, cmp_vi b)          { return vi(_mm_or_si128(a.v, b.v)); }
+static inline cmp_vi viand(cmp_vi a, cmp_vi b)         { return vi(_mm_and_si128(a.v, b.v)); }
+static inline cmp_vi vixor(cmp_vi a, cmp_vi b)         { return vi(_mm_xor_si128(a.v, b.v)); }
+static inline cmp_vi visll(cmp_vi a, CGU_INT n)        { return vi(_mm_sll_epi32(a.v, _mm_cvtsi32_si128(n))); }
+static inline cmp_vi visrl(cmp_vi a, CGU_INT n)        { return vi(_mm_srl_epi32(a.v, _mm_cvtsi32_si128(n))); }
+static inline cmp_vm vieq(cmp_vi a, cmp_vi b)          { return vm(_mm_castsi128_ps(_mm_cmpeq_epi32(a.v, b.v))); }
+static inline cmp_vm vigt(cmp_vi a, cmp_vi b)          { return vm(_mm_castsi128_ps(_mm_cmpgt_epi32(a.v, b.v))); }
+static inline cmp_vi viselect(cmp_vm m, cmp_vi a, cmp_vi b) { return vi(_mm_blendv_epi8(b.v, a.v, _mm_castps_si128(m.v))); }
+static inline cmp_vi vcvt(cmp_vf a)                    { return vi(_mm_cvttps_epi32(a.v)); }
+static inline cmp_vf vtof(cmp_vi a)                    { return vf(_mm_cvtepi32_ps(a.v)); }
+
+#endif
+
+//----------------------------------------------------------------------------
+// Helpers matching the scalar CPU versions used by the kernels
+//----------------------------------------------------------------------------
+
+// std::round, halfway cases away from zero
+static inline cmp_vf vround(cmp_vf a)
+{
+    cmp_vf t    = vtrunc(a);
+    cmp_vf away = t + vxorbits(vset(1.0f), vsignbit(a));
+    return vselect(vge(vabs(a - t), vset(0.5f)), away, t);
+}
+
+static inline cmp_vf vneg(cmp_vf a)
+{
+    return vxorbits(a, vset(-0.0f));
+}
+
+// cmp_clamp3f for one channel
+static inline cmp_vf vclamp(cmp_vf a, CGU_FLOAT minValue, CGU_FLOAT maxValue)
+{
+    return vmin(vmax(a, vset(minValue)), vset(maxValue));
+}
+
+static inline cmp_vi viselect(cmp_vm m, CGU_INT32 a, cmp_vi b)
+{
+    return viselect(m, viset(a), b);
+}
+
+// Texel i of every lane as 0..1, the same as (CGU_FLOAT)(channel & 0xFF) / 255.0f
+static inline cmp_vf cmp_laneTexel(const CMP_BlockLanes& lanes, CGU_INT i, CGU_UINT32 shift)
+{
+    cmp_vi texel = visrl(viload(lanes.texels[i]), (CGU_INT)shift);
+    return vtof(viand(texel, viset(0xFF))) / vset(255.0f);
+}
+
+// cmp_ProcessColors for isSRGB false, setopt 0 (min max) returns the quantized colours in colorMin and colorMax
+static void cmp_processColorsLanes(cmp_vf colorMin[3],
+                                   cmp_vf colorMax[3],
+                                   cmp_vi& c0,
+                                   cmp_vi& c1,
+                                   CGU_INT setopt)
+{
+    const CGU_FLOAT scale[3] = {31.0f, 63.0f, 31.0f};
+    cmp_vi          ci0[3], ci1[3];
+
+    for (CGU_INT ch = 0; ch < 3; ch++)
+    {
+        cmp_vf MinColorScaled = vclamp(colorMin[ch], 0.0f, 1.0f);
+        cmp_vf MaxColorScaled = vclamp(colorMax[ch], 0.0f, 1.0f);
+        if (setopt == 0)
+        {
+            MinColorScaled = vfloor(MinColorScaled * vset(scale[ch]));
+            MaxColorScaled = vceil(MaxColorScaled * vset(scale[ch]));
+            colorMin[ch]   = MinColorScaled / vset(scale[ch]);
+            colorMax[ch]   = MaxColorScaled / vset(scale[ch]);
+        }
+        else
+        {
+            MinColorScaled = vround(MinColorScaled * vset(scale[ch]));
+            MaxColorScaled = vround(MaxColorScaled * vset(scale[ch]));
+        }
+        ci0[ch] = vcvt(MinColorScaled);
+        ci1[ch] = vcvt(MaxColorScaled);
+    }
+
+    c0 = vior(vior(visll(ci0[0], 11), visll(ci0[1], 5)), ci0[2]);
+    c1 = vior(vior(visll(ci1[0], 11), visll(ci1[1], 5)), ci1[2]);
+}
+
+// cmp_getIndicesRGB with getErr false
+static cmp_vi cmp_getIndicesRGBLanes(const cmp_vf block[3][BLOCK_SIZE_4X4], const cmp_vf minColor[3], const cmp_vf maxColor[3])
+{
+    cmp_vf range[3];
+    for (CGU_INT ch = 0; ch < 3; ch++)
+        range[ch] = minColor[ch] - maxColor[ch];
+
+    cmp_vf Scale          = vset(3.f) / (((range[0] * range[0]) + (range[1] * range[1])) + (range[2] * range[2]));
+    cmp_vf ScaledRange[3] = {range[0] * Scale, range[1] * Scale, range[2] * Scale};
+    cmp_vf maxDotMax      = ((maxColor[0] * maxColor[0]) + (maxColor[1] * maxColor[1])) + (maxColor[2] * maxColor[2]);
+    cmp_vf maxDotMin      = ((maxColor[0] * minColor[0]) + (maxColor[1] * minColor[1])) + (maxColor[2] * minColor[2]);
+    cmp_vf Bias           = (maxDotMax - maxDotMin) * Scale;
+
+    cmp_vi PackedIndices = viset(0);
+    for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+    {
+        cmp_vf diff  = (((block[0][i] * ScaledRange[0]) + (block[1][i] * ScaledRange[1])) + (block[2][i] * ScaledRange[2])) + Bias;
+        cmp_vi index = viand(vcvt(vround(diff)), viset(0x3));
+
+        // remap linear offset to spec offset {0,2,3,1}
+        index = viselect(vieq(index, viset(0)), 0, viselect(vieq(index, viset(3)), 1, viadd(index, viset(1))));
+
+        PackedIndices = vior(PackedIndices, visll(index, 2 * i));
+    }
+    return PackedIndices;
+}
+
+// cmp_565ToLinear
+static void cmp_565ToLinearLanes(cmp_vi n565, cmp_vf color[3])
+{
+    cmp_vi r0 = visrl(viand(n565, viset(0xf800)), 8);
+    cmp_vi g0 = visrl(viand(n565, viset(0x07e0)), 3);
+    cmp_vi b0 = visll(viand(n565, viset(0x001f)), 3);
+
+    color[0] = vtof(viadd(r0, visrl(r0, 5)));
+    color[1] = vtof(viadd(g0, visrl(g0, 6)));
+    color[2] = vtof(viadd(b0, visrl(b0, 5)));
+}
+
+// CMP_RGBBlockError with isSRGB false
+static cmp_vf cmp_RGBBlockErrorLanes(const cmp_vf src[3][BLOCK_SIZE_4X4], cmp_vi cmpX, cmp_vi cmpY)
+{
+    cmp_vi n0 = viand(cmpX, viset(0xffff));
+    cmp_vi n1 = visrl(cmpX, 16);
+    cmp_vm fourColour = vigt(n0, n1);
+
+    cmp_vf c0[3], c1[3], c2[3], c3[3];
+    cmp_565ToLinearLanes(n0, c0);
+    cmp_565ToLinearLanes(n1, c1);
+    for (CGU_INT ch = 0; ch < 3; ch++)
+    {
+        c2[ch] = vselect(fourColour, ((c0[ch] * vset(2.0f)) + c1[ch]) / vset(3.0f), (c0[ch] + c1[ch]) / vset(2.0f));
+        c3[ch] = vselect(fourColour, ((c1[ch] * vset(2.0f)) + c0[ch]) / vset(3.0f), vset(0.0f));
+    }
+
+    cmp_vf serr[3] = {vset(0.0f), vset(0.0f), vset(0.0f)};
+    for (CGU_INT j = 0; j < BLOCK_SIZE_4X4; j++)
+    {
+        cmp_vi index = viand(visrl(cmpY, 2 * j), viset(3));
+        cmp_vm is0   = vieq(index, viset(0));
+        cmp_vm is1   = vieq(index, viset(1));
+        cmp_vm is2   = vieq(index, viset(2));
+        for (CGU_INT ch = 0; ch < 3; ch++)
+        {
+            cmp_vf decoded = vselect(is0, c0[ch], vselect(is1, c1[ch], vselect(is2, c2[ch], c3[ch])));
+            cmp_vf d       = vround(src[ch][j] * vset(255.0f)) - decoded;
+            serr[ch]       = serr[ch] + (d * d);
+        }
+    }
+
+    return ((serr[0] + serr[1]) + serr[2]) / vset(48.0f);
+}
+
+//----------------------------------------------------------------------------
+// CompressRGBBlock_FM with isSRGB false, one block per lane
+//----------------------------------------------------------------------------
+static void cmp_compressRGBLanes(const CMP_BlockLanes& lanes, CGU_FLOAT fquality, CMP_LaneResults& results)
+{
+    cmp_vf src[3][BLOCK_SIZE_4X4];
+    for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+    {
+        src[0][i] = cmp_laneTexel(lanes, i, 0);
+        src[1][i] = cmp_laneTexel(lanes, i, 8);
+        src[2][i] = cmp_laneTexel(lanes, i, 16);
+    }
+
+    // (1) Min max encoding
+    cmp_vf srcMin[3] = {vset(1.0f), vset(1.0f), vset(1.0f)};
+    cmp_vf srcMax[3] = {vset(0.0f), vset(0.0f), vset(0.0f)};
+    for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+    {
+        for (CGU_INT ch = 0; ch < 3; ch++)
+        {
+            srcMin[ch] = vmin(src[ch][i], srcMin[ch]);
+            srcMax[ch] = vmax(src[ch][i], srcMax[ch]);
+        }
+    }
+
+    cmp_vi c0, c1;
+    cmp_processColorsLanes(srcMin, srcMax, c0, c1, 0);
+
+    // Lanes where all colours are equal keep the single colour encoding with no error
+    cmp_vm minMaxLanes = vigt(c1, c0);
+    cmp_vi Q1X         = viselect(minMaxLanes, vior(visll(c0, 16), c1), vior(visll(c1, 16), c0));
+    cmp_vi Q1Y         = viselect(minMaxLanes, cmp_getIndicesRGBLanes(src, srcMin, srcMax), viset(0));
+
+    if (fquality <= CMP_QUALITY1)
+    {
+        vistore(results.x, Q1X);
+        vistore(results.y, Q1Y);
+        vstore(results.err, vset(0.0f));
+        return;
+    }
+
+    // Source with blue replaced by the average of green and blue
+    cmp_vf srcRGB[3][BLOCK_SIZE_4X4];
+    cmp_vf average_rgb[3] = {vset(0.0f), vset(0.0f), vset(0.0f)};
+    for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+    {
+        srcRGB[0][i] = src[0][i];
+        srcRGB[1][i] = src[1][i];
+        srcRGB[2][i] = (src[1][i] + src[2][i]) * vset(0.5F);
+        for (CGU_INT ch = 0; ch < 3; ch++)
+            average_rgb[ch] = average_rgb[ch] + srcRGB[ch][i];
+    }
+    for (CGU_INT ch = 0; ch < 3; ch++)
+        average_rgb[ch] = average_rgb[ch] * vset(0.0625F);
+
+    // (4) Axis direction
+    cmp_vf axisVectorRGB[3] = {vset(0.0f), vset(0.0f), vset(0.0f)};
+    cmp_vf rg_pos = vset(0.0f);
+    cmp_vf bg_pos = vset(0.0f);
+    cmp_vf rb_pos = vset(0.0f);
+    for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+    {
+        cmp_vf rgb[3];
+        for (CGU_INT ch = 0; ch < 3; ch++)
+        {
+            rgb[ch]           = srcRGB[ch][i] - average_rgb[ch];
+            axisVectorRGB[ch] = axisVectorRGB[ch] + vabs(rgb[ch]);
+        }
+        cmp_vm rPositive = vgt(rgb[0], vset(0.0f));
+        rg_pos = vselect(rPositive, rg_pos + rgb[1], rg_pos);
+        rb_pos = vselect(rPositive, rb_pos + rgb[2], rb_pos);
+        bg_pos = vselect(vgt(rgb[2], vset(0.0f)), bg_pos + rgb[1], bg_pos);
+    }
+    for (CGU_INT ch = 0; ch < 3; ch++)
+        axisVectorRGB[ch] = axisVectorRGB[ch] * vset(0.0625F);
+
+    axisVectorRGB[0] = vselect(vlt(rg_pos, vset(0.0f)), vneg(axisVectorRGB[0]), axisVectorRGB[0]);
+    axisVectorRGB[2] = vselect(vlt(bg_pos, vset(0.0f)), vneg(axisVectorRGB[2]), axisVectorRGB[2]);
+    cmp_vm noGreen   = vand(vand(veq(rg_pos, bg_pos), veq(rg_pos, vset(0.0f))), vlt(rb_pos, vset(0.0f)));
+    axisVectorRGB[2] = vselect(noGreen, vneg(axisVectorRGB[2]), axisVectorRGB[2]);
+
+    // (5) Normalize the axis
+    cmp_vf v2 = ((axisVectorRGB[0] * axisVectorRGB[0]) + (axisVectorRGB[1] * axisVectorRGB[1])) + (axisVectorRGB[2] * axisVectorRGB[2]);
+    cmp_vf v2_recip = vselect(vgt(v2, vset(0.0f)), vset(1.0f) / vsqrt(v2), vset(1.0f));
+    for (CGU_INT ch = 0; ch < 3; ch++)
+        axisVectorRGB[ch] = axisVectorRGB[ch] * v2_recip;
+
+    // (6) Project onto the axis
+    cmp_vf pos_on_axis[BLOCK_SIZE_4X4];
+    cmp_vf axisleft  = vset(CMP_FLOAT_MAX);
+    cmp_vf axisright = vset(-CMP_FLOAT_MAX);
+    for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+    {
+        cmp_vf temp[3];
+        for (CGU_INT ch = 0; ch < 3; ch++)
+            temp[ch] = srcRGB[ch][i] - average_rgb[ch];
+        pos_on_axis[i] = ((temp[0] * axisVectorRGB[0]) + (temp[1] * axisVectorRGB[1])) + (temp[2] * axisVectorRGB[2]);
+
+        axisleft  = vselect(vlt(pos_on_axis[i], axisleft), pos_on_axis[i], axisleft);
+        axisright = vselect(vgt(pos_on_axis[i], axisright), pos_on_axis[i], axisright);
+    }
+
+    // (7) Centre the points on the axis
+    cmp_vf axiscentre = (axisleft + axisright) * vset(0.5F);
+    for (CGU_INT ch = 0; ch < 3; ch++)
+        average_rgb[ch] = average_rgb[ch] + (axisVectorRGB[ch] * axiscentre);
+    for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+        pos_on_axis[i] = pos_on_axis[i] - axiscentre;
+    axisright = axisright - axiscentre;
+    axisleft  = axisleft - axiscentre;
+
+    // (8) High and low output colours
+    cmp_vf MinColor[3], MaxColor[3];
+    for (CGU_INT ch = 0; ch < 3; ch++)
+    {
+        MinColor[ch] = average_rgb[ch] + (axisVectorRGB[ch] * axisleft);
+        MaxColor[ch] = average_rgb[ch] + (axisVectorRGB[ch] * axisright);
+    }
+    MinColor[2] = (MinColor[2] * vset(2.0f)) - MinColor[1];
+    MaxColor[2] = (MaxColor[2] * vset(2.0f)) - MaxColor[1];
+
+    cmp_processColorsLanes(MinColor, MaxColor, c0, c1, 1);
+
+    // Force a 4 colour opaque block, equal colours use only one of the two points
+    cmp_vm swapLanes  = vigt(c1, c0);
+    cmp_vm equalLanes = vieq(c0, c1);
+    cmp_vi swap       = viselect(swapLanes, 1, viset(0));
+    cmp_vi cmax       = viselect(swapLanes, c1, c0);
+    cmp_vi cmin       = viselect(swapLanes, c0, c1);
+    for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+        pos_on_axis[i] = vselect(equalLanes, axisleft, pos_on_axis[i]);
+
+    cmp_vi cmpX = vior(cmax, visll(cmin, 16));
+
+    // (9) Final clustering
+    cmp_vi cmpY     = viset(0);
+    cmp_vf division = (axisright * vset(2.0f)) / vset(3.0f);
+    axiscentre      = (axisleft + axisright) / vset(2.0f);
+    for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+    {
+        cmp_vi index = viselect(vge(vabs(pos_on_axis[i]), division), 0, viset(2));
+        index = viselect(vge(pos_on_axis[i], axiscentre), viadd(index, viset(1)), index);
+        index = vixor(index, swap);
+        cmpY  = vior(cmpY, visll(index, 2 * i));
+    }
+
+    cmp_vf CompMinErr = cmp_RGBBlockErrorLanes(src, cmpX, cmpY);
+    cmp_vf Q1CompErr  = cmp_RGBBlockErrorLanes(src, Q1X, Q1Y);
+    cmp_vm useQ1      = vgt(CompMinErr, Q1CompErr);
+
+    cmpX = viselect(useQ1, Q1X, cmpX);
+    cmpY = viselect(useQ1, Q1Y, cmpY);
+    cmp_vf errout = vselect(useQ1, Q1CompErr, CompMinErr);
+
+    // Single colour lanes returned before the axis search
+    vistore(results.x, viselect(minMaxLanes, cmpX, Q1X));
+    vistore(results.y, viselect(minMaxLanes, cmpY, Q1Y));
+    vstore(results.err, vselect(minMaxLanes, errout, vset(0.0f)));
+}
+
+//----------------------------------------------------------------------------
+// cmp_compressAlphaBlock for fquality < CMP_QUALITY2, one block per lane
+//----------------------------------------------------------------------------
+static void cmp_compressAlphaLanes(const CMP_BlockLanes& lanes, CGU_UINT32 shift, CMP_LaneResults& results)
+{
+    cmp_vf alphaBlock[BLOCK_SIZE_4X4];
+    for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+        alphaBlock[i] = cmp_laneTexel(lanes, i, shift);
+
+    // cmp_getLinearEndPoints: bounding box
+    cmp_vf rampMin = alphaBlock[0];
+    cmp_vf rampMax = alphaBlock[0];
+    for (CGU_INT i = 1; i < BLOCK_SIZE_4X4; i++)
+    {
+        rampMin = vmin(alphaBlock[i], rampMin);
+        rampMax = vmax(alphaBlock[i], rampMax);
+    }
+
+    // cmp_getBlockPackedIndices
+    cmp_vf Range     = vselect(vneq(rampMin, rampMax), rampMin - rampMax, vset(1.0f));
+    cmp_vf RampSteps = vset(7.f) / Range;
+    cmp_vf Bias      = vneg(RampSteps) * rampMax;
+
+    cmp_vi pcIndices[BLOCK_SIZE_4X4];
+    for (CGU_INT i = 0; i < BLOCK_SIZE_4X4; i++)
+    {
+        cmp_vi index = vcvt(vround((alphaBlock[i] * RampSteps) + Bias));
+        index        = viselect(vigt(index, viset(0)), viadd(index, viset(1)), index);
+        pcIndices[i] = viselect(vieq(index, viset(8)), 1, index);
+    }
+
+    cmp_vi MinRampU = vcvt(vround(rampMin * vset(255.0f)));
+    cmp_vi MaxRampU = vcvt(vround(rampMax * vset(255.0f)));
+
+    cmp_vi cmpX = vior(visll(MinRampU, 8), MaxRampU);
+    cmp_vi cmpY = viset(0);
+    for (CGU_INT i = 0; i < 5; i++)
+        cmpX = vior(cmpX, visll(pcIndices[i], 16 + (i * 3)));
+    cmpX = vior(cmpX, visll(pcIndices[5], 31));
+    cmpY = vior(cmpY, visrl(pcIndices[5], 1));
+    for (CGU_INT i = 6; i < BLOCK_SIZE_4X4; i++)
+        cmpY = vior(cmpY, visll(pcIndices[i], i * 3 - 16));
+
+    vistore(results.x, cmpX);
+    vistore(results.y, cmpY);
+}
+
+//----------------------------------------------------------------------------
+// ScoreBC6Shapes (BC6_Encode_kernel.cpp) for one block, one two region shape
+// per lane
+//----------------------------------------------------------------------------
+
+// BC6LineFitError, cov is {rr, gg, bb, rg, rb, gb} of one region
+static cmp_vf cmp_BC6LineFitErrorLanes(const cmp_vf cov[6])
+{
+    cmp_vf t = cov[0] + cov[1] + cov[2];
+
+    cmp_vf a[6];
+    for (CGU_INT k = 0; k < 6; k++)
+        a[k] = cov[k] / t;
+
+    cmp_vf vx = a[0], vy = a[3], vz = a[4], d = a[0];
+    cmp_vm row1 = vgt(a[1], d);
+    vx = vselect(row1, a[3], vx);
+    vy = vselect(row1, a[1], vy);
+    vz = vselect(row1, a[5], vz);
+    d  = vselect(row1, a[1], d);
+    cmp_vm row2 = vgt(a[2], d);
+    vx = vselect(row2, a[4], vx);
+    vy = vselect(row2, a[5], vy);
+    vz = vselect(row2, a[2], vz);
+
+    cmp_vf x, y, z;
+    for (CGU_INT k = 0; k < 3; k++)
+    {
+        x  = a[0] * vx + a[3] * vy + a[4] * vz;
+        y  = a[3] * vx + a[1] * vy + a[5] * vz;
+        z  = a[4] * vx + a[5] * vy + a[2] * vz;
+        vx = x; vy = y; vz = z;
+    }
+
+    cmp_vf vv = vx * vx + vy * vy + vz * vz;
+
+    x = a[0] * vx + a[3] * vy + a[4] * vz;
+    y = a[3] * vx + a[1] * vy + a[5] * vz;
+    z = a[4] * vx + a[5] * vy + a[2] * vz;
+    cmp_vf vAv = vx * x + vy * y + vz * z;
+
+    cmp_vf err = t * (vset(1.0f) - vAv / vv);
+    err        = vselect(vgt(err, vset(0.0f)), err, vset(0.0f));
+    err        = vselect(vle(vv, vset(0.0f)), t, err);
+    return vselect(vle(t, vset(0.0f)), vset(0.0f), err);
+}
+
+static void cmp_scoreBC6ShapesLanes(const CGU_FLOAT din[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+                                    const CGU_FLOAT masks[MAX_SUBSET_SIZE][CMP_BC6_SHAPES],
+                                    CGU_FLOAT       score[CMP_BC6_SHAPES])
+{
+    CGU_FLOAT total[3] = {0.0f, 0.0f, 0.0f};
+    for (CGU_INT i = 0; i < MAX_SUBSET_SIZE; i++)
+        for (CGU_INT c = 0; c < 3; c++)
+            total[c] += din[i][c];
+
+    for (CGU_INT shape = 0; shape < CMP_BC6_SHAPES; shape += CMP_LANES)
+    {
+        cmp_vf n1      = vset(0.0f);
+        cmp_vf sum1[3] = {vset(0.0f), vset(0.0f), vset(0.0f)};
+        for (CGU_INT i = 0; i < MAX_SUBSET_SIZE; i++)
+        {
+            cmp_vf m = vload(&masks[i][shape]);
+            n1       = n1 + m;
+            for (CGU_INT c = 0; c < 3; c++)
+                sum1[c] = sum1[c] + m * vset(din[i][c]);
+        }
+
+        cmp_vf n0 = vset((CGU_FLOAT)MAX_SUBSET_SIZE) - n1;
+        cmp_vf mean0[3], mean1[3];
+        for (CGU_INT c = 0; c < 3; c++)
+        {
+            mean0[c] = (vset(total[c]) - sum1[c]) / n0;
+            mean1[c] = sum1[c] / n1;
+        }
+
+        cmp_vf cov0[6], cov1[6];
+        for (CGU_INT k = 0; k < 6; k++)
+        {
+            cov0[k] = vset(0.0f);
+            cov1[k] = vset(0.0f);
+        }
+        for (CGU_INT i = 0; i < MAX_SUBSET_SIZE; i++)
+        {
+            cmp_vf m1 = vload(&masks[i][shape]);
+            cmp_vf m0 = vset(1.0f) - m1;
+            cmp_vf d0[3], d1[3];
+            for (CGU_INT c = 0; c < 3; c++)
+            {
+                d0[c] = vset(din[i][c]) - mean0[c];
+                d1[c] = vset(din[i][c]) - mean1[c];
+            }
+            cov0[0] = cov0[0] + m0 * (d0[0] * d0[0]);
+            cov0[1] = cov0[1] + m0 * (d0[1] * d0[1]);
+            cov0[2] = cov0[2] + m0 * (d0[2] * d0[2]);
+            cov0[3] = cov0[3] + m0 * (d0[0] * d0[1]);
+            cov0[4] = cov0[4] + m0 * (d0[0] * d0[2]);
+            cov0[5] = cov0[5] + m0 * (d0[1] * d0[2]);
+            cov1[0] = cov1[0] + m1 * (d1[0] * d1[0]);
+            cov1[1] = cov1[1] + m1 * (d1[1] * d1[1]);
+            cov1[2] = cov1[2] + m1 * (d1[2] * d1[2]);
+            cov1[3] = cov1[3] + m1 * (d1[0] * d1[1]);
+            cov1[4] = cov1[4] + m1 * (d1[0] * d1[2]);
+            cov1[5] = cov1[5] + m1 * (d1[1] * d1[2]);
+        }
+
+        vstore(&score[shape], cmp_BC6LineFitErrorLanes(cov0) + cmp_BC6LineFitErrorLanes(cov1));
+    }
+}
+
+} // namespace
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+// Entry points, built for the baseline and only called when the CPU supports the instruction set
+void CMP_BLOCKS_FUNC(cmp_compressRGBLanes)(const CMP_BlockLanes& lanes, CGU_FLOAT fquality, CMP_LaneResults& results)
+{
+    cmp_compressRGBLanes(lanes, fquality, results);
+}
+
+void CMP_BLOCKS_FUNC(cmp_compressAlphaLanes)(const CMP_BlockLanes& lanes, CGU_UINT32 shift, CMP_LaneResults& results)
+{
+    cmp_compressAlphaLanes(lanes, shift, results);
+}
+
+void CMP_BLOCKS_FUNC(cmp_scoreBC6ShapesLanes)(const CGU_FLOAT din[MAX_SUBSET_SIZE][MAX_DIMENSION_BIG],
+                                              const CGU_FLOAT masks[MAX_SUBSET_SIZE][CMP_BC6_SHAPES],
+                                              CGU_FLOAT       score[CMP_BC6_SHAPES])
+{
+    cmp_scoreBC6ShapesLanes(din, masks, score);
+}
+
+#endif // CMP_BLOCKS_X86
+
+#endif
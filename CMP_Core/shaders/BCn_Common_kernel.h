@@ -2107,20 +2107,22 @@ static CMP_EndPoints CompressRGBBlock_Slow(
 
 
 // Process a rgbBlock which is normalized (0.0f ... 1.0f), signed normal is not implemented
-static CGU_Vec2ui CompressBlockBC1_RGBA_Internal(
+//------------------------------------------------------------------------------------------
+// High quality pass of CompressBlockBC1_RGBA_Internal, cmpBlock and errLQ are the result of
+// CompressRGBBlock_FM for the same block. Split out for the multiple block API which runs
+// the CompressRGBBlock_FM pass for several blocks at once
+//------------------------------------------------------------------------------------------
+static CGU_Vec2ui CompressBlockBC1_RGBA_Refine(
                       const CGU_Vec3f rgbBlockUVf[BLOCK_SIZE_4X4],
                       const CGU_FLOAT BlockA[BLOCK_SIZE_4X4],
                       CGU_Vec3f  channelWeights,
                       CGU_UINT32 dwAlphaThreshold,
                       CGU_UINT32 m_nRefinementSteps,
                       CMP_IN CGU_FLOAT fquality,
-                      CGU_BOOL isSRGB )
+                      CGU_BOOL isSRGB,
+                      CGU_Vec2ui cmpBlock,
+                      CGU_FLOAT  errLQ)
 {
-    CGU_Vec2ui      cmpBlock  = {0,0};
-    CGU_FLOAT       errLQ = 1e6f;
-
-    cmpBlock = CompressRGBBlock_FM(rgbBlockUVf,fquality,isSRGB,CMP_REFINOUT errLQ);
-
 #ifndef CMP_USE_LOWQUALITY
     //------------------------------------------------------------------
     // Processing is in 0..255 range, code needs to be normized to 0..1
@@ -2430,6 +2432,31 @@ static CGU_Vec2ui CompressBlockBC1_RGBA_Internal(
     return cmpBlock;
 }
 
+static CGU_Vec2ui CompressBlockBC1_RGBA_Internal(
+                      const CGU_Vec3f rgbBlockUVf[BLOCK_SIZE_4X4],
+                      const CGU_FLOAT BlockA[BLOCK_SIZE_4X4],
+                      CGU_Vec3f  channelWeights,
+                      CGU_UINT32 dwAlphaThreshold,
+                      CGU_UINT32 m_nRefinementSteps,
+                      CMP_IN CGU_FLOAT fquality,
+                      CGU_BOOL isSRGB )
+{
+    CGU_Vec2ui      cmpBlock  = {0,0};
+    CGU_FLOAT       errLQ = 1e6f;
+
+    cmpBlock = CompressRGBBlock_FM(rgbBlockUVf,fquality,isSRGB,CMP_REFINOUT errLQ);
+
+    return CompressBlockBC1_RGBA_Refine(rgbBlockUVf,
+                                        BlockA,
+                                        channelWeights,
+                                        dwAlphaThreshold,
+                                        m_nRefinementSteps,
+                                        fquality,
+                                        isSRGB,
+                                        cmpBlock,
+                                        errLQ);
+}
+
 //============================= Alpha: New single header interfaces: supports GPU shader interface  ==================================================
 
 // Compress a BC1 block
@@ -165,4 +165,35 @@ int CMP_CDECL DecompressBlockBC5(const unsigned char cmpBlock[16], unsigned char
 int CMP_CDECL CompressBlockBC6(const unsigned short *srcBlock, unsigned int srcStrideInShorts, unsigned char cmpBlock[16], const void *options CMP_DEFAULTNULL);
 int CMP_CDECL DecompressBlockBC6(const unsigned char cmpBlock[16], unsigned short srcBlock[48], const void *options CMP_DEFAULTNULL);
 
+//======================================================================================================
+// Multiple block API: compresses every 4x4 block of a width x height source, with the same
+// formats and options as the single block calls above. Blocks are written in row order to
+// cmpBlocks, which must hold ((width+3)/4) * ((height+3)/4) blocks. When width or height are
+// not a multiple of 4 the edge blocks repeat the last column or row of the source.
+//
+// Groups of blocks are compressed together with the widest of SSE4.1, AVX2 or AVX-512 found
+// at run time, the output is the same as calling CompressBlockBCn for each block.
+// A single row of blocks can be compressed by passing a height of 4.
+//======================================================================================================
+int CMP_CDECL CompressBlocksBC1(const unsigned char *srcBlocks, unsigned int srcStrideInBytes, unsigned int width, unsigned int height, unsigned char *cmpBlocks, const void *options CMP_DEFAULTNULL);
+int CMP_CDECL CompressBlocksBC2(const unsigned char *srcBlocks, unsigned int srcStrideInBytes, unsigned int width, unsigned int height, unsigned char *cmpBlocks, const void *options CMP_DEFAULTNULL);
+int CMP_CDECL CompressBlocksBC3(const unsigned char *srcBlocks, unsigned int srcStrideInBytes, unsigned int width, unsigned int height, unsigned char *cmpBlocks, const void *options CMP_DEFAULTNULL);
+
+// 1 channel source, 8 bits per texel
+int CMP_CDECL CompressBlocksBC4(const unsigned char *srcBlocks, unsigned int srcStrideInBytes, unsigned int width, unsigned int height, unsigned char *cmpBlocks, const void *options CMP_DEFAULTNULL);
+
+// 2 channel source held as two 8 bit planes of the same size
+int CMP_CDECL CompressBlocksBC5(const unsigned char *srcBlocks1, unsigned int srcStrideInBytes1,
+                                const unsigned char *srcBlocks2, unsigned int srcStrideInBytes2,
+                                unsigned int width, unsigned int height, unsigned char *cmpBlocks, const void *options CMP_DEFAULTNULL);
+
+// 3 channel source RGB:16 bit half floats, srcStrideInShorts as for CompressBlockBC6. Blocks are encoded
+// one at a time, for qualities below 0.25 the two region shapes tried for each block are chosen by
+// scoring every shape at once in SIMD lanes
+int CMP_CDECL CompressBlocksBC6(const unsigned short *srcBlocks, unsigned int srcStrideInShorts, unsigned int width, unsigned int height, unsigned char *cmpBlocks, const void *options CMP_DEFAULTNULL);
+
+// 4 channel source RGBA:8888, blocks are encoded one at a time with the widest of the SSE2, AVX2 or
+// AVX-512 builds of the BC7 encoder found at run time
+int CMP_CDECL CompressBlocksBC7(const unsigned char *srcBlocks, unsigned int srcStrideInBytes, unsigned int width, unsigned int height, unsigned char *cmpBlocks, const void *options CMP_DEFAULTNULL);
+
 #endif  // CMP_CORE
@@ -1,7 +1,13 @@
 #include <map>
 #include <array>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
 #include "../../../Common/Lib/Ext/Catch2/catch.hpp"
 #include "../source/CMP_Core.h"
+#include "../shaders/BC7_Encode_kernel.h"
+#include "../../Applications/_Libs/CMP_Math/cmp_math_cpuid.h"
 #include "../../Applications/_Plugins/Common/UtilFuncs.h"
 // incudes all compressed 4x4 blocks
 #include "BlockConstants.h"
@@ -10,6 +16,8 @@
 static const int BC1_BLOCK_SIZE = 8;
 static const int BC2_BLOCK_SIZE = 16;
 static const int BC3_BLOCK_SIZE = 16;
+static const int BC6_BLOCK_SIZE = 16;
+static const int BC7_BLOCK_SIZE = 16;
 static const int DECOMPRESSED_BLOCK_SIZE = 64;
 static const int STRIDE_DECOMPRESSED = 16;
 
@@ -2605,4 +2613,283 @@ TEST_CASE("BC7_Green_Half_Alpha", "[BC7_Green_Half_Alpha]")
 }
 
 
-//***************************************************************************************
\ No newline at end of file
+//***************************************************************************************
+
+// Multiple block API must match the single block API for every block, including the
+// edge blocks of a source that is not a multiple of 4 in size
+static void FillTestImage(std::vector<unsigned char>& image, int width, int height, int channels)
+{
+	image.resize(width * height * channels);
+	unsigned int seed = 0x1234567;
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			for (int c = 0; c < channels; c++)
+			{
+				seed = seed * 1103515245 + 12345;
+				unsigned char noise = (unsigned char)(seed >> 24);
+				// Mix of flat, gradient and noisy blocks
+				unsigned char value = ((x / 4 + y / 4) % 3 == 0) ? 0x40 : ((x / 4 + y / 4) % 3 == 1) ? (unsigned char)(x * 5 + y * 3 + c * 60) : noise;
+				image[(y * width + x) * channels + c] = value;
+			}
+}
+
+static void GetSourceBlock(const std::vector<unsigned char>& image, int width, int height, int channels, int bx, int by, unsigned char* block)
+{
+	for (int i = 0; i < 16; i++)
+	{
+		int x = std::min(bx * 4 + i % 4, width - 1);
+		int y = std::min(by * 4 + i / 4, height - 1);
+		memcpy(block + i * channels, &image[(y * width + x) * channels], channels);
+	}
+}
+
+TEST_CASE("CompressBlocks_BC1_BC5_Match_Single_Block", "[CompressBlocks]")
+{
+	const int width = 45;
+	const int height = 22;
+	const int blocksX = (width + 3) / 4;
+	const int blocksY = (height + 3) / 4;
+	const float qualities[] = { 0.05f, 0.3f, 1.0f };
+
+	std::vector<unsigned char> imageRGBA, imageR, imageG;
+	FillTestImage(imageRGBA, width, height, 4);
+	FillTestImage(imageR, width, height, 1);
+	imageG.assign(imageR.rbegin(), imageR.rend());
+
+	for (float quality : qualities)
+	{
+		void* options = nullptr;
+		CreateOptionsBC1(&options);
+		SetQualityBC1(options, quality);
+
+		for (int codec = 1; codec <= 5; codec++)
+		{
+			const int blockSize = (codec == 1 || codec == 4) ? BC1_BLOCK_SIZE : BC2_BLOCK_SIZE;
+			std::vector<unsigned char> cmpBlocks(blocksX * blocksY * blockSize);
+			int result = 0;
+			switch (codec)
+			{
+			case 1: result = CompressBlocksBC1(imageRGBA.data(), width * 4, width, height, cmpBlocks.data(), options); break;
+			case 2: result = CompressBlocksBC2(imageRGBA.data(), width * 4, width, height, cmpBlocks.data(), options); break;
+			case 3: result = CompressBlocksBC3(imageRGBA.data(), width * 4, width, height, cmpBlocks.data(), options); break;
+			case 4: result = CompressBlocksBC4(imageR.data(), width, width, height, cmpBlocks.data(), options); break;
+			case 5: result = CompressBlocksBC5(imageR.data(), width, imageG.data(), width, width, height, cmpBlocks.data(), options); break;
+			}
+			REQUIRE(result == 0);
+
+			for (int by = 0; by < blocksY; by++)
+				for (int bx = 0; bx < blocksX; bx++)
+				{
+					unsigned char srcRGBA[64], srcR[16], srcG[16];
+					unsigned char cmpBlock[16];
+					GetSourceBlock(imageRGBA, width, height, 4, bx, by, srcRGBA);
+					GetSourceBlock(imageR, width, height, 1, bx, by, srcR);
+					GetSourceBlock(imageG, width, height, 1, bx, by, srcG);
+					switch (codec)
+					{
+					case 1: CompressBlockBC1(srcRGBA, 16, cmpBlock, options); break;
+					case 2: CompressBlockBC2(srcRGBA, 16, cmpBlock, options); break;
+					case 3: CompressBlockBC3(srcRGBA, 16, cmpBlock, options); break;
+					case 4: CompressBlockBC4(srcR, 4, cmpBlock, options); break;
+					case 5: CompressBlockBC5(srcR, 4, srcG, 4, cmpBlock, options); break;
+					}
+					CHECK(memcmp(cmpBlock, &cmpBlocks[(by * blocksX + bx) * blockSize], blockSize) == 0);
+				}
+		}
+
+		DestroyOptionsBC1(options);
+	}
+}
+
+TEST_CASE("CompressBlocks_BC7_Match_Single_Block", "[CompressBlocks]")
+{
+	const int width = 18;
+	const int height = 10;
+	const int blocksX = (width + 3) / 4;
+	const int blocksY = (height + 3) / 4;
+	const float qualities[] = { 0.05f, 0.6f };
+
+	std::vector<unsigned char> imageRGBA;
+	FillTestImage(imageRGBA, width, height, 4);
+
+	for (float quality : qualities)
+	{
+		void* options = nullptr;
+		CreateOptionsBC7(&options);
+		SetQualityBC7(options, quality);
+
+		std::vector<unsigned char> cmpBlocks(blocksX * blocksY * BC7_BLOCK_SIZE);
+		REQUIRE(CompressBlocksBC7(imageRGBA.data(), width * 4, width, height, cmpBlocks.data(), options) == 0);
+
+		for (int by = 0; by < blocksY; by++)
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				unsigned char srcRGBA[64];
+				unsigned char cmpBlock[16];
+				GetSourceBlock(imageRGBA, width, height, 4, bx, by, srcRGBA);
+				CompressBlockBC7(srcRGBA, 16, cmpBlock, options);
+				CHECK(memcmp(cmpBlock, &cmpBlocks[(by * blocksX + bx) * BC7_BLOCK_SIZE], BC7_BLOCK_SIZE) == 0);
+			}
+
+		DestroyOptionsBC7(options);
+	}
+}
+
+// RGB half float image for BC6H, the 8 bit test pattern mapped to 0.125 .. 2.0
+static void FillTestImageBC6(std::vector<unsigned short>& image, int width, int height)
+{
+	std::vector<unsigned char> image8;
+	FillTestImage(image8, width, height, 3);
+	image.resize(image8.size());
+	for (size_t i = 0; i < image8.size(); i++)
+		image[i] = (unsigned short)(0x3000 + image8[i] * 16);
+}
+
+static void GetSourceBlockBC6(const std::vector<unsigned short>& image, int width, int height, int bx, int by, unsigned short* block)
+{
+	for (int i = 0; i < 16; i++)
+	{
+		int x = std::min(bx * 4 + i % 4, width - 1);
+		int y = std::min(by * 4 + i / 4, height - 1);
+		memcpy(block + i * 3, &image[(y * width + x) * 3], 3 * sizeof(unsigned short));
+	}
+}
+
+static double PSNRBC6(const std::vector<unsigned short>& image, int width, int height, const std::vector<unsigned char>& cmpBlocks)
+{
+	const int blocksX = (width + 3) / 4;
+	const int blocksY = (height + 3) / 4;
+	double error = 0.0;
+	for (int by = 0; by < blocksY; by++)
+		for (int bx = 0; bx < blocksX; bx++)
+		{
+			unsigned short srcBlock[48];
+			unsigned short decompBlock[48];
+			GetSourceBlockBC6(image, width, height, bx, by, srcBlock);
+			DecompressBlockBC6(&cmpBlocks[(by * blocksX + bx) * BC6_BLOCK_SIZE], decompBlock, nullptr);
+			for (int i = 0; i < 48; i++)
+			{
+				double diff = HalfToFloat(decompBlock[i]) - HalfToFloat(srcBlock[i]);
+				error += diff * diff;
+			}
+		}
+	// Peak value of 2.0
+	return 10.0 * log10(4.0 / (error / (blocksX * blocksY * 48)));
+}
+
+TEST_CASE("CompressBlocks_BC6_Match_Single_Block", "[CompressBlocks]")
+{
+	const int width = 18;
+	const int height = 10;
+	const int blocksX = (width + 3) / 4;
+	const int blocksY = (height + 3) / 4;
+	const float qualities[] = { 0.05f, 0.1f, 0.3f };
+
+	std::vector<unsigned short> imageRGB;
+	FillTestImageBC6(imageRGB, width, height);
+
+	for (float quality : qualities)
+	{
+		void* options = nullptr;
+		CreateOptionsBC6(&options);
+		SetQualityBC6(options, quality);
+
+		std::vector<unsigned char> cmpBlocks(blocksX * blocksY * BC6_BLOCK_SIZE);
+		REQUIRE(CompressBlocksBC6(imageRGB.data(), width * 3, width, height, cmpBlocks.data(), options) == 0);
+
+		for (int by = 0; by < blocksY; by++)
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				unsigned short srcRGB[48];
+				unsigned char cmpBlock[16];
+				GetSourceBlockBC6(imageRGB, width, height, bx, by, srcRGB);
+				CompressBlockBC6(srcRGB, 12, cmpBlock, options);
+				CHECK(memcmp(cmpBlock, &cmpBlocks[(by * blocksX + bx) * BC6_BLOCK_SIZE], BC6_BLOCK_SIZE) == 0);
+			}
+
+		DestroyOptionsBC6(options);
+	}
+}
+
+// Low qualities only search the best scoring two region shapes, the image quality must stay
+// close to the full search
+TEST_CASE("CompressBlocks_BC6_Shape_Search_PSNR", "[CompressBlocks]")
+{
+	const int width = 16;
+	const int height = 16;
+	const int blocks = (width / 4) * (height / 4);
+
+	std::vector<unsigned short> imageRGB;
+	FillTestImageBC6(imageRGB, width, height);
+
+	void* options = nullptr;
+	CreateOptionsBC6(&options);
+
+	std::vector<unsigned char> cmpFull(blocks * BC6_BLOCK_SIZE);
+	SetQualityBC6(options, 1.0f);
+	REQUIRE(CompressBlocksBC6(imageRGB.data(), width * 3, width, height, cmpFull.data(), options) == 0);
+
+	std::vector<unsigned char> cmpFast(blocks * BC6_BLOCK_SIZE);
+	SetQualityBC6(options, 0.05f);
+	REQUIRE(CompressBlocksBC6(imageRGB.data(), width * 3, width, height, cmpFast.data(), options) == 0);
+
+	double psnrFull = PSNRBC6(imageRGB, width, height, cmpFull);
+	double psnrFast = PSNRBC6(imageRGB, width, height, cmpFast);
+	CHECK(psnrFast > psnrFull - 1.0);
+
+	DestroyOptionsBC6(options);
+}
+
+// Every instruction set build of the BC7 encoder that the CPU supports must give the same
+// blocks as the default build
+TEST_CASE("BC7_Encoder_Variants_Match_Default", "[CompressBlocks]")
+{
+	const int width = 16;
+	const int height = 16;
+	const float qualities[] = { 0.05f, 0.6f, 1.0f };
+
+	std::vector<CMP_BC7EncodeProc> variants;
+	std::vector<const char*> variantNames;
+#ifdef CMP_BC7_X86
+	cmp_cpufeatures cpu = cmp_get_cpufeatures();
+	if (cpu.feature[SSP_AVX2])
+	{
+		variants.push_back(cmp_bc7_avx2::CompressBlockBC7_ISA);
+		variantNames.push_back("AVX2");
+	}
+	if (cpu.feature[SSP_AVX512_F])
+	{
+		variants.push_back(cmp_bc7_avx512::CompressBlockBC7_ISA);
+		variantNames.push_back("AVX-512");
+	}
+#endif
+
+	std::vector<unsigned char> imageRGBA;
+	FillTestImage(imageRGBA, width, height, 4);
+
+	for (float quality : qualities)
+	{
+		void* options = nullptr;
+		CreateOptionsBC7(&options);
+		SetQualityBC7(options, quality);
+
+		for (int by = 0; by < height / 4; by++)
+			for (int bx = 0; bx < width / 4; bx++)
+			{
+				unsigned char srcRGBA[64];
+				unsigned char cmpDefault[16];
+				GetSourceBlock(imageRGBA, width, height, 4, bx, by, srcRGBA);
+				CompressBlockBC7_Encode(srcRGBA, 16, cmpDefault, (BC7_Encode*)options);
+
+				for (size_t v = 0; v < variants.size(); v++)
+				{
+					unsigned char cmpBlock[16];
+					variants[v](srcRGBA, 16, cmpBlock, (BC7_Encode*)options);
+					INFO(variantNames[v] << " quality " << quality << " block " << bx << "," << by);
+					CHECK(memcmp(cmpBlock, cmpDefault, BC7_BLOCK_SIZE) == 0);
+				}
+			}
+
+		DestroyOptionsBC7(options);
+	}
+}
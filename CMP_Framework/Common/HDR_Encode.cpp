@@ -33,6 +33,7 @@
 #include <math.h>
 #include <float.h>
 #include <cstdlib>
+#include <mutex>
 
 namespace HDR_Encode
 {
@@ -2135,9 +2136,9 @@ float sperr(int in_data, int clog, int bits, int p2, int o1, int o2)
 }
 #endif
 
-void init_ramps()
-{
 #ifdef USE_RAMPS
+static void build_ramps()
+{
     int clog, bits;
     int in_data; // p1;
     int p2;
@@ -2248,6 +2249,15 @@ void init_ramps()
     //                             printf("sp_data[%2d].sp_idx[%2d][%2d][%2d][%2d][%2d][0] = %d\n", in_data,CLT(clog), BTT(bits),o1,o2,i, sp_data[in_data].sp_idx[CLT(clog)][BTT(bits)][o1][o2][i][0]);
     //                             printf("sp_data[%2d].sp_idx[%2d][%2d][%2d][%2d][%2d][1] = %d\n", in_data,CLT(clog), BTT(bits),o1,o2,i, sp_data[in_data].sp_idx[CLT(clog)][BTT(bits)][o1][o2][i][1]);
     //                         }
+}
+#endif
+
+void init_ramps()
+{
+#ifdef USE_RAMPS
+    // The tables are built once and then shared read only by all the encoders
+    static std::once_flag ramps_once;
+    std::call_once(ramps_once, build_ramps);
 #endif
 }
 